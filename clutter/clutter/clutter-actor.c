@@ -549,6 +549,7 @@
 #include "clutter/clutter-main.h"
 #include "clutter/clutter-marshal.h"
 #include "clutter/clutter-mutter.h"
+#include "clutter/clutter-offscreen-effect.h"
 #include "clutter/clutter-paint-context-private.h"
 #include "clutter/clutter-paint-nodes.h"
 #include "clutter/clutter-paint-node-private.h"
@@ -705,6 +706,9 @@ struct _ClutterActorPrivate
   /* a string used for debugging messages */
   char *debug_name;
 
+  /* a label identifying the actor in GPU paint timings */
+  char *gpu_timing_label;
+
   /* a set of clones of the actor */
   GHashTable *clones;
 
@@ -2438,6 +2442,37 @@ absolute_geometry_changed_cb (ClutterActor *actor,
   return CLUTTER_ACTOR_TRAVERSE_VISIT_CONTINUE;
 }
 
+/*< private >
+ * queue_redraw_for_transform:
+ * @self: a #ClutterActor
+ *
+ * Queues a redraw of @self for a change that only affects how its contents
+ * are placed on the stage, i.e. its transformation or opacity, but not the
+ * contents themselves.
+ *
+ * Offscreen effects render the actor in its own coordinate space and at
+ * full opacity, so unless anything else in the subtree queues a redraw,
+ * the outermost one can keep painting its cached image.
+ */
+static void
+queue_redraw_for_transform (ClutterActor *self)
+{
+  ClutterActorPrivate *priv = self->priv;
+  ClutterEffect *effect = NULL;
+
+  if (priv->effects != NULL)
+    {
+      const GList *effects = _clutter_meta_group_peek_metas (priv->effects);
+
+      if (effects != NULL && CLUTTER_IS_OFFSCREEN_EFFECT (effects->data))
+        effect = effects->data;
+    }
+
+  _clutter_actor_queue_redraw_full (self,
+                                    NULL, /* clip */
+                                    effect);
+}
+
 static void
 transform_changed (ClutterActor *actor)
 {
@@ -3293,11 +3328,13 @@ in_clone_paint (void)
   return clone_paint_level > 0;
 }
 
-/* Returns TRUE if the actor can be ignored */
-/* FIXME: we should return a ClutterCullResult, and
- * clutter_actor_paint should understand that a CLUTTER_CULL_RESULT_IN
- * means there's no point in trying to cull descendants of the current
- * node. */
+/* Returns TRUE if culling succeeded, with the result in @result_out.
+ *
+ * The visible paint volume of an actor contains the ones of its children,
+ * so the actor tree acts as a bounding volume hierarchy: when an actor is
+ * CLUTTER_CULL_RESULT_OUT its whole subtree is skipped, and when it is
+ * CLUTTER_CULL_RESULT_IN none of its descendants need to be tested.
+ */
 static gboolean
 cull_actor (ClutterActor        *self,
             ClutterPaintContext *paint_context,
@@ -3305,6 +3342,7 @@ cull_actor (ClutterActor        *self,
 {
   ClutterActorPrivate *priv = self->priv;
   const GArray *clip_frusta;
+  const graphene_frustum_t *clip_bounds_frustum;
   ClutterCullResult result = CLUTTER_CULL_RESULT_IN;
   int i;
 
@@ -3328,12 +3366,22 @@ cull_actor (ClutterActor        *self,
     }
 
   clip_frusta = clutter_paint_context_get_clip_frusta (paint_context);
-  if (!clip_frusta)
+  if (!clip_frusta || clutter_paint_context_is_inside_clip (paint_context))
     {
       *result_out = result;
       return TRUE;
     }
 
+  clip_bounds_frustum =
+    clutter_paint_context_get_clip_bounds_frustum (paint_context);
+  if (clip_bounds_frustum &&
+      _clutter_paint_volume_cull (&priv->visible_paint_volume,
+                                  clip_bounds_frustum) == CLUTTER_CULL_RESULT_OUT)
+    {
+      *result_out = CLUTTER_CULL_RESULT_OUT;
+      return TRUE;
+    }
+
   for (i = 0; i < clip_frusta->len; i++)
     {
       const graphene_frustum_t *clip_frustum =
@@ -3532,6 +3580,33 @@ clutter_actor_paint_node (ClutterActor        *actor,
   return TRUE;
 }
 
+static ClutterActorGpuTiming *
+maybe_begin_gpu_timing (ClutterActor        *self,
+                        ClutterPaintContext *paint_context)
+{
+  ClutterActorPrivate *priv = self->priv;
+  ClutterActor *stage;
+  const char *label;
+
+  if (priv->gpu_timing_label)
+    label = priv->gpu_timing_label;
+  else if (priv->parent && CLUTTER_ACTOR_IS_TOPLEVEL (priv->parent))
+    label = _clutter_actor_get_debug_name (self);
+  else
+    return NULL;
+
+  if (in_clone_paint ())
+    return NULL;
+
+  stage = _clutter_actor_get_stage_internal (self);
+  if (!stage)
+    return NULL;
+
+  return clutter_stage_begin_actor_gpu_timing (CLUTTER_STAGE (stage),
+                                               paint_context,
+                                               label);
+}
+
 /**
  * clutter_actor_paint:
  * @self: A #ClutterActor
@@ -3557,9 +3632,11 @@ clutter_actor_paint (ClutterActor        *self,
   g_autoptr (ClutterPaintNode) actor_node = NULL;
   g_autoptr (ClutterPaintNode) root_node = NULL;
   ClutterActorPrivate *priv;
+  ClutterActorGpuTiming *gpu_timing = NULL;
   ClutterActorBox clip;
   gboolean culling_inhibited;
   gboolean clip_set = FALSE;
+  gboolean inside_clip = FALSE;
 
   g_return_if_fail (CLUTTER_IS_ACTOR (self));
 
@@ -3711,6 +3788,10 @@ clutter_actor_paint (ClutterActor        *self,
         _clutter_actor_paint_cull_result (self, success, result, actor_node);
       else if (result == CLUTTER_CULL_RESULT_OUT && success)
         return;
+
+      inside_clip = success &&
+                    result == CLUTTER_CULL_RESULT_IN &&
+                    !clutter_paint_context_is_inside_clip (paint_context);
     }
 
   if (priv->effects == NULL)
@@ -3722,8 +3803,26 @@ clutter_actor_paint (ClutterActor        *self,
   if (G_UNLIKELY (clutter_paint_debug_flags & CLUTTER_DEBUG_PAINT_VOLUMES))
     _clutter_actor_draw_paint_volume (self, actor_node);
 
+  if (G_UNLIKELY (clutter_paint_debug_flags & CLUTTER_DEBUG_PAINT_GPU_TIMINGS))
+    gpu_timing = maybe_begin_gpu_timing (self, paint_context);
+
+  if (inside_clip)
+    clutter_paint_context_push_inside_clip (paint_context);
+
   clutter_paint_node_paint (root_node, paint_context);
 
+  if (inside_clip)
+    clutter_paint_context_pop_inside_clip (paint_context);
+
+  if (gpu_timing)
+    {
+      ClutterActor *stage = _clutter_actor_get_stage_internal (self);
+
+      clutter_stage_end_actor_gpu_timing (CLUTTER_STAGE (stage),
+                                          paint_context,
+                                          gpu_timing);
+    }
+
   /* If we make it here then the actor has run through a complete
    * paint run including all the effects so it's no longer dirty,
    * unless a new redraw was queued up.
@@ -4294,7 +4393,7 @@ clutter_actor_set_pivot_point_internal (ClutterActor           *self,
 
   g_object_notify_by_pspec (G_OBJECT (self), obj_props[PROP_PIVOT_POINT]);
 
-  clutter_actor_queue_redraw (self);
+  queue_redraw_for_transform (self);
 }
 
 static inline void
@@ -4311,7 +4410,7 @@ clutter_actor_set_pivot_point_z_internal (ClutterActor *self,
 
   g_object_notify_by_pspec (G_OBJECT (self), obj_props[PROP_PIVOT_POINT_Z]);
 
-  clutter_actor_queue_redraw (self);
+  queue_redraw_for_transform (self);
 }
 
 /*< private >
@@ -4344,7 +4443,7 @@ clutter_actor_set_translation_internal (ClutterActor *self,
   transform_changed (self);
   update_pointer_if_not_animated (self);
 
-  clutter_actor_queue_redraw (self);
+  queue_redraw_for_transform (self);
   g_object_notify_by_pspec (obj, pspec);
 }
 
@@ -4474,7 +4573,7 @@ clutter_actor_set_rotation_angle_internal (ClutterActor *self,
   transform_changed (self);
   update_pointer_if_not_animated (self);
 
-  clutter_actor_queue_redraw (self);
+  queue_redraw_for_transform (self);
 
   g_object_notify_by_pspec (G_OBJECT (self), pspec);
 }
@@ -4596,7 +4695,7 @@ clutter_actor_set_scale_factor_internal (ClutterActor *self,
   transform_changed (self);
   update_pointer_if_not_animated (self);
 
-  clutter_actor_queue_redraw (self);
+  queue_redraw_for_transform (self);
   g_object_notify_by_pspec (obj, pspec);
 }
 
@@ -5505,6 +5604,7 @@ clutter_actor_finalize (GObject *object)
   g_free (priv->name);
 
   g_free (priv->debug_name);
+  g_free (priv->gpu_timing_label);
 
   G_OBJECT_CLASS (clutter_actor_parent_class)->finalize (object);
 }
@@ -10119,15 +10219,13 @@ clutter_actor_set_opacity_internal (ClutterActor *self,
     {
       priv->opacity = opacity;
 
-      /* Queue a redraw from the flatten effect so that it can use
-         its cached image if available instead of having to redraw the
-         actual actor. If it doesn't end up using the FBO then the
-         effect is still able to continue the paint anyway. If there
-         is no flatten effect yet then this is equivalent to queueing
-         a full redraw */
-      _clutter_actor_queue_redraw_full (self,
-                                        NULL, /* clip */
-                                        priv->flatten_effect);
+      /* Queue a redraw from the outermost offscreen effect (such as
+         the flatten effect) so that it can use its cached image if
+         available instead of having to redraw the actual actor. If it
+         doesn't end up using the FBO then the effect is still able to
+         continue the paint anyway. If there is no such effect then
+         this is equivalent to queueing a full redraw */
+      queue_redraw_for_transform (self);
 
       g_object_notify_by_pspec (G_OBJECT (self), obj_props[PROP_OPACITY]);
     }
@@ -10397,7 +10495,7 @@ clutter_actor_set_z_position_internal (ClutterActor *self,
       transform_changed (self);
       update_pointer_if_not_animated (self);
 
-      clutter_actor_queue_redraw (self);
+      queue_redraw_for_transform (self);
 
       g_object_notify_by_pspec (G_OBJECT (self), obj_props[PROP_Z_POSITION]);
     }
@@ -13835,7 +13933,7 @@ clutter_actor_set_transform_internal (ClutterActor            *self,
   transform_changed (self);
   update_pointer_if_not_animated (self);
 
-  clutter_actor_queue_redraw (self);
+  queue_redraw_for_transform (self);
 
   g_object_notify_by_pspec (obj, obj_props[PROP_TRANSFORM]);
 
@@ -13952,6 +14050,25 @@ clutter_actor_is_painting_unmapped (ClutterActor *self)
   return self->priv->unmapped_paint_branch_counter > 0;
 }
 
+/**
+ * clutter_actor_set_gpu_timing_label: (skip)
+ * @actor: a #ClutterActor
+ * @label: (nullable): a label, or %NULL
+ *
+ * Makes the GPU time spent painting @actor and its children be measured
+ * and reported using @label when the `gpu-timings` paint debug flag is
+ * set. Direct children of the stage are always measured.
+ */
+void
+clutter_actor_set_gpu_timing_label (ClutterActor *actor,
+                                    const char   *label)
+{
+  ClutterActorPrivate *priv = actor->priv;
+
+  g_free (priv->gpu_timing_label);
+  priv->gpu_timing_label = g_strdup (label);
+}
+
 gboolean
 clutter_actor_has_damage (ClutterActor *actor)
 {
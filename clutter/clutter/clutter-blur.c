@@ -55,6 +55,26 @@
  *
  * http://rastergrid.com/blog/2010/09/efficient-gaussian-blur-with-linear-sampling/
  *
+ * ## Dual filter pyramid
+ *
+ * For large blur radii, #ClutterBlur switches from the separable gaussian
+ * kernel to a dual filter ("Dual Kawase") pyramid. The source texture is
+ * downsampled a number of times by a factor of 2 using a 5-tap filter, and
+ * then upsampled again using an 8-tap filter, stopping at half the source
+ * size. Each pass only performs a handful of texture lookups at a fraction
+ * of the source resolution, so the cost stays roughly constant no matter how
+ * large the radius is. The result is an approximation of a gaussian blur,
+ * which is visually indistinguishable at these radii.
+ *
+ * ## Intermediate texture reuse
+ *
+ * Blurs are usually recreated every frame with the same size and sigma.
+ * Released blurs keep their intermediate textures, framebuffers and
+ * pipelines in a small per-context pool for a short while, so that
+ * consecutive frames don't need to reallocate them. As the blurred texture
+ * may still be sampled by journals that weren't flushed yet, blurs only
+ * become reusable once the frame they were released in is done.
+ *
  * ## Incremental gauss-factor calculation
  *
  * The kernel values for the gaussian kernel are computed incrementally instead
@@ -105,42 +125,140 @@ static const char *gaussian_blur_glsl =
 "                                                                          \n"
 "  cogl_texel = ret / gauss_coefficient_total;                             \n";
 
+static const char *dual_kawase_glsl_declarations =
+"uniform vec2 half_pixel;                                                  \n";
+
+static const char *dual_kawase_downsample_glsl =
+"  vec2 uv = vec2 (cogl_tex_coord.st);                                     \n"
+"                                                                          \n"
+"  vec4 ret = texture2D (cogl_sampler, uv) * 4.0;                          \n"
+"  ret += texture2D (cogl_sampler, uv - half_pixel);                       \n"
+"  ret += texture2D (cogl_sampler, uv + half_pixel);                       \n"
+"  ret += texture2D (cogl_sampler, uv + vec2 (half_pixel.x, -half_pixel.y));\n"
+"  ret += texture2D (cogl_sampler, uv - vec2 (half_pixel.x, -half_pixel.y));\n"
+"                                                                          \n"
+"  cogl_texel = ret / 8.0;                                                 \n";
+
+static const char *dual_kawase_upsample_glsl =
+"  vec2 uv = vec2 (cogl_tex_coord.st);                                     \n"
+"  vec2 hp = half_pixel;                                                   \n"
+"                                                                          \n"
+"  vec4 ret = texture2D (cogl_sampler, uv + vec2 (-hp.x * 2.0, 0.0));      \n"
+"  ret += texture2D (cogl_sampler, uv + vec2 (-hp.x, hp.y)) * 2.0;         \n"
+"  ret += texture2D (cogl_sampler, uv + vec2 (0.0, hp.y * 2.0));           \n"
+"  ret += texture2D (cogl_sampler, uv + vec2 (hp.x, hp.y)) * 2.0;          \n"
+"  ret += texture2D (cogl_sampler, uv + vec2 (hp.x * 2.0, 0.0));           \n"
+"  ret += texture2D (cogl_sampler, uv + vec2 (hp.x, -hp.y)) * 2.0;         \n"
+"  ret += texture2D (cogl_sampler, uv + vec2 (0.0, -hp.y * 2.0));          \n"
+"  ret += texture2D (cogl_sampler, uv + vec2 (-hp.x, -hp.y)) * 2.0;        \n"
+"                                                                          \n"
+"  cogl_texel = ret / 12.0;                                                \n";
+
 #define MIN_DOWNSCALE_SIZE 256.f
 #define MAX_SIGMA 6.f
 
-enum
+/* Above this sigma, the dual filter pyramid is used instead of the
+ * separable gaussian kernel.
+ */
+#define DUAL_KAWASE_MIN_SIGMA 12.f
+/* Each pyramid level approximately doubles the blur radius; keep adding
+ * levels until the remaining sigma per level is below this value.
+ */
+#define DUAL_KAWASE_SIGMA_PER_LEVEL 2.f
+#define DUAL_KAWASE_MIN_LEVELS 2
+#define DUAL_KAWASE_MAX_LEVELS 6
+#define DUAL_KAWASE_MIN_SIZE 8
+
+#define MAX_BLUR_PASSES (2 * DUAL_KAWASE_MAX_LEVELS - 1)
+
+#define BLUR_POOL_SIZE 4
+#define BLUR_POOL_EXPIRE_TIMEOUT_S 2
+
+typedef enum
 {
   VERTICAL,
   HORIZONTAL,
-};
+  DOWNSAMPLE,
+  UPSAMPLE,
+} BlurPassKind;
 
 typedef struct
 {
   CoglFramebuffer *framebuffer;
   CoglPipeline *pipeline;
   CoglTexture *texture;
-  int orientation;
+  BlurPassKind kind;
 } BlurPass;
 
 struct _ClutterBlur
 {
+  CoglContext *context;
   CoglTexture *source_texture;
+  int width;
+  int height;
   float sigma;
   float downscale_factor;
+  float offset;
 
-  BlurPass pass[2];
+  int n_passes;
+  BlurPass pass[MAX_BLUR_PASSES];
 };
 
+typedef struct
+{
+  /* Blurs that can be reused */
+  GQueue blurs;
+
+  /* Blurs released while painting the current frame. Journals that weren't
+   * flushed yet may still sample their textures, so they are only moved to
+   * the reusable pool once the frame is done.
+   */
+  GList *released_blurs;
+
+  unsigned int release_id;
+  unsigned int expire_id;
+} BlurPool;
+
+static CoglUserDataKey blur_pool_key;
+
 static CoglPipeline*
-create_blur_pipeline (void)
+create_blur_pipeline (BlurPassKind kind)
 {
   static CoglPipelineKey blur_pipeline_key = "clutter-blur-pipeline-private";
+  static CoglPipelineKey downsample_pipeline_key =
+    "clutter-blur-downsample-pipeline-private";
+  static CoglPipelineKey upsample_pipeline_key =
+    "clutter-blur-upsample-pipeline-private";
   CoglContext *ctx =
     clutter_backend_get_cogl_context (clutter_get_default_backend ());
+  CoglPipelineKey *pipeline_key;
   CoglPipeline *blur_pipeline;
+  const char *declarations;
+  const char *replace;
+
+  switch (kind)
+    {
+    case DOWNSAMPLE:
+      pipeline_key = &downsample_pipeline_key;
+      declarations = dual_kawase_glsl_declarations;
+      replace = dual_kawase_downsample_glsl;
+      break;
+    case UPSAMPLE:
+      pipeline_key = &upsample_pipeline_key;
+      declarations = dual_kawase_glsl_declarations;
+      replace = dual_kawase_upsample_glsl;
+      break;
+    case VERTICAL:
+    case HORIZONTAL:
+    default:
+      pipeline_key = &blur_pipeline_key;
+      declarations = gaussian_blur_glsl_declarations;
+      replace = gaussian_blur_glsl;
+      break;
+    }
 
   blur_pipeline =
-    cogl_context_get_named_pipeline (ctx, &blur_pipeline_key);
+    cogl_context_get_named_pipeline (ctx, pipeline_key);
 
   if (G_UNLIKELY (blur_pipeline == NULL))
     {
@@ -157,27 +275,55 @@ create_blur_pipeline (void)
                                          COGL_PIPELINE_WRAP_MODE_CLAMP_TO_EDGE);
 
       snippet = cogl_snippet_new (COGL_SNIPPET_HOOK_TEXTURE_LOOKUP,
-                                  gaussian_blur_glsl_declarations,
+                                  declarations,
                                   NULL);
-      cogl_snippet_set_replace (snippet, gaussian_blur_glsl);
+      cogl_snippet_set_replace (snippet, replace);
       cogl_pipeline_add_layer_snippet (blur_pipeline, 0, snippet);
       cogl_object_unref (snippet);
 
-      cogl_context_set_named_pipeline (ctx, &blur_pipeline_key, blur_pipeline);
+      cogl_context_set_named_pipeline (ctx, pipeline_key, blur_pipeline);
     }
 
   return cogl_pipeline_copy (blur_pipeline);
 }
 
+static void
+update_dual_kawase_uniforms (ClutterBlur *blur,
+                             BlurPass    *pass)
+{
+  int half_pixel_uniform;
+
+  half_pixel_uniform =
+    cogl_pipeline_get_uniform_location (pass->pipeline, "half_pixel");
+  if (half_pixel_uniform > -1)
+    {
+      float half_pixel[2] = {
+        0.5f * blur->offset / cogl_texture_get_width (pass->texture),
+        0.5f * blur->offset / cogl_texture_get_height (pass->texture),
+      };
+
+      cogl_pipeline_set_uniform_float (pass->pipeline,
+                                       half_pixel_uniform,
+                                       2, 1,
+                                       half_pixel);
+    }
+}
+
 static void
 update_blur_uniforms (ClutterBlur *blur,
                       BlurPass    *pass)
 {
-  gboolean vertical = pass->orientation == VERTICAL;
+  gboolean vertical = pass->kind == VERTICAL;
   int sigma_uniform;
   int pixel_step_uniform;
   int direction_uniform;
 
+  if (pass->kind == DOWNSAMPLE || pass->kind == UPSAMPLE)
+    {
+      update_dual_kawase_uniforms (blur, pass);
+      return;
+    }
+
   pixel_step_uniform =
     cogl_pipeline_get_uniform_location (pass->pipeline, "pixel_step");
   if (pixel_step_uniform > -1)
@@ -221,22 +367,19 @@ update_blur_uniforms (ClutterBlur *blur,
 
 static gboolean
 create_fbo (ClutterBlur *blur,
-            BlurPass    *pass)
+            BlurPass    *pass,
+            float        downscale_factor)
 {
   CoglContext *ctx =
     clutter_backend_get_cogl_context (clutter_get_default_backend ());
   float scaled_height;
   float scaled_width;
-  float height;
-  float width;
 
   g_clear_pointer (&pass->texture, cogl_object_unref);
   g_clear_object (&pass->framebuffer);
 
-  width = cogl_texture_get_width (blur->source_texture);
-  height = cogl_texture_get_height (blur->source_texture);
-  scaled_width = floorf (width / blur->downscale_factor);
-  scaled_height = floorf (height / blur->downscale_factor);
+  scaled_width = MAX (1.f, floorf (blur->width / downscale_factor));
+  scaled_height = MAX (1.f, floorf (blur->height / downscale_factor));
 
   pass->texture = COGL_TEXTURE (cogl_texture_2d_new_with_size (ctx,
                                                                scaled_width,
@@ -261,22 +404,73 @@ create_fbo (ClutterBlur *blur,
 }
 
 static gboolean
-setup_blur_pass (ClutterBlur *blur,
-                 BlurPass    *pass,
-                 int          orientation,
-                 CoglTexture *texture)
+setup_blur_pass (ClutterBlur  *blur,
+                 BlurPass     *pass,
+                 BlurPassKind  kind,
+                 CoglTexture  *texture,
+                 float         downscale_factor)
 {
-  pass->orientation = orientation;
-  pass->pipeline = create_blur_pipeline ();
+  pass->kind = kind;
+  pass->pipeline = create_blur_pipeline (kind);
   cogl_pipeline_set_layer_texture (pass->pipeline, 0, texture);
 
-  if (!create_fbo (blur, pass))
+  if (!create_fbo (blur, pass, downscale_factor))
     return FALSE;
 
   update_blur_uniforms (blur, pass);
   return TRUE;
 }
 
+static gboolean
+setup_gaussian_passes (ClutterBlur *blur)
+{
+  BlurPass *vpass = &blur->pass[0];
+  BlurPass *hpass = &blur->pass[1];
+
+  blur->n_passes = 2;
+
+  return setup_blur_pass (blur, vpass, VERTICAL,
+                          blur->source_texture, blur->downscale_factor) &&
+         setup_blur_pass (blur, hpass, HORIZONTAL,
+                          vpass->texture, blur->downscale_factor);
+}
+
+static gboolean
+setup_dual_kawase_passes (ClutterBlur *blur,
+                          int          n_levels)
+{
+  CoglTexture *texture = blur->source_texture;
+  int i;
+
+  blur->n_passes = 2 * n_levels - 1;
+
+  /* Downsample into levels 1…n_levels, then upsample back up to level 1,
+   * which is half the size of the source texture.
+   */
+  for (i = 0; i < n_levels; i++)
+    {
+      BlurPass *pass = &blur->pass[i];
+
+      if (!setup_blur_pass (blur, pass, DOWNSAMPLE, texture, 1 << (i + 1)))
+        return FALSE;
+
+      texture = pass->texture;
+    }
+
+  for (i = 0; i < n_levels - 1; i++)
+    {
+      BlurPass *pass = &blur->pass[n_levels + i];
+      int level = n_levels - i - 1;
+
+      if (!setup_blur_pass (blur, pass, UPSAMPLE, texture, 1 << level))
+        return FALSE;
+
+      texture = pass->texture;
+    }
+
+  return TRUE;
+}
+
 static float
 calculate_downscale_factor (float width,
                             float height,
@@ -305,6 +499,33 @@ calculate_downscale_factor (float width,
   return downscale_factor;
 }
 
+static int
+calculate_dual_kawase_levels (float  width,
+                              float  height,
+                              float  sigma,
+                              float *out_offset)
+{
+  int n_levels = DUAL_KAWASE_MIN_LEVELS;
+
+  while (n_levels < DUAL_KAWASE_MAX_LEVELS &&
+         sigma / (1 << n_levels) > DUAL_KAWASE_SIGMA_PER_LEVEL &&
+         width / (1 << (n_levels + 1)) >= DUAL_KAWASE_MIN_SIZE &&
+         height / (1 << (n_levels + 1)) >= DUAL_KAWASE_MIN_SIZE)
+    n_levels++;
+
+  if (width / (1 << n_levels) < DUAL_KAWASE_MIN_SIZE ||
+      height / (1 << n_levels) < DUAL_KAWASE_MIN_SIZE)
+    return 0;
+
+  /* Spread the samples further apart to cover whatever radius is left
+   * over after the last level.
+   */
+  *out_offset = CLAMP (sigma / (1 << n_levels),
+                       1.f, 2.f * DUAL_KAWASE_SIGMA_PER_LEVEL);
+
+  return n_levels;
+}
+
 static void
 apply_blur_pass (BlurPass *pass)
 {
@@ -331,6 +552,138 @@ clear_blur_pass (BlurPass *pass)
   g_clear_object (&pass->framebuffer);
 }
 
+static void
+destroy_blur (ClutterBlur *blur)
+{
+  int i;
+
+  for (i = 0; i < MAX_BLUR_PASSES; i++)
+    clear_blur_pass (&blur->pass[i]);
+  cogl_clear_object (&blur->source_texture);
+  g_free (blur);
+}
+
+static void
+blur_pool_free (BlurPool *pool)
+{
+  g_clear_handle_id (&pool->release_id, g_source_remove);
+  g_clear_handle_id (&pool->expire_id, g_source_remove);
+  g_list_free_full (g_steal_pointer (&pool->released_blurs),
+                    (GDestroyNotify) destroy_blur);
+  g_queue_clear_full (&pool->blurs, (GDestroyNotify) destroy_blur);
+  g_free (pool);
+}
+
+static BlurPool *
+ensure_blur_pool (CoglContext *context)
+{
+  BlurPool *pool;
+
+  pool = cogl_object_get_user_data (COGL_OBJECT (context), &blur_pool_key);
+  if (pool)
+    return pool;
+
+  pool = g_new0 (BlurPool, 1);
+  g_queue_init (&pool->blurs);
+  cogl_object_set_user_data (COGL_OBJECT (context),
+                             &blur_pool_key,
+                             pool,
+                             (CoglUserDataDestroyCallback) blur_pool_free);
+
+  return pool;
+}
+
+static gboolean
+expire_blur_pool (gpointer user_data)
+{
+  BlurPool *pool = user_data;
+  ClutterBlur *blur;
+
+  while ((blur = g_queue_pop_head (&pool->blurs)))
+    destroy_blur (blur);
+
+  pool->expire_id = 0;
+  return G_SOURCE_REMOVE;
+}
+
+static gboolean
+release_blurs (gpointer user_data)
+{
+  BlurPool *pool = user_data;
+  GList *l;
+
+  for (l = pool->released_blurs; l; l = l->next)
+    g_queue_push_head (&pool->blurs, l->data);
+  g_clear_pointer (&pool->released_blurs, g_list_free);
+
+  while (g_queue_get_length (&pool->blurs) > BLUR_POOL_SIZE)
+    destroy_blur (g_queue_pop_tail (&pool->blurs));
+
+  g_clear_handle_id (&pool->expire_id, g_source_remove);
+  pool->expire_id = g_timeout_add_seconds (BLUR_POOL_EXPIRE_TIMEOUT_S,
+                                           expire_blur_pool,
+                                           pool);
+  g_source_set_name_by_id (pool->expire_id, "[clutter] expire_blur_pool");
+
+  pool->release_id = 0;
+  return G_SOURCE_REMOVE;
+}
+
+static ClutterBlur *
+steal_pooled_blur (CoglContext *context,
+                   CoglTexture *texture,
+                   float        sigma)
+{
+  int width = cogl_texture_get_width (texture);
+  int height = cogl_texture_get_height (texture);
+  BlurPool *pool;
+  GList *l;
+
+  pool = cogl_object_get_user_data (COGL_OBJECT (context), &blur_pool_key);
+  if (!pool)
+    return NULL;
+
+  for (l = pool->blurs.head; l; l = l->next)
+    {
+      ClutterBlur *blur = l->data;
+
+      if (blur->width != width ||
+          blur->height != height ||
+          !G_APPROX_VALUE (blur->sigma, sigma, FLT_EPSILON))
+        continue;
+
+      g_queue_delete_link (&pool->blurs, l);
+
+      blur->source_texture = cogl_object_ref (texture);
+      cogl_pipeline_set_layer_texture (blur->pass[0].pipeline, 0, texture);
+
+      return blur;
+    }
+
+  return NULL;
+}
+
+static void
+pool_blur (ClutterBlur *blur)
+{
+  BlurPool *pool = ensure_blur_pool (blur->context);
+
+  /* Don't keep the source texture alive while pooled */
+  cogl_pipeline_set_layer_null_texture (blur->pass[0].pipeline, 0);
+  cogl_clear_object (&blur->source_texture);
+
+  pool->released_blurs = g_list_prepend (pool->released_blurs, blur);
+
+  if (!pool->release_id)
+    {
+      pool->release_id = g_idle_add_full (G_PRIORITY_HIGH_IDLE,
+                                          release_blurs,
+                                          pool,
+                                          NULL);
+      g_source_set_name_by_id (pool->release_id, "[clutter] release_blurs");
+    }
+}
+
 /**
  * clutter_blur_new:
  * @texture: a #CoglTexture
@@ -344,33 +697,50 @@ ClutterBlur *
 clutter_blur_new (CoglTexture *texture,
                   float        sigma)
 {
+  CoglContext *context =
+    clutter_backend_get_cogl_context (clutter_get_default_backend ());
   ClutterBlur *blur;
   unsigned int height;
   unsigned int width;
-  BlurPass *hpass;
-  BlurPass *vpass;
+  int n_levels = 0;
+  gboolean success;
 
   g_return_val_if_fail (texture != NULL, NULL);
   g_return_val_if_fail (sigma >= 0.0, NULL);
 
+  if (!G_APPROX_VALUE (sigma, 0.0, FLT_EPSILON))
+    {
+      blur = steal_pooled_blur (context, texture, sigma);
+      if (blur)
+        return blur;
+    }
+
   width = cogl_texture_get_width (texture);
   height = cogl_texture_get_height (texture);
 
   blur = g_new0 (ClutterBlur, 1);
+  blur->context = context;
   blur->sigma = sigma;
+  blur->width = width;
+  blur->height = height;
   blur->source_texture = cogl_object_ref (texture);
   blur->downscale_factor = calculate_downscale_factor (width, height, sigma);
 
   if (G_APPROX_VALUE (sigma, 0.0, FLT_EPSILON))
     goto out;
 
-  vpass = &blur->pass[VERTICAL];
-  hpass = &blur->pass[HORIZONTAL];
+  if (sigma >= DUAL_KAWASE_MIN_SIGMA)
+    n_levels = calculate_dual_kawase_levels (width, height, sigma,
+                                             &blur->offset);
+
+  if (n_levels > 0)
+    success = setup_dual_kawase_passes (blur, n_levels);
+  else
+    success = setup_gaussian_passes (blur);
 
-  if (!setup_blur_pass (blur, vpass, VERTICAL, texture) ||
-      !setup_blur_pass (blur, hpass, HORIZONTAL, vpass->texture))
+  if (!success)
     {
-      clutter_blur_free (blur);
+      destroy_blur (blur);
       return NULL;
     }
 
@@ -388,11 +758,10 @@ out:
 void
 clutter_blur_apply (ClutterBlur *blur)
 {
-  if (G_APPROX_VALUE (blur->sigma, 0.0, FLT_EPSILON))
-    return;
+  int i;
 
-  apply_blur_pass (&blur->pass[VERTICAL]);
-  apply_blur_pass (&blur->pass[HORIZONTAL]);
+  for (i = 0; i < blur->n_passes; i++)
+    apply_blur_pass (&blur->pass[i]);
 }
 
 /**
@@ -407,25 +776,27 @@ clutter_blur_apply (ClutterBlur *blur)
 CoglTexture *
 clutter_blur_get_texture (ClutterBlur *blur)
 {
-  if (G_APPROX_VALUE (blur->sigma, 0.0, FLT_EPSILON))
+  if (blur->n_passes == 0)
     return blur->source_texture;
   else
-    return blur->pass[HORIZONTAL].texture;
+    return blur->pass[blur->n_passes - 1].texture;
 }
 
 /**
  * clutter_blur_free:
  * @blur: A #ClutterBlur
  *
- * Frees @blur.
+ * Frees @blur. The intermediate textures may be kept around for a short
+ * while, to be reused by a subsequent blur with the same size and sigma
+ * once the current frame has been painted.
  */
 void
 clutter_blur_free (ClutterBlur *blur)
 {
   g_assert (blur);
 
-  clear_blur_pass (&blur->pass[VERTICAL]);
-  clear_blur_pass (&blur->pass[HORIZONTAL]);
-  cogl_clear_object (&blur->source_texture);
-  g_free (blur);
+  if (blur->n_passes > 0)
+    pool_blur (blur);
+  else
+    destroy_blur (blur);
 }
@@ -109,6 +109,12 @@ struct _ClutterFrameClock
   gboolean pending_reschedule;
   gboolean pending_reschedule_now;
 
+  /* Earliest presentation time an update was requested for, or 0 */
+  int64_t requested_presentation_time_us;
+  /* Whether the scheduled update is for a requested presentation time,
+   * and may be moved earlier by a regular update */
+  gboolean is_next_update_timed;
+
   int inhibit_count;
 
   GList *timelines;
@@ -220,6 +226,11 @@ maybe_reschedule_update (ClutterFrameClock *frame_clock)
           clutter_frame_clock_schedule_update (frame_clock);
         }
     }
+  else if (frame_clock->requested_presentation_time_us)
+    {
+      clutter_frame_clock_schedule_update_at (frame_clock,
+                                              frame_clock->requested_presentation_time_us);
+    }
 }
 
 static void
@@ -606,6 +617,87 @@ calculate_next_update_time_us (ClutterFrameClock *frame_clock,
   *out_min_render_time_allowed_us = min_render_time_allowed_us;
 }
 
+/*
+ * Requested presentation times are never scheduled more than this many
+ * refresh cycles after the earliest possible presentation. Whoever requested
+ * one later than that has to request it again from the dispatched update, so
+ * a far away time can't hold back the frame clock.
+ */
+#define MAX_SCHEDULE_AHEAD_REFRESH_CYCLES 2
+
+/*
+ * Like calculate_next_update_time_us() but for the first presentation at or
+ * after presentation_time_us. In variable refresh rate mode, the presentation
+ * itself is moved there instead.
+ */
+static void
+calculate_next_update_time_for_presentation_us (ClutterFrameClock *frame_clock,
+                                                int64_t            presentation_time_us,
+                                                int64_t           *out_next_update_time_us,
+                                                int64_t           *out_next_presentation_time_us,
+                                                int64_t           *out_min_render_time_allowed_us)
+{
+  int64_t refresh_interval_us = frame_clock->refresh_interval_us;
+  int64_t max_render_time_allowed_us;
+  int64_t next_presentation_time_us;
+  int64_t now_us;
+
+  max_render_time_allowed_us =
+    clutter_frame_clock_compute_max_render_time_us (frame_clock);
+
+  switch (frame_clock->mode)
+    {
+    case CLUTTER_FRAME_CLOCK_MODE_FIXED:
+      calculate_next_update_time_us (frame_clock,
+                                     out_next_update_time_us,
+                                     out_next_presentation_time_us,
+                                     out_min_render_time_allowed_us);
+
+      next_presentation_time_us = *out_next_presentation_time_us;
+      if (next_presentation_time_us == 0 ||
+          next_presentation_time_us >= presentation_time_us)
+        return;
+
+      presentation_time_us =
+        MIN (presentation_time_us,
+             next_presentation_time_us +
+             MAX_SCHEDULE_AHEAD_REFRESH_CYCLES * refresh_interval_us);
+
+      next_presentation_time_us +=
+        ((presentation_time_us - next_presentation_time_us +
+          refresh_interval_us - 1) / refresh_interval_us) * refresh_interval_us;
+
+      *out_next_update_time_us =
+        next_presentation_time_us - max_render_time_allowed_us;
+      *out_next_presentation_time_us = next_presentation_time_us;
+      return;
+    case CLUTTER_FRAME_CLOCK_MODE_VARIABLE:
+      now_us = g_get_monotonic_time ();
+
+      next_presentation_time_us = now_us + max_render_time_allowed_us;
+      if (frame_clock->last_presentation_time_us)
+        {
+          next_presentation_time_us =
+            MAX (next_presentation_time_us,
+                 frame_clock->last_presentation_time_us + refresh_interval_us);
+        }
+
+      next_presentation_time_us =
+        CLAMP (presentation_time_us,
+               next_presentation_time_us,
+               next_presentation_time_us +
+               MAX_SCHEDULE_AHEAD_REFRESH_CYCLES * refresh_interval_us);
+
+      *out_next_update_time_us =
+        next_presentation_time_us - max_render_time_allowed_us;
+      *out_next_presentation_time_us = next_presentation_time_us;
+      *out_min_render_time_allowed_us = max_render_time_allowed_us;
+      return;
+    }
+
+  g_assert_not_reached ();
+}
+
 static void
 calculate_next_idle_timeout_us (ClutterFrameClock *frame_clock,
                                 int64_t           *out_next_update_time_us)
@@ -709,12 +801,15 @@ clutter_frame_clock_schedule_update_now (ClutterFrameClock *frame_clock)
   g_source_set_ready_time (frame_clock->source, next_update_time_us);
   frame_clock->state = CLUTTER_FRAME_CLOCK_STATE_SCHEDULED;
   frame_clock->is_next_presentation_time_valid = FALSE;
+  frame_clock->is_next_update_timed = FALSE;
 }
 
 void
 clutter_frame_clock_schedule_update (ClutterFrameClock *frame_clock)
 {
   int64_t next_update_time_us = -1;
+  int64_t next_presentation_time_us;
+  int64_t min_render_time_allowed_us;
 
   if (frame_clock->inhibit_count > 0)
     {
@@ -731,8 +826,12 @@ clutter_frame_clock_schedule_update (ClutterFrameClock *frame_clock)
       return;
     case CLUTTER_FRAME_CLOCK_STATE_IDLE:
       break;
-    case CLUTTER_FRAME_CLOCK_STATE_IDLE_TIMEOUT:
     case CLUTTER_FRAME_CLOCK_STATE_SCHEDULED:
+      /* An update timed for a later presentation must not delay this one */
+      if (frame_clock->is_next_update_timed)
+        break;
+      return;
+    case CLUTTER_FRAME_CLOCK_STATE_IDLE_TIMEOUT:
       return;
     case CLUTTER_FRAME_CLOCK_STATE_DISPATCHING:
     case CLUTTER_FRAME_CLOCK_STATE_PENDING_PRESENTED:
@@ -745,8 +844,14 @@ clutter_frame_clock_schedule_update (ClutterFrameClock *frame_clock)
     case CLUTTER_FRAME_CLOCK_MODE_FIXED:
       calculate_next_update_time_us (frame_clock,
                                      &next_update_time_us,
-                                     &frame_clock->next_presentation_time_us,
-                                     &frame_clock->min_render_time_allowed_us);
+                                     &next_presentation_time_us,
+                                     &min_render_time_allowed_us);
+      if (frame_clock->state == CLUTTER_FRAME_CLOCK_STATE_SCHEDULED &&
+          frame_clock->next_update_time_us <= next_update_time_us)
+        return;
+
+      frame_clock->next_presentation_time_us = next_presentation_time_us;
+      frame_clock->min_render_time_allowed_us = min_render_time_allowed_us;
       frame_clock->is_next_presentation_time_valid =
             (frame_clock->next_presentation_time_us != 0);
       frame_clock->state = CLUTTER_FRAME_CLOCK_STATE_SCHEDULED;
@@ -754,6 +859,10 @@ clutter_frame_clock_schedule_update (ClutterFrameClock *frame_clock)
     case CLUTTER_FRAME_CLOCK_MODE_VARIABLE:
       calculate_next_idle_timeout_us (frame_clock,
                                       &next_update_time_us);
+      if (frame_clock->state == CLUTTER_FRAME_CLOCK_STATE_SCHEDULED &&
+          frame_clock->next_update_time_us <= next_update_time_us)
+        return;
+
       frame_clock->is_next_presentation_time_valid = FALSE;
       frame_clock->state = CLUTTER_FRAME_CLOCK_STATE_IDLE_TIMEOUT;
       break;
@@ -761,10 +870,107 @@ clutter_frame_clock_schedule_update (ClutterFrameClock *frame_clock)
 
   g_warn_if_fail (next_update_time_us != -1);
 
+  frame_clock->is_next_update_timed = FALSE;
   frame_clock->next_update_time_us = next_update_time_us;
   g_source_set_ready_time (frame_clock->source, next_update_time_us);
 }
 
+/**
+ * clutter_frame_clock_schedule_update_at:
+ * @frame_clock: a #ClutterFrameClock
+ * @presentation_time_us: the earliest wanted presentation time
+ *
+ * Schedules an update for the first presentation at or after
+ * @presentation_time_us, unless an earlier one is already scheduled. In
+ * variable refresh rate mode, the presentation is timed to happen at
+ * @presentation_time_us when possible.
+ *
+ * The request only applies to the next dispatched update; if that turns out
+ * to be too early, it needs to be made again. Updates are never scheduled
+ * more than a couple of refresh cycles ahead for this, and regular updates
+ * scheduled in the meantime still happen at their usual time.
+ */
+void
+clutter_frame_clock_schedule_update_at (ClutterFrameClock *frame_clock,
+                                        int64_t            presentation_time_us)
+{
+  int64_t next_update_time_us;
+  int64_t next_presentation_time_us;
+  int64_t min_render_time_allowed_us;
+
+  if (!frame_clock->requested_presentation_time_us ||
+      presentation_time_us < frame_clock->requested_presentation_time_us)
+    frame_clock->requested_presentation_time_us = presentation_time_us;
+
+  if (frame_clock->inhibit_count > 0)
+    return;
+
+  switch (frame_clock->state)
+    {
+    case CLUTTER_FRAME_CLOCK_STATE_INIT:
+      clutter_frame_clock_schedule_update (frame_clock);
+      return;
+    case CLUTTER_FRAME_CLOCK_STATE_IDLE:
+    case CLUTTER_FRAME_CLOCK_STATE_IDLE_TIMEOUT:
+    case CLUTTER_FRAME_CLOCK_STATE_SCHEDULED:
+      break;
+    case CLUTTER_FRAME_CLOCK_STATE_DISPATCHING:
+    case CLUTTER_FRAME_CLOCK_STATE_PENDING_PRESENTED:
+      /* Handled by maybe_reschedule_update() */
+      return;
+    }
+
+  calculate_next_update_time_for_presentation_us (frame_clock,
+                                                  frame_clock->requested_presentation_time_us,
+                                                  &next_update_time_us,
+                                                  &next_presentation_time_us,
+                                                  &min_render_time_allowed_us);
+
+  if ((frame_clock->state == CLUTTER_FRAME_CLOCK_STATE_SCHEDULED ||
+       frame_clock->state == CLUTTER_FRAME_CLOCK_STATE_IDLE_TIMEOUT) &&
+      frame_clock->next_update_time_us <= next_update_time_us)
+    return;
+
+  next_update_time_us = MAX (next_update_time_us, g_get_monotonic_time ());
+
+  frame_clock->next_update_time_us = next_update_time_us;
+  frame_clock->next_presentation_time_us = next_presentation_time_us;
+  frame_clock->min_render_time_allowed_us = min_render_time_allowed_us;
+  frame_clock->is_next_presentation_time_valid =
+    (next_presentation_time_us != 0);
+  frame_clock->is_next_update_timed = TRUE;
+  frame_clock->state = CLUTTER_FRAME_CLOCK_STATE_SCHEDULED;
+  g_source_set_ready_time (frame_clock->source, next_update_time_us);
+}
+
+/**
+ * clutter_frame_clock_get_next_update_time:
+ * @frame_clock: a #ClutterFrameClock
+ * @out_next_update_time_us: (out): return location for the update time
+ *
+ * Predicts when the update following the one being dispatched needs to
+ * start to make it to the refresh cycle after the current target
+ * presentation. This is the deadline for new content to be shown one
+ * refresh cycle after the current frame.
+ *
+ * Returns: %FALSE if there is no prediction, e.g. in variable refresh rate
+ *   mode, where updates are not aligned to refresh cycles.
+ */
+gboolean
+clutter_frame_clock_get_next_update_time (ClutterFrameClock *frame_clock,
+                                          int64_t           *out_next_update_time_us)
+{
+  if (frame_clock->mode != CLUTTER_FRAME_CLOCK_MODE_FIXED ||
+      !frame_clock->is_next_presentation_time_valid)
+    return FALSE;
+
+  *out_next_update_time_us =
+    frame_clock->next_presentation_time_us +
+    frame_clock->refresh_interval_us -
+    clutter_frame_clock_compute_max_render_time_us (frame_clock);
+  return TRUE;
+}
+
 void
 clutter_frame_clock_set_mode (ClutterFrameClock     *frame_clock,
                               ClutterFrameClockMode  mode)
@@ -840,6 +1046,8 @@ clutter_frame_clock_dispatch (ClutterFrameClock *frame_clock,
     }
 
   frame_clock->last_dispatch_time_us = time_us;
+  frame_clock->requested_presentation_time_us = 0;
+  frame_clock->is_next_update_timed = FALSE;
   g_source_set_ready_time (frame_clock->source, -1);
 
   frame_clock->state = CLUTTER_FRAME_CLOCK_STATE_DISPATCHING;
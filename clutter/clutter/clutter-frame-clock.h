@@ -86,6 +86,14 @@ void clutter_frame_clock_schedule_update (ClutterFrameClock *frame_clock);
 CLUTTER_EXPORT
 void clutter_frame_clock_schedule_update_now (ClutterFrameClock *frame_clock);
 
+CLUTTER_EXPORT
+void clutter_frame_clock_schedule_update_at (ClutterFrameClock *frame_clock,
+                                             int64_t            presentation_time_us);
+
+CLUTTER_EXPORT
+gboolean clutter_frame_clock_get_next_update_time (ClutterFrameClock *frame_clock,
+                                                   int64_t           *out_next_update_time_us);
+
 CLUTTER_EXPORT
 void clutter_frame_clock_inhibit (ClutterFrameClock *frame_clock);
 
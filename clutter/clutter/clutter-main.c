@@ -82,6 +82,8 @@ static ClutterMainContext *ClutterCntx       = NULL;
 static gboolean clutter_is_initialized       = FALSE;
 static gboolean clutter_show_fps             = FALSE;
 static gboolean clutter_disable_mipmap_text  = FALSE;
+static gboolean clutter_enable_sdf_text      = FALSE;
+static gboolean clutter_enable_async_glyphs  = FALSE;
 static gboolean clutter_enable_accessibility = TRUE;
 static gboolean clutter_sync_to_vblank       = TRUE;
 
@@ -137,6 +139,7 @@ static const GDebugKey clutter_paint_debug_keys[] = {
   { "damage-region", CLUTTER_DEBUG_PAINT_DAMAGE_REGION },
   { "disable-dynamic-max-render-time", CLUTTER_DEBUG_DISABLE_DYNAMIC_MAX_RENDER_TIME },
   { "max-render-time", CLUTTER_DEBUG_PAINT_MAX_RENDER_TIME },
+  { "gpu-timings", CLUTTER_DEBUG_PAINT_GPU_TIMINGS },
 };
 
 gboolean
@@ -202,6 +205,9 @@ clutter_context_get_pango_fontmap (void)
 
   use_mipmapping = !clutter_disable_mipmap_text;
   cogl_pango_font_map_set_use_mipmapping (font_map, use_mipmapping);
+  cogl_pango_font_map_set_use_sdf (font_map, clutter_enable_sdf_text);
+  cogl_pango_font_map_set_use_async_rasterization (font_map,
+                                                   clutter_enable_async_glyphs);
 
   self->font_map = font_map;
 
@@ -588,6 +594,14 @@ init_clutter_debug (ClutterMainContext *clutter_context)
   env_string = g_getenv ("CLUTTER_DISABLE_MIPMAPPED_TEXT");
   if (env_string)
     clutter_disable_mipmap_text = TRUE;
+
+  env_string = g_getenv ("CLUTTER_ENABLE_SDF_TEXT");
+  if (env_string)
+    clutter_enable_sdf_text = TRUE;
+
+  env_string = g_getenv ("CLUTTER_ENABLE_ASYNC_GLYPHS");
+  if (env_string)
+    clutter_enable_async_glyphs = TRUE;
 }
 
 ClutterContext *
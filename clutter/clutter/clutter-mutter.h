@@ -96,6 +96,10 @@ void clutter_stage_view_assign_next_scanout (ClutterStageView *stage_view,
 CLUTTER_EXPORT
 gboolean clutter_actor_has_damage (ClutterActor *actor);
 
+CLUTTER_EXPORT
+void clutter_actor_set_gpu_timing_label (ClutterActor *actor,
+                                         const char   *label);
+
 CLUTTER_EXPORT
 gboolean clutter_actor_has_transitions (ClutterActor *actor);
 
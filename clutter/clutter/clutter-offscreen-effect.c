@@ -364,6 +364,17 @@ clutter_offscreen_effect_pre_paint (ClutterEffect       *effect,
   if (!update_fbo (effect, target_width, target_height, resource_scale))
     goto disable_effect;
 
+  /* Rather than stalling the frame while the driver compiles the program
+   * for the effect, paint the actor without it until the program is ready.
+   * The framebuffer is kept around so it doesn't need to be recreated once
+   * the effect is ready to be used.
+   */
+  if (priv->pipeline && !cogl_pipeline_precompile (priv->pipeline))
+    {
+      clutter_actor_queue_redraw (priv->actor);
+      return FALSE;
+    }
+
   offscreen = COGL_FRAMEBUFFER (priv->offscreen);
 
   /* We don't want the FBO contents to be transformed. That could waste memory
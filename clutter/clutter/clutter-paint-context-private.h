@@ -20,10 +20,11 @@
 #include "clutter/clutter-paint-context.h"
 
 ClutterPaintContext *
-clutter_paint_context_new_for_view (ClutterStageView     *view,
-                                    const cairo_region_t *redraw_clip,
-                                    GArray               *clip_frusta,
-                                    ClutterPaintFlag      paint_flags);
+clutter_paint_context_new_for_view (ClutterStageView         *view,
+                                    const cairo_region_t     *redraw_clip,
+                                    GArray                   *clip_frusta,
+                                    const graphene_frustum_t *clip_bounds_frustum,
+                                    ClutterPaintFlag          paint_flags);
 
 gboolean clutter_paint_context_is_drawing_off_stage (ClutterPaintContext *paint_context);
 
@@ -32,5 +33,14 @@ CoglFramebuffer * clutter_paint_context_get_base_framebuffer (ClutterPaintContex
 const GArray *
 clutter_paint_context_get_clip_frusta (ClutterPaintContext *paint_context);
 
+const graphene_frustum_t *
+clutter_paint_context_get_clip_bounds_frustum (ClutterPaintContext *paint_context);
+
+void clutter_paint_context_push_inside_clip (ClutterPaintContext *paint_context);
+
+void clutter_paint_context_pop_inside_clip (ClutterPaintContext *paint_context);
+
+gboolean clutter_paint_context_is_inside_clip (ClutterPaintContext *paint_context);
+
 void clutter_paint_context_assign_frame (ClutterPaintContext *paint_context,
                                          ClutterFrame        *frame);
@@ -33,6 +33,11 @@ struct _ClutterPaintContext
 
   cairo_region_t *redraw_clip;
   GArray *clip_frusta;
+
+  gboolean has_clip_bounds_frustum;
+  graphene_frustum_t clip_bounds_frustum;
+
+  int inside_clip_level;
 };
 
 G_DEFINE_BOXED_TYPE (ClutterPaintContext, clutter_paint_context,
@@ -40,10 +45,11 @@ G_DEFINE_BOXED_TYPE (ClutterPaintContext, clutter_paint_context,
                      clutter_paint_context_unref)
 
 ClutterPaintContext *
-clutter_paint_context_new_for_view (ClutterStageView     *view,
-                                    const cairo_region_t *redraw_clip,
-                                    GArray               *clip_frusta,
-                                    ClutterPaintFlag      paint_flags)
+clutter_paint_context_new_for_view (ClutterStageView         *view,
+                                    const cairo_region_t     *redraw_clip,
+                                    GArray                   *clip_frusta,
+                                    const graphene_frustum_t *clip_bounds_frustum,
+                                    ClutterPaintFlag          paint_flags)
 {
   ClutterPaintContext *paint_context;
   CoglFramebuffer *framebuffer;
@@ -55,6 +61,12 @@ clutter_paint_context_new_for_view (ClutterStageView     *view,
   paint_context->clip_frusta = g_array_ref (clip_frusta);
   paint_context->paint_flags = paint_flags;
 
+  if (clip_bounds_frustum)
+    {
+      paint_context->clip_bounds_frustum = *clip_bounds_frustum;
+      paint_context->has_clip_bounds_frustum = TRUE;
+    }
+
   framebuffer = clutter_stage_view_get_framebuffer (view);
   clutter_paint_context_push_framebuffer (paint_context, framebuffer);
 
@@ -146,6 +158,49 @@ clutter_paint_context_get_clip_frusta (ClutterPaintContext *paint_context)
   return paint_context->clip_frusta;
 }
 
+/*
+ * clutter_paint_context_get_clip_bounds_frustum:
+ *
+ * Returns a frustum enclosing all the clip frusta, or %NULL if there is only
+ * a single clip frustum. Anything outside of it can be culled with a single
+ * test, regardless of how many clip frusta there are.
+ */
+const graphene_frustum_t *
+clutter_paint_context_get_clip_bounds_frustum (ClutterPaintContext *paint_context)
+{
+  if (!paint_context->has_clip_bounds_frustum)
+    return NULL;
+
+  return &paint_context->clip_bounds_frustum;
+}
+
+/*
+ * clutter_paint_context_push_inside_clip:
+ *
+ * Marks that the actor currently being painted is known to be fully inside
+ * one of the clip frusta. Since the visible paint volume of an actor contains
+ * the ones of its children, there is no need to cull its descendants.
+ */
+void
+clutter_paint_context_push_inside_clip (ClutterPaintContext *paint_context)
+{
+  paint_context->inside_clip_level++;
+}
+
+void
+clutter_paint_context_pop_inside_clip (ClutterPaintContext *paint_context)
+{
+  g_return_if_fail (paint_context->inside_clip_level > 0);
+
+  paint_context->inside_clip_level--;
+}
+
+gboolean
+clutter_paint_context_is_inside_clip (ClutterPaintContext *paint_context)
+{
+  return paint_context->inside_clip_level > 0;
+}
+
 /**
  * clutter_paint_context_get_framebuffer:
  * @paint_context: The #ClutterPaintContext
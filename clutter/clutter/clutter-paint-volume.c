@@ -1004,6 +1004,7 @@ _clutter_paint_volume_cull (ClutterPaintVolume       *pv,
 {
   int vertex_count;
   graphene_box_t box;
+  int i;
 
   if (pv->is_empty)
     return CLUTTER_CULL_RESULT_OUT;
@@ -1022,10 +1023,18 @@ _clutter_paint_volume_cull (ClutterPaintVolume       *pv,
 
   graphene_box_init_from_points (&box, vertex_count, pv->vertices);
 
-  if (graphene_frustum_intersects_box (frustum, &box))
-    return CLUTTER_CULL_RESULT_IN;
-  else
+  if (!graphene_frustum_intersects_box (frustum, &box))
     return CLUTTER_CULL_RESULT_OUT;
+
+  /* The frustum is convex, so the volume is fully contained as soon as all
+   * of its vertices are. */
+  for (i = 0; i < vertex_count; i++)
+    {
+      if (!graphene_frustum_contains_point (frustum, &pv->vertices[i]))
+        return CLUTTER_CULL_RESULT_PARTIAL;
+    }
+
+  return CLUTTER_CULL_RESULT_IN;
 }
 
 void
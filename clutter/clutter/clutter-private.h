@@ -224,6 +224,10 @@ gboolean _clutter_util_rectangle_intersection (const cairo_rectangle_int_t *src1
 gboolean clutter_util_rectangle_equal (const cairo_rectangle_int_t *src1,
                                        const cairo_rectangle_int_t *src2);
 
+CLUTTER_EXPORT
+gboolean clutter_util_region_coalesce (cairo_region_t **region,
+                                       int              max_rectangles);
+
 CLUTTER_EXPORT
 PangoDirection _clutter_pango_unichar_direction (gunichar ch);
 
@@ -235,6 +239,7 @@ typedef enum _ClutterCullResult
   CLUTTER_CULL_RESULT_UNKNOWN,
   CLUTTER_CULL_RESULT_IN,
   CLUTTER_CULL_RESULT_OUT,
+  CLUTTER_CULL_RESULT_PARTIAL,
 } ClutterCullResult;
 
 gboolean        _clutter_has_progress_function  (GType gtype);
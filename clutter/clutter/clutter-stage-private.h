@@ -108,6 +108,16 @@ void            clutter_stage_presented                 (ClutterStage      *stag
                                                          ClutterStageView  *view,
                                                          ClutterFrameInfo  *frame_info);
 
+typedef struct _ClutterActorGpuTiming ClutterActorGpuTiming;
+
+ClutterActorGpuTiming * clutter_stage_begin_actor_gpu_timing (ClutterStage        *stage,
+                                                              ClutterPaintContext *paint_context,
+                                                              const char          *label);
+
+void clutter_stage_end_actor_gpu_timing (ClutterStage          *stage,
+                                         ClutterPaintContext   *paint_context,
+                                         ClutterActorGpuTiming *timing);
+
 void            clutter_stage_queue_actor_relayout      (ClutterStage *stage,
                                                          ClutterActor *actor);
 
@@ -31,6 +31,10 @@
 #include "clutter/clutter-stage-private.h"
 #include "cogl/cogl.h"
 
+/* Redraw clips are unions of many small actor clips; keep them from
+ * fragmenting into more rectangles than is cheap to clip and damage with. */
+#define MAX_REDRAW_CLIP_RECTANGLES 16
+
 enum
 {
   PROP_0,
@@ -977,6 +981,12 @@ clutter_stage_view_add_redraw_clip (ClutterStageView            *view,
   else
     {
       cairo_region_union_rectangle (priv->redraw_clip, clip);
+      if (cairo_region_num_rectangles (priv->redraw_clip) >
+          MAX_REDRAW_CLIP_RECTANGLES)
+        {
+          clutter_util_region_coalesce (&priv->redraw_clip,
+                                        MAX_REDRAW_CLIP_RECTANGLES);
+        }
       maybe_mark_full_redraw (view, &priv->redraw_clip);
     }
 
@@ -1046,6 +1056,8 @@ clutter_stage_view_accumulate_redraw_clip (ClutterStageView *view)
   if (priv->redraw_clip && priv->accumulated_redraw_clip)
     {
       cairo_region_union (priv->accumulated_redraw_clip, priv->redraw_clip);
+      clutter_util_region_coalesce (&priv->accumulated_redraw_clip,
+                                    MAX_REDRAW_CLIP_RECTANGLES);
       maybe_mark_full_redraw (view, &priv->accumulated_redraw_clip);
     }
   else if (priv->redraw_clip && !priv->has_accumulated_redraw_clip)
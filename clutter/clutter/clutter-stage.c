@@ -142,9 +142,24 @@ struct _ClutterStagePrivate
   GHashTable *pointer_devices;
   GHashTable *touch_sequences;
 
+  GPtrArray *pending_gpu_timings;
+
   guint actor_needs_immediate_relayout : 1;
 };
 
+struct _ClutterActorGpuTiming
+{
+  ClutterStageView *view;
+  int64_t frame_counter;
+  CoglContext *cogl_context;
+  char *label;
+
+  CoglTimestampQuery *begin_query;
+  CoglTimestampQuery *end_query;
+
+  int64_t gpu_to_cpu_offset_ns;
+};
+
 struct _ClutterGrab
 {
   grefcount ref_count;
@@ -410,6 +425,8 @@ clutter_stage_do_paint_view (ClutterStage         *stage,
   cairo_rectangle_int_t clip_rect;
   g_autoptr (GArray) clip_frusta = NULL;
   graphene_frustum_t clip_frustum;
+  graphene_frustum_t clip_bounds_frustum;
+  gboolean has_clip_bounds_frustum = FALSE;
   ClutterPaintNode *root_node;
   CoglFramebuffer *fb;
   ClutterColor bg_color;
@@ -431,6 +448,15 @@ clutter_stage_do_paint_view (ClutterStage         *stage,
           setup_clip_frustum (stage, &clip_rect, &clip_frustum);
           g_array_append_val (clip_frusta, clip_frustum);
         }
+
+      /* Lets actors outside of the redraw clip, e.g. on other views, be
+       * culled with a single test instead of one per clip rectangle. */
+      if (n_rectangles > 1)
+        {
+          cairo_region_get_extents (redraw_clip, &clip_rect);
+          setup_clip_frustum (stage, &clip_rect, &clip_bounds_frustum);
+          has_clip_bounds_frustum = TRUE;
+        }
     }
   else
     {
@@ -453,6 +479,8 @@ clutter_stage_do_paint_view (ClutterStage         *stage,
   paint_context = clutter_paint_context_new_for_view (view,
                                                       redraw_clip,
                                                       clip_frusta,
+                                                      has_clip_bounds_frustum ?
+                                                      &clip_bounds_frustum : NULL,
                                                       paint_flags);
 
   if (frame)
@@ -1238,6 +1266,19 @@ clutter_stage_get_property (GObject    *gobject,
     }
 }
 
+static void
+actor_gpu_timing_free (ClutterActorGpuTiming *timing)
+{
+  if (timing->begin_query)
+    cogl_context_free_timestamp_query (timing->cogl_context,
+                                       timing->begin_query);
+  if (timing->end_query)
+    cogl_context_free_timestamp_query (timing->cogl_context,
+                                       timing->end_query);
+  g_free (timing->label);
+  g_free (timing);
+}
+
 static void
 clutter_stage_dispose (GObject *object)
 {
@@ -1273,6 +1314,8 @@ clutter_stage_dispose (GObject *object)
   g_hash_table_remove_all (priv->pointer_devices);
   g_hash_table_remove_all (priv->touch_sequences);
 
+  g_ptr_array_set_size (priv->pending_gpu_timings, 0);
+
   G_OBJECT_CLASS (clutter_stage_parent_class)->dispose (object);
 }
 
@@ -1297,6 +1340,8 @@ clutter_stage_finalize (GObject *object)
 
   g_array_free (priv->paint_volume_stack, TRUE);
 
+  g_ptr_array_unref (priv->pending_gpu_timings);
+
   G_OBJECT_CLASS (clutter_stage_parent_class)->finalize (object);
 }
 
@@ -1677,6 +1722,8 @@ clutter_stage_init (ClutterStage *self)
     }
 
   priv->event_queue = g_queue_new ();
+  priv->pending_gpu_timings =
+    g_ptr_array_new_with_free_func ((GDestroyNotify) actor_gpu_timing_free);
   priv->cur_event_actors = g_ptr_array_sized_new (32);
   priv->cur_event_emission_chain =
     g_array_sized_new (FALSE, TRUE, sizeof (EventReceiver), 32);
@@ -2650,11 +2697,118 @@ clutter_stage_get_frame_counter (ClutterStage          *stage)
   return _clutter_stage_window_get_frame_counter (stage_window);
 }
 
+ClutterActorGpuTiming *
+clutter_stage_begin_actor_gpu_timing (ClutterStage        *stage,
+                                      ClutterPaintContext *paint_context,
+                                      const char          *label)
+{
+  ClutterStageView *view;
+  CoglFramebuffer *framebuffer;
+  CoglContext *cogl_context;
+  ClutterActorGpuTiming *timing;
+  int64_t gpu_time_ns;
+
+  view = clutter_paint_context_get_stage_view (paint_context);
+  if (!view)
+    return NULL;
+
+  framebuffer = clutter_paint_context_get_framebuffer (paint_context);
+  cogl_context = cogl_framebuffer_get_context (framebuffer);
+  if (!cogl_has_feature (cogl_context, COGL_FEATURE_ID_TIMESTAMP_QUERY))
+    return NULL;
+
+  timing = g_new0 (ClutterActorGpuTiming, 1);
+  timing->view = view;
+  timing->frame_counter = clutter_stage_get_frame_counter (stage);
+  timing->cogl_context = cogl_context;
+  timing->label = g_strdup (label);
+
+  /* GPU timestamps are in an unspecified time base; sample both clocks so
+   * the results can be placed on the CLOCK_MONOTONIC based trace timeline.
+   */
+  gpu_time_ns = cogl_context_get_gpu_time_ns (cogl_context);
+  timing->gpu_to_cpu_offset_ns = g_get_monotonic_time () * 1000 - gpu_time_ns;
+  timing->begin_query = cogl_framebuffer_create_timestamp_query (framebuffer);
+
+  return timing;
+}
+
+void
+clutter_stage_end_actor_gpu_timing (ClutterStage          *stage,
+                                    ClutterPaintContext   *paint_context,
+                                    ClutterActorGpuTiming *timing)
+{
+  ClutterStagePrivate *priv = stage->priv;
+  CoglFramebuffer *framebuffer;
+
+  framebuffer = clutter_paint_context_get_framebuffer (paint_context);
+  timing->end_query = cogl_framebuffer_create_timestamp_query (framebuffer);
+
+  g_ptr_array_add (priv->pending_gpu_timings, timing);
+}
+
+static void
+report_actor_gpu_timings (ClutterStage     *stage,
+                          ClutterStageView *view,
+                          ClutterFrameInfo *frame_info)
+{
+  ClutterStagePrivate *priv = stage->priv;
+  GList *stage_views;
+  unsigned int i = 0;
+
+  stage_views = clutter_stage_peek_stage_views (stage);
+
+  while (i < priv->pending_gpu_timings->len)
+    {
+      ClutterActorGpuTiming *timing =
+        g_ptr_array_index (priv->pending_gpu_timings, i);
+
+      /* Once the frame the queries were part of has been presented, reading
+       * back the results won't stall. Timings of later frames of the view
+       * stay pending, and timings for views that have gone away will never
+       * be presented; drop them along the way. */
+      if (timing->view == view &&
+          timing->frame_counter <= frame_info->frame_counter)
+        {
+          int64_t begin_time_ns;
+          int64_t end_time_ns;
+
+          begin_time_ns =
+            cogl_context_timestamp_query_get_time_ns (timing->cogl_context,
+                                                      timing->begin_query);
+          end_time_ns =
+            cogl_context_timestamp_query_get_time_ns (timing->cogl_context,
+                                                      timing->end_query);
+
+          COGL_TRACE_MARK ("ClutterActor (GPU paint)",
+                           timing->label,
+                           begin_time_ns + timing->gpu_to_cpu_offset_ns,
+                           end_time_ns - begin_time_ns);
+
+          CLUTTER_NOTE (FRAME_TIMINGS, "GPU paint of %s: %" G_GINT64_FORMAT " µs",
+                        timing->label,
+                        (end_time_ns - begin_time_ns) / 1000);
+        }
+      else if (g_list_find (stage_views, timing->view))
+        {
+          i++;
+          continue;
+        }
+
+      g_ptr_array_remove_index (priv->pending_gpu_timings, i);
+    }
+}
+
 void
 clutter_stage_presented (ClutterStage     *stage,
                          ClutterStageView *view,
                          ClutterFrameInfo *frame_info)
 {
+  ClutterStagePrivate *priv = stage->priv;
+
+  if (priv->pending_gpu_timings->len > 0)
+    report_actor_gpu_timings (stage, view, frame_info);
+
   g_signal_emit (stage, stage_signals[PRESENTED], 0, view, frame_info);
 }
 
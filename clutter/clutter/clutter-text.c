@@ -182,6 +182,11 @@ struct _ClutterTextPrivate
   /* Signal handler for when the :text-direction changes */
   gulong direction_changed_id;
 
+  /* Signal handler for when glyphs that were left out of the layout
+     have been rasterized */
+  PangoRenderer *glyphs_renderer;
+  gulong glyphs_ready_id;
+
   ClutterInputFocus *input_focus;
   ClutterInputContentHintFlags input_hints;
   ClutterInputContentPurpose input_purpose;
@@ -1758,6 +1763,7 @@ clutter_text_dispose (GObject *gobject)
   g_clear_signal_handler (&priv->direction_changed_id, self);
   g_clear_signal_handler (&priv->settings_changed_id,
                           clutter_get_default_backend ());
+  g_clear_signal_handler (&priv->glyphs_ready_id, priv->glyphs_renderer);
 
   g_clear_handle_id (&priv->password_hint_id, g_source_remove);
 
@@ -1913,6 +1919,39 @@ clutter_text_foreach_selection_rectangle_prescaled (ClutterText              *se
   clutter_text_foreach_selection_rectangle (self, 1.0f, func, user_data);
 }
 
+static void
+clutter_text_glyphs_ready_cb (ClutterText *self)
+{
+  ClutterTextPrivate *priv = self->priv;
+
+  g_clear_signal_handler (&priv->glyphs_ready_id, priv->glyphs_renderer);
+
+  clutter_actor_queue_redraw (CLUTTER_ACTOR (self));
+}
+
+/* Glyphs that are rasterized in the background are left out of the
+ * layout until they are ready, so the text needs to be painted again
+ * once they are */
+static void
+clutter_text_watch_pending_glyphs (ClutterText *self,
+                                   PangoLayout *layout)
+{
+  ClutterTextPrivate *priv = self->priv;
+  PangoFontMap *font_map;
+
+  if (priv->glyphs_ready_id != 0 ||
+      !cogl_pango_layout_has_pending_glyphs (layout))
+    return;
+
+  font_map = pango_context_get_font_map (pango_layout_get_context (layout));
+  priv->glyphs_renderer =
+    cogl_pango_font_map_get_renderer (COGL_PANGO_FONT_MAP (font_map));
+  priv->glyphs_ready_id =
+    g_signal_connect_swapped (priv->glyphs_renderer, "glyphs-ready",
+                              G_CALLBACK (clutter_text_glyphs_ready_cb),
+                              self);
+}
+
 static void
 paint_selection_rectangle (ClutterText           *self,
                            const ClutterActorBox *box,
@@ -2767,6 +2806,7 @@ clutter_text_paint (ClutterActor        *self,
                             priv->text_color.blue,
                             real_opacity);
   cogl_pango_show_layout (fb, layout, priv->text_x, priv->text_y, &color);
+  clutter_text_watch_pending_glyphs (text, layout);
 
   selection_paint (text, fb);
 
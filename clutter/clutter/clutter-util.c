@@ -237,6 +237,158 @@ clutter_util_rectangle_equal (const cairo_rectangle_int_t *src1,
           (src1->height == src2->height));
 }
 
+static int64_t
+rectangle_area (const cairo_rectangle_int_t *rect)
+{
+  return (int64_t) rect->width * rect->height;
+}
+
+static int64_t
+calculate_merge_waste (const cairo_rectangle_int_t *src1,
+                       const cairo_rectangle_int_t *src2,
+                       cairo_rectangle_int_t       *merged)
+{
+  cairo_rectangle_int_t overlap;
+  int64_t covered_area;
+
+  _clutter_util_rectangle_union (src1, src2, merged);
+
+  covered_area = rectangle_area (src1) + rectangle_area (src2);
+  if (_clutter_util_rectangle_intersection (src1, src2, &overlap))
+    covered_area -= rectangle_area (&overlap);
+
+  return rectangle_area (merged) - covered_area;
+}
+
+/* Merging two rectangles is considered free when less than 1/8 of the
+ * resulting bounding box is area that wasn't part of the region. */
+#define COALESCE_CHEAP_WASTE_FRACTION 8
+
+/* Only consider merging rectangles this far apart in the (y, x) sorted
+ * rectangle list; keeps coalescing linear in the number of rectangles. */
+#define COALESCE_SEARCH_WINDOW 8
+
+#define COALESCE_MAX_PASSES 3
+
+static int
+coalesce_rectangles (cairo_rectangle_int_t *rects,
+                     int                    n_rects,
+                     int                    max_rectangles)
+{
+  while (n_rects > 1)
+    {
+      cairo_rectangle_int_t best_merged = { 0 };
+      int64_t best_waste = G_MAXINT64;
+      int best_i = -1;
+      int best_j = -1;
+      int i, j;
+
+      for (i = 0; i < n_rects - 1; i++)
+        {
+          for (j = i + 1; j < MIN (n_rects, i + 1 + COALESCE_SEARCH_WINDOW); j++)
+            {
+              cairo_rectangle_int_t merged;
+              int64_t waste;
+
+              waste = calculate_merge_waste (&rects[i], &rects[j], &merged);
+              if (waste < best_waste)
+                {
+                  best_waste = waste;
+                  best_merged = merged;
+                  best_i = i;
+                  best_j = j;
+                }
+            }
+        }
+
+      if (n_rects <= max_rectangles &&
+          best_waste * COALESCE_CHEAP_WASTE_FRACTION >
+          rectangle_area (&best_merged))
+        break;
+
+      rects[best_i] = best_merged;
+      memmove (&rects[best_j], &rects[best_j + 1],
+               (n_rects - best_j - 1) * sizeof (cairo_rectangle_int_t));
+      n_rects--;
+    }
+
+  return n_rects;
+}
+
+/**
+ * clutter_util_region_coalesce:
+ * @region: (inout): a region
+ * @max_rectangles: the maximum number of rectangles @region may consist of
+ *
+ * Approximates @region with a superset made up of at most @max_rectangles
+ * rectangles. Neighbouring rectangles are merged into their bounding box
+ * when doing so adds little area that wasn't part of the region, and,
+ * while there are still too many rectangles, by picking the merges that
+ * waste the least area first.
+ *
+ * This is meant for clip and damage regions, where painting a few extra
+ * pixels is cheaper than clipping against a heavily fragmented region.
+ *
+ * Returns: %TRUE if @region was replaced
+ */
+gboolean
+clutter_util_region_coalesce (cairo_region_t **region,
+                              int              max_rectangles)
+{
+  g_autofree cairo_rectangle_int_t *rects = NULL;
+  cairo_region_t *coalesced;
+  int n_rects;
+  int pass;
+  int i;
+
+  g_return_val_if_fail (max_rectangles > 0, FALSE);
+
+  n_rects = cairo_region_num_rectangles (*region);
+  if (n_rects <= 1)
+    return FALSE;
+
+  rects = g_new (cairo_rectangle_int_t, n_rects);
+  for (i = 0; i < n_rects; i++)
+    cairo_region_get_rectangle (*region, i, &rects[i]);
+
+  coalesced = NULL;
+  for (pass = 0; pass < COALESCE_MAX_PASSES; pass++)
+    {
+      int n_coalesced;
+
+      n_coalesced = coalesce_rectangles (rects, n_rects, max_rectangles);
+      if (n_coalesced == n_rects && !coalesced)
+        return FALSE;
+
+      g_clear_pointer (&coalesced, cairo_region_destroy);
+      coalesced = cairo_region_create_rectangles (rects, n_coalesced);
+
+      /* Merged bounding boxes may overlap, and the banded representation of
+       * their union can end up with more rectangles than we merged into;
+       * coalesce the result again in that case. */
+      n_rects = cairo_region_num_rectangles (coalesced);
+      if (n_rects <= max_rectangles)
+        break;
+
+      for (i = 0; i < n_rects; i++)
+        cairo_region_get_rectangle (coalesced, i, &rects[i]);
+    }
+
+  if (cairo_region_num_rectangles (coalesced) > max_rectangles)
+    {
+      cairo_rectangle_int_t extents;
+
+      cairo_region_get_extents (coalesced, &extents);
+      cairo_region_destroy (coalesced);
+      coalesced = cairo_region_create_rectangle (&extents);
+    }
+
+  cairo_region_destroy (*region);
+  *region = coalesced;
+
+  return TRUE;
+}
+
 typedef struct
 {
   GType value_type;
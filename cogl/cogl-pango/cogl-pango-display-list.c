@@ -42,6 +42,17 @@ typedef enum
   COGL_PANGO_DISPLAY_LIST_TRAPEZOID
 } CoglPangoDisplayListNodeType;
 
+/* Number of times a display list has to be rendered before its
+ * texture nodes are moved into retained vertex buffers */
+#define COGL_PANGO_DISPLAY_LIST_STABLE_RENDERS 3
+
+/* For small runs of text like icon labels, we can get better performance
+ * going through the Cogl journal since text may then be batched together
+ * with other geometry. */
+/* FIXME: 25 is a number I plucked out of thin air; it would be good
+ * to determine this empirically! */
+#define COGL_PANGO_DISPLAY_LIST_MIN_VBO_RECTANGLES 25
+
 typedef struct _CoglPangoDisplayListNode CoglPangoDisplayListNode;
 typedef struct _CoglPangoDisplayListRectangle CoglPangoDisplayListRectangle;
 
@@ -52,8 +63,19 @@ struct _CoglPangoDisplayList
   GSList                 *nodes;
   GSList                 *last_node;
   CoglPangoPipelineCache *pipeline_cache;
+  unsigned int            n_renders;
 };
 
+/* Vertex format of the retained vertex buffers. The override color
+ * is only used when override is 1 */
+typedef struct
+{
+  float x, y;
+  float s, t;
+  uint8_t r, g, b, a;
+  float override;
+} CoglPangoDisplayListVertex;
+
 /* This matches the format expected by cogl_rectangles_with_texture_coords */
 struct _CoglPangoDisplayListRectangle
 {
@@ -82,6 +104,11 @@ struct _CoglPangoDisplayListNode
       /* A primitive representing those vertices */
       CoglPrimitive *primitive;
       guint has_color : 1;
+      /* Whether the texture contains signed distance fields */
+      guint sdf : 1;
+      /* Whether the primitive is a retained merge of several nodes
+         which carries the override colors in its vertices */
+      guint color_overrides : 1;
     } texture;
 
     struct
@@ -134,6 +161,7 @@ _cogl_pango_display_list_remove_color_override (CoglPangoDisplayList *dl)
 void
 _cogl_pango_display_list_add_texture (CoglPangoDisplayList *dl,
                                       CoglTexture *texture,
+                                      gboolean sdf,
                                       float x_1, float y_1,
                                       float x_2, float y_2,
                                       float tx_1, float ty_1,
@@ -147,6 +175,7 @@ _cogl_pango_display_list_add_texture (CoglPangoDisplayList *dl,
   if (dl->last_node
       && (node = dl->last_node->data)->type == COGL_PANGO_DISPLAY_LIST_TEXTURE
       && node->d.texture.texture == texture
+      && !node->d.texture.color_overrides
       && (dl->color_override
           ? (node->color_override && cogl_color_equal (&dl->color, &node->color))
           : !node->color_override))
@@ -168,6 +197,7 @@ _cogl_pango_display_list_add_texture (CoglPangoDisplayList *dl,
       node->color = dl->color;
       node->pipeline = NULL;
       node->d.texture.texture = cogl_object_ref (texture);
+      node->d.texture.sdf = sdf;
       node->d.texture.rectangles
         = g_array_new (FALSE, FALSE, sizeof (CoglPangoDisplayListRectangle));
       node->d.texture.primitive = NULL;
@@ -379,17 +409,233 @@ _cogl_framebuffer_draw_display_list_texture (CoglFramebuffer *fb,
                                              CoglPipeline *pipeline,
                                              CoglPangoDisplayListNode *node)
 {
-  /* For small runs of text like icon labels, we can get better performance
-   * going through the Cogl journal since text may then be batched together
-   * with other geometry. */
-  /* FIXME: 25 is a number I plucked out of thin air; it would be good
-   * to determine this empirically! */
-  if (node->d.texture.rectangles->len < 25)
+  if (node->d.texture.rectangles->len <
+      COGL_PANGO_DISPLAY_LIST_MIN_VBO_RECTANGLES)
     emit_rectangles_through_journal (fb, pipeline, node);
   else
     emit_vertex_buffer_geometry (fb, pipeline, node);
 }
 
+static void
+_cogl_pango_display_list_node_free (CoglPangoDisplayListNode *node);
+
+static CoglPrimitive *
+create_retained_primitive (CoglContext *ctx,
+                           GSList *first,
+                           GSList *end,
+                           int n_rectangles)
+{
+  CoglAttributeBuffer *buffer;
+  CoglPangoDisplayListVertex *verts, *v;
+  int n_verts = n_rectangles * 4;
+  gboolean allocated = FALSE;
+  CoglAttribute *attributes[4];
+  CoglPrimitive *prim;
+  CoglIndices *indices;
+  GSList *l;
+  int i;
+
+  buffer =
+    cogl_attribute_buffer_new_with_size (ctx,
+                                         n_verts *
+                                         sizeof (CoglPangoDisplayListVertex));
+
+  if ((verts = cogl_buffer_map (COGL_BUFFER (buffer),
+                                COGL_BUFFER_ACCESS_WRITE,
+                                COGL_BUFFER_MAP_HINT_DISCARD)) == NULL)
+    {
+      verts = g_new (CoglPangoDisplayListVertex, n_verts);
+      allocated = TRUE;
+    }
+
+  v = verts;
+
+  for (l = first; l != end; l = l->next)
+    {
+      CoglPangoDisplayListNode *node = l->data;
+      CoglPangoDisplayListVertex corner = { 0, };
+
+      if (node->color_override)
+        {
+          corner.r = cogl_color_get_red_byte (&node->color);
+          corner.g = cogl_color_get_green_byte (&node->color);
+          corner.b = cogl_color_get_blue_byte (&node->color);
+          corner.a = cogl_color_get_alpha_byte (&node->color);
+          corner.override = 1.0f;
+        }
+
+      for (i = 0; i < node->d.texture.rectangles->len; i++)
+        {
+          const CoglPangoDisplayListRectangle *rectangle
+            = &g_array_index (node->d.texture.rectangles,
+                              CoglPangoDisplayListRectangle, i);
+
+          *v = corner;
+          v->x = rectangle->x_1;
+          v->y = rectangle->y_1;
+          v->s = rectangle->s_1;
+          v->t = rectangle->t_1;
+          v++;
+          *v = corner;
+          v->x = rectangle->x_1;
+          v->y = rectangle->y_2;
+          v->s = rectangle->s_1;
+          v->t = rectangle->t_2;
+          v++;
+          *v = corner;
+          v->x = rectangle->x_2;
+          v->y = rectangle->y_2;
+          v->s = rectangle->s_2;
+          v->t = rectangle->t_2;
+          v++;
+          *v = corner;
+          v->x = rectangle->x_2;
+          v->y = rectangle->y_1;
+          v->s = rectangle->s_2;
+          v->t = rectangle->t_1;
+          v++;
+        }
+    }
+
+  if (allocated)
+    {
+      cogl_buffer_set_data (COGL_BUFFER (buffer),
+                            0, /* offset */
+                            verts,
+                            sizeof (CoglPangoDisplayListVertex) * n_verts);
+      g_free (verts);
+    }
+  else
+    cogl_buffer_unmap (COGL_BUFFER (buffer));
+
+  attributes[0] =
+    cogl_attribute_new (buffer,
+                        "cogl_position_in",
+                        sizeof (CoglPangoDisplayListVertex),
+                        G_STRUCT_OFFSET (CoglPangoDisplayListVertex, x),
+                        2, /* n_components */
+                        COGL_ATTRIBUTE_TYPE_FLOAT);
+  attributes[1] =
+    cogl_attribute_new (buffer,
+                        "cogl_tex_coord0_in",
+                        sizeof (CoglPangoDisplayListVertex),
+                        G_STRUCT_OFFSET (CoglPangoDisplayListVertex, s),
+                        2, /* n_components */
+                        COGL_ATTRIBUTE_TYPE_FLOAT);
+  attributes[2] =
+    cogl_attribute_new (buffer,
+                        "_cogl_pango_override_color",
+                        sizeof (CoglPangoDisplayListVertex),
+                        G_STRUCT_OFFSET (CoglPangoDisplayListVertex, r),
+                        4, /* n_components */
+                        COGL_ATTRIBUTE_TYPE_UNSIGNED_BYTE);
+  cogl_attribute_set_normalized (attributes[2], TRUE);
+  attributes[3] =
+    cogl_attribute_new (buffer,
+                        "_cogl_pango_override",
+                        sizeof (CoglPangoDisplayListVertex),
+                        G_STRUCT_OFFSET (CoglPangoDisplayListVertex, override),
+                        1, /* n_components */
+                        COGL_ATTRIBUTE_TYPE_FLOAT);
+
+  prim = cogl_primitive_new_with_attributes (COGL_VERTICES_MODE_TRIANGLES,
+                                             n_verts,
+                                             attributes,
+                                             4 /* n_attributes */);
+
+  indices = cogl_get_rectangle_indices (ctx, n_rectangles);
+  cogl_primitive_set_indices (prim, indices, n_rectangles * 6);
+
+  cogl_object_unref (buffer);
+  for (i = 0; i < G_N_ELEMENTS (attributes); i++)
+    cogl_object_unref (attributes[i]);
+
+  return prim;
+}
+
+/* Once a display list has been drawn unchanged for a few frames it
+ * is likely to be drawn many more times, for example for a static
+ * label. Each run of texture nodes using the same glyph cache
+ * texture is then merged into a single node with a vertex buffer
+ * that is kept for the lifetime of the display list. The override
+ * colors of the merged nodes are stored in the vertices so that the
+ * whole run is drawn with one draw call and changing the draw color
+ * only changes a uniform. Drawing a vertex buffer flushes the journal,
+ * so runs that are too short to be drawn from a vertex buffer anyway
+ * are left alone to keep being batched with other geometry. */
+static void
+_cogl_pango_display_list_retain (CoglPangoDisplayList *dl)
+{
+  CoglContext *ctx = dl->pipeline_cache->ctx;
+  GSList *l;
+
+  for (l = dl->nodes; l; l = l->next)
+    {
+      CoglPangoDisplayListNode *node = l->data;
+      CoglPangoDisplayListNode *merged, *other;
+      GSList *last, *end, *next;
+      int n_rectangles;
+
+      if (node->type != COGL_PANGO_DISPLAY_LIST_TEXTURE ||
+          node->d.texture.color_overrides)
+        continue;
+
+      n_rectangles = node->d.texture.rectangles->len;
+      last = l;
+
+      for (end = l->next; end; end = end->next)
+        {
+          other = end->data;
+
+          if (other->type != COGL_PANGO_DISPLAY_LIST_TEXTURE ||
+              other->d.texture.texture != node->d.texture.texture ||
+              other->d.texture.sdf != node->d.texture.sdf ||
+              other->d.texture.color_overrides)
+            break;
+
+          n_rectangles += other->d.texture.rectangles->len;
+          last = end;
+        }
+
+      if (n_rectangles < COGL_PANGO_DISPLAY_LIST_MIN_VBO_RECTANGLES)
+        {
+          l = last;
+          continue;
+        }
+
+      merged = g_new0 (CoglPangoDisplayListNode, 1);
+      merged->type = COGL_PANGO_DISPLAY_LIST_TEXTURE;
+      merged->color_override = FALSE;
+      merged->pipeline =
+        _cogl_pango_pipeline_cache_get_color_override (dl->pipeline_cache,
+                                                       node->d.texture.texture,
+                                                       node->d.texture.sdf);
+      merged->d.texture.texture = cogl_object_ref (node->d.texture.texture);
+      merged->d.texture.sdf = node->d.texture.sdf;
+      merged->d.texture.color_overrides = TRUE;
+      merged->d.texture.rectangles =
+        g_array_new (FALSE, FALSE, sizeof (CoglPangoDisplayListRectangle));
+      merged->d.texture.primitive =
+        create_retained_primitive (ctx, l, end, n_rectangles);
+
+      for (next = l; next != end; )
+        {
+          GSList *node_link = next;
+
+          next = next->next;
+          _cogl_pango_display_list_node_free (node_link->data);
+          if (node_link != l)
+            g_slist_free_1 (node_link);
+        }
+
+      l->data = merged;
+      l->next = end;
+
+      if (end == NULL)
+        dl->last_node = l;
+    }
+}
+
 void
 _cogl_pango_display_list_render (CoglFramebuffer *fb,
                                  CoglPangoDisplayList *dl,
@@ -397,21 +643,42 @@ _cogl_pango_display_list_render (CoglFramebuffer *fb,
 {
   GSList *l;
 
+  if (dl->n_renders < COGL_PANGO_DISPLAY_LIST_STABLE_RENDERS &&
+      ++dl->n_renders == COGL_PANGO_DISPLAY_LIST_STABLE_RENDERS)
+    _cogl_pango_display_list_retain (dl);
+
   for (l = dl->nodes; l; l = l->next)
     {
       CoglPangoDisplayListNode *node = l->data;
       CoglColor draw_color;
 
+      if (node->type == COGL_PANGO_DISPLAY_LIST_TEXTURE &&
+          node->d.texture.color_overrides)
+        {
+          draw_color = *color;
+          cogl_color_premultiply (&draw_color);
+
+          _cogl_pango_pipeline_cache_set_color_override_color
+            (dl->pipeline_cache, node->pipeline, &draw_color);
+
+          cogl_primitive_draw (node->d.texture.primitive,
+                               fb,
+                               node->pipeline);
+          continue;
+        }
+
       if (node->pipeline == NULL)
         {
           if (node->type == COGL_PANGO_DISPLAY_LIST_TEXTURE)
             node->pipeline =
               _cogl_pango_pipeline_cache_get (dl->pipeline_cache,
-                                              node->d.texture.texture);
+                                              node->d.texture.texture,
+                                              node->d.texture.sdf);
           else
             node->pipeline =
               _cogl_pango_pipeline_cache_get (dl->pipeline_cache,
-                                              NULL);
+                                              NULL,
+                                              FALSE);
         }
 
       if (node->color_override)
@@ -433,7 +700,8 @@ _cogl_pango_display_list_render (CoglFramebuffer *fb,
       switch (node->type)
         {
         case COGL_PANGO_DISPLAY_LIST_TEXTURE:
-          _cogl_framebuffer_draw_display_list_texture (fb, node->pipeline, node);
+          _cogl_framebuffer_draw_display_list_texture (fb, node->pipeline,
+                                                       node);
           break;
 
         case COGL_PANGO_DISPLAY_LIST_RECTANGLE:
@@ -481,6 +749,7 @@ _cogl_pango_display_list_clear (CoglPangoDisplayList *dl)
                      _cogl_pango_display_list_node_free);
   dl->nodes = NULL;
   dl->last_node = NULL;
+  dl->n_renders = 0;
 }
 
 void
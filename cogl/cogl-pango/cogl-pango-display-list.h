@@ -49,6 +49,7 @@ _cogl_pango_display_list_remove_color_override (CoglPangoDisplayList *dl);
 void
 _cogl_pango_display_list_add_texture (CoglPangoDisplayList *dl,
                                       CoglTexture *texture,
+                                      gboolean sdf,
                                       float x_1, float y_1,
                                       float x_2, float y_2,
                                       float tx_1, float ty_1,
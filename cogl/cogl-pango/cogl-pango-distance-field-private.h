@@ -0,0 +1,50 @@
+/*
+ * Cogl
+ *
+ * A Low Level GPU Graphics and Utilities API
+ *
+ * Copyright (C) 2026 agent
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <glib.h>
+
+#include "cogl/cogl-macros.h"
+
+G_BEGIN_DECLS
+
+/* Converts the antialiased coverage of a glyph into a signed distance
+ * field where 128 is on the outline and the values fall off linearly
+ * to 0 and 255 at COGL_PANGO_SDF_SPREAD pixels outside and inside of
+ * it. The partial coverage of edge pixels is used to estimate the
+ * sub-pixel position of the outline */
+COGL_EXPORT_TEST void
+_cogl_pango_compute_distance_field (const uint8_t *coverage,
+                                    int            coverage_stride,
+                                    int            width,
+                                    int            height,
+                                    uint8_t       *out,
+                                    int            out_stride);
+
+G_END_DECLS
@@ -0,0 +1,161 @@
+/*
+ * Cogl
+ *
+ * A Low Level GPU Graphics and Utilities API
+ *
+ * Copyright (C) 2026 agent
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "cogl-config.h"
+
+#include <math.h>
+
+#include "cogl-pango/cogl-pango-distance-field-private.h"
+#include "cogl-pango/cogl-pango-glyph-cache.h"
+
+#define SDF_INF 1e20f
+
+/* One dimensional squared Euclidean distance transform from
+ * Felzenszwalb and Huttenlocher's "Distance Transforms of Sampled
+ * Functions", applied in place to a row or column of the grid */
+static void
+edt_1d (float *grid,
+        int    offset,
+        int    stride,
+        int    length,
+        float *f,
+        int   *v,
+        float *z)
+{
+  int q, k, r;
+  float s;
+
+  v[0] = 0;
+  z[0] = -SDF_INF;
+  z[1] = SDF_INF;
+  f[0] = grid[offset];
+
+  for (q = 1, k = 0; q < length; q++)
+    {
+      f[q] = grid[offset + q * stride];
+
+      do
+        {
+          r = v[k];
+          s = (f[q] - f[r] + q * q - r * r) / (q - r) / 2.0f;
+        }
+      while (s <= z[k] && --k > -1);
+
+      k++;
+      v[k] = q;
+      z[k] = s;
+      z[k + 1] = SDF_INF;
+    }
+
+  for (q = 0, k = 0; q < length; q++)
+    {
+      while (z[k + 1] < q)
+        k++;
+      r = v[k];
+      grid[offset + q * stride] = f[r] + (q - r) * (q - r);
+    }
+}
+
+static void
+edt_2d (float *grid,
+        int    width,
+        int    height,
+        float *f,
+        int   *v,
+        float *z)
+{
+  int x, y;
+
+  for (x = 0; x < width; x++)
+    edt_1d (grid, x, width, height, f, v, z);
+  for (y = 0; y < height; y++)
+    edt_1d (grid, y * width, 1, width, f, v, z);
+}
+
+void
+_cogl_pango_compute_distance_field (const uint8_t *coverage,
+                                    int            coverage_stride,
+                                    int            width,
+                                    int            height,
+                                    uint8_t       *out,
+                                    int            out_stride)
+{
+  int n_pixels = width * height;
+  int max_length = MAX (width, height);
+  float *outer = g_new (float, n_pixels);
+  float *inner = g_new (float, n_pixels);
+  float *f = g_new (float, max_length);
+  float *z = g_new (float, max_length + 1);
+  int *v = g_new (int, max_length);
+  int x, y;
+
+  for (y = 0; y < height; y++)
+    for (x = 0; x < width; x++)
+      {
+        int i = y * width + x;
+        float a = coverage[y * coverage_stride + x] / 255.0f;
+
+        if (a >= 1.0f)
+          {
+            outer[i] = 0.0f;
+            inner[i] = SDF_INF;
+          }
+        else if (a <= 0.0f)
+          {
+            outer[i] = SDF_INF;
+            inner[i] = 0.0f;
+          }
+        else
+          {
+            float d = 0.5f - a;
+
+            outer[i] = d > 0.0f ? d * d : 0.0f;
+            inner[i] = d < 0.0f ? d * d : 0.0f;
+          }
+      }
+
+  edt_2d (outer, width, height, f, v, z);
+  edt_2d (inner, width, height, f, v, z);
+
+  for (y = 0; y < height; y++)
+    for (x = 0; x < width; x++)
+      {
+        int i = y * width + x;
+        float d = sqrtf (outer[i]) - sqrtf (inner[i]);
+        float value = 0.5f - d / (2.0f * COGL_PANGO_SDF_SPREAD);
+
+        out[y * out_stride + x] =
+          (uint8_t) roundf (CLAMP (value, 0.0f, 1.0f) * 255.0f);
+      }
+
+  g_free (outer);
+  g_free (inner);
+  g_free (f);
+  g_free (z);
+  g_free (v);
+}
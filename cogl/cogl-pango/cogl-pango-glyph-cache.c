@@ -29,6 +29,8 @@
 #include "cogl-config.h"
 
 #include <glib.h>
+#include <pango/pangocairo.h>
+#include <cairo-ft.h>
 
 #include "cogl-pango/cogl-pango-glyph-cache.h"
 #include "cogl-pango/cogl-pango-private.h"
@@ -36,6 +38,7 @@
 #include "cogl/cogl-atlas-texture-private.h"
 
 typedef struct _CoglPangoGlyphCacheKey     CoglPangoGlyphCacheKey;
+typedef struct _CoglPangoSdfFont           CoglPangoSdfFont;
 
 struct _CoglPangoGlyphCache
 {
@@ -64,6 +67,29 @@ struct _CoglPangoGlyphCache
   /* Whether mipmapping is being used for this cache. This only
      affects whether we decide to put the glyph in the global atlas */
   gboolean          use_mipmapping;
+
+  /* Whether the glyphs are stored as signed distance fields. In that
+     case the glyphs of every size of a font are looked up using the
+     same font at COGL_PANGO_SDF_FONT_SIZE */
+  gboolean          use_sdf;
+
+  /* Hash table from a font to the CoglPangoSdfFont used to render
+     it */
+  GHashTable       *sdf_fonts;
+
+  /* Incremented every time the cache is cleared. Glyphs that are
+     rasterized in the background use this to detect that their cache
+     value was freed in the meantime */
+  unsigned int      generation;
+};
+
+struct _CoglPangoSdfFont
+{
+  /* The font at COGL_PANGO_SDF_FONT_SIZE or NULL if the glyphs of the
+     font can't be rendered from distance fields */
+  PangoFont *font;
+  /* Scale from the SDF font to the font */
+  float      scale;
 };
 
 struct _CoglPangoGlyphCacheKey
@@ -72,6 +98,12 @@ struct _CoglPangoGlyphCacheKey
   PangoGlyph  glyph;
 };
 
+typedef struct
+{
+  CoglPangoGlyphCacheDirtyFunc func;
+  void *user_data;
+} CoglPangoGlyphCacheDirtyClosure;
+
 static void
 cogl_pango_glyph_cache_value_free (CoglPangoGlyphCacheValue *value)
 {
@@ -87,6 +119,13 @@ cogl_pango_glyph_cache_key_free (CoglPangoGlyphCacheKey *key)
   g_free (key);
 }
 
+static void
+cogl_pango_sdf_font_free (CoglPangoSdfFont *sdf_font)
+{
+  g_clear_object (&sdf_font->font);
+  g_free (sdf_font);
+}
+
 static unsigned int
 cogl_pango_glyph_cache_hash_func (const void *key)
 {
@@ -142,6 +181,26 @@ cogl_pango_glyph_cache_new (CoglContext *ctx,
 
   cache->use_mipmapping = use_mipmapping;
 
+  cache->use_sdf = FALSE;
+  cache->sdf_fonts = NULL;
+
+  cache->generation = 0;
+
+  return cache;
+}
+
+CoglPangoGlyphCache *
+_cogl_pango_glyph_cache_new_sdf (CoglContext *ctx)
+{
+  CoglPangoGlyphCache *cache = cogl_pango_glyph_cache_new (ctx, FALSE);
+
+  cache->use_sdf = TRUE;
+  cache->sdf_fonts =
+    g_hash_table_new_full (g_direct_hash,
+                           g_direct_equal,
+                           g_object_unref,
+                           (GDestroyNotify) cogl_pango_sdf_font_free);
+
   return cache;
 }
 
@@ -162,6 +221,12 @@ cogl_pango_glyph_cache_clear (CoglPangoGlyphCache *cache)
   cache->has_dirty_glyphs = FALSE;
 
   g_hash_table_remove_all (cache->hash_table);
+  cache->generation++;
+
+  /* The glyph cache is cleared when the font options change so the
+     SDF fonts have to be loaded again as well */
+  if (cache->sdf_fonts)
+    g_hash_table_remove_all (cache->sdf_fonts);
 }
 
 void
@@ -177,6 +242,7 @@ cogl_pango_glyph_cache_free (CoglPangoGlyphCache *cache)
   cogl_pango_glyph_cache_clear (cache);
 
   g_hash_table_unref (cache->hash_table);
+  g_clear_pointer (&cache->sdf_fonts, g_hash_table_unref);
 
   g_hook_list_clear (&cache->reorganize_callbacks);
 
@@ -223,8 +289,10 @@ cogl_pango_glyph_cache_add_to_global_atlas (CoglPangoGlyphCache *cache,
     return FALSE;
 
   /* If the cache is using mipmapping then we can't use the global
-     atlas because it would just get migrated back out */
-  if (cache->use_mipmapping)
+     atlas because it would just get migrated back out. Distance
+     fields need to stay in alpha-only textures so that they get the
+     right pipeline */
+  if (cache->use_mipmapping || cache->use_sdf)
     return FALSE;
 
   texture = cogl_atlas_texture_new_with_size (cache->ctx,
@@ -307,6 +375,163 @@ cogl_pango_glyph_cache_add_to_local_atlas (CoglPangoGlyphCache *cache,
   return TRUE;
 }
 
+static gboolean
+get_scalable_font_info (PangoFont *font,
+                        double    *size,
+                        char     **family_name,
+                        char     **style_name)
+{
+  cairo_scaled_font_t *scaled_font;
+  cairo_matrix_t font_matrix;
+  FT_Face ft_face;
+  gboolean scalable;
+
+  scaled_font = pango_cairo_font_get_scaled_font (PANGO_CAIRO_FONT (font));
+  if (scaled_font == NULL ||
+      cairo_scaled_font_get_type (scaled_font) != CAIRO_FONT_TYPE_FT)
+    return FALSE;
+
+  /* Only uniformly scaled fonts can share a distance field */
+  cairo_scaled_font_get_font_matrix (scaled_font, &font_matrix);
+  if (font_matrix.xy != 0.0 || font_matrix.yx != 0.0 ||
+      font_matrix.xx != font_matrix.yy || font_matrix.yy <= 0.0)
+    return FALSE;
+
+  ft_face = cairo_ft_scaled_font_lock_face (scaled_font);
+  if (ft_face == NULL)
+    return FALSE;
+
+  /* Bitmap and color glyphs can't be represented by a distance
+     field */
+  scalable = FT_IS_SCALABLE (ft_face) && !FT_HAS_COLOR (ft_face);
+  if (scalable)
+    {
+      *size = font_matrix.yy;
+      *family_name = g_strdup (ft_face->family_name);
+      *style_name = g_strdup (ft_face->style_name);
+    }
+
+  cairo_ft_scaled_font_unlock_face (scaled_font);
+
+  return scalable;
+}
+
+static PangoFont *
+load_sdf_font (PangoFontMap         *font_map,
+               PangoFontDescription *desc)
+{
+  PangoContext *context;
+  cairo_font_options_t *font_options;
+  PangoFont *font;
+
+  /* The context isn't kept around because it would hold a reference
+     on the font map, which indirectly owns the glyph cache */
+  context = pango_font_map_create_context (font_map);
+
+  /* Hinting is specific to a size so the outlines are used
+     unmodified */
+  font_options = cairo_font_options_create ();
+  cairo_font_options_set_antialias (font_options, CAIRO_ANTIALIAS_GRAY);
+  cairo_font_options_set_hint_style (font_options, CAIRO_HINT_STYLE_NONE);
+  cairo_font_options_set_hint_metrics (font_options, CAIRO_HINT_METRICS_OFF);
+  pango_cairo_context_set_font_options (context, font_options);
+  cairo_font_options_destroy (font_options);
+
+  font = pango_font_map_load_font (font_map, context, desc);
+
+  g_object_unref (context);
+
+  return font;
+}
+
+static void
+cogl_pango_glyph_cache_init_sdf_font (CoglPangoGlyphCache *cache,
+                                      PangoFont           *font,
+                                      CoglPangoSdfFont    *sdf_font)
+{
+  g_autofree char *family_name = NULL;
+  g_autofree char *style_name = NULL;
+  g_autofree char *sdf_family_name = NULL;
+  g_autofree char *sdf_style_name = NULL;
+  PangoFontDescription *desc;
+  PangoFontMap *font_map;
+  PangoFont *sdf;
+  double size, sdf_size;
+
+  font_map = pango_font_get_font_map (font);
+  if (font_map == NULL)
+    return;
+
+  if (!get_scalable_font_info (font, &size, &family_name, &style_name))
+    return;
+
+  desc = pango_font_describe (font);
+  pango_font_description_set_absolute_size (desc,
+                                            COGL_PANGO_SDF_FONT_SIZE *
+                                            PANGO_SCALE);
+  sdf = load_sdf_font (font_map, desc);
+  pango_font_description_free (desc);
+
+  if (sdf == NULL)
+    return;
+
+  /* Glyph indices are only meaningful within a face so make sure the
+     description resolved to the same one */
+  if (!get_scalable_font_info (sdf, &sdf_size,
+                               &sdf_family_name, &sdf_style_name) ||
+      g_strcmp0 (family_name, sdf_family_name) != 0 ||
+      g_strcmp0 (style_name, sdf_style_name) != 0)
+    {
+      g_object_unref (sdf);
+      return;
+    }
+
+  sdf_font->font = sdf;
+  sdf_font->scale = size / sdf_size;
+}
+
+static CoglPangoSdfFont *
+cogl_pango_glyph_cache_get_sdf_font (CoglPangoGlyphCache *cache,
+                                     PangoFont           *font)
+{
+  CoglPangoSdfFont *sdf_font;
+
+  sdf_font = g_hash_table_lookup (cache->sdf_fonts, font);
+  if (sdf_font == NULL)
+    {
+      sdf_font = g_new0 (CoglPangoSdfFont, 1);
+      cogl_pango_glyph_cache_init_sdf_font (cache, font, sdf_font);
+      g_hash_table_insert (cache->sdf_fonts, g_object_ref (font), sdf_font);
+    }
+
+  return sdf_font;
+}
+
+/* Returns whether the glyphs of the font can be stored in the SDF
+ * cache, and if so the scale to apply to the cached glyphs to render
+ * them at the size of the font */
+gboolean
+_cogl_pango_glyph_cache_get_sdf_scale (CoglPangoGlyphCache *cache,
+                                       PangoFont           *font,
+                                       float               *scale)
+{
+  CoglPangoSdfFont *sdf_font;
+
+  g_return_val_if_fail (cache->use_sdf, FALSE);
+
+  if (font == NULL)
+    return FALSE;
+
+  sdf_font = cogl_pango_glyph_cache_get_sdf_font (cache, font);
+  if (sdf_font->font == NULL)
+    return FALSE;
+
+  if (scale)
+    *scale = sdf_font->scale;
+
+  return TRUE;
+}
+
 CoglPangoGlyphCacheValue *
 cogl_pango_glyph_cache_lookup (CoglPangoGlyphCache *cache,
                                gboolean             create,
@@ -316,6 +541,17 @@ cogl_pango_glyph_cache_lookup (CoglPangoGlyphCache *cache,
   CoglPangoGlyphCacheKey lookup_key;
   CoglPangoGlyphCacheValue *value;
 
+  /* All of the sizes of a font share the glyphs of the SDF font */
+  if (cache->use_sdf)
+    {
+      CoglPangoSdfFont *sdf_font =
+        cogl_pango_glyph_cache_get_sdf_font (cache, font);
+
+      g_return_val_if_fail (sdf_font->font != NULL, NULL);
+
+      font = sdf_font->font;
+    }
+
   lookup_key.font = font;
   lookup_key.glyph = glyph;
 
@@ -337,6 +573,16 @@ cogl_pango_glyph_cache_lookup (CoglPangoGlyphCache *cache,
       value->draw_width = ink_rect.width;
       value->draw_height = ink_rect.height;
 
+      /* Leave room for the distance field outside of the outline */
+      if (cache->use_sdf && ink_rect.width >= 1 && ink_rect.height >= 1)
+        {
+          value->sdf = TRUE;
+          value->draw_x -= COGL_PANGO_SDF_SPREAD;
+          value->draw_y -= COGL_PANGO_SDF_SPREAD;
+          value->draw_width += COGL_PANGO_SDF_SPREAD * 2;
+          value->draw_height += COGL_PANGO_SDF_SPREAD * 2;
+        }
+
       /* If the glyph is zero-sized then we don't need to reserve any
          space for it and we can just avoid painting anything */
       if (ink_rect.width < 1 || ink_rect.height < 1)
@@ -379,11 +625,11 @@ _cogl_pango_glyph_cache_set_dirty_glyphs_cb (void *key_ptr,
 {
   CoglPangoGlyphCacheKey *key = key_ptr;
   CoglPangoGlyphCacheValue *value = value_ptr;
-  CoglPangoGlyphCacheDirtyFunc func = user_data;
+  CoglPangoGlyphCacheDirtyClosure *closure = user_data;
 
   if (value->dirty)
     {
-      func (key->font, key->glyph, value);
+      closure->func (key->font, key->glyph, value, closure->user_data);
 
       value->dirty = FALSE;
     }
@@ -391,20 +637,94 @@ _cogl_pango_glyph_cache_set_dirty_glyphs_cb (void *key_ptr,
 
 void
 _cogl_pango_glyph_cache_set_dirty_glyphs (CoglPangoGlyphCache *cache,
-                                          CoglPangoGlyphCacheDirtyFunc func)
+                                          CoglPangoGlyphCacheDirtyFunc func,
+                                          void *user_data)
 {
+  CoglPangoGlyphCacheDirtyClosure closure;
+
   /* If we know that there are no dirty glyphs then we can shortcut
      out early */
   if (!cache->has_dirty_glyphs)
     return;
 
+  closure.func = func;
+  closure.user_data = user_data;
+
   g_hash_table_foreach (cache->hash_table,
                         _cogl_pango_glyph_cache_set_dirty_glyphs_cb,
-                        func);
+                        &closure);
 
   cache->has_dirty_glyphs = FALSE;
 }
 
+unsigned int
+_cogl_pango_glyph_cache_get_generation (CoglPangoGlyphCache *cache)
+{
+  return cache->generation;
+}
+
+typedef struct
+{
+  CoglRectangleMapEntry region;
+  gboolean is_pending;
+} CoglPangoGlyphCacheRegionData;
+
+static void
+check_region_is_pending_cb (const CoglRectangleMapEntry *entry,
+                            void                        *rectangle_data,
+                            void                        *user_data)
+{
+  CoglPangoGlyphCacheValue *value = rectangle_data;
+  CoglPangoGlyphCacheRegionData *data = user_data;
+
+  if (entry->x >= data->region.x + data->region.width ||
+      entry->y >= data->region.y + data->region.height ||
+      entry->x + entry->width <= data->region.x ||
+      entry->y + entry->height <= data->region.y)
+    return;
+
+  if (!value->pending)
+    data->is_pending = FALSE;
+}
+
+/* Returns whether the given region of one of the cache's own atlas
+   textures only contains glyphs that still have to be uploaded, so
+   that the whole region can be overwritten at once */
+gboolean
+_cogl_pango_glyph_cache_region_is_pending (CoglPangoGlyphCache *cache,
+                                           CoglTexture         *texture,
+                                           int                  x,
+                                           int                  y,
+                                           int                  width,
+                                           int                  height)
+{
+  CoglPangoGlyphCacheRegionData data;
+  GSList *l;
+
+  for (l = cache->atlases; l; l = l->next)
+    {
+      CoglAtlas *atlas = l->data;
+
+      if (atlas->texture != texture)
+        continue;
+
+      data.region.x = x;
+      data.region.y = y;
+      data.region.width = width;
+      data.region.height = height;
+      data.is_pending = TRUE;
+
+      _cogl_rectangle_map_foreach (atlas->map,
+                                   check_region_is_pending_cb,
+                                   &data);
+
+      return data.is_pending;
+    }
+
+  /* Glyphs in the global atlas share the texture with other users */
+  return FALSE;
+}
+
 void
 _cogl_pango_glyph_cache_add_reorganize_callback (CoglPangoGlyphCache *cache,
                                                  GHookFunc func,
@@ -35,6 +35,14 @@
 
 G_BEGIN_DECLS
 
+/* Pixel size that glyphs are rasterized at when they are stored as
+   signed distance fields. The same glyph is then scaled to render any
+   size of the font */
+#define COGL_PANGO_SDF_FONT_SIZE 48
+/* Distance in pixels at the SDF font size covered by the distance
+   field on each side of the glyph outline */
+#define COGL_PANGO_SDF_SPREAD 6
+
 typedef struct _CoglPangoGlyphCache      CoglPangoGlyphCache;
 typedef struct _CoglPangoGlyphCacheValue CoglPangoGlyphCacheValue;
 
@@ -60,11 +68,23 @@ struct _CoglPangoGlyphCacheValue
   guint dirty : 1;
   /* Set to TRUE if the glyph has colors (eg. emoji) */
   guint has_color : 1;
+  /* Set to TRUE if the texture contains a signed distance field for
+     the glyph at COGL_PANGO_SDF_FONT_SIZE rather than its coverage.
+     The draw rectangle is then also in pixels at that size */
+  guint sdf : 1;
+  /* Set to TRUE once an image of the glyph has been uploaded to the
+     texture at least once */
+  guint rasterized : 1;
+  /* Set to TRUE while the glyph is being rasterized in the
+     background. The glyph can't be drawn until the image is
+     uploaded */
+  guint pending : 1;
 };
 
 typedef void (* CoglPangoGlyphCacheDirtyFunc) (PangoFont *font,
                                                PangoGlyph glyph,
-                                               CoglPangoGlyphCacheValue *value);
+                                               CoglPangoGlyphCacheValue *value,
+                                               void *user_data);
 
 COGL_EXPORT CoglPangoGlyphCache *
 cogl_pango_glyph_cache_new (CoglContext *ctx,
@@ -82,6 +102,14 @@ cogl_pango_glyph_cache_lookup (CoglPangoGlyphCache *cache,
 COGL_EXPORT void
 cogl_pango_glyph_cache_clear (CoglPangoGlyphCache *cache);
 
+CoglPangoGlyphCache *
+_cogl_pango_glyph_cache_new_sdf (CoglContext *ctx);
+
+gboolean
+_cogl_pango_glyph_cache_get_sdf_scale (CoglPangoGlyphCache *cache,
+                                       PangoFont           *font,
+                                       float               *scale);
+
 void
 _cogl_pango_glyph_cache_add_reorganize_callback (CoglPangoGlyphCache *cache,
                                                  GHookFunc func,
@@ -94,6 +122,18 @@ _cogl_pango_glyph_cache_remove_reorganize_callback (CoglPangoGlyphCache *cache,
 
 void
 _cogl_pango_glyph_cache_set_dirty_glyphs (CoglPangoGlyphCache *cache,
-                                          CoglPangoGlyphCacheDirtyFunc func);
+                                          CoglPangoGlyphCacheDirtyFunc func,
+                                          void *user_data);
+
+unsigned int
+_cogl_pango_glyph_cache_get_generation (CoglPangoGlyphCache *cache);
+
+gboolean
+_cogl_pango_glyph_cache_region_is_pending (CoglPangoGlyphCache *cache,
+                                           CoglTexture         *texture,
+                                           int                  x,
+                                           int                  y,
+                                           int                  width,
+                                           int                  height);
 
 G_END_DECLS
@@ -91,6 +91,15 @@ _cogl_pango_pipeline_cache_new (CoglContext *ctx,
 
   cache->base_texture_rgba_pipeline = NULL;
   cache->base_texture_alpha_pipeline = NULL;
+  cache->base_texture_sdf_pipeline = NULL;
+
+  cache->color_override_hash_table =
+    g_hash_table_new_full (g_direct_hash,
+                           g_direct_equal,
+                           _cogl_pango_pipeline_cache_key_destroy,
+                           _cogl_pango_pipeline_cache_value_destroy);
+  cache->color_override_snippet = NULL;
+  cache->color_uniform_location = -1;
 
   cache->use_mipmapping = use_mipmapping;
 
@@ -152,9 +161,45 @@ get_base_texture_alpha_pipeline (CoglPangoPipelineCache *cache)
   return cache->base_texture_alpha_pipeline;
 }
 
+static CoglPipeline *
+get_base_texture_sdf_pipeline (CoglPangoPipelineCache *cache)
+{
+  if (cache->base_texture_sdf_pipeline == NULL)
+    {
+      CoglPipeline *pipeline;
+      CoglSnippet *snippet;
+
+      pipeline = cogl_pipeline_copy (get_base_texture_alpha_pipeline (cache));
+      cache->base_texture_sdf_pipeline = pipeline;
+
+      /* The distance field is always sampled linearly because the
+       * edge is found by interpolating between texels */
+      cogl_pipeline_set_layer_filters (pipeline, 0,
+                                       COGL_PIPELINE_FILTER_LINEAR,
+                                       COGL_PIPELINE_FILTER_LINEAR);
+
+      /* The texture stores the distance to the outline with 0.5 on
+       * the outline itself. Turn that back into coverage, blending
+       * over about one pixel on the screen whatever the scale of the
+       * glyph is */
+      snippet = cogl_snippet_new (COGL_SNIPPET_HOOK_TEXTURE_LOOKUP,
+                                  NULL,
+                                  "float cogl_sdf_width = "
+                                  "0.7 * fwidth (cogl_texel.a);\n"
+                                  "cogl_texel.a = "
+                                  "smoothstep (0.5 - cogl_sdf_width, "
+                                  "0.5 + cogl_sdf_width, "
+                                  "cogl_texel.a);\n");
+      cogl_pipeline_add_layer_snippet (pipeline, 0, snippet);
+      cogl_object_unref (snippet);
+    }
+
+  return cache->base_texture_sdf_pipeline;
+}
+
 typedef struct
 {
-  CoglPangoPipelineCache *cache;
+  GHashTable *hash_table;
   CoglTexture *texture;
 } PipelineDestroyNotifyData;
 
@@ -163,65 +208,160 @@ pipeline_destroy_notify_cb (void *user_data)
 {
   PipelineDestroyNotifyData *data = user_data;
 
-  g_hash_table_remove (data->cache->hash_table, data->texture);
+  g_hash_table_remove (data->hash_table, data->texture);
   g_free (data);
 }
 
-CoglPipeline *
-_cogl_pango_pipeline_cache_get (CoglPangoPipelineCache *cache,
-                                CoglTexture *texture)
+static CoglPipeline *
+create_texture_pipeline (CoglPangoPipelineCache *cache,
+                         CoglTexture *texture,
+                         gboolean sdf)
 {
-  CoglPangoPipelineCacheEntry *entry;
-  PipelineDestroyNotifyData *destroy_data;
-  static CoglUserDataKey pipeline_destroy_notify_key;
-
-  /* Look for an existing entry */
-  entry = g_hash_table_lookup (cache->hash_table, texture);
-
-  if (entry)
-    return cogl_object_ref (entry->pipeline);
+  CoglPipeline *base;
+  CoglPipeline *pipeline;
 
-  /* No existing pipeline was found so let's create another */
-  entry = g_new0 (CoglPangoPipelineCacheEntry, 1);
+  if (sdf)
+    base = get_base_texture_sdf_pipeline (cache);
+  else if (_cogl_texture_get_format (texture) == COGL_PIXEL_FORMAT_A_8)
+    base = get_base_texture_alpha_pipeline (cache);
+  else
+    base = get_base_texture_rgba_pipeline (cache);
 
-  if (texture)
-    {
-      CoglPipeline *base;
+  pipeline = cogl_pipeline_copy (base);
 
-      entry->texture = cogl_object_ref (texture);
+  cogl_pipeline_set_layer_texture (pipeline, 0 /* layer */, texture);
 
-      if (_cogl_texture_get_format (entry->texture) == COGL_PIXEL_FORMAT_A_8)
-        base = get_base_texture_alpha_pipeline (cache);
-      else
-        base = get_base_texture_rgba_pipeline (cache);
+  return pipeline;
+}
 
-      entry->pipeline = cogl_pipeline_copy (base);
+static void
+add_pipeline_entry (GHashTable *hash_table,
+                    CoglTexture *texture,
+                    CoglPipeline *pipeline)
+{
+  CoglPangoPipelineCacheEntry *entry;
+  PipelineDestroyNotifyData *destroy_data;
+  static CoglUserDataKey pipeline_destroy_notify_key;
 
-      cogl_pipeline_set_layer_texture (entry->pipeline, 0 /* layer */, texture);
-    }
-  else
-    {
-      entry->texture = NULL;
-      entry->pipeline = cogl_pipeline_new (cache->ctx);
-    }
+  entry = g_new0 (CoglPangoPipelineCacheEntry, 1);
+  entry->texture = texture ? cogl_object_ref (texture) : NULL;
+  entry->pipeline = pipeline;
 
   /* Add a weak reference to the pipeline so we can remove it from the
      hash table when it is destroyed */
   destroy_data = g_new0 (PipelineDestroyNotifyData, 1);
-  destroy_data->cache = cache;
+  destroy_data->hash_table = hash_table;
   destroy_data->texture = texture;
-  cogl_object_set_user_data (COGL_OBJECT (entry->pipeline),
+  cogl_object_set_user_data (COGL_OBJECT (pipeline),
                              &pipeline_destroy_notify_key,
                              destroy_data,
                              pipeline_destroy_notify_cb);
 
-  g_hash_table_insert (cache->hash_table,
+  g_hash_table_insert (hash_table,
                        texture ? cogl_object_ref (texture) : NULL,
                        entry);
+}
+
+CoglPipeline *
+_cogl_pango_pipeline_cache_get (CoglPangoPipelineCache *cache,
+                                CoglTexture *texture,
+                                gboolean sdf)
+{
+  CoglPangoPipelineCacheEntry *entry;
+  CoglPipeline *pipeline;
+
+  /* Look for an existing entry */
+  entry = g_hash_table_lookup (cache->hash_table, texture);
+
+  if (entry)
+    return cogl_object_ref (entry->pipeline);
+
+  /* No existing pipeline was found so let's create another */
+  if (texture)
+    pipeline = create_texture_pipeline (cache, texture, sdf);
+  else
+    pipeline = cogl_pipeline_new (cache->ctx);
+
+  add_pipeline_entry (cache->hash_table, texture, pipeline);
 
   /* This doesn't take a reference on the pipeline so that it will use
      the newly created reference */
-  return entry->pipeline;
+  return pipeline;
+}
+
+static CoglSnippet *
+get_color_override_snippet (CoglPangoPipelineCache *cache)
+{
+  if (cache->color_override_snippet == NULL)
+    {
+      /* The override color is not premultiplied, just like the
+       * colors passed to cogl_pipeline_set_color(). It is scaled by
+       * the alpha of the draw color so that the paint opacity still
+       * applies to it */
+      cache->color_override_snippet =
+        cogl_snippet_new (COGL_SNIPPET_HOOK_VERTEX,
+                          "uniform vec4 _cogl_pango_color;\n"
+                          "attribute vec4 _cogl_pango_override_color;\n"
+                          "attribute float _cogl_pango_override;\n",
+                          "vec4 override_color = "
+                          "vec4 (_cogl_pango_override_color.rgb * "
+                          "_cogl_pango_override_color.a, "
+                          "_cogl_pango_override_color.a) * "
+                          "_cogl_pango_color.a;\n"
+                          "cogl_color_out = mix (_cogl_pango_color, "
+                          "override_color, "
+                          "_cogl_pango_override);\n");
+    }
+
+  return cache->color_override_snippet;
+}
+
+CoglPipeline *
+_cogl_pango_pipeline_cache_get_color_override (CoglPangoPipelineCache *cache,
+                                               CoglTexture *texture,
+                                               gboolean sdf)
+{
+  CoglPangoPipelineCacheEntry *entry;
+  CoglPipeline *pipeline;
+
+  entry = g_hash_table_lookup (cache->color_override_hash_table, texture);
+
+  if (entry)
+    return cogl_object_ref (entry->pipeline);
+
+  /* The color is passed in a uniform rather than with
+   * cogl_pipeline_set_color() so that these pipelines don't share
+   * any state that is changed for every draw with the pipelines
+   * returned by _cogl_pango_pipeline_cache_get() */
+  pipeline = create_texture_pipeline (cache, texture, sdf);
+  cogl_pipeline_add_snippet (pipeline, get_color_override_snippet (cache));
+
+  if (cache->color_uniform_location == -1)
+    cache->color_uniform_location =
+      cogl_pipeline_get_uniform_location (pipeline, "_cogl_pango_color");
+
+  add_pipeline_entry (cache->color_override_hash_table, texture, pipeline);
+
+  return pipeline;
+}
+
+void
+_cogl_pango_pipeline_cache_set_color_override_color (CoglPangoPipelineCache *cache,
+                                                     CoglPipeline *pipeline,
+                                                     const CoglColor *color)
+{
+  float values[4];
+
+  values[0] = cogl_color_get_red (color);
+  values[1] = cogl_color_get_green (color);
+  values[2] = cogl_color_get_blue (color);
+  values[3] = cogl_color_get_alpha (color);
+
+  cogl_pipeline_set_uniform_float (pipeline,
+                                   cache->color_uniform_location,
+                                   4, /* n_components */
+                                   1, /* count */
+                                   values);
 }
 
 void
@@ -231,8 +371,13 @@ _cogl_pango_pipeline_cache_free (CoglPangoPipelineCache *cache)
     cogl_object_unref (cache->base_texture_rgba_pipeline);
   if (cache->base_texture_alpha_pipeline)
     cogl_object_unref (cache->base_texture_alpha_pipeline);
+  if (cache->base_texture_sdf_pipeline)
+    cogl_object_unref (cache->base_texture_sdf_pipeline);
+  if (cache->color_override_snippet)
+    cogl_object_unref (cache->color_override_snippet);
 
   g_hash_table_destroy (cache->hash_table);
+  g_hash_table_destroy (cache->color_override_hash_table);
 
   cogl_object_unref (cache->ctx);
 
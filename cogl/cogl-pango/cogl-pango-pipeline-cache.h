@@ -47,6 +47,14 @@ typedef struct _CoglPangoPipelineCache
 
   CoglPipeline *base_texture_alpha_pipeline;
   CoglPipeline *base_texture_rgba_pipeline;
+  CoglPipeline *base_texture_sdf_pipeline;
+
+  /* Hash table of the pipelines that take the color of each vertex
+     from an attribute, see
+     _cogl_pango_pipeline_cache_get_color_override() */
+  GHashTable *color_override_hash_table;
+  CoglSnippet *color_override_snippet;
+  int color_uniform_location;
 
   gboolean use_mipmapping;
 } CoglPangoPipelineCache;
@@ -57,11 +65,29 @@ _cogl_pango_pipeline_cache_new (CoglContext *ctx,
                                 gboolean use_mipmapping);
 
 /* Returns a pipeline that can be used to render glyphs in the given
-   texture. The pipeline has a new reference so it is up to the caller
-   to unref it */
+   texture. If sdf is TRUE then the texture contains signed distance
+   fields instead of glyph coverage. The pipeline has a new reference
+   so it is up to the caller to unref it */
 CoglPipeline *
 _cogl_pango_pipeline_cache_get (CoglPangoPipelineCache *cache,
-                                CoglTexture *texture);
+                                CoglTexture *texture,
+                                gboolean sdf);
+
+/* Returns a pipeline for the texture that takes the color of each
+   vertex from the _cogl_pango_override_color attribute when the
+   _cogl_pango_override attribute is 1, and from the
+   _cogl_pango_color uniform otherwise. The uniform is set with
+   _cogl_pango_pipeline_cache_set_color_override_color() instead of
+   cogl_pipeline_set_color(). A new reference is returned */
+CoglPipeline *
+_cogl_pango_pipeline_cache_get_color_override (CoglPangoPipelineCache *cache,
+                                               CoglTexture *texture,
+                                               gboolean sdf);
+
+void
+_cogl_pango_pipeline_cache_set_color_override_color (CoglPangoPipelineCache *cache,
+                                                     CoglPipeline *pipeline,
+                                                     const CoglColor *color);
 
 void
 _cogl_pango_pipeline_cache_free (CoglPangoPipelineCache *cache);
@@ -51,6 +51,7 @@
 #include <pango/pango-renderer.h>
 #include <cairo.h>
 #include <cairo-ft.h>
+#include <string.h>
 
 #include "cogl/cogl-debug.h"
 #include "cogl/cogl-context-private.h"
@@ -58,6 +59,7 @@
 #include "cogl-pango/cogl-pango-private.h"
 #include "cogl-pango/cogl-pango-glyph-cache.h"
 #include "cogl-pango/cogl-pango-display-list.h"
+#include "cogl-pango/cogl-pango-distance-field-private.h"
 
 enum
 {
@@ -67,6 +69,15 @@ enum
   PROP_LAST
 };
 
+enum
+{
+  GLYPHS_READY,
+
+  LAST_SIGNAL
+};
+
+static guint signals[LAST_SIGNAL];
+
 typedef struct
 {
   CoglPangoGlyphCache *glyph_cache;
@@ -84,10 +95,33 @@ struct _CoglPangoRenderer
   CoglPangoRendererCaches no_mipmap_caches;
   CoglPangoRendererCaches mipmap_caches;
 
+  /* Cache of glyphs as signed distance fields which is used instead
+     of the caches above for scalable fonts when use_sdf is set. It
+     shares the pipeline caches because those are keyed by texture */
+  CoglPangoGlyphCache *sdf_glyph_cache;
+
   gboolean use_mipmapping;
+  gboolean use_sdf;
+
+  /* Whether glyphs that have never been drawn are rasterized on a
+     worker thread instead of while the display list is built */
+  gboolean use_async_rasterization;
+
+  /* The worker thread and the jobs that it has finished, which are
+     uploaded from finished_jobs_source on the main thread */
+  GThreadPool *raster_pool;
+  GAsyncQueue *finished_jobs;
+  GSource *finished_jobs_source;
+  int cancel_jobs;
+
+  /* The CoglPangoLayoutQdata of the layouts whose display lists
+     skipped glyphs that were still being rasterized */
+  GList *pending_layouts;
 
   /* The current display list that is being built */
   CoglPangoDisplayList *display_list;
+  /* Set if a glyph was skipped while building the display list */
+  gboolean display_list_has_pending_glyphs;
 };
 
 struct _CoglPangoRendererClass
@@ -111,6 +145,12 @@ struct _CoglPangoLayoutQdata
      need to regenerate the display list if the mipmapping value is
      changed because it will be using a different set of textures */
   gboolean mipmapping_used;
+  /* Whether glyphs from the SDF cache may have been used to render
+     this layout */
+  gboolean sdf_used;
+  /* Whether the display list is missing glyphs that are still being
+     rasterized. The display list is rebuilt once they are ready */
+  gboolean has_pending_glyphs;
 };
 
 static void
@@ -119,6 +159,7 @@ _cogl_pango_ensure_glyph_cache_for_layout_line (PangoLayoutLine *line);
 typedef struct
 {
   CoglPangoDisplayList *display_list;
+  gboolean sdf;
   float x1, y1, x2, y2;
 } CoglPangoRendererSliceCbData;
 
@@ -143,6 +184,7 @@ cogl_pango_renderer_slice_cb (CoglTexture *texture,
 
   _cogl_pango_display_list_add_texture (data->display_list,
                                         texture,
+                                        data->sdf,
                                         data->x1,
                                         data->y1,
                                         data->x2,
@@ -157,17 +199,19 @@ static void
 cogl_pango_renderer_draw_glyph (CoglPangoRenderer        *priv,
                                 CoglPangoGlyphCacheValue *cache_value,
                                 float                     x1,
-                                float                     y1)
+                                float                     y1,
+                                float                     scale)
 {
   CoglPangoRendererSliceCbData data;
 
   g_return_if_fail (priv->display_list != NULL);
 
   data.display_list = priv->display_list;
+  data.sdf = cache_value->sdf;
   data.x1 = x1;
   data.y1 = y1;
-  data.x2 = x1 + (float) cache_value->draw_width;
-  data.y2 = y1 + (float) cache_value->draw_height;
+  data.x2 = x1 + (float) cache_value->draw_width * scale;
+  data.y2 = y1 + (float) cache_value->draw_height * scale;
 
   /* We iterate the internal sub textures of the texture so that we
      can get a pointer to the base texture even if the texture is in
@@ -188,6 +232,7 @@ cogl_pango_renderer_draw_glyph (CoglPangoRenderer        *priv,
 
 static void cogl_pango_renderer_dispose (GObject *object);
 static void cogl_pango_renderer_finalize (GObject *object);
+static void cogl_pango_renderer_stop_jobs (CoglPangoRenderer *priv);
 static void cogl_pango_renderer_draw_glyphs (PangoRenderer    *renderer,
                                              PangoFont        *font,
                                              PangoGlyphString *glyphs,
@@ -230,6 +275,7 @@ _cogl_pango_renderer_constructed (GObject *gobject)
     cogl_pango_glyph_cache_new (ctx, FALSE);
   renderer->mipmap_caches.glyph_cache =
     cogl_pango_glyph_cache_new (ctx, TRUE);
+  renderer->sdf_glyph_cache = _cogl_pango_glyph_cache_new_sdf (ctx);
 
   _cogl_pango_renderer_set_use_mipmapping (renderer, FALSE);
 
@@ -276,6 +322,22 @@ cogl_pango_renderer_class_init (CoglPangoRendererClass *klass)
 
   g_object_class_install_property (object_class, PROP_COGL_CONTEXT, pspec);
 
+  /**
+   * CoglPangoRenderer::glyphs-ready:
+   * @renderer: the #CoglPangoRenderer
+   *
+   * Emitted when glyphs that were rasterized in the background have
+   * been uploaded to the glyph cache. Layouts that were drawn without
+   * them need to be drawn again.
+   */
+  signals[GLYPHS_READY] =
+    g_signal_new ("glyphs-ready",
+                  G_TYPE_FROM_CLASS (klass),
+                  G_SIGNAL_RUN_LAST,
+                  0,
+                  NULL, NULL, NULL,
+                  G_TYPE_NONE, 0);
+
   renderer_class->draw_glyphs = cogl_pango_renderer_draw_glyphs;
   renderer_class->draw_rectangle = cogl_pango_renderer_draw_rectangle;
   renderer_class->draw_trapezoid = cogl_pango_renderer_draw_trapezoid;
@@ -286,6 +348,8 @@ cogl_pango_renderer_dispose (GObject *object)
 {
   CoglPangoRenderer *priv = COGL_PANGO_RENDERER (object);
 
+  cogl_pango_renderer_stop_jobs (priv);
+
   cogl_clear_object (&priv->ctx);
 
   G_OBJECT_CLASS (cogl_pango_renderer_parent_class)->dispose (object);
@@ -298,10 +362,13 @@ cogl_pango_renderer_finalize (GObject *object)
 
   cogl_pango_glyph_cache_free (priv->no_mipmap_caches.glyph_cache);
   cogl_pango_glyph_cache_free (priv->mipmap_caches.glyph_cache);
+  cogl_pango_glyph_cache_free (priv->sdf_glyph_cache);
 
   _cogl_pango_pipeline_cache_free (priv->no_mipmap_caches.pipeline_cache);
   _cogl_pango_pipeline_cache_free (priv->mipmap_caches.pipeline_cache);
 
+  g_list_free (priv->pending_layouts);
+
   G_OBJECT_CLASS (cogl_pango_renderer_parent_class)->finalize (object);
 }
 
@@ -348,11 +415,23 @@ cogl_pango_layout_qdata_forget_display_list (CoglPangoLayoutQdata *qdata)
         (caches->glyph_cache,
          (GHookFunc) cogl_pango_layout_qdata_forget_display_list,
          qdata);
+      if (qdata->sdf_used)
+        _cogl_pango_glyph_cache_remove_reorganize_callback
+          (qdata->renderer->sdf_glyph_cache,
+           (GHookFunc) cogl_pango_layout_qdata_forget_display_list,
+           qdata);
 
       _cogl_pango_display_list_free (qdata->display_list);
 
       qdata->display_list = NULL;
     }
+
+  if (qdata->has_pending_glyphs)
+    {
+      qdata->renderer->pending_layouts =
+        g_list_remove (qdata->renderer->pending_layouts, qdata);
+      qdata->has_pending_glyphs = FALSE;
+    }
 }
 
 static void
@@ -364,22 +443,12 @@ cogl_pango_render_qdata_destroy (CoglPangoLayoutQdata *qdata)
   g_free (qdata);
 }
 
-void
-cogl_pango_show_layout (CoglFramebuffer *fb,
-                        PangoLayout *layout,
-                        float x,
-                        float y,
-                        const CoglColor *color)
+static CoglPangoLayoutQdata *
+cogl_pango_layout_ensure_qdata (PangoLayout       *layout,
+                                CoglPangoRenderer *priv)
 {
-  PangoContext *context;
-  CoglPangoRenderer *priv;
   CoglPangoLayoutQdata *qdata;
 
-  context = pango_layout_get_context (layout);
-  priv = cogl_pango_get_renderer_from_context (context);
-  if (G_UNLIKELY (!priv))
-    return;
-
   qdata = g_object_get_qdata (G_OBJECT (layout),
                               cogl_pango_layout_get_qdata_key ());
 
@@ -394,13 +463,47 @@ cogl_pango_show_layout (CoglFramebuffer *fb,
                                cogl_pango_render_qdata_destroy);
     }
 
+  return qdata;
+}
+
+static void
+cogl_pango_layout_qdata_add_pending_glyphs (CoglPangoLayoutQdata *qdata)
+{
+  CoglPangoRenderer *priv = qdata->renderer;
+
+  if (qdata->has_pending_glyphs)
+    return;
+
+  qdata->has_pending_glyphs = TRUE;
+  priv->pending_layouts = g_list_prepend (priv->pending_layouts, qdata);
+}
+
+void
+cogl_pango_show_layout (CoglFramebuffer *fb,
+                        PangoLayout *layout,
+                        float x,
+                        float y,
+                        const CoglColor *color)
+{
+  PangoContext *context;
+  CoglPangoRenderer *priv;
+  CoglPangoLayoutQdata *qdata;
+
+  context = pango_layout_get_context (layout);
+  priv = cogl_pango_get_renderer_from_context (context);
+  if (G_UNLIKELY (!priv))
+    return;
+
+  qdata = cogl_pango_layout_ensure_qdata (layout, priv);
+
   /* Check if the layout has changed since the last build of the
      display list. This trick was suggested by Behdad Esfahbod here:
      http://mail.gnome.org/archives/gtk-i18n-list/2009-May/msg00019.html */
   if (qdata->display_list &&
       ((qdata->first_line &&
         qdata->first_line->layout != layout) ||
-       qdata->mipmapping_used != priv->use_mipmapping))
+       qdata->mipmapping_used != priv->use_mipmapping ||
+       qdata->sdf_used != priv->use_sdf))
     cogl_pango_layout_qdata_forget_display_list (qdata);
 
   if (qdata->display_list == NULL)
@@ -420,12 +523,22 @@ cogl_pango_show_layout (CoglFramebuffer *fb,
         (caches->glyph_cache,
          (GHookFunc) cogl_pango_layout_qdata_forget_display_list,
          qdata);
+      if (priv->use_sdf)
+        _cogl_pango_glyph_cache_add_reorganize_callback
+          (priv->sdf_glyph_cache,
+           (GHookFunc) cogl_pango_layout_qdata_forget_display_list,
+           qdata);
 
       priv->display_list = qdata->display_list;
+      priv->display_list_has_pending_glyphs = FALSE;
       pango_renderer_draw_layout (PANGO_RENDERER (priv), layout, 0, 0);
       priv->display_list = NULL;
 
       qdata->mipmapping_used = priv->use_mipmapping;
+      qdata->sdf_used = priv->use_sdf;
+
+      if (priv->display_list_has_pending_glyphs)
+        cogl_pango_layout_qdata_add_pending_glyphs (qdata);
     }
 
   cogl_framebuffer_push_matrix (fb);
@@ -474,12 +587,20 @@ cogl_pango_show_layout_line (CoglFramebuffer *fb,
             &priv->no_mipmap_caches);
 
   priv->display_list = _cogl_pango_display_list_new (caches->pipeline_cache);
+  priv->display_list_has_pending_glyphs = FALSE;
 
   _cogl_pango_ensure_glyph_cache_for_layout_line (line);
 
   pango_renderer_draw_layout_line (PANGO_RENDERER (priv), line,
                                    pango_x, pango_y);
 
+  /* Lines don't keep a display list, but the layout is flagged the
+     same way so that cogl_pango_layout_has_pending_glyphs() tells the
+     caller to draw it again on CoglPangoRenderer::glyphs-ready */
+  if (priv->display_list_has_pending_glyphs)
+    cogl_pango_layout_qdata_add_pending_glyphs
+      (cogl_pango_layout_ensure_qdata (line->layout, priv));
+
   _cogl_pango_display_list_render (fb,
                                    priv->display_list,
                                    color);
@@ -493,6 +614,7 @@ _cogl_pango_renderer_clear_glyph_cache (CoglPangoRenderer *renderer)
 {
   cogl_pango_glyph_cache_clear (renderer->mipmap_caches.glyph_cache);
   cogl_pango_glyph_cache_clear (renderer->no_mipmap_caches.glyph_cache);
+  cogl_pango_glyph_cache_clear (renderer->sdf_glyph_cache);
 }
 
 void
@@ -508,6 +630,52 @@ _cogl_pango_renderer_get_use_mipmapping (CoglPangoRenderer *renderer)
   return renderer->use_mipmapping;
 }
 
+void
+_cogl_pango_renderer_set_use_sdf (CoglPangoRenderer *renderer,
+                                  gboolean value)
+{
+  /* Turning the distance fields back into coverage needs the
+     derivative functions in the fragment shader */
+  if (value &&
+      !_cogl_has_private_feature (renderer->ctx,
+                                  COGL_PRIVATE_FEATURE_SHADER_DERIVATIVES))
+    value = FALSE;
+
+  renderer->use_sdf = value;
+}
+
+gboolean
+_cogl_pango_renderer_get_use_sdf (CoglPangoRenderer *renderer)
+{
+  return renderer->use_sdf;
+}
+
+void
+_cogl_pango_renderer_set_use_async_rasterization (CoglPangoRenderer *renderer,
+                                                  gboolean value)
+{
+  renderer->use_async_rasterization = value;
+}
+
+gboolean
+_cogl_pango_renderer_get_use_async_rasterization (CoglPangoRenderer *renderer)
+{
+  return renderer->use_async_rasterization;
+}
+
+gboolean
+cogl_pango_layout_has_pending_glyphs (PangoLayout *layout)
+{
+  CoglPangoLayoutQdata *qdata;
+
+  g_return_val_if_fail (PANGO_IS_LAYOUT (layout), FALSE);
+
+  qdata = g_object_get_qdata (G_OBJECT (layout),
+                              cogl_pango_layout_get_qdata_key ());
+
+  return qdata != NULL && qdata->has_pending_glyphs;
+}
+
 static CoglPangoGlyphCacheValue *
 cogl_pango_renderer_get_cached_glyph (PangoRenderer *renderer,
                                       gboolean       create,
@@ -519,6 +687,12 @@ cogl_pango_renderer_get_cached_glyph (PangoRenderer *renderer,
                                      &priv->mipmap_caches :
                                      &priv->no_mipmap_caches);
 
+  if (priv->use_sdf &&
+      _cogl_pango_glyph_cache_get_sdf_scale (priv->sdf_glyph_cache,
+                                             font, NULL))
+    return cogl_pango_glyph_cache_lookup (priv->sdf_glyph_cache,
+                                          create, font, glyph);
+
   return cogl_pango_glyph_cache_lookup (caches->glyph_cache,
                                         create, font, glyph);
 }
@@ -541,82 +715,473 @@ font_has_color_glyphs (const PangoFont *font)
   return has_color;
 }
 
-static void
-cogl_pango_renderer_set_dirty_glyph (PangoFont *font,
-                                     PangoGlyph glyph,
-                                     CoglPangoGlyphCacheValue *value)
+typedef struct
 {
-  cairo_surface_t *surface;
-  cairo_t *cr;
   cairo_scaled_font_t *scaled_font;
-  cairo_glyph_t cairo_glyph;
+  PangoGlyph glyph;
+
+  int draw_x;
+  int draw_y;
+  int width;
+  int height;
+
+  gboolean sdf;
   cairo_format_t format_cairo;
   CoglPixelFormat format_cogl;
 
-  COGL_NOTE (PANGO, "redrawing glyph %i", glyph);
+  /* The rasterized glyph, which has the size of the draw rectangle */
+  cairo_surface_t *surface;
+} CoglPangoGlyphImage;
 
-  /* Glyphs that don't take up any space will end up without a
-     texture. These should never become dirty so they shouldn't end up
-     here */
-  g_return_if_fail (value->texture != NULL);
+typedef struct
+{
+  CoglPangoGlyphImage image;
+
+  /* The cache value is only valid as long as the generation of the
+     cache hasn't changed */
+  CoglPangoGlyphCache *cache;
+  unsigned int cache_generation;
+  CoglPangoGlyphCacheValue *value;
+
+  gboolean has_color;
+} CoglPangoGlyphJob;
+
+typedef struct
+{
+  CoglPangoRenderer *renderer;
+  CoglPangoGlyphCache *cache;
+} CoglPangoRendererDirtyData;
+
+static void
+cogl_pango_glyph_image_init (CoglPangoGlyphImage      *image,
+                             PangoFont                *font,
+                             PangoGlyph                glyph,
+                             CoglPangoGlyphCacheValue *value)
+{
+  cairo_scaled_font_t *scaled_font;
 
-  if (_cogl_texture_get_format (value->texture) == COGL_PIXEL_FORMAT_A_8)
+  scaled_font = pango_cairo_font_get_scaled_font (PANGO_CAIRO_FONT (font));
+
+  image->scaled_font = cairo_scaled_font_reference (scaled_font);
+  image->glyph = glyph;
+  image->draw_x = value->draw_x;
+  image->draw_y = value->draw_y;
+  image->width = value->draw_width;
+  image->height = value->draw_height;
+  image->sdf = value->sdf;
+  image->surface = NULL;
+
+  if (value->sdf ||
+      _cogl_texture_get_format (value->texture) == COGL_PIXEL_FORMAT_A_8)
     {
-      format_cairo = CAIRO_FORMAT_A8;
-      format_cogl = COGL_PIXEL_FORMAT_A_8;
+      image->format_cairo = CAIRO_FORMAT_A8;
+      image->format_cogl = COGL_PIXEL_FORMAT_A_8;
     }
   else
     {
-      format_cairo = CAIRO_FORMAT_ARGB32;
+      image->format_cairo = CAIRO_FORMAT_ARGB32;
 
       /* Cairo stores the data in native byte order as ARGB but Cogl's
          pixel formats specify the actual byte order. Therefore we
          need to use a different format depending on the
          architecture */
 #if G_BYTE_ORDER == G_LITTLE_ENDIAN
-      format_cogl = COGL_PIXEL_FORMAT_BGRA_8888_PRE;
+      image->format_cogl = COGL_PIXEL_FORMAT_BGRA_8888_PRE;
 #else
-      format_cogl = COGL_PIXEL_FORMAT_ARGB_8888_PRE;
+      image->format_cogl = COGL_PIXEL_FORMAT_ARGB_8888_PRE;
 #endif
     }
+}
+
+/* This only uses Cairo so it is safe to call from the rasterization
+ * thread */
+static void
+cogl_pango_glyph_image_rasterize (CoglPangoGlyphImage *image)
+{
+  cairo_surface_t *surface;
+  cairo_t *cr;
+  cairo_glyph_t cairo_glyph;
 
-  surface = cairo_image_surface_create (format_cairo,
-                                        value->draw_width,
-                                        value->draw_height);
+  surface = cairo_image_surface_create (image->format_cairo,
+                                        image->width,
+                                        image->height);
   cr = cairo_create (surface);
 
-  scaled_font = pango_cairo_font_get_scaled_font (PANGO_CAIRO_FONT (font));
-  cairo_set_scaled_font (cr, scaled_font);
+  cairo_set_scaled_font (cr, image->scaled_font);
 
   cairo_set_source_rgba (cr, 1.0, 1.0, 1.0, 1.0);
 
-  cairo_glyph.x = -value->draw_x;
-  cairo_glyph.y = -value->draw_y;
+  cairo_glyph.x = -image->draw_x;
+  cairo_glyph.y = -image->draw_y;
   /* The PangoCairo glyph numbers directly map to Cairo glyph
      numbers */
-  cairo_glyph.index = glyph;
+  cairo_glyph.index = image->glyph;
   cairo_show_glyphs (cr, &cairo_glyph, 1);
 
   cairo_destroy (cr);
   cairo_surface_flush (surface);
 
+  /* The font of a distance field glyph is the one at
+     COGL_PANGO_SDF_FONT_SIZE so the glyph is drawn like the other
+     glyphs before converting it */
+  if (image->sdf)
+    {
+      cairo_surface_t *distance_field;
+
+      distance_field = cairo_image_surface_create (CAIRO_FORMAT_A8,
+                                                   image->width,
+                                                   image->height);
+      _cogl_pango_compute_distance_field (cairo_image_surface_get_data (surface),
+                                          cairo_image_surface_get_stride (surface),
+                                          image->width,
+                                          image->height,
+                                          cairo_image_surface_get_data (distance_field),
+                                          cairo_image_surface_get_stride (distance_field));
+      cairo_surface_mark_dirty (distance_field);
+
+      cairo_surface_destroy (surface);
+      surface = distance_field;
+    }
+
+  image->surface = surface;
+}
+
+static void
+cogl_pango_glyph_image_upload (CoglPangoGlyphImage      *image,
+                               CoglPangoGlyphCacheValue *value)
+{
   /* Copy the glyph to the texture */
   cogl_texture_set_region (value->texture,
                            0, /* src_x */
                            0, /* src_y */
                            value->tx_pixel, /* dst_x */
                            value->ty_pixel, /* dst_y */
-                           value->draw_width, /* dst_width */
-                           value->draw_height, /* dst_height */
-                           value->draw_width, /* width */
-                           value->draw_height, /* height */
-                           format_cogl,
-                           cairo_image_surface_get_stride (surface),
-                           cairo_image_surface_get_data (surface));
+                           image->width, /* dst_width */
+                           image->height, /* dst_height */
+                           image->width, /* width */
+                           image->height, /* height */
+                           image->format_cogl,
+                           cairo_image_surface_get_stride (image->surface),
+                           cairo_image_surface_get_data (image->surface));
+}
+
+static void
+cogl_pango_glyph_image_clear (CoglPangoGlyphImage *image)
+{
+  g_clear_pointer (&image->surface, cairo_surface_destroy);
+  g_clear_pointer (&image->scaled_font, cairo_scaled_font_destroy);
+}
+
+static void
+cogl_pango_glyph_job_free (CoglPangoGlyphJob *job)
+{
+  cogl_pango_glyph_image_clear (&job->image);
+  g_free (job);
+}
+
+static void
+cogl_pango_renderer_rasterize_job (gpointer data,
+                                   gpointer user_data)
+{
+  CoglPangoGlyphJob *job = data;
+  CoglPangoRenderer *priv = user_data;
+
+  if (!g_atomic_int_get (&priv->cancel_jobs))
+    cogl_pango_glyph_image_rasterize (&job->image);
+
+  g_async_queue_push (priv->finished_jobs, job);
+  g_source_set_ready_time (priv->finished_jobs_source, 0);
+}
+
+static int
+compare_jobs_by_texture (gconstpointer a,
+                         gconstpointer b)
+{
+  const CoglPangoGlyphJob *job_a = *(const CoglPangoGlyphJob **) a;
+  const CoglPangoGlyphJob *job_b = *(const CoglPangoGlyphJob **) b;
+  uintptr_t texture_a = (uintptr_t) job_a->value->texture;
+  uintptr_t texture_b = (uintptr_t) job_b->value->texture;
+
+  return texture_a < texture_b ? -1 : texture_a > texture_b ? 1 : 0;
+}
+
+/* Only merge the uploads of an atlas if the staging image wouldn't
+   be mostly empty space */
+#define MAX_MERGED_UPLOAD_AREA_RATIO 4
+
+/* Uploads the glyphs of jobs that all have the same texture. If the
+   glyphs are close together and nothing else is stored in between,
+   they are copied into a single staging image so that the texture is
+   updated only once */
+static void
+cogl_pango_renderer_upload_jobs_for_texture (CoglPangoGlyphJob **jobs,
+                                             unsigned int        n_jobs)
+{
+  CoglTexture *texture = jobs[0]->value->texture;
+  int x1 = G_MAXINT, y1 = G_MAXINT, x2 = 0, y2 = 0;
+  int glyphs_area = 0;
+  gboolean can_merge = n_jobs > 1;
+  g_autofree uint8_t *data = NULL;
+  int width, height;
+  unsigned int i;
+
+  for (i = 0; i < n_jobs && can_merge; i++)
+    {
+      CoglPangoGlyphCacheValue *value = jobs[i]->value;
+      CoglPangoGlyphImage *image = &jobs[i]->image;
+
+      if (image->format_cogl != COGL_PIXEL_FORMAT_A_8)
+        can_merge = FALSE;
+
+      x1 = MIN (x1, value->tx_pixel);
+      y1 = MIN (y1, value->ty_pixel);
+      x2 = MAX (x2, value->tx_pixel + image->width);
+      y2 = MAX (y2, value->ty_pixel + image->height);
+      glyphs_area += image->width * image->height;
+    }
+
+  width = x2 - x1;
+  height = y2 - y1;
+
+  if (can_merge &&
+      (width * height > glyphs_area * MAX_MERGED_UPLOAD_AREA_RATIO ||
+       !_cogl_pango_glyph_cache_region_is_pending (jobs[0]->cache,
+                                                   texture,
+                                                   x1, y1,
+                                                   width, height)))
+    can_merge = FALSE;
+
+  if (!can_merge)
+    {
+      for (i = 0; i < n_jobs; i++)
+        cogl_pango_glyph_image_upload (&jobs[i]->image, jobs[i]->value);
+      return;
+    }
+
+  /* The space in between the glyphs is either free or reserved for
+     glyphs that are still being rasterized, so it can be cleared */
+  data = g_malloc0 (width * height);
+
+  for (i = 0; i < n_jobs; i++)
+    {
+      CoglPangoGlyphCacheValue *value = jobs[i]->value;
+      CoglPangoGlyphImage *image = &jobs[i]->image;
+      const uint8_t *src = cairo_image_surface_get_data (image->surface);
+      int src_stride = cairo_image_surface_get_stride (image->surface);
+      uint8_t *dst;
+      int y;
+
+      dst = data + (value->ty_pixel - y1) * width + (value->tx_pixel - x1);
+
+      for (y = 0; y < image->height; y++)
+        memcpy (dst + y * width, src + y * src_stride, image->width);
+    }
+
+  cogl_texture_set_region (texture,
+                           0, /* src_x */
+                           0, /* src_y */
+                           x1, /* dst_x */
+                           y1, /* dst_y */
+                           width, /* dst_width */
+                           height, /* dst_height */
+                           width, /* width */
+                           height, /* height */
+                           COGL_PIXEL_FORMAT_A_8,
+                           width,
+                           data);
+}
+
+static gboolean
+cogl_pango_renderer_upload_finished_jobs (gpointer user_data)
+{
+  CoglPangoRenderer *priv = user_data;
+  g_autoptr (GPtrArray) jobs = NULL;
+  CoglPangoGlyphJob *job;
+  int n_textures = 0;
+  unsigned int i, first_job;
+
+  jobs = g_ptr_array_new_with_free_func ((GDestroyNotify)
+                                         cogl_pango_glyph_job_free);
+
+  while ((job = g_async_queue_try_pop (priv->finished_jobs)))
+    {
+      /* The cache value was freed if the glyph cache has been cleared
+         since the job was queued */
+      if (job->cache_generation !=
+          _cogl_pango_glyph_cache_get_generation (job->cache))
+        {
+          cogl_pango_glyph_job_free (job);
+          continue;
+        }
+
+      g_ptr_array_add (jobs, job);
+    }
+
+  if (jobs->len == 0)
+    return G_SOURCE_CONTINUE;
+
+  /* Upload all of the glyphs of an atlas in one go so that each
+     texture is only updated once per batch. The glyphs might have
+     been moved since the jobs were queued but they are uploaded to
+     wherever they are now */
+  g_ptr_array_sort (jobs, compare_jobs_by_texture);
+
+  for (first_job = 0; first_job < jobs->len; first_job = i)
+    {
+      CoglPangoGlyphJob *first = g_ptr_array_index (jobs, first_job);
+
+      for (i = first_job + 1; i < jobs->len; i++)
+        {
+          job = g_ptr_array_index (jobs, i);
+          if (job->value->texture != first->value->texture)
+            break;
+        }
+
+      cogl_pango_renderer_upload_jobs_for_texture
+        ((CoglPangoGlyphJob **) &jobs->pdata[first_job], i - first_job);
+      n_textures++;
+    }
+
+  for (i = 0; i < jobs->len; i++)
+    {
+      job = g_ptr_array_index (jobs, i);
+
+      job->value->has_color = job->has_color;
+      job->value->rasterized = TRUE;
+      job->value->pending = FALSE;
+    }
+
+  COGL_NOTE (PANGO, "uploaded %u glyphs rasterized in the background "
+             "to %i textures", jobs->len, n_textures);
+
+  /* The display lists that skipped glyphs which weren't ready yet
+     need to be rebuilt */
+  while (priv->pending_layouts)
+    cogl_pango_layout_qdata_forget_display_list (priv->pending_layouts->data);
+
+  g_signal_emit (priv, signals[GLYPHS_READY], 0);
+
+  return G_SOURCE_CONTINUE;
+}
+
+static gboolean
+finished_jobs_source_dispatch (GSource     *source,
+                               GSourceFunc  callback,
+                               gpointer     user_data)
+{
+  g_source_set_ready_time (source, -1);
+
+  return callback (user_data);
+}
+
+static GSourceFuncs finished_jobs_source_funcs = {
+  NULL,
+  NULL,
+  finished_jobs_source_dispatch,
+  NULL
+};
+
+static void
+cogl_pango_renderer_queue_job (CoglPangoRenderer *priv,
+                               CoglPangoGlyphJob *job)
+{
+  if (priv->raster_pool == NULL)
+    {
+      GSource *source;
+
+      priv->finished_jobs =
+        g_async_queue_new_full ((GDestroyNotify) cogl_pango_glyph_job_free);
+
+      source = g_source_new (&finished_jobs_source_funcs, sizeof (GSource));
+      g_source_set_name (source, "[mutter] CoglPango glyph uploads");
+      g_source_set_callback (source,
+                             cogl_pango_renderer_upload_finished_jobs,
+                             priv, NULL);
+      g_source_attach (source, NULL);
+      priv->finished_jobs_source = source;
+
+      /* A single thread is enough to keep up with the glyphs that
+         are missed in a frame and keeps them in order */
+      priv->raster_pool = g_thread_pool_new (cogl_pango_renderer_rasterize_job,
+                                             priv,
+                                             1,
+                                             FALSE,
+                                             NULL);
+    }
+
+  g_thread_pool_push (priv->raster_pool, job, NULL);
+}
+
+static void
+cogl_pango_renderer_stop_jobs (CoglPangoRenderer *priv)
+{
+  if (priv->raster_pool == NULL)
+    return;
 
-  cairo_surface_destroy (surface);
+  /* Wait for the thread to finish without rasterizing the remaining
+     glyphs. The finished jobs are freed along with the queue */
+  g_atomic_int_set (&priv->cancel_jobs, TRUE);
+  g_thread_pool_free (priv->raster_pool, FALSE, TRUE);
+  priv->raster_pool = NULL;
 
-  value->has_color = font_has_color_glyphs (font);
+  g_source_destroy (priv->finished_jobs_source);
+  g_clear_pointer (&priv->finished_jobs_source, g_source_unref);
+  g_clear_pointer (&priv->finished_jobs, g_async_queue_unref);
+}
+
+static void
+cogl_pango_renderer_set_dirty_glyph (PangoFont *font,
+                                     PangoGlyph glyph,
+                                     CoglPangoGlyphCacheValue *value,
+                                     void *user_data)
+{
+  CoglPangoRendererDirtyData *data = user_data;
+  CoglPangoRenderer *priv = data->renderer;
+  CoglPangoGlyphImage image;
+  gboolean has_color;
+
+  COGL_NOTE (PANGO, "redrawing glyph %i", glyph);
+
+  /* Glyphs that don't take up any space will end up without a
+     texture. These should never become dirty so they shouldn't end up
+     here */
+  g_return_if_fail (value->texture != NULL);
+
+  /* A glyph that is still being rasterized gets uploaded to its new
+     position once it is ready */
+  if (value->pending)
+    return;
+
+  cogl_pango_glyph_image_init (&image, font, glyph, value);
+  has_color = !value->sdf && font_has_color_glyphs (font);
+
+  /* Only glyphs that have never been drawn are rasterized in the
+     background. The ones that are redrawn because the atlas was
+     reorganized were visible already so they shouldn't disappear
+     for a frame */
+  if (priv->use_async_rasterization && !value->rasterized)
+    {
+      CoglPangoGlyphJob *job = g_new0 (CoglPangoGlyphJob, 1);
+
+      job->image = image;
+      job->cache = data->cache;
+      job->cache_generation =
+        _cogl_pango_glyph_cache_get_generation (data->cache);
+      job->value = value;
+      job->has_color = has_color;
+
+      value->pending = TRUE;
+
+      cogl_pango_renderer_queue_job (priv, job);
+      return;
+    }
+
+  cogl_pango_glyph_image_rasterize (&image);
+  cogl_pango_glyph_image_upload (&image, value);
+  cogl_pango_glyph_image_clear (&image);
+
+  value->has_color = has_color;
+  value->rasterized = TRUE;
 }
 
 static void
@@ -654,12 +1219,26 @@ _cogl_pango_ensure_glyph_cache_for_layout_line_internal (PangoLayoutLine *line)
 }
 
 static void
-_cogl_pango_set_dirty_glyphs (CoglPangoRenderer *priv)
+_cogl_pango_set_dirty_glyphs_for_cache (CoglPangoRenderer   *priv,
+                                        CoglPangoGlyphCache *cache)
 {
+  CoglPangoRendererDirtyData data;
+
+  data.renderer = priv;
+  data.cache = cache;
+
   _cogl_pango_glyph_cache_set_dirty_glyphs
-    (priv->mipmap_caches.glyph_cache, cogl_pango_renderer_set_dirty_glyph);
-  _cogl_pango_glyph_cache_set_dirty_glyphs
-    (priv->no_mipmap_caches.glyph_cache, cogl_pango_renderer_set_dirty_glyph);
+    (cache, cogl_pango_renderer_set_dirty_glyph, &data);
+}
+
+static void
+_cogl_pango_set_dirty_glyphs (CoglPangoRenderer *priv)
+{
+  _cogl_pango_set_dirty_glyphs_for_cache (priv,
+                                          priv->mipmap_caches.glyph_cache);
+  _cogl_pango_set_dirty_glyphs_for_cache (priv,
+                                          priv->no_mipmap_caches.glyph_cache);
+  _cogl_pango_set_dirty_glyphs_for_cache (priv, priv->sdf_glyph_cache);
 }
 
 static void
@@ -836,6 +1415,7 @@ cogl_pango_renderer_draw_glyphs (PangoRenderer    *renderer,
 {
   CoglPangoRenderer *priv = (CoglPangoRenderer *) renderer;
   CoglPangoGlyphCacheValue *cache_value;
+  float sdf_scale = 0.0f;
   int i;
 
   for (i = 0; i < glyphs->num_glyphs; i++)
@@ -888,7 +1468,11 @@ cogl_pango_renderer_draw_glyphs (PangoRenderer    *renderer,
              a dirty glyph here */
           g_assert (cache_value == NULL || !cache_value->dirty);
 
-	  if (cache_value == NULL)
+          /* Glyphs that are still being rasterized are left out until
+             they are ready */
+          if (cache_value && cache_value->pending)
+            priv->display_list_has_pending_glyphs = TRUE;
+	  else if (cache_value == NULL)
             {
               cogl_pango_renderer_draw_box (renderer,
                                             x,
@@ -898,8 +1482,21 @@ cogl_pango_renderer_draw_glyphs (PangoRenderer    *renderer,
             }
 	  else if (cache_value->texture)
 	    {
-	      x += (float)(cache_value->draw_x);
-	      y += (float)(cache_value->draw_y);
+              float scale = 1.0f;
+
+              /* Distance field glyphs are stored at a fixed size and
+                 scaled to the size of the font */
+              if (cache_value->sdf)
+                {
+                  if (sdf_scale == 0.0f)
+                    _cogl_pango_glyph_cache_get_sdf_scale (priv->sdf_glyph_cache,
+                                                           font,
+                                                           &sdf_scale);
+                  scale = sdf_scale;
+                }
+
+	      x += (float)(cache_value->draw_x) * scale;
+	      y += (float)(cache_value->draw_y) * scale;
 
               /* Do not override color if the glyph/font provide its own */
               if (cache_value->has_color)
@@ -914,7 +1511,7 @@ cogl_pango_renderer_draw_glyphs (PangoRenderer    *renderer,
                   _cogl_pango_display_list_set_color_override (priv->display_list, &color);
                 }
 
-              cogl_pango_renderer_draw_glyph (priv, cache_value, x, y);
+              cogl_pango_renderer_draw_glyph (priv, cache_value, x, y, scale);
 	    }
 	}
 
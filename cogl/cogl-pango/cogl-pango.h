@@ -121,6 +121,11 @@ cogl_pango_font_map_clear_glyph_cache (CoglPangoFontMap *font_map);
  *
  * This api should be used to avoid mid-scene modifications of
  * glyph-cache textures which can lead to undefined rendering results.
+ *
+ * If the font map uses asynchronous rasterization, glyphs that have
+ * never been drawn are instead rasterized in the background and left
+ * out of the layout until [signal@CoglPango.Renderer::glyphs-ready]
+ * is emitted.
  */
 COGL_EXPORT void
 cogl_pango_ensure_glyph_cache_for_layout (PangoLayout *layout);
@@ -149,6 +154,62 @@ cogl_pango_font_map_set_use_mipmapping (CoglPangoFontMap *font_map,
 COGL_EXPORT gboolean
 cogl_pango_font_map_get_use_mipmapping (CoglPangoFontMap *font_map);
 
+/**
+ * cogl_pango_font_map_set_use_sdf:
+ * @font_map: a #CoglPangoFontMap
+ * @value: %TRUE to render glyphs from signed distance fields
+ *
+ * Sets whether the renderer for the passed font map should store the
+ * glyphs of scalable fonts as signed distance fields. A glyph is then
+ * only rasterized once and shared by every size of its font, which
+ * avoids refilling the glyph cache when text is scaled at the cost of
+ * losing hinting.
+ *
+ * This has no effect if the GPU can't render distance fields.
+ */
+COGL_EXPORT void
+cogl_pango_font_map_set_use_sdf (CoglPangoFontMap *font_map,
+                                 gboolean value);
+
+/**
+ * cogl_pango_font_map_get_use_sdf:
+ * @font_map: a #CoglPangoFontMap
+ *
+ * Retrieves whether the [class@CoglPango.Renderer] used by @font_map will
+ * render glyphs from signed distance fields.
+ *
+ * Return value: %TRUE if signed distance fields are used, %FALSE otherwise.
+ */
+COGL_EXPORT gboolean
+cogl_pango_font_map_get_use_sdf (CoglPangoFontMap *font_map);
+
+/**
+ * cogl_pango_font_map_set_use_async_rasterization:
+ * @font_map: a #CoglPangoFontMap
+ * @value: %TRUE to rasterize missing glyphs in the background
+ *
+ * Sets whether the renderer for the passed font map should rasterize
+ * glyphs that aren't in the glyph cache yet on a worker thread. The
+ * glyphs are then drawn from the frame after they were first needed
+ * instead of stalling the frame that needed them.
+ */
+COGL_EXPORT void
+cogl_pango_font_map_set_use_async_rasterization (CoglPangoFontMap *font_map,
+                                                 gboolean value);
+
+/**
+ * cogl_pango_font_map_get_use_async_rasterization:
+ * @font_map: a #CoglPangoFontMap
+ *
+ * Retrieves whether the [class@CoglPango.Renderer] used by @font_map
+ * rasterizes missing glyphs in the background.
+ *
+ * Return value: %TRUE if glyphs are rasterized asynchronously,
+ *   %FALSE otherwise.
+ */
+COGL_EXPORT gboolean
+cogl_pango_font_map_get_use_async_rasterization (CoglPangoFontMap *font_map);
+
 /**
  * cogl_pango_font_map_get_renderer:
  * @font_map: a #CoglPangoFontMap
@@ -196,6 +257,21 @@ cogl_pango_show_layout_line (CoglFramebuffer *framebuffer,
                              float y,
                              const CoglColor *color);
 
+/**
+ * cogl_pango_layout_has_pending_glyphs:
+ * @layout: a #PangoLayout
+ *
+ * Checks whether the last time @layout or one of its lines was drawn
+ * with [func@CoglPango.show_layout] or
+ * [func@CoglPango.show_layout_line] some of its glyphs were left out
+ * because they were still being rasterized.
+ *
+ * Return value: %TRUE if @layout needs to be drawn again once
+ *   [signal@CoglPango.Renderer::glyphs-ready] is emitted.
+ */
+COGL_EXPORT gboolean
+cogl_pango_layout_has_pending_glyphs (PangoLayout *layout);
+
 
 #define COGL_PANGO_TYPE_RENDERER                (cogl_pango_renderer_get_type ())
 #define COGL_PANGO_RENDERER(obj)                (G_TYPE_CHECK_INSTANCE_CAST ((obj), COGL_PANGO_TYPE_RENDERER, CoglPangoRenderer))
@@ -74,5 +74,8 @@ _cogl_atlas_texture_remove_reorganize_callback (CoglContext *ctx,
                                                 GHookFunc callback,
                                                 void *user_data);
 
+void
+_cogl_atlas_texture_compact_atlases (CoglContext *ctx);
+
 gboolean
 _cogl_is_atlas_texture (void *object);
@@ -196,6 +196,50 @@ _cogl_atlas_texture_atlas_destroyed_cb (void *user_data)
   ctx->atlases = g_slist_remove (ctx->atlases, user_data);
 }
 
+/* Time an atlas has to stay sparse before it is compacted. This avoids
+   shrinking it while textures are being replaced, eg. during an
+   animation, only to grow it again. It is measured in time rather than
+   in swaps, as every onscreen swap checks the atlases, so a swap count
+   would depend on the number of monitors */
+#define COGL_ATLAS_COMPACT_DELAY_US (G_USEC_PER_SEC * 2)
+
+void
+_cogl_atlas_texture_compact_atlases (CoglContext *ctx)
+{
+  gboolean compacted = FALSE;
+  int64_t now_us;
+  GSList *l;
+
+  if (!ctx->atlases)
+    return;
+
+  now_us = g_get_monotonic_time ();
+
+  for (l = ctx->atlases; l; l = l->next)
+    {
+      CoglAtlas *atlas = l->data;
+
+      if (!_cogl_atlas_can_compact (atlas))
+        {
+          atlas->sparse_since_us = 0;
+          continue;
+        }
+
+      if (!atlas->sparse_since_us)
+        atlas->sparse_since_us = now_us;
+
+      /* Migrating an atlas costs about as much as growing it so at
+         most one atlas is compacted per swap */
+      if (compacted ||
+          now_us - atlas->sparse_since_us < COGL_ATLAS_COMPACT_DELAY_US)
+        continue;
+
+      atlas->sparse_since_us = 0;
+      _cogl_atlas_compact (atlas);
+      compacted = TRUE;
+    }
+}
+
 static CoglAtlas *
 _cogl_atlas_texture_create_atlas (CoglContext *ctx)
 {
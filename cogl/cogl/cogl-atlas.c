@@ -63,6 +63,8 @@ _cogl_atlas_new (CoglPixelFormat texture_format,
   atlas->texture_format = texture_format;
   g_hook_list_init (&atlas->pre_reorganize_callbacks, sizeof (GHook));
   g_hook_list_init (&atlas->post_reorganize_callbacks, sizeof (GHook));
+  atlas->sparse_since_us = 0;
+  atlas->compact_failed_used_space = 0;
 
   return _cogl_atlas_object_new (atlas);
 }
@@ -559,6 +561,136 @@ _cogl_atlas_remove (CoglAtlas *atlas,
                     _cogl_rectangle_map_get_height (atlas->map)));
 };
 
+/* Returns whether the used space of the atlas, including the same
+ * margin that _cogl_atlas_reserve_space() leaves when reorganizing,
+ * would fit in half of the texture */
+gboolean
+_cogl_atlas_can_compact (CoglAtlas *atlas)
+{
+  unsigned int map_width, map_height;
+  unsigned int initial_width, initial_height;
+  unsigned int used_space;
+
+  if (atlas->map == NULL ||
+      (atlas->flags & COGL_ATLAS_DISABLE_MIGRATION))
+    return FALSE;
+
+  map_width = _cogl_rectangle_map_get_width (atlas->map);
+  map_height = _cogl_rectangle_map_get_height (atlas->map);
+
+  /* The atlas never gets smaller than its initial size */
+  _cogl_atlas_get_initial_size (atlas->texture_format,
+                                &initial_width, &initial_height);
+  if (map_width * map_height <= initial_width * initial_height)
+    return FALSE;
+
+  used_space = (map_width * map_height -
+                _cogl_rectangle_map_get_remaining_space (atlas->map));
+
+  /* Don't retry a compaction that failed until some more space has
+     been freed */
+  if (atlas->compact_failed_used_space &&
+      used_space >= atlas->compact_failed_used_space)
+    return FALSE;
+
+  return used_space * 53 / 50 <= map_width * map_height / 2;
+}
+
+/* Repacks the rectangles of the atlas into the smallest texture that
+ * can hold them. Returns FALSE if that isn't smaller than the current
+ * texture, in which case nothing is changed */
+gboolean
+_cogl_atlas_compact (CoglAtlas *atlas)
+{
+  CoglAtlasGetRectanglesData data;
+  CoglRectangleMap *new_map;
+  CoglTexture2D *new_tex;
+  unsigned int map_width, map_height;
+  unsigned int old_width, old_height;
+  unsigned int n_rectangles;
+
+  g_return_val_if_fail (atlas->map != NULL, FALSE);
+  g_return_val_if_fail (!(atlas->flags & COGL_ATLAS_DISABLE_MIGRATION),
+                        FALSE);
+
+  old_width = _cogl_rectangle_map_get_width (atlas->map);
+  old_height = _cogl_rectangle_map_get_height (atlas->map);
+  n_rectangles = _cogl_rectangle_map_get_n_rectangles (atlas->map);
+
+  if (n_rectangles == 0)
+    return FALSE;
+
+  data.n_textures = 0;
+  data.textures = g_new (CoglAtlasRepositionData, n_rectangles);
+  _cogl_rectangle_map_foreach (atlas->map,
+                               _cogl_atlas_get_rectangles_cb,
+                               &data);
+
+  qsort (data.textures, data.n_textures,
+         sizeof (CoglAtlasRepositionData),
+         _cogl_atlas_compare_size_cb);
+
+  /* Start from the initial size and let the map grow until everything
+     fits */
+  _cogl_atlas_get_initial_size (atlas->texture_format,
+                                &map_width, &map_height);
+
+  new_map = _cogl_atlas_create_map (atlas->texture_format,
+                                    map_width, map_height,
+                                    data.n_textures, data.textures);
+
+  if (new_map == NULL ||
+      (_cogl_rectangle_map_get_width (new_map) *
+       _cogl_rectangle_map_get_height (new_map) >= old_width * old_height))
+    {
+      COGL_NOTE (ATLAS, "%p: Atlas can't be compacted", atlas);
+      atlas->compact_failed_used_space =
+        (old_width * old_height -
+         _cogl_rectangle_map_get_remaining_space (atlas->map));
+      g_clear_pointer (&new_map, _cogl_rectangle_map_free);
+      g_free (data.textures);
+      return FALSE;
+    }
+
+  new_tex = _cogl_atlas_create_texture (atlas,
+                                        _cogl_rectangle_map_get_width (new_map),
+                                        _cogl_rectangle_map_get_height (new_map));
+  if (new_tex == NULL)
+    {
+      COGL_NOTE (ATLAS, "%p: Could not create a CoglTexture2D", atlas);
+      _cogl_rectangle_map_free (new_map);
+      g_free (data.textures);
+      return FALSE;
+    }
+
+  COGL_NOTE (ATLAS, "%p: Atlas compacted from %ux%u to %ux%u",
+             atlas,
+             old_width, old_height,
+             _cogl_rectangle_map_get_width (new_map),
+             _cogl_rectangle_map_get_height (new_map));
+
+  _cogl_atlas_notify_pre_reorganize (atlas);
+
+  _cogl_atlas_migrate (atlas,
+                       data.n_textures,
+                       data.textures,
+                       atlas->texture,
+                       COGL_TEXTURE (new_tex),
+                       NULL);
+  _cogl_rectangle_map_free (atlas->map);
+  cogl_object_unref (atlas->texture);
+
+  atlas->map = new_map;
+  atlas->texture = COGL_TEXTURE (new_tex);
+  atlas->compact_failed_used_space = 0;
+
+  _cogl_atlas_notify_post_reorganize (atlas);
+
+  g_free (data.textures);
+
+  return TRUE;
+}
+
 static CoglTexture *
 create_migration_texture (CoglContext *ctx,
                           int width,
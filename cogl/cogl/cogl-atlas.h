@@ -61,6 +61,13 @@ struct _CoglAtlas
 
   GHookList pre_reorganize_callbacks;
   GHookList post_reorganize_callbacks;
+
+  /* Monotonic time at which the atlas became sparse enough to fit in
+     a smaller texture, or 0 if it currently isn't */
+  int64_t sparse_since_us;
+  /* Used space at which the last compaction failed to shrink the
+     atlas. It isn't retried until more space has been freed */
+  unsigned int compact_failed_used_space;
 };
 
 COGL_EXPORT CoglAtlas *
@@ -78,6 +85,12 @@ void
 _cogl_atlas_remove (CoglAtlas *atlas,
                     const CoglRectangleMapEntry *rectangle);
 
+gboolean
+_cogl_atlas_can_compact (CoglAtlas *atlas);
+
+gboolean
+_cogl_atlas_compact (CoglAtlas *atlas);
+
 CoglTexture *
 _cogl_atlas_copy_rectangle (CoglAtlas *atlas,
                             int x,
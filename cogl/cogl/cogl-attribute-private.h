@@ -81,6 +81,10 @@ struct _CoglAttribute
     } constant;
   } d;
 
+  /* Number of instances drawn before advancing to the next element of
+     the attribute, or 0 to advance once per vertex */
+  unsigned int instance_divisor;
+
   int immutable_ref;
 };
 
@@ -133,3 +137,7 @@ _cogl_flush_attributes_state (CoglFramebuffer *framebuffer,
 
 int
 _cogl_attribute_get_n_components (CoglAttribute *attribute);
+
+void
+_cogl_attribute_set_instance_divisor (CoglAttribute *attribute,
+                                      unsigned int   divisor);
@@ -489,6 +489,19 @@ cogl_attribute_set_buffer (CoglAttribute *attribute,
   attribute->d.buffered.attribute_buffer = attribute_buffer;
 }
 
+void
+_cogl_attribute_set_instance_divisor (CoglAttribute *attribute,
+                                      unsigned int   divisor)
+{
+  g_return_if_fail (cogl_is_attribute (attribute));
+  g_return_if_fail (attribute->is_buffered);
+
+  if (G_UNLIKELY (attribute->immutable_ref))
+    warn_about_midscene_changes ();
+
+  attribute->instance_divisor = divisor;
+}
+
 CoglAttribute *
 _cogl_attribute_immutable_ref (CoglAttribute *attribute)
 {
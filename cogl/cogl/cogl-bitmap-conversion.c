@@ -32,6 +32,7 @@
 
 #include "cogl/cogl-private.h"
 #include "cogl/cogl-bitmap-private.h"
+#include "cogl/cogl-bitmap-simd-private.h"
 #include "cogl/cogl-context-private.h"
 #include "cogl/cogl-texture-private.h"
 
@@ -63,197 +64,18 @@
 
 /* (Un)Premultiplication */
 
-inline static void
-_cogl_unpremult_alpha_0 (uint8_t *dst)
-{
-  dst[0] = 0;
-  dst[1] = 0;
-  dst[2] = 0;
-  dst[3] = 0;
-}
-
-inline static void
-_cogl_unpremult_alpha_last (uint8_t *dst)
-{
-  uint8_t alpha = dst[3];
-
-  dst[0] = (dst[0] * 255) / alpha;
-  dst[1] = (dst[1] * 255) / alpha;
-  dst[2] = (dst[2] * 255) / alpha;
-}
-
-inline static void
-_cogl_unpremult_alpha_first (uint8_t *dst)
-{
-  uint8_t alpha = dst[0];
-
-  dst[1] = (dst[1] * 255) / alpha;
-  dst[2] = (dst[2] * 255) / alpha;
-  dst[3] = (dst[3] * 255) / alpha;
-}
-
-/* No division form of floor((c*a + 128)/255) (I first encountered
- * this in the RENDER implementation in the X server.) Being exact
- * is important for a == 255 - we want to get exactly c.
- */
-#define MULT(d,a,t)                             \
-  G_STMT_START {                                \
-    t = d * a + 128;                            \
-    d = ((t >> 8) + t) >> 8;                    \
-  } G_STMT_END
-
-inline static void
-_cogl_premult_alpha_last (uint8_t *dst)
-{
-  uint8_t alpha = dst[3];
-  /* Using a separate temporary per component has given slightly better
-   * code generation with GCC in the past; it shouldn't do any worse in
-   * any case.
-   */
-  unsigned int t1, t2, t3;
-  MULT(dst[0], alpha, t1);
-  MULT(dst[1], alpha, t2);
-  MULT(dst[2], alpha, t3);
-}
-
-inline static void
-_cogl_premult_alpha_first (uint8_t *dst)
-{
-  uint8_t alpha = dst[0];
-  unsigned int t1, t2, t3;
-
-  MULT(dst[1], alpha, t1);
-  MULT(dst[2], alpha, t2);
-  MULT(dst[3], alpha, t3);
-}
-
-#undef MULT
-
-/* Use the SSE optimized version to premult four pixels at once when
-   it is available. The same assembler code works for x86 and x86-64
-   because it doesn't refer to any non-SSE registers directly */
-#if defined(__SSE2__) && defined(__GNUC__) \
-  && (defined(__x86_64) || defined(__i386))
-#define COGL_USE_PREMULT_SSE2
-#endif
-
-#ifdef COGL_USE_PREMULT_SSE2
-
-inline static void
-_cogl_premult_alpha_last_four_pixels_sse2 (uint8_t *p)
-{
-  /* 8 copies of 128 used below */
-  static const int16_t eight_halves[8] __attribute__ ((aligned (16))) =
-    { 128, 128, 128, 128, 128, 128, 128, 128 };
-  /* Mask of the rgb components of the four pixels */
-  static const int8_t just_rgb[16] __attribute__ ((aligned (16))) =
-    { 0xff, 0xff, 0xff, 0x00, 0xff, 0xff, 0xff, 0x00,
-      0xff, 0xff, 0xff, 0x00, 0xff, 0xff, 0xff, 0x00 };
-  /* Each SSE register only holds two pixels because we need to work
-     with 16-bit intermediate values. We still do four pixels by
-     interleaving two registers in the hope that it will pipeline
-     better */
-  asm (/* Load eight_halves into xmm5 for later */
-       "movdqa (%1), %%xmm5\n"
-       /* Clear xmm3 */
-       "pxor %%xmm3, %%xmm3\n"
-       /* Load two pixels from p into the low half of xmm0 */
-       "movlps (%0), %%xmm0\n"
-       /* Load the next set of two pixels from p into the low half of xmm1 */
-       "movlps 8(%0), %%xmm1\n"
-       /* Unpack 8 bytes from the low quad-words in each register to 8
-          16-bit values */
-       "punpcklbw %%xmm3, %%xmm0\n"
-       "punpcklbw %%xmm3, %%xmm1\n"
-       /* Copy alpha values of the first pixel in xmm0 to all
-          components of the first pixel in xmm2 */
-       "pshuflw $255, %%xmm0, %%xmm2\n"
-       /* same for xmm1 and xmm3 */
-       "pshuflw $255, %%xmm1, %%xmm3\n"
-       /* The above also copies the second pixel directly so we now
-          want to replace the RGB components with copies of the alpha
-          components */
-       "pshufhw $255, %%xmm2, %%xmm2\n"
-       "pshufhw $255, %%xmm3, %%xmm3\n"
-       /* Multiply the rgb components by the alpha */
-       "pmullw %%xmm2, %%xmm0\n"
-       "pmullw %%xmm3, %%xmm1\n"
-       /* Add 128 to each component */
-       "paddw %%xmm5, %%xmm0\n"
-       "paddw %%xmm5, %%xmm1\n"
-       /* Copy the results to temporary registers xmm4 and xmm5 */
-       "movdqa %%xmm0, %%xmm4\n"
-       "movdqa %%xmm1, %%xmm5\n"
-       /* Divide the results by 256 */
-       "psrlw $8, %%xmm0\n"
-       "psrlw $8, %%xmm1\n"
-       /* Add the temporaries back in */
-       "paddw %%xmm4, %%xmm0\n"
-       "paddw %%xmm5, %%xmm1\n"
-       /* Divide again */
-       "psrlw $8, %%xmm0\n"
-       "psrlw $8, %%xmm1\n"
-       /* Pack the results back as bytes */
-       "packuswb %%xmm1, %%xmm0\n"
-       /* Load just_rgb into xmm3 for later */
-       "movdqa (%2), %%xmm3\n"
-       /* Reload all four pixels into xmm2 */
-       "movups (%0), %%xmm2\n"
-       /* Mask out the alpha from the results */
-       "andps %%xmm3, %%xmm0\n"
-       /* Mask out the RGB from the original four pixels */
-       "andnps %%xmm2, %%xmm3\n"
-       /* Combine the two to get the right alpha values */
-       "orps %%xmm3, %%xmm0\n"
-       /* Write to memory */
-       "movdqu %%xmm0, (%0)\n"
-       : /* no outputs */
-       : "r" (p), "r" (eight_halves), "r" (just_rgb)
-       : "xmm0", "xmm1", "xmm2", "xmm3", "xmm4", "xmm5");
-}
-
-#endif /* COGL_USE_PREMULT_SSE2 */
-
 static void
 _cogl_bitmap_premult_unpacked_span_8 (uint8_t *data,
                                       int width)
 {
-#ifdef COGL_USE_PREMULT_SSE2
-
-  /* Process 4 pixels at a time */
-  while (width >= 4)
-    {
-      _cogl_premult_alpha_last_four_pixels_sse2 (data);
-      data += 4 * 4;
-      width -= 4;
-    }
-
-  /* If there are any pixels left we will fall through and
-     handle them below */
-
-#endif /* COGL_USE_PREMULT_SSE2 */
-
-  while (width-- > 0)
-    {
-      _cogl_premult_alpha_last (data);
-      data += 4;
-    }
+  _cogl_bitmap_simd_get_funcs ()->premult_alpha_last (data, width);
 }
 
 static void
 _cogl_bitmap_unpremult_unpacked_span_8 (uint8_t *data,
                                         int width)
 {
-  int x;
-
-  for (x = 0; x < width; x++)
-    {
-      if (data[3] == 0)
-        _cogl_unpremult_alpha_0 (data);
-      else
-        _cogl_unpremult_alpha_last (data);
-      data += 4;
-    }
+  _cogl_bitmap_simd_get_funcs ()->unpremult_alpha_last (data, width);
 }
 
 static void
@@ -272,6 +94,7 @@ _cogl_bitmap_unpremult_unpacked_span_16 (uint16_t *data,
           data[1] = (data[1] * 65535) / alpha;
           data[2] = (data[2] * 65535) / alpha;
         }
+      data += 4;
     }
 }
 
@@ -286,6 +109,7 @@ _cogl_bitmap_premult_unpacked_span_16 (uint16_t *data,
       data[0] = (data[0] * alpha) / 65535;
       data[1] = (data[1] * alpha) / 65535;
       data[2] = (data[2] * alpha) / 65535;
+      data += 4;
     }
 }
 
@@ -376,6 +200,101 @@ _cogl_bitmap_needs_short_temp_buffer (CoglPixelFormat format)
   return FALSE;
 }
 
+/* Gets the byte offsets of the red, green, blue and alpha components
+   of a format with four 8-bit components */
+static gboolean
+_cogl_bitmap_get_8888_offsets (CoglPixelFormat format,
+                               int offsets[4])
+{
+  static const int rgba[4] = { 0, 1, 2, 3 };
+  static const int bgra[4] = { 2, 1, 0, 3 };
+  static const int argb[4] = { 1, 2, 3, 0 };
+  static const int abgr[4] = { 3, 2, 1, 0 };
+  const int *table;
+
+  switch (format & ~COGL_PREMULT_BIT)
+    {
+    case COGL_PIXEL_FORMAT_RGBX_8888:
+    case COGL_PIXEL_FORMAT_RGBA_8888:
+      table = rgba;
+      break;
+    case COGL_PIXEL_FORMAT_BGRX_8888:
+    case COGL_PIXEL_FORMAT_BGRA_8888:
+      table = bgra;
+      break;
+    case COGL_PIXEL_FORMAT_XRGB_8888:
+    case COGL_PIXEL_FORMAT_ARGB_8888:
+      table = argb;
+      break;
+    case COGL_PIXEL_FORMAT_XBGR_8888:
+    case COGL_PIXEL_FORMAT_ABGR_8888:
+      table = abgr;
+      break;
+    default:
+      return FALSE;
+    }
+
+  memcpy (offsets, table, sizeof (int) * 4);
+
+  return TRUE;
+}
+
+/* Converting between two formats with four 8-bit components is just
+   a matter of reordering the bytes so it can skip unpacking to the
+   temporary row */
+static gboolean
+_cogl_bitmap_get_shuffle (CoglPixelFormat src_format,
+                          CoglPixelFormat dst_format,
+                          CoglBitmapShuffle *shuffle)
+{
+  int src_offsets[4];
+  int dst_offsets[4];
+  int i;
+
+  if (!_cogl_bitmap_get_8888_offsets (src_format, src_offsets) ||
+      !_cogl_bitmap_get_8888_offsets (dst_format, dst_offsets))
+    return FALSE;
+
+  for (i = 0; i < 4; i++)
+    shuffle->shuffle[dst_offsets[i]] = src_offsets[i];
+
+  /* Formats without alpha unpack to an opaque alpha and pack 255
+     into the padding byte */
+  if (!(src_format & COGL_A_BIT) || !(dst_format & COGL_A_BIT))
+    shuffle->shuffle[dst_offsets[3]] = -1;
+
+  return TRUE;
+}
+
+static gboolean
+_cogl_bitmap_get_unpack_10 (CoglPixelFormat format,
+                            CoglBitmapUnpack10 *unpack)
+{
+  switch (format & ~COGL_PREMULT_BIT)
+    {
+    case COGL_PIXEL_FORMAT_RGBA_1010102:
+      *unpack = (CoglBitmapUnpack10) { 22, 12, 2, 0 };
+      return TRUE;
+    case COGL_PIXEL_FORMAT_BGRA_1010102:
+      *unpack = (CoglBitmapUnpack10) { 2, 12, 22, 0 };
+      return TRUE;
+    case COGL_PIXEL_FORMAT_XRGB_2101010:
+      *unpack = (CoglBitmapUnpack10) { 20, 10, 0, -1 };
+      return TRUE;
+    case COGL_PIXEL_FORMAT_ARGB_2101010:
+      *unpack = (CoglBitmapUnpack10) { 20, 10, 0, 30 };
+      return TRUE;
+    case COGL_PIXEL_FORMAT_XBGR_2101010:
+      *unpack = (CoglBitmapUnpack10) { 0, 10, 20, -1 };
+      return TRUE;
+    case COGL_PIXEL_FORMAT_ABGR_2101010:
+      *unpack = (CoglBitmapUnpack10) { 0, 10, 20, 30 };
+      return TRUE;
+    default:
+      return FALSE;
+    }
+}
+
 gboolean
 _cogl_bitmap_convert_into_bitmap (CoglBitmap *src_bmp,
                                   CoglBitmap *dst_bmp,
@@ -392,7 +311,12 @@ _cogl_bitmap_convert_into_bitmap (CoglBitmap *src_bmp,
   int width, height;
   CoglPixelFormat src_format;
   CoglPixelFormat dst_format;
+  const CoglBitmapSimdFuncs *funcs;
+  CoglBitmapShuffle shuffle;
+  CoglBitmapUnpack10 unpack_10;
   gboolean use_16;
+  gboolean use_shuffle;
+  gboolean use_unpack_10;
   gboolean need_premult;
 
   src_format = cogl_bitmap_get_format (src_bmp);
@@ -453,13 +377,52 @@ _cogl_bitmap_convert_into_bitmap (CoglBitmap *src_bmp,
       return FALSE;
     }
 
+  funcs = _cogl_bitmap_simd_get_funcs ();
+
+  use_shuffle = _cogl_bitmap_get_shuffle (src_format, dst_format, &shuffle);
+
+  if (use_shuffle)
+    {
+      for (y = 0; y < height; y++)
+        {
+          dst = dst_data + y * dst_rowstride;
+
+          funcs->shuffle_8888 (src_data + y * src_rowstride, dst,
+                               width, &shuffle);
+
+          if (!need_premult)
+            continue;
+
+          if (dst_format & COGL_PREMULT_BIT)
+            {
+              if (dst_format & COGL_AFIRST_BIT)
+                funcs->premult_alpha_first (dst, width);
+              else
+                funcs->premult_alpha_last (dst, width);
+            }
+          else
+            {
+              if (dst_format & COGL_AFIRST_BIT)
+                funcs->unpremult_alpha_first (dst, width);
+              else
+                funcs->unpremult_alpha_last (dst, width);
+            }
+        }
+
+      _cogl_bitmap_unmap (src_bmp);
+      _cogl_bitmap_unmap (dst_bmp);
+
+      return TRUE;
+    }
+
   use_16 = _cogl_bitmap_needs_short_temp_buffer (dst_format);
+  use_unpack_10 = !use_16 && _cogl_bitmap_get_unpack_10 (src_format,
+                                                         &unpack_10);
 
   /* Allocate a buffer to hold a temporary RGBA row */
   tmp_row = g_malloc (width *
                       (use_16 ? sizeof (uint16_t) : sizeof (uint8_t)) * 4);
 
-  /* FIXME: Optimize */
   for (y = 0; y < height; y++)
     {
       src = src_data + y * src_rowstride;
@@ -467,6 +430,8 @@ _cogl_bitmap_convert_into_bitmap (CoglBitmap *src_bmp,
 
       if (use_16)
         _cogl_unpack_16 (src_format, src, tmp_row, width);
+      else if (use_unpack_10)
+        funcs->unpack_10_to_8 (src, tmp_row, width, &unpack_10);
       else
         _cogl_unpack_8 (src_format, src, tmp_row, width);
 
@@ -636,9 +601,10 @@ gboolean
 _cogl_bitmap_unpremult (CoglBitmap *bmp,
                         GError **error)
 {
+  const CoglBitmapSimdFuncs *funcs = _cogl_bitmap_simd_get_funcs ();
   uint8_t *p, *data;
   uint16_t *tmp_row;
-  int x,y;
+  int y;
   CoglPixelFormat format;
   int width, height;
   int rowstride;
@@ -676,18 +642,9 @@ _cogl_bitmap_unpremult (CoglBitmap *bmp,
       else
         {
           if (format & COGL_AFIRST_BIT)
-            {
-              for (x = 0; x < width; x++)
-                {
-                  if (p[0] == 0)
-                    _cogl_unpremult_alpha_0 (p);
-                  else
-                    _cogl_unpremult_alpha_first (p);
-                  p += 4;
-                }
-            }
+            funcs->unpremult_alpha_first (p, width);
           else
-            _cogl_bitmap_unpremult_unpacked_span_8 (p, width);
+            funcs->unpremult_alpha_last (p, width);
         }
     }
 
@@ -704,9 +661,10 @@ gboolean
 _cogl_bitmap_premult (CoglBitmap *bmp,
                       GError **error)
 {
+  const CoglBitmapSimdFuncs *funcs = _cogl_bitmap_simd_get_funcs ();
   uint8_t *p, *data;
   uint16_t *tmp_row;
-  int x,y;
+  int y;
   CoglPixelFormat format;
   int width, height;
   int rowstride;
@@ -743,15 +701,9 @@ _cogl_bitmap_premult (CoglBitmap *bmp,
       else
         {
           if (format & COGL_AFIRST_BIT)
-            {
-              for (x = 0; x < width; x++)
-                {
-                  _cogl_premult_alpha_first (p);
-                  p += 4;
-                }
-            }
+            funcs->premult_alpha_first (p, width);
           else
-            _cogl_bitmap_premult_unpacked_span_8 (p, width);
+            funcs->premult_alpha_last (p, width);
         }
     }
 
@@ -0,0 +1,111 @@
+/*
+ * Cogl
+ *
+ * A Low Level GPU Graphics and Utilities API
+ *
+ * Copyright (C) 2026 agent
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <glib.h>
+
+#include "cogl/cogl-macros.h"
+
+G_BEGIN_DECLS
+
+/*
+ * Kernels for the inner loops of the bitmap conversion code. Each
+ * kernel has a portable implementation and optionally vectorized
+ * implementations which are picked at runtime depending on what the
+ * CPU supports. All implementations produce exactly the same results
+ * as the portable one.
+ */
+
+typedef enum
+{
+  COGL_BITMAP_SIMD_NONE,
+  COGL_BITMAP_SIMD_SSE2,
+  COGL_BITMAP_SIMD_AVX2,
+  COGL_BITMAP_SIMD_NEON,
+
+  COGL_BITMAP_SIMD_N_LEVELS
+} CoglBitmapSimdLevel;
+
+/* Reorders the bytes of 32-bit pixels. Byte i of each destination
+ * pixel is taken from byte shuffle[i] of the source pixel or is set
+ * to 0xff if shuffle[i] is negative */
+typedef struct
+{
+  int8_t shuffle[4];
+} CoglBitmapShuffle;
+
+/* Positions of the channels of a format with 10 bits per color
+ * component and 2 bits of alpha. a_shift is negative if the format
+ * has no alpha */
+typedef struct
+{
+  int r_shift;
+  int g_shift;
+  int b_shift;
+  int a_shift;
+} CoglBitmapUnpack10;
+
+typedef struct
+{
+  CoglBitmapSimdLevel level;
+  const char *name;
+
+  /* In place (un)premultiplication of 8-bit per component pixels
+   * with the alpha either in the last or in the first byte */
+  void (* premult_alpha_last) (uint8_t *data,
+                               int      width);
+  void (* premult_alpha_first) (uint8_t *data,
+                                int      width);
+  void (* unpremult_alpha_last) (uint8_t *data,
+                                 int      width);
+  void (* unpremult_alpha_first) (uint8_t *data,
+                                  int      width);
+
+  void (* shuffle_8888) (const uint8_t           *src,
+                         uint8_t                 *dst,
+                         int                      width,
+                         const CoglBitmapShuffle *shuffle);
+
+  /* Unpacks a 10-bit per component format to 8-bit RGBA */
+  void (* unpack_10_to_8) (const uint8_t            *src,
+                           uint8_t                  *dst,
+                           int                       width,
+                           const CoglBitmapUnpack10 *unpack);
+} CoglBitmapSimdFuncs;
+
+/* Returns the fastest implementation supported by the CPU */
+COGL_EXPORT_TEST const CoglBitmapSimdFuncs *
+_cogl_bitmap_simd_get_funcs (void);
+
+/* Returns NULL if the level isn't built in or the CPU doesn't
+ * support it */
+COGL_EXPORT_TEST const CoglBitmapSimdFuncs *
+_cogl_bitmap_simd_get_funcs_for_level (CoglBitmapSimdLevel level);
+
+G_END_DECLS
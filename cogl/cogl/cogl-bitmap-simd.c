@@ -0,0 +1,1092 @@
+/*
+ * Cogl
+ *
+ * A Low Level GPU Graphics and Utilities API
+ *
+ * Copyright (C) 2026 agent
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "cogl-config.h"
+
+#include <string.h>
+
+#include "cogl/cogl-bitmap-simd-private.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define COGL_BITMAP_SIMD_X86
+#include <immintrin.h>
+#endif
+
+#if defined(__aarch64__)
+#define COGL_BITMAP_SIMD_NEON_AARCH64
+#include <arm_neon.h>
+#endif
+
+/* Portable versions */
+
+/* No division form of floor((c*a + 128)/255) (I first encountered
+ * this in the RENDER implementation in the X server.) Being exact
+ * is important for a == 255 - we want to get exactly c.
+ */
+#define MULT(d,a,t)                             \
+  G_STMT_START {                                \
+    t = d * a + 128;                            \
+    d = ((t >> 8) + t) >> 8;                    \
+  } G_STMT_END
+
+static void
+premult_alpha_last_c (uint8_t *data,
+                      int      width)
+{
+  while (width-- > 0)
+    {
+      uint8_t alpha = data[3];
+      /* Using a separate temporary per component has given slightly
+       * better code generation with GCC in the past; it shouldn't do
+       * any worse in any case.
+       */
+      unsigned int t1, t2, t3;
+
+      MULT (data[0], alpha, t1);
+      MULT (data[1], alpha, t2);
+      MULT (data[2], alpha, t3);
+      data += 4;
+    }
+}
+
+static void
+premult_alpha_first_c (uint8_t *data,
+                       int      width)
+{
+  while (width-- > 0)
+    {
+      uint8_t alpha = data[0];
+      unsigned int t1, t2, t3;
+
+      MULT (data[1], alpha, t1);
+      MULT (data[2], alpha, t2);
+      MULT (data[3], alpha, t3);
+      data += 4;
+    }
+}
+
+#undef MULT
+
+static void
+unpremult_alpha_last_c (uint8_t *data,
+                        int      width)
+{
+  while (width-- > 0)
+    {
+      uint8_t alpha = data[3];
+
+      if (alpha == 0)
+        {
+          memset (data, 0, 4);
+        }
+      else
+        {
+          data[0] = (data[0] * 255) / alpha;
+          data[1] = (data[1] * 255) / alpha;
+          data[2] = (data[2] * 255) / alpha;
+        }
+      data += 4;
+    }
+}
+
+static void
+unpremult_alpha_first_c (uint8_t *data,
+                         int      width)
+{
+  while (width-- > 0)
+    {
+      uint8_t alpha = data[0];
+
+      if (alpha == 0)
+        {
+          memset (data, 0, 4);
+        }
+      else
+        {
+          data[1] = (data[1] * 255) / alpha;
+          data[2] = (data[2] * 255) / alpha;
+          data[3] = (data[3] * 255) / alpha;
+        }
+      data += 4;
+    }
+}
+
+static void
+shuffle_8888_c (const uint8_t           *src,
+                uint8_t                 *dst,
+                int                      width,
+                const CoglBitmapShuffle *shuffle)
+{
+  while (width-- > 0)
+    {
+      uint8_t pixel[4];
+      int i;
+
+      /* Copy first so that src and dst can be the same */
+      memcpy (pixel, src, 4);
+
+      for (i = 0; i < 4; i++)
+        dst[i] = shuffle->shuffle[i] < 0 ? 0xff : pixel[shuffle->shuffle[i]];
+
+      src += 4;
+      dst += 4;
+    }
+}
+
+#define UNPACK_10_TO_8(b) (((b) * 255 + 0x1ff) / 0x3ff)
+
+static void
+unpack_10_to_8_c (const uint8_t            *src,
+                  uint8_t                  *dst,
+                  int                       width,
+                  const CoglBitmapUnpack10 *unpack)
+{
+  while (width-- > 0)
+    {
+      uint32_t v;
+
+      memcpy (&v, src, sizeof (v));
+
+      dst[0] = UNPACK_10_TO_8 ((v >> unpack->r_shift) & 0x3ff);
+      dst[1] = UNPACK_10_TO_8 ((v >> unpack->g_shift) & 0x3ff);
+      dst[2] = UNPACK_10_TO_8 ((v >> unpack->b_shift) & 0x3ff);
+      if (unpack->a_shift >= 0)
+        dst[3] = ((v >> unpack->a_shift) & 0x3) * 0x55;
+      else
+        dst[3] = 0xff;
+
+      src += 4;
+      dst += 4;
+    }
+}
+
+#undef UNPACK_10_TO_8
+
+static const CoglBitmapSimdFuncs simd_funcs_c = {
+  .level = COGL_BITMAP_SIMD_NONE,
+  .name = "c",
+  .premult_alpha_last = premult_alpha_last_c,
+  .premult_alpha_first = premult_alpha_first_c,
+  .unpremult_alpha_last = unpremult_alpha_last_c,
+  .unpremult_alpha_first = unpremult_alpha_first_c,
+  .shuffle_8888 = shuffle_8888_c,
+  .unpack_10_to_8 = unpack_10_to_8_c,
+};
+
+#ifdef COGL_BITMAP_SIMD_X86
+
+/* SSE2 versions, working on four pixels at a time. The vector
+ * versions of the shifts are used throughout so that the channel
+ * positions can be passed as arguments. */
+
+#define SSE2 __attribute__ ((target ("sse2")))
+
+static inline SSE2 __m128i
+premult_2_pixels_sse2 (__m128i pixels,
+                       __m128i alpha)
+{
+  pixels = _mm_mullo_epi16 (pixels, alpha);
+  pixels = _mm_add_epi16 (pixels, _mm_set1_epi16 (128));
+  pixels = _mm_add_epi16 (pixels, _mm_srli_epi16 (pixels, 8));
+
+  return _mm_srli_epi16 (pixels, 8);
+}
+
+static inline SSE2 void
+premult_sse2 (uint8_t  *data,
+              int       width,
+              gboolean  alpha_first)
+{
+  const __m128i zero = _mm_setzero_si128 ();
+  const __m128i alpha_mask = _mm_set1_epi32 (alpha_first ? 0xff : 0xff000000);
+
+  for (; width >= 4; width -= 4, data += 16)
+    {
+      __m128i pixels = _mm_loadu_si128 ((const __m128i *) data);
+      /* Each register only holds two pixels because the
+       * intermediate values need 16 bits */
+      __m128i lo = _mm_unpacklo_epi8 (pixels, zero);
+      __m128i hi = _mm_unpackhi_epi8 (pixels, zero);
+      __m128i alpha_lo, alpha_hi;
+      __m128i result;
+
+      if (alpha_first)
+        {
+          alpha_lo = _mm_shufflelo_epi16 (lo, _MM_SHUFFLE (0, 0, 0, 0));
+          alpha_lo = _mm_shufflehi_epi16 (alpha_lo, _MM_SHUFFLE (0, 0, 0, 0));
+          alpha_hi = _mm_shufflelo_epi16 (hi, _MM_SHUFFLE (0, 0, 0, 0));
+          alpha_hi = _mm_shufflehi_epi16 (alpha_hi, _MM_SHUFFLE (0, 0, 0, 0));
+        }
+      else
+        {
+          alpha_lo = _mm_shufflelo_epi16 (lo, _MM_SHUFFLE (3, 3, 3, 3));
+          alpha_lo = _mm_shufflehi_epi16 (alpha_lo, _MM_SHUFFLE (3, 3, 3, 3));
+          alpha_hi = _mm_shufflelo_epi16 (hi, _MM_SHUFFLE (3, 3, 3, 3));
+          alpha_hi = _mm_shufflehi_epi16 (alpha_hi, _MM_SHUFFLE (3, 3, 3, 3));
+        }
+
+      result = _mm_packus_epi16 (premult_2_pixels_sse2 (lo, alpha_lo),
+                                 premult_2_pixels_sse2 (hi, alpha_hi));
+
+      /* Keep the original alpha */
+      result = _mm_or_si128 (_mm_andnot_si128 (alpha_mask, result),
+                             _mm_and_si128 (alpha_mask, pixels));
+
+      _mm_storeu_si128 ((__m128i *) data, result);
+    }
+
+  if (alpha_first)
+    premult_alpha_first_c (data, width);
+  else
+    premult_alpha_last_c (data, width);
+}
+
+static SSE2 void
+premult_alpha_last_sse2 (uint8_t *data,
+                         int      width)
+{
+  premult_sse2 (data, width, FALSE);
+}
+
+static SSE2 void
+premult_alpha_first_sse2 (uint8_t *data,
+                          int      width)
+{
+  premult_sse2 (data, width, TRUE);
+}
+
+static inline SSE2 __m128i
+unpremult_channel_sse2 (__m128i pixels,
+                        int     shift,
+                        __m128  alpha)
+{
+  const __m128i count = _mm_cvtsi32_si128 (shift);
+  __m128i channel;
+  __m128 value;
+
+  channel = _mm_and_si128 (_mm_srl_epi32 (pixels, count),
+                           _mm_set1_epi32 (0xff));
+  value = _mm_mul_ps (_mm_cvtepi32_ps (channel), _mm_set1_ps (255.0f));
+
+  /* The division is correctly rounded and the exact quotient is at
+   * least 1/255 away from the next integer whenever the color is not
+   * bigger than the alpha, so truncating gives the same result as
+   * the integer division */
+  channel = _mm_cvttps_epi32 (_mm_div_ps (value, alpha));
+
+  return _mm_sll_epi32 (channel, count);
+}
+
+static inline SSE2 void
+unpremult_sse2 (uint8_t  *data,
+                int       width,
+                gboolean  alpha_first)
+{
+  const int alpha_shift = alpha_first ? 0 : 24;
+  const int color_shift = alpha_first ? 8 : 0;
+  const __m128i alpha_count = _mm_cvtsi32_si128 (alpha_shift);
+
+  for (; width >= 4; width -= 4, data += 16)
+    {
+      __m128i pixels = _mm_loadu_si128 ((const __m128i *) data);
+      __m128i alpha, alpha_bytes, is_zero;
+      __m128 alpha_float;
+      __m128i result;
+
+      alpha = _mm_and_si128 (_mm_srl_epi32 (pixels, alpha_count),
+                             _mm_set1_epi32 (0xff));
+
+      /* Premultiplied colors can't be bigger than the alpha. Leave
+       * invalid pixels to the portable version so that the results
+       * stay the same */
+      alpha_bytes = _mm_or_si128 (alpha, _mm_slli_epi32 (alpha, 8));
+      alpha_bytes = _mm_or_si128 (alpha_bytes,
+                                  _mm_slli_epi32 (alpha_bytes, 16));
+      if (_mm_movemask_epi8 (_mm_cmpeq_epi8 (_mm_max_epu8 (pixels,
+                                                           alpha_bytes),
+                                             alpha_bytes)) != 0xffff)
+        {
+          if (alpha_first)
+            unpremult_alpha_first_c (data, 4);
+          else
+            unpremult_alpha_last_c (data, 4);
+          continue;
+        }
+
+      alpha_float = _mm_cvtepi32_ps (alpha);
+
+      result = _mm_sll_epi32 (alpha, alpha_count);
+      result = _mm_or_si128 (result,
+                             unpremult_channel_sse2 (pixels,
+                                                     color_shift,
+                                                     alpha_float));
+      result = _mm_or_si128 (result,
+                             unpremult_channel_sse2 (pixels,
+                                                     color_shift + 8,
+                                                     alpha_float));
+      result = _mm_or_si128 (result,
+                             unpremult_channel_sse2 (pixels,
+                                                     color_shift + 16,
+                                                     alpha_float));
+
+      /* Fully transparent pixels become 0 */
+      is_zero = _mm_cmpeq_epi32 (alpha, _mm_setzero_si128 ());
+      result = _mm_andnot_si128 (is_zero, result);
+
+      _mm_storeu_si128 ((__m128i *) data, result);
+    }
+
+  if (alpha_first)
+    unpremult_alpha_first_c (data, width);
+  else
+    unpremult_alpha_last_c (data, width);
+}
+
+static SSE2 void
+unpremult_alpha_last_sse2 (uint8_t *data,
+                           int      width)
+{
+  unpremult_sse2 (data, width, FALSE);
+}
+
+static SSE2 void
+unpremult_alpha_first_sse2 (uint8_t *data,
+                            int      width)
+{
+  unpremult_sse2 (data, width, TRUE);
+}
+
+static SSE2 void
+shuffle_8888_sse2 (const uint8_t           *src,
+                   uint8_t                 *dst,
+                   int                      width,
+                   const CoglBitmapShuffle *shuffle)
+{
+  __m128i src_counts[4], dst_counts[4];
+  uint32_t fill = 0;
+  int i;
+
+  for (i = 0; i < 4; i++)
+    {
+      if (shuffle->shuffle[i] < 0)
+        fill |= 0xffu << (i * 8);
+      src_counts[i] = _mm_cvtsi32_si128 (MAX (shuffle->shuffle[i], 0) * 8);
+      dst_counts[i] = _mm_cvtsi32_si128 (i * 8);
+    }
+
+  for (; width >= 4; width -= 4, src += 16, dst += 16)
+    {
+      __m128i pixels = _mm_loadu_si128 ((const __m128i *) src);
+      __m128i result = _mm_set1_epi32 (fill);
+
+      for (i = 0; i < 4; i++)
+        {
+          __m128i channel;
+
+          if (shuffle->shuffle[i] < 0)
+            continue;
+
+          channel = _mm_and_si128 (_mm_srl_epi32 (pixels, src_counts[i]),
+                                   _mm_set1_epi32 (0xff));
+          result = _mm_or_si128 (result,
+                                 _mm_sll_epi32 (channel, dst_counts[i]));
+        }
+
+      _mm_storeu_si128 ((__m128i *) dst, result);
+    }
+
+  shuffle_8888_c (src, dst, width, shuffle);
+}
+
+static inline SSE2 __m128i
+unpack_10_channel_sse2 (__m128i pixels,
+                        int     shift)
+{
+  __m128i value;
+
+  value = _mm_and_si128 (_mm_srl_epi32 (pixels, _mm_cvtsi32_si128 (shift)),
+                         _mm_set1_epi32 (0x3ff));
+
+  /* (v * 255 + 511) / 1023 without a division. This is exact for
+   * all 10-bit values */
+  value = _mm_sub_epi32 (_mm_slli_epi32 (value, 8), value);
+  value = _mm_add_epi32 (value, _mm_set1_epi32 (0x1ff));
+  value = _mm_add_epi32 (value, _mm_srli_epi32 (value, 10));
+
+  return _mm_srli_epi32 (value, 10);
+}
+
+static SSE2 void
+unpack_10_to_8_sse2 (const uint8_t            *src,
+                     uint8_t                  *dst,
+                     int                       width,
+                     const CoglBitmapUnpack10 *unpack)
+{
+  for (; width >= 4; width -= 4, src += 16, dst += 16)
+    {
+      __m128i pixels = _mm_loadu_si128 ((const __m128i *) src);
+      __m128i result, alpha;
+
+      result = unpack_10_channel_sse2 (pixels, unpack->r_shift);
+      result = _mm_or_si128 (result,
+                             _mm_slli_epi32 (unpack_10_channel_sse2 (pixels,
+                                                                     unpack->g_shift),
+                                             8));
+      result = _mm_or_si128 (result,
+                             _mm_slli_epi32 (unpack_10_channel_sse2 (pixels,
+                                                                     unpack->b_shift),
+                                             16));
+
+      if (unpack->a_shift >= 0)
+        {
+          /* Multiply by 0x55 to expand the 2 bits */
+          alpha = _mm_srl_epi32 (pixels, _mm_cvtsi32_si128 (unpack->a_shift));
+          alpha = _mm_and_si128 (alpha, _mm_set1_epi32 (0x3));
+          alpha = _mm_or_si128 (alpha, _mm_slli_epi32 (alpha, 2));
+          alpha = _mm_or_si128 (alpha, _mm_slli_epi32 (alpha, 4));
+        }
+      else
+        {
+          alpha = _mm_set1_epi32 (0xff);
+        }
+
+      result = _mm_or_si128 (result, _mm_slli_epi32 (alpha, 24));
+
+      _mm_storeu_si128 ((__m128i *) dst, result);
+    }
+
+  unpack_10_to_8_c (src, dst, width, unpack);
+}
+
+#undef SSE2
+
+static const CoglBitmapSimdFuncs simd_funcs_sse2 = {
+  .level = COGL_BITMAP_SIMD_SSE2,
+  .name = "sse2",
+  .premult_alpha_last = premult_alpha_last_sse2,
+  .premult_alpha_first = premult_alpha_first_sse2,
+  .unpremult_alpha_last = unpremult_alpha_last_sse2,
+  .unpremult_alpha_first = unpremult_alpha_first_sse2,
+  .shuffle_8888 = shuffle_8888_sse2,
+  .unpack_10_to_8 = unpack_10_to_8_sse2,
+};
+
+/* AVX2 versions, working on eight pixels at a time. The 256-bit
+ * unpack, pack and shuffle instructions work on each 128-bit half
+ * separately but that doesn't matter here because pixels never
+ * cross the halves. */
+
+#define AVX2 __attribute__ ((target ("avx2")))
+
+static inline AVX2 __m256i
+premult_2_pixels_avx2 (__m256i pixels,
+                       __m256i alpha)
+{
+  pixels = _mm256_mullo_epi16 (pixels, alpha);
+  pixels = _mm256_add_epi16 (pixels, _mm256_set1_epi16 (128));
+  pixels = _mm256_add_epi16 (pixels, _mm256_srli_epi16 (pixels, 8));
+
+  return _mm256_srli_epi16 (pixels, 8);
+}
+
+static inline AVX2 void
+premult_avx2 (uint8_t  *data,
+              int       width,
+              gboolean  alpha_first)
+{
+  const __m256i zero = _mm256_setzero_si256 ();
+  const __m256i alpha_mask =
+    _mm256_set1_epi32 (alpha_first ? 0xff : 0xff000000);
+  const __m256i alpha_shuffle =
+    alpha_first ?
+    _mm256_set_epi8 (9, 8, 9, 8, 9, 8, 9, 8, 1, 0, 1, 0, 1, 0, 1, 0,
+                     9, 8, 9, 8, 9, 8, 9, 8, 1, 0, 1, 0, 1, 0, 1, 0) :
+    _mm256_set_epi8 (15, 14, 15, 14, 15, 14, 15, 14, 7, 6, 7, 6, 7, 6, 7, 6,
+                     15, 14, 15, 14, 15, 14, 15, 14, 7, 6, 7, 6, 7, 6, 7, 6);
+
+  for (; width >= 8; width -= 8, data += 32)
+    {
+      __m256i pixels = _mm256_loadu_si256 ((const __m256i *) data);
+      __m256i lo = _mm256_unpacklo_epi8 (pixels, zero);
+      __m256i hi = _mm256_unpackhi_epi8 (pixels, zero);
+      __m256i result;
+
+      result =
+        _mm256_packus_epi16 (premult_2_pixels_avx2 (lo,
+                                                    _mm256_shuffle_epi8 (lo,
+                                                                         alpha_shuffle)),
+                             premult_2_pixels_avx2 (hi,
+                                                    _mm256_shuffle_epi8 (hi,
+                                                                         alpha_shuffle)));
+
+      result = _mm256_or_si256 (_mm256_andnot_si256 (alpha_mask, result),
+                                _mm256_and_si256 (alpha_mask, pixels));
+
+      _mm256_storeu_si256 ((__m256i *) data, result);
+    }
+
+  if (alpha_first)
+    premult_alpha_first_c (data, width);
+  else
+    premult_alpha_last_c (data, width);
+}
+
+static AVX2 void
+premult_alpha_last_avx2 (uint8_t *data,
+                         int      width)
+{
+  premult_avx2 (data, width, FALSE);
+}
+
+static AVX2 void
+premult_alpha_first_avx2 (uint8_t *data,
+                          int      width)
+{
+  premult_avx2 (data, width, TRUE);
+}
+
+static inline AVX2 __m256i
+unpremult_channel_avx2 (__m256i pixels,
+                        int     shift,
+                        __m256  alpha)
+{
+  const __m128i count = _mm_cvtsi32_si128 (shift);
+  __m256i channel;
+  __m256 value;
+
+  channel = _mm256_and_si256 (_mm256_srl_epi32 (pixels, count),
+                              _mm256_set1_epi32 (0xff));
+  value = _mm256_mul_ps (_mm256_cvtepi32_ps (channel),
+                         _mm256_set1_ps (255.0f));
+
+  /* See unpremult_channel_sse2() */
+  channel = _mm256_cvttps_epi32 (_mm256_div_ps (value, alpha));
+
+  return _mm256_sll_epi32 (channel, count);
+}
+
+static inline AVX2 void
+unpremult_avx2 (uint8_t  *data,
+                int       width,
+                gboolean  alpha_first)
+{
+  const int alpha_shift = alpha_first ? 0 : 24;
+  const int color_shift = alpha_first ? 8 : 0;
+  const __m128i alpha_count = _mm_cvtsi32_si128 (alpha_shift);
+  const __m256i alpha_shuffle =
+    alpha_first ?
+    _mm256_set_epi8 (12, 12, 12, 12, 8, 8, 8, 8, 4, 4, 4, 4, 0, 0, 0, 0,
+                     12, 12, 12, 12, 8, 8, 8, 8, 4, 4, 4, 4, 0, 0, 0, 0) :
+    _mm256_set_epi8 (15, 15, 15, 15, 11, 11, 11, 11, 7, 7, 7, 7, 3, 3, 3, 3,
+                     15, 15, 15, 15, 11, 11, 11, 11, 7, 7, 7, 7, 3, 3, 3, 3);
+
+  for (; width >= 8; width -= 8, data += 32)
+    {
+      __m256i pixels = _mm256_loadu_si256 ((const __m256i *) data);
+      __m256i alpha, alpha_bytes, is_zero;
+      __m256 alpha_float;
+      __m256i result;
+
+      /* See unpremult_sse2() */
+      alpha_bytes = _mm256_shuffle_epi8 (pixels, alpha_shuffle);
+      if (_mm256_movemask_epi8 (_mm256_cmpeq_epi8 (_mm256_max_epu8 (pixels,
+                                                                    alpha_bytes),
+                                                   alpha_bytes)) != -1)
+        {
+          if (alpha_first)
+            unpremult_alpha_first_c (data, 8);
+          else
+            unpremult_alpha_last_c (data, 8);
+          continue;
+        }
+
+      alpha = _mm256_and_si256 (_mm256_srl_epi32 (pixels, alpha_count),
+                                _mm256_set1_epi32 (0xff));
+      alpha_float = _mm256_cvtepi32_ps (alpha);
+
+      result = _mm256_sll_epi32 (alpha, alpha_count);
+      result = _mm256_or_si256 (result,
+                                unpremult_channel_avx2 (pixels,
+                                                        color_shift,
+                                                        alpha_float));
+      result = _mm256_or_si256 (result,
+                                unpremult_channel_avx2 (pixels,
+                                                        color_shift + 8,
+                                                        alpha_float));
+      result = _mm256_or_si256 (result,
+                                unpremult_channel_avx2 (pixels,
+                                                        color_shift + 16,
+                                                        alpha_float));
+
+      is_zero = _mm256_cmpeq_epi32 (alpha, _mm256_setzero_si256 ());
+      result = _mm256_andnot_si256 (is_zero, result);
+
+      _mm256_storeu_si256 ((__m256i *) data, result);
+    }
+
+  if (alpha_first)
+    unpremult_alpha_first_c (data, width);
+  else
+    unpremult_alpha_last_c (data, width);
+}
+
+static AVX2 void
+unpremult_alpha_last_avx2 (uint8_t *data,
+                           int      width)
+{
+  unpremult_avx2 (data, width, FALSE);
+}
+
+static AVX2 void
+unpremult_alpha_first_avx2 (uint8_t *data,
+                            int      width)
+{
+  unpremult_avx2 (data, width, TRUE);
+}
+
+static AVX2 void
+shuffle_8888_avx2 (const uint8_t           *src,
+                   uint8_t                 *dst,
+                   int                      width,
+                   const CoglBitmapShuffle *shuffle)
+{
+  int8_t control_bytes[32];
+  int8_t fill_bytes[32];
+  __m256i control, fill;
+  int i;
+
+  /* Bytes with the top bit set in the control are zeroed by the
+   * shuffle and then filled with 0xff */
+  for (i = 0; i < 32; i++)
+    {
+      int8_t byte = shuffle->shuffle[i % 4];
+
+      control_bytes[i] = byte < 0 ? -128 : (i & ~3 & 0xf) + byte;
+      fill_bytes[i] = byte < 0 ? -1 : 0;
+    }
+
+  control = _mm256_loadu_si256 ((const __m256i *) control_bytes);
+  fill = _mm256_loadu_si256 ((const __m256i *) fill_bytes);
+
+  for (; width >= 8; width -= 8, src += 32, dst += 32)
+    {
+      __m256i pixels = _mm256_loadu_si256 ((const __m256i *) src);
+
+      pixels = _mm256_or_si256 (_mm256_shuffle_epi8 (pixels, control), fill);
+      _mm256_storeu_si256 ((__m256i *) dst, pixels);
+    }
+
+  shuffle_8888_c (src, dst, width, shuffle);
+}
+
+static inline AVX2 __m256i
+unpack_10_channel_avx2 (__m256i pixels,
+                        int     shift)
+{
+  __m256i value;
+
+  value = _mm256_and_si256 (_mm256_srl_epi32 (pixels,
+                                              _mm_cvtsi32_si128 (shift)),
+                            _mm256_set1_epi32 (0x3ff));
+
+  /* See unpack_10_channel_sse2() */
+  value = _mm256_sub_epi32 (_mm256_slli_epi32 (value, 8), value);
+  value = _mm256_add_epi32 (value, _mm256_set1_epi32 (0x1ff));
+  value = _mm256_add_epi32 (value, _mm256_srli_epi32 (value, 10));
+
+  return _mm256_srli_epi32 (value, 10);
+}
+
+static AVX2 void
+unpack_10_to_8_avx2 (const uint8_t            *src,
+                     uint8_t                  *dst,
+                     int                       width,
+                     const CoglBitmapUnpack10 *unpack)
+{
+  for (; width >= 8; width -= 8, src += 32, dst += 32)
+    {
+      __m256i pixels = _mm256_loadu_si256 ((const __m256i *) src);
+      __m256i result, alpha;
+
+      result = unpack_10_channel_avx2 (pixels, unpack->r_shift);
+      result =
+        _mm256_or_si256 (result,
+                         _mm256_slli_epi32 (unpack_10_channel_avx2 (pixels,
+                                                                    unpack->g_shift),
+                                            8));
+      result =
+        _mm256_or_si256 (result,
+                         _mm256_slli_epi32 (unpack_10_channel_avx2 (pixels,
+                                                                    unpack->b_shift),
+                                            16));
+
+      if (unpack->a_shift >= 0)
+        {
+          alpha = _mm256_srl_epi32 (pixels,
+                                    _mm_cvtsi32_si128 (unpack->a_shift));
+          alpha = _mm256_and_si256 (alpha, _mm256_set1_epi32 (0x3));
+          alpha = _mm256_mullo_epi32 (alpha, _mm256_set1_epi32 (0x55));
+        }
+      else
+        {
+          alpha = _mm256_set1_epi32 (0xff);
+        }
+
+      result = _mm256_or_si256 (result, _mm256_slli_epi32 (alpha, 24));
+
+      _mm256_storeu_si256 ((__m256i *) dst, result);
+    }
+
+  unpack_10_to_8_c (src, dst, width, unpack);
+}
+
+#undef AVX2
+
+static const CoglBitmapSimdFuncs simd_funcs_avx2 = {
+  .level = COGL_BITMAP_SIMD_AVX2,
+  .name = "avx2",
+  .premult_alpha_last = premult_alpha_last_avx2,
+  .premult_alpha_first = premult_alpha_first_avx2,
+  .unpremult_alpha_last = unpremult_alpha_last_avx2,
+  .unpremult_alpha_first = unpremult_alpha_first_avx2,
+  .shuffle_8888 = shuffle_8888_avx2,
+  .unpack_10_to_8 = unpack_10_to_8_avx2,
+};
+
+#endif /* COGL_BITMAP_SIMD_X86 */
+
+#ifdef COGL_BITMAP_SIMD_NEON_AARCH64
+
+/* NEON versions, working on eight pixels at a time. The loads
+ * deinterleave the pixels so that each register holds one byte of
+ * every pixel. NEON is always available on AArch64 so these don't
+ * need a runtime check. */
+
+static inline uint8x8_t
+premult_channel_neon (uint8x8_t channel,
+                      uint8x8_t alpha)
+{
+  uint16x8_t t;
+
+  t = vaddq_u16 (vmull_u8 (channel, alpha), vdupq_n_u16 (128));
+
+  return vshrn_n_u16 (vaddq_u16 (t, vshrq_n_u16 (t, 8)), 8);
+}
+
+static inline void
+premult_neon (uint8_t  *data,
+              int       width,
+              gboolean  alpha_first)
+{
+  const int alpha_index = alpha_first ? 0 : 3;
+  const int color_index = alpha_first ? 1 : 0;
+
+  for (; width >= 8; width -= 8, data += 32)
+    {
+      uint8x8x4_t pixels = vld4_u8 (data);
+      uint8x8_t alpha = pixels.val[alpha_index];
+      int i;
+
+      for (i = color_index; i < color_index + 3; i++)
+        pixels.val[i] = premult_channel_neon (pixels.val[i], alpha);
+
+      vst4_u8 (data, pixels);
+    }
+
+  if (alpha_first)
+    premult_alpha_first_c (data, width);
+  else
+    premult_alpha_last_c (data, width);
+}
+
+static void
+premult_alpha_last_neon (uint8_t *data,
+                         int      width)
+{
+  premult_neon (data, width, FALSE);
+}
+
+static void
+premult_alpha_first_neon (uint8_t *data,
+                          int      width)
+{
+  premult_neon (data, width, TRUE);
+}
+
+static inline uint32x4_t
+unpremult_4_neon (uint16x4_t  channel,
+                  float32x4_t alpha)
+{
+  float32x4_t value;
+
+  value = vmulq_n_f32 (vcvtq_f32_u32 (vmovl_u16 (channel)), 255.0f);
+
+  /* See unpremult_channel_sse2() */
+  return vcvtq_u32_f32 (vdivq_f32 (value, alpha));
+}
+
+static inline uint8x8_t
+unpremult_channel_neon (uint8x8_t   channel,
+                        float32x4_t alpha_lo,
+                        float32x4_t alpha_hi)
+{
+  uint16x8_t wide = vmovl_u8 (channel);
+  uint32x4_t lo, hi;
+
+  lo = unpremult_4_neon (vget_low_u16 (wide), alpha_lo);
+  hi = unpremult_4_neon (vget_high_u16 (wide), alpha_hi);
+
+  return vmovn_u16 (vcombine_u16 (vmovn_u32 (lo), vmovn_u32 (hi)));
+}
+
+static inline void
+unpremult_neon (uint8_t  *data,
+                int       width,
+                gboolean  alpha_first)
+{
+  const int alpha_index = alpha_first ? 0 : 3;
+  const int color_index = alpha_first ? 1 : 0;
+
+  for (; width >= 8; width -= 8, data += 32)
+    {
+      uint8x8x4_t pixels = vld4_u8 (data);
+      uint8x8_t alpha = pixels.val[alpha_index];
+      uint8x8_t valid = vdup_n_u8 (0xff);
+      uint8x8_t not_zero;
+      uint16x8_t alpha_wide;
+      float32x4_t alpha_lo, alpha_hi;
+      int i;
+
+      /* See unpremult_sse2() */
+      for (i = color_index; i < color_index + 3; i++)
+        valid = vand_u8 (valid, vcle_u8 (pixels.val[i], alpha));
+      if (vget_lane_u64 (vreinterpret_u64_u8 (valid), 0) != G_MAXUINT64)
+        {
+          if (alpha_first)
+            unpremult_alpha_first_c (data, 8);
+          else
+            unpremult_alpha_last_c (data, 8);
+          continue;
+        }
+
+      alpha_wide = vmovl_u8 (alpha);
+      alpha_lo = vcvtq_f32_u32 (vmovl_u16 (vget_low_u16 (alpha_wide)));
+      alpha_hi = vcvtq_f32_u32 (vmovl_u16 (vget_high_u16 (alpha_wide)));
+
+      /* Fully transparent pixels become 0. The colors of those are
+       * already 0 because they can't be bigger than the alpha */
+      not_zero = vtst_u8 (alpha, alpha);
+
+      for (i = color_index; i < color_index + 3; i++)
+        pixels.val[i] = vand_u8 (unpremult_channel_neon (pixels.val[i],
+                                                         alpha_lo,
+                                                         alpha_hi),
+                                 not_zero);
+
+      vst4_u8 (data, pixels);
+    }
+
+  if (alpha_first)
+    unpremult_alpha_first_c (data, width);
+  else
+    unpremult_alpha_last_c (data, width);
+}
+
+static void
+unpremult_alpha_last_neon (uint8_t *data,
+                           int      width)
+{
+  unpremult_neon (data, width, FALSE);
+}
+
+static void
+unpremult_alpha_first_neon (uint8_t *data,
+                            int      width)
+{
+  unpremult_neon (data, width, TRUE);
+}
+
+static void
+shuffle_8888_neon (const uint8_t           *src,
+                   uint8_t                 *dst,
+                   int                      width,
+                   const CoglBitmapShuffle *shuffle)
+{
+  uint8_t control_bytes[16];
+  uint8_t fill_bytes[16];
+  uint8x16_t control, fill;
+  int i;
+
+  /* Out of range indices in the control give 0 which is then
+   * filled with 0xff */
+  for (i = 0; i < 16; i++)
+    {
+      int8_t byte = shuffle->shuffle[i % 4];
+
+      control_bytes[i] = byte < 0 ? 0xff : (i & ~3) + byte;
+      fill_bytes[i] = byte < 0 ? 0xff : 0;
+    }
+
+  control = vld1q_u8 (control_bytes);
+  fill = vld1q_u8 (fill_bytes);
+
+  for (; width >= 4; width -= 4, src += 16, dst += 16)
+    {
+      uint8x16_t pixels = vld1q_u8 (src);
+
+      vst1q_u8 (dst, vorrq_u8 (vqtbl1q_u8 (pixels, control), fill));
+    }
+
+  shuffle_8888_c (src, dst, width, shuffle);
+}
+
+static inline uint32x4_t
+unpack_10_channel_neon (uint32x4_t pixels,
+                        int        shift)
+{
+  uint32x4_t value;
+
+  value = vandq_u32 (vshlq_u32 (pixels, vdupq_n_s32 (-shift)),
+                     vdupq_n_u32 (0x3ff));
+
+  /* See unpack_10_channel_sse2() */
+  value = vmlaq_n_u32 (vdupq_n_u32 (0x1ff), value, 255);
+  value = vaddq_u32 (value, vshrq_n_u32 (value, 10));
+
+  return vshrq_n_u32 (value, 10);
+}
+
+static void
+unpack_10_to_8_neon (const uint8_t            *src,
+                     uint8_t                  *dst,
+                     int                       width,
+                     const CoglBitmapUnpack10 *unpack)
+{
+  for (; width >= 4; width -= 4, src += 16, dst += 16)
+    {
+      uint32x4_t pixels = vreinterpretq_u32_u8 (vld1q_u8 (src));
+      uint32x4_t result, alpha;
+
+      result = unpack_10_channel_neon (pixels, unpack->r_shift);
+      result = vorrq_u32 (result,
+                          vshlq_n_u32 (unpack_10_channel_neon (pixels,
+                                                               unpack->g_shift),
+                                       8));
+      result = vorrq_u32 (result,
+                          vshlq_n_u32 (unpack_10_channel_neon (pixels,
+                                                               unpack->b_shift),
+                                       16));
+
+      if (unpack->a_shift >= 0)
+        {
+          alpha = vshlq_u32 (pixels, vdupq_n_s32 (-unpack->a_shift));
+          alpha = vmulq_n_u32 (vandq_u32 (alpha, vdupq_n_u32 (0x3)), 0x55);
+        }
+      else
+        {
+          alpha = vdupq_n_u32 (0xff);
+        }
+
+      result = vorrq_u32 (result, vshlq_n_u32 (alpha, 24));
+
+      vst1q_u8 (dst, vreinterpretq_u8_u32 (result));
+    }
+
+  unpack_10_to_8_c (src, dst, width, unpack);
+}
+
+static const CoglBitmapSimdFuncs simd_funcs_neon = {
+  .level = COGL_BITMAP_SIMD_NEON,
+  .name = "neon",
+  .premult_alpha_last = premult_alpha_last_neon,
+  .premult_alpha_first = premult_alpha_first_neon,
+  .unpremult_alpha_last = unpremult_alpha_last_neon,
+  .unpremult_alpha_first = unpremult_alpha_first_neon,
+  .shuffle_8888 = shuffle_8888_neon,
+  .unpack_10_to_8 = unpack_10_to_8_neon,
+};
+
+#endif /* COGL_BITMAP_SIMD_NEON_AARCH64 */
+
+const CoglBitmapSimdFuncs *
+_cogl_bitmap_simd_get_funcs_for_level (CoglBitmapSimdLevel level)
+{
+  switch (level)
+    {
+    case COGL_BITMAP_SIMD_NONE:
+      return &simd_funcs_c;
+
+    case COGL_BITMAP_SIMD_SSE2:
+#ifdef COGL_BITMAP_SIMD_X86
+      __builtin_cpu_init ();
+      if (__builtin_cpu_supports ("sse2"))
+        return &simd_funcs_sse2;
+#endif
+      return NULL;
+
+    case COGL_BITMAP_SIMD_AVX2:
+#ifdef COGL_BITMAP_SIMD_X86
+      __builtin_cpu_init ();
+      if (__builtin_cpu_supports ("avx2"))
+        return &simd_funcs_avx2;
+#endif
+      return NULL;
+
+    case COGL_BITMAP_SIMD_NEON:
+#ifdef COGL_BITMAP_SIMD_NEON_AARCH64
+      return &simd_funcs_neon;
+#else
+      return NULL;
+#endif
+
+    case COGL_BITMAP_SIMD_N_LEVELS:
+      break;
+    }
+
+  g_assert_not_reached ();
+  return NULL;
+}
+
+const CoglBitmapSimdFuncs *
+_cogl_bitmap_simd_get_funcs (void)
+{
+  static const CoglBitmapSimdFuncs *funcs = NULL;
+
+  if (g_once_init_enter (&funcs))
+    {
+      const CoglBitmapSimdFuncs *best = NULL;
+      int level;
+
+      for (level = COGL_BITMAP_SIMD_N_LEVELS - 1; !best && level >= 0; level--)
+        best = _cogl_bitmap_simd_get_funcs_for_level (level);
+
+      g_once_init_leave (&funcs, best);
+    }
+
+  return funcs;
+}
@@ -71,6 +71,12 @@ typedef enum _CoglBufferFlags
   COGL_BUFFER_FLAG_MAPPED_FALLBACK = 1UL << 2
 } CoglBufferFlags;
 
+/* Internal map hint telling the driver that it doesn't need to wait
+ * for the GPU to finish using the buffer before mapping it. The caller
+ * guarantees that nothing pending on the GPU reads from the mapped
+ * range. */
+#define COGL_BUFFER_MAP_HINT_UNSYNCHRONIZED ((CoglBufferMapHint) (1 << 30))
+
 typedef enum
 {
   COGL_BUFFER_USAGE_HINT_TEXTURE,
@@ -158,15 +164,17 @@ _cogl_buffer_map (CoglBuffer *buffer,
                   GError **error);
 
 /* This is a wrapper around cogl_buffer_map_range for internal use
-   when we want to map the buffer for write only to replace the entire
-   contents. If the map fails then it will fallback to writing to a
-   temporary buffer. When _cogl_buffer_unmap_for_fill_or_fallback is
-   called the temporary buffer will be copied into the array. Note
-   that these calls share a global array so they can not be nested. */
+   when we want to map the buffer for write only to replace the
+   contents of the range. If the map fails then it will fallback to
+   writing to a temporary buffer. When
+   _cogl_buffer_unmap_for_fill_or_fallback is called the temporary
+   buffer will be copied into the array. Note that these calls share a
+   global array so they can not be nested. */
 void *
 _cogl_buffer_map_range_for_fill_or_fallback (CoglBuffer *buffer,
                                              size_t offset,
-                                             size_t size);
+                                             size_t size,
+                                             CoglBufferMapHint hints);
 COGL_EXPORT void *
 _cogl_buffer_map_for_fill_or_fallback (CoglBuffer *buffer);
 
@@ -106,6 +106,8 @@ struct _CoglContext
   int n_attribute_names;
 
   CoglBitmask       enabled_custom_attributes;
+  /* Attribute locations that currently have a non-zero divisor */
+  CoglBitmask       instanced_custom_attributes;
 
   /* These are temporary bitmasks that are used when disabling
    * builtin and custom attribute arrays. They are here just
@@ -143,6 +145,18 @@ struct _CoglContext
   /* Global journal buffers */
   GArray           *journal_flush_attributes_array;
   GArray           *journal_clip_bounds;
+  CoglAttributeBuffer *journal_unit_quad_buffer;
+  /* The vertices of each journal flush are appended to this buffer,
+     which is used as a ring shared by all framebuffers. Space after
+     journal_vbo_offset hasn't been written to since the storage was
+     last orphaned, so it can be mapped without waiting for the GPU.
+     When the ring wraps around the storage is orphaned so that the
+     driver gives us fresh memory while the GPU is still reading the
+     old one */
+  CoglAttributeBuffer *journal_vbo;
+  size_t            journal_vbo_offset;
+  CoglSnippet      *journal_instance_transform_snippet;
+  CoglSnippet      *journal_instance_tex_coord_snippets[COGL_JOURNAL_MAX_INSTANCED_LAYERS];
 
   /* Some simple caching, to minimize state changes... */
   CoglPipeline     *current_pipeline;
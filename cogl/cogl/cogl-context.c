@@ -251,12 +251,19 @@ cogl_context_new (CoglDisplay *display,
   context->journal_flush_attributes_array =
     g_array_new (TRUE, FALSE, sizeof (CoglAttribute *));
   context->journal_clip_bounds = NULL;
+  context->journal_unit_quad_buffer = NULL;
+  context->journal_vbo = NULL;
+  context->journal_vbo_offset = 0;
+  context->journal_instance_transform_snippet = NULL;
+  memset (context->journal_instance_tex_coord_snippets, 0,
+          sizeof (context->journal_instance_tex_coord_snippets));
 
   context->current_pipeline = NULL;
   context->current_pipeline_changes_since_flush = 0;
   context->current_pipeline_with_color_attrib = FALSE;
 
   _cogl_bitmask_init (&context->enabled_custom_attributes);
+  _cogl_bitmask_init (&context->instanced_custom_attributes);
   _cogl_bitmask_init (&context->enable_custom_attributes_tmp);
   _cogl_bitmask_init (&context->changed_bits_tmp);
 
@@ -328,6 +335,7 @@ _cogl_context_free (CoglContext *context)
 {
   const CoglWinsysVtable *winsys = _cogl_context_get_winsys (context);
   const CoglDriverVtable *driver = _cogl_context_get_driver (context);
+  int i;
 
   winsys->context_deinit (context);
 
@@ -347,6 +355,17 @@ _cogl_context_free (CoglContext *context)
     g_array_free (context->journal_flush_attributes_array, TRUE);
   if (context->journal_clip_bounds)
     g_array_free (context->journal_clip_bounds, TRUE);
+  if (context->journal_unit_quad_buffer)
+    cogl_object_unref (context->journal_unit_quad_buffer);
+  if (context->journal_vbo)
+    cogl_object_unref (context->journal_vbo);
+  if (context->journal_instance_transform_snippet)
+    cogl_object_unref (context->journal_instance_transform_snippet);
+  for (i = 0; i < G_N_ELEMENTS (context->journal_instance_tex_coord_snippets); i++)
+    {
+      if (context->journal_instance_tex_coord_snippets[i])
+        cogl_object_unref (context->journal_instance_tex_coord_snippets[i]);
+    }
 
   if (context->rectangle_byte_indices)
     cogl_object_unref (context->rectangle_byte_indices);
@@ -370,6 +389,7 @@ _cogl_context_free (CoglContext *context)
   g_hook_list_clear (&context->atlas_reorganize_callbacks);
 
   _cogl_bitmask_destroy (&context->enabled_custom_attributes);
+  _cogl_bitmask_destroy (&context->instanced_custom_attributes);
   _cogl_bitmask_destroy (&context->enable_custom_attributes_tmp);
   _cogl_bitmask_destroy (&context->changed_bits_tmp);
 
@@ -531,3 +551,14 @@ cogl_context_get_gpu_time_ns (CoglContext *context)
 
   return context->driver_vtable->get_gpu_time_ns (context);
 }
+
+int
+cogl_context_get_latest_sync_fd (CoglContext *context)
+{
+  const CoglWinsysVtable *winsys = _cogl_context_get_winsys (context);
+
+  if (!winsys->context_get_latest_sync_fd)
+    return -1;
+
+  return winsys->context_get_latest_sync_fd (context);
+}
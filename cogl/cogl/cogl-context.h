@@ -368,4 +368,17 @@ cogl_context_timestamp_query_get_time_ns (CoglContext        *context,
 COGL_EXPORT int64_t
 cogl_context_get_gpu_time_ns (CoglContext *context);
 
+/**
+ * cogl_context_get_latest_sync_fd:
+ * @context: a #CoglContext pointer
+ *
+ * Creates a sync file descriptor which gets signalled once all GPU work
+ * submitted so far has completed.
+ *
+ * Return value: (transfer full): A sync file descriptor, or -1 if not
+ *   supported
+ */
+COGL_EXPORT int
+cogl_context_get_latest_sync_fd (CoglContext *context);
+
 G_END_DECLS
@@ -161,6 +161,12 @@ OPT (DISABLE_FAST_READ_PIXEL,
      N_("Disable read pixel optimization"),
      N_("Disable optimization for reading 1px for simple "
         "scenes of opaque rectangles"))
+OPT (JOURNAL_REORDER,
+     N_("Root Cause"),
+     "journal-reorder",
+     N_("Reorder the journal"),
+     N_("Reorder non-overlapping rectangles in the journal to improve "
+        "batching"))
 OPT (CLIPPING,
      N_("Cogl Tracing"),
      "clipping",
@@ -145,6 +145,31 @@ cogl_framebuffer_driver_draw_indexed_attributes (CoglFramebufferDriver  *driver,
                                   flags);
 }
 
+void
+cogl_framebuffer_driver_draw_instanced_attributes (CoglFramebufferDriver  *driver,
+                                                   CoglPipeline           *pipeline,
+                                                   CoglVerticesMode        mode,
+                                                   int                     first_vertex,
+                                                   int                     n_vertices,
+                                                   int                     n_instances,
+                                                   CoglAttribute         **attributes,
+                                                   int                     n_attributes,
+                                                   CoglDrawFlags           flags)
+{
+  CoglFramebufferDriverClass *klass =
+    COGL_FRAMEBUFFER_DRIVER_GET_CLASS (driver);
+
+  klass->draw_instanced_attributes (driver,
+                                    pipeline,
+                                    mode,
+                                    first_vertex,
+                                    n_vertices,
+                                    n_instances,
+                                    attributes,
+                                    n_attributes,
+                                    flags);
+}
+
 gboolean
 cogl_framebuffer_driver_read_pixels_into_bitmap (CoglFramebufferDriver  *driver,
                                                  int                     x,
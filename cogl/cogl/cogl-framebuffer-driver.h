@@ -78,6 +78,16 @@ struct _CoglFramebufferDriverClass
                                     int                     n_attributes,
                                     CoglDrawFlags           flags);
 
+  void (* draw_instanced_attributes) (CoglFramebufferDriver  *driver,
+                                      CoglPipeline           *pipeline,
+                                      CoglVerticesMode        mode,
+                                      int                     first_vertex,
+                                      int                     n_vertices,
+                                      int                     n_instances,
+                                      CoglAttribute         **attributes,
+                                      int                     n_attributes,
+                                      CoglDrawFlags           flags);
+
   gboolean (* read_pixels_into_bitmap) (CoglFramebufferDriver  *driver,
                                         int                     x,
                                         int                     y,
@@ -132,6 +142,17 @@ cogl_framebuffer_driver_draw_indexed_attributes (CoglFramebufferDriver  *driver,
                                                  int                     n_attributes,
                                                  CoglDrawFlags           flags);
 
+void
+cogl_framebuffer_driver_draw_instanced_attributes (CoglFramebufferDriver  *driver,
+                                                   CoglPipeline           *pipeline,
+                                                   CoglVerticesMode        mode,
+                                                   int                     first_vertex,
+                                                   int                     n_vertices,
+                                                   int                     n_instances,
+                                                   CoglAttribute         **attributes,
+                                                   int                     n_attributes,
+                                                   CoglDrawFlags           flags);
+
 gboolean
 cogl_framebuffer_driver_read_pixels_into_bitmap (CoglFramebufferDriver  *driver,
                                                  int                     x,
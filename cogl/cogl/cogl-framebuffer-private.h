@@ -246,6 +246,21 @@ _cogl_framebuffer_draw_indexed_attributes (CoglFramebuffer *framebuffer,
                                            int n_attributes,
                                            CoglDrawFlags flags);
 
+/* Draws n_instances copies of n_vertices vertices. Attributes with a
+ * non-zero instance divisor advance per instance instead of per
+ * vertex. This requires COGL_PRIVATE_FEATURE_INSTANCED_ARRAYS and is
+ * only used internally by the CoglJournal. */
+void
+_cogl_framebuffer_draw_instanced_attributes (CoglFramebuffer *framebuffer,
+                                             CoglPipeline *pipeline,
+                                             CoglVerticesMode mode,
+                                             int first_vertex,
+                                             int n_vertices,
+                                             int n_instances,
+                                             CoglAttribute **attributes,
+                                             int n_attributes,
+                                             CoglDrawFlags flags);
+
 void
 cogl_framebuffer_set_viewport4fv (CoglFramebuffer *framebuffer,
                                   float *viewport);
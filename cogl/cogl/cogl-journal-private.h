@@ -35,7 +35,12 @@
 #include "cogl/cogl-clip-stack.h"
 #include "cogl/cogl-fence-private.h"
 
-#define COGL_JOURNAL_VBO_POOL_SIZE 8
+/* Minimum size in bytes of the streaming vertex buffer */
+#define COGL_JOURNAL_VBO_MIN_SIZE (256 * 1024)
+
+/* Maximum number of layers a pipeline can have for its rectangles to
+   be drawn with instancing */
+#define COGL_JOURNAL_MAX_INSTANCED_LAYERS 4
 
 typedef struct _CoglJournal
 {
@@ -51,15 +56,9 @@ typedef struct _CoglJournal
   GArray *vertices;
   size_t needed_vbo_len;
 
-  /* A pool of attribute buffers is used so that we can avoid repeatedly
-     reallocating buffers. Only one of these buffers at a time will be
-     used by Cogl but we keep more than one alive anyway in case the
-     GL driver is internally using the buffer and it would have to
-     allocate a new one when we start writing to it */
-  CoglAttributeBuffer *vbo_pool[COGL_JOURNAL_VBO_POOL_SIZE];
-  /* The next vbo to use from the pool. We just cycle through them in
-     order */
-  unsigned int next_vbo_in_pool;
+  /* Scratch array for the screen bounds of the entries while
+     reordering them */
+  GArray *reorder_bounds;
 
   int fast_read_pixel_count;
 
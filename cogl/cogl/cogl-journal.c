@@ -91,11 +91,40 @@
   (POS_STRIDE + COLOR_STRIDE + \
    TEX_STRIDE * (N_LAYERS < MIN_LAYER_PADDING ? MIN_LAYER_PADDING : N_LAYERS))
 
+/* XXX NB:
+ * When the quads are drawn with instancing the vertex array instead
+ * contains one record per quad which gets expanded by the vertex
+ * shader using a shared unit quad:
+ *    3 GLfloats for the transformed top left position (x, y and z)
+ *    2 GLfloats for the transformed bottom right position (x and y)
+ *    4 RGBA GLubytes,
+ *    4 GLfloats per layer for the top left and bottom right tex coords
+ *
+ * The quads are always transformed in software and only quads that
+ * remain axis aligned with a constant z are instanced so the two
+ * corners are enough to describe them. n_layers is padded in the same
+ * way as above.
+ */
+#define INSTANCE_POS_STRIDE 5 /* number of 32bit words */
+#define INSTANCE_TEX_STRIDE 4 /* number of 32bit words */
+#define GET_JOURNAL_INSTANCE_STRIDE_FOR_N_LAYERS(N_LAYERS) \
+  (INSTANCE_POS_STRIDE + COLOR_STRIDE + \
+   INSTANCE_TEX_STRIDE * (N_LAYERS < MIN_LAYER_PADDING ? \
+                          MIN_LAYER_PADDING : N_LAYERS))
+
+/* Instancing only pays off once there are enough quads to make up for
+   the extra setup, so smaller journals use the indexed path */
+#define COGL_JOURNAL_INSTANCING_THRESHOLD 16
+
 /* If a batch is longer than this threshold then we'll assume it's not
    worth doing software clipping and it's cheaper to program the GPU
    to do the clip */
 #define COGL_JOURNAL_HARDWARE_CLIP_THRESHOLD 8
 
+/* The maximum number of entries that an entry can be moved back past
+   when reordering the journal to improve batching */
+#define COGL_JOURNAL_REORDER_WINDOW 64
+
 typedef struct _CoglJournalFlushState
 {
   CoglContext *ctx;
@@ -108,8 +137,12 @@ typedef struct _CoglJournalFlushState
 
   size_t stride;
   size_t array_offset;
+  /* When drawing with instancing this counts instances rather than
+     vertices */
   GLuint current_vertex;
 
+  gboolean instanced;
+
   CoglIndices *indices;
   size_t indices_type_size;
 
@@ -125,16 +158,12 @@ typedef gboolean (*CoglJournalBatchTest) (CoglJournalEntry *entry0,
 void
 _cogl_journal_free (CoglJournal *journal)
 {
-  int i;
-
   if (journal->entries)
     g_array_free (journal->entries, TRUE);
   if (journal->vertices)
     g_array_free (journal->vertices, TRUE);
-
-  for (i = 0; i < COGL_JOURNAL_VBO_POOL_SIZE; i++)
-    if (journal->vbo_pool[i])
-      cogl_object_unref (journal->vbo_pool[i]);
+  if (journal->reorder_bounds)
+    g_array_free (journal->reorder_bounds, TRUE);
 
   g_free (journal);
 }
@@ -147,6 +176,7 @@ _cogl_journal_new (CoglFramebuffer *framebuffer)
   journal->framebuffer = framebuffer;
   journal->entries = g_array_new (FALSE, FALSE, sizeof (CoglJournalEntry));
   journal->vertices = g_array_new (FALSE, FALSE, sizeof (float));
+  journal->reorder_bounds = g_array_new (FALSE, FALSE, sizeof (float) * 4);
 
   _cogl_list_init (&journal->pending_fences);
 
@@ -260,6 +290,53 @@ batch_and_call (CoglJournalEntry *entries,
   batch_callback (batch_start, batch_len, data);
 }
 
+/* The per-instance attributes are set up for the start of the stride
+ * batch and there's no portable way to pass a base instance to the
+ * draw call, so they are offset to the first quad of this batch
+ * instead. The attributes are only read while the draw call is
+ * flushed, so they are shifted in place and restored afterwards
+ * rather than allocating new attributes for every batch */
+static void
+shift_instance_attributes (CoglJournalFlushState *state,
+                           size_t                 from_offset,
+                           size_t                 to_offset)
+{
+  CoglAttribute **attributes = (CoglAttribute **) state->attributes->data;
+  int i;
+
+  for (i = 0; i < state->attributes->len; i++)
+    {
+      if (attributes[i]->instance_divisor != 0)
+        {
+          attributes[i]->d.buffered.offset -= from_offset;
+          attributes[i]->d.buffered.offset += to_offset;
+        }
+    }
+}
+
+static void
+draw_instanced_entries (CoglJournalFlushState *state,
+                        int                    batch_len,
+                        CoglDrawFlags          draw_flags)
+{
+  CoglFramebuffer *framebuffer = state->journal->framebuffer;
+  size_t instance_offset = state->current_vertex * state->stride;
+
+  shift_instance_attributes (state, 0, instance_offset);
+
+  _cogl_framebuffer_draw_instanced_attributes (framebuffer,
+                                               state->pipeline,
+                                               COGL_VERTICES_MODE_TRIANGLE_STRIP,
+                                               0, 4,
+                                               batch_len,
+                                               (CoglAttribute **)
+                                               state->attributes->data,
+                                               state->attributes->len,
+                                               draw_flags);
+
+  shift_instance_attributes (state, instance_offset, 0);
+}
+
 static void
 _cogl_journal_flush_modelview_and_entries (CoglJournalEntry *batch_start,
                                            int               batch_len,
@@ -293,7 +370,11 @@ _cogl_journal_flush_modelview_and_entries (CoglJournalEntry *batch_start,
   if (!_cogl_pipeline_get_real_blend_enabled (state->pipeline))
     draw_flags |= COGL_DRAW_COLOR_ATTRIBUTE_IS_OPAQUE;
 
-  if (batch_len > 1)
+  if (state->instanced)
+    {
+      draw_instanced_entries (state, batch_len, draw_flags);
+    }
+  else if (batch_len > 1)
     {
       CoglVerticesMode mode = COGL_VERTICES_MODE_TRIANGLES;
       int first_vertex = state->current_vertex * 6 / 4;
@@ -370,7 +451,10 @@ _cogl_journal_flush_modelview_and_entries (CoglJournalEntry *batch_start,
              || (ctx->journal_rectangles_color & 0x07) == 0x07);
     }
 
-  state->current_vertex += (4 * batch_len);
+  if (state->instanced)
+    state->current_vertex += batch_len;
+  else
+    state->current_vertex += (4 * batch_len);
 
   COGL_TIMER_STOP (_cogl_uprof_context, time_flush_modelview_and_entries);
 }
@@ -383,6 +467,135 @@ compare_entry_modelviews (CoglJournalEntry *entry0,
   return entry0->modelview_entry == entry1->modelview_entry;
 }
 
+static CoglUserDataKey instanced_pipeline_key;
+static CoglUserDataKey instanced_pipeline_n_layers_key;
+
+static void
+instanced_pipeline_destroyed_cb (CoglPipeline *weak_pipeline,
+                                 void *user_data)
+{
+  CoglPipeline *original_pipeline = user_data;
+
+  /* See pipeline_destroyed_cb() in cogl-framebuffer.c for why this
+   * is safe */
+  cogl_object_set_user_data (COGL_OBJECT (original_pipeline),
+                             &instanced_pipeline_key, NULL, NULL);
+
+  cogl_object_unref (weak_pipeline);
+}
+
+/* The instance attributes are custom attributes so they can't use the
+ * cogl_ prefix, which is reserved for the builtin ones */
+static CoglSnippet *
+get_instance_transform_snippet (CoglContext *ctx)
+{
+  if (ctx->journal_instance_transform_snippet == NULL)
+    {
+      CoglSnippet *snippet;
+
+      snippet = cogl_snippet_new (COGL_SNIPPET_HOOK_VERTEX_TRANSFORM,
+                                  "attribute vec3 _cogl_instance_pos0;\n"
+                                  "attribute vec2 _cogl_instance_pos1;\n",
+                                  NULL);
+      cogl_snippet_set_replace (snippet,
+                                "cogl_position_out = "
+                                "cogl_modelview_projection_matrix * "
+                                "vec4 (mix (_cogl_instance_pos0.xy, "
+                                "_cogl_instance_pos1, "
+                                "cogl_position_in.xy), "
+                                "_cogl_instance_pos0.z, 1.0);\n");
+      ctx->journal_instance_transform_snippet = snippet;
+    }
+
+  return ctx->journal_instance_transform_snippet;
+}
+
+static CoglSnippet *
+get_instance_tex_coord_snippet (CoglContext *ctx,
+                                int n_layers)
+{
+  CoglSnippet **snippet_ptr =
+    &ctx->journal_instance_tex_coord_snippets[n_layers - 1];
+
+  if (*snippet_ptr == NULL)
+    {
+      GString *declarations = g_string_new (NULL);
+      GString *post = g_string_new (NULL);
+      int i;
+
+      /* The layer indices of instanced pipelines are always 0 to
+       * n_layers - 1 so the snippet can be shared between them */
+      for (i = 0; i < n_layers; i++)
+        {
+          g_string_append_printf (declarations,
+                                  "attribute vec4 _cogl_instance_tex%i;\n",
+                                  i);
+          g_string_append_printf (post,
+                                  "cogl_tex_coord%i_out = "
+                                  "cogl_texture_matrix%i * "
+                                  "vec4 (mix (_cogl_instance_tex%i.xy, "
+                                  "_cogl_instance_tex%i.zw, "
+                                  "cogl_position_in.xy), 0.0, 1.0);\n",
+                                  i, i, i, i);
+        }
+
+      *snippet_ptr = cogl_snippet_new (COGL_SNIPPET_HOOK_VERTEX,
+                                       declarations->str,
+                                       post->str);
+
+      g_string_free (declarations, TRUE);
+      g_string_free (post, TRUE);
+    }
+
+  return *snippet_ptr;
+}
+
+/* Returns a weak copy of the pipeline that expands the instance
+ * records in the vertex shader. It is cached on the pipeline so that
+ * it is kept across flushes and will follow any changes to it */
+static CoglPipeline *
+get_instanced_pipeline (CoglContext  *ctx,
+                        CoglPipeline *pipeline,
+                        int           n_layers)
+{
+  CoglPipeline *instanced_pipeline;
+
+  instanced_pipeline = cogl_object_get_user_data (COGL_OBJECT (pipeline),
+                                                  &instanced_pipeline_key);
+  if (instanced_pipeline)
+    {
+      int cached_n_layers =
+        GPOINTER_TO_INT (cogl_object_get_user_data (COGL_OBJECT (instanced_pipeline),
+                                                    &instanced_pipeline_n_layers_key));
+
+      /* The texture coordinate snippet depends on the number of
+       * layers so the copy has to be replaced if that changed */
+      if (cached_n_layers == n_layers)
+        return instanced_pipeline;
+
+      cogl_object_unref (instanced_pipeline);
+    }
+
+  instanced_pipeline = _cogl_pipeline_weak_copy (pipeline,
+                                                 instanced_pipeline_destroyed_cb,
+                                                 pipeline);
+  cogl_object_set_user_data (COGL_OBJECT (pipeline),
+                             &instanced_pipeline_key, instanced_pipeline,
+                             NULL);
+  cogl_object_set_user_data (COGL_OBJECT (instanced_pipeline),
+                             &instanced_pipeline_n_layers_key,
+                             GINT_TO_POINTER (n_layers),
+                             NULL);
+
+  cogl_pipeline_add_snippet (instanced_pipeline,
+                             get_instance_transform_snippet (ctx));
+  if (n_layers > 0)
+    cogl_pipeline_add_snippet (instanced_pipeline,
+                               get_instance_tex_coord_snippet (ctx, n_layers));
+
+  return instanced_pipeline;
+}
+
 /* At this point we have a run of quads that we know have compatible
  * pipelines, but they may not all have the same modelview matrix */
 static void
@@ -402,7 +615,12 @@ _cogl_journal_flush_pipeline_and_entries (CoglJournalEntry *batch_start,
   if (G_UNLIKELY (COGL_DEBUG_ENABLED (COGL_DEBUG_BATCHING)))
     g_print ("BATCHING:    pipeline batch len = %d\n", batch_len);
 
-  state->pipeline = batch_start->pipeline;
+  if (state->instanced)
+    state->pipeline = get_instanced_pipeline (state->ctx,
+                                              batch_start->pipeline,
+                                              batch_start->n_layers);
+  else
+    state->pipeline = batch_start->pipeline;
 
   /* If we haven't transformed the quads in software then we need to also break
    * up batches according to changes in the modelview matrix... */
@@ -449,10 +667,7 @@ create_attribute_cb (CoglPipeline *pipeline,
 {
   CreateAttributeState *state = user_data;
   CoglJournalFlushState *flush_state = state->flush_state;
-  CoglAttribute **attribute_entry =
-    &g_array_index (flush_state->attributes,
-                    CoglAttribute *,
-                    state->current + 2);
+  CoglAttribute **attribute_entry;
   const char *names[] = {
       "cogl_tex_coord0_in",
       "cogl_tex_coord1_in",
@@ -465,6 +680,35 @@ create_attribute_cb (CoglPipeline *pipeline,
   };
   char *name;
 
+  if (flush_state->instanced)
+    {
+      /* NB: attributes 0 to 3 are the unit quad position, color and
+       * the two corner positions */
+      attribute_entry = &g_array_index (flush_state->attributes,
+                                        CoglAttribute *,
+                                        state->current + 4);
+      name = g_strdup_printf ("_cogl_instance_tex%d", layer_number);
+      *attribute_entry =
+        cogl_attribute_new (flush_state->attribute_buffer,
+                            name,
+                            flush_state->stride,
+                            flush_state->array_offset +
+                            (INSTANCE_POS_STRIDE + COLOR_STRIDE) * 4 +
+                            INSTANCE_TEX_STRIDE * 4 * state->current,
+                            4,
+                            COGL_ATTRIBUTE_TYPE_FLOAT);
+      _cogl_attribute_set_instance_divisor (*attribute_entry, 1);
+      g_free (name);
+
+      state->current++;
+
+      return TRUE;
+    }
+
+  attribute_entry = &g_array_index (flush_state->attributes,
+                                    CoglAttribute *,
+                                    state->current + 2);
+
   /* XXX NB:
    * Our journal's vertex data is arranged as follows:
    * 4 vertices per quad:
@@ -508,6 +752,7 @@ _cogl_journal_flush_texcoord_vbo_offsets_and_entries (
 {
   CoglJournalFlushState *state = data;
   CreateAttributeState create_attrib_state;
+  int n_base_attributes;
   int i;
   COGL_STATIC_TIMER (time_flush_texcoord_pipeline_entries,
                      "flush: vbo+texcoords+pipeline+entries", /* parent */
@@ -518,12 +763,15 @@ _cogl_journal_flush_texcoord_vbo_offsets_and_entries (
 
   COGL_TIMER_START (_cogl_uprof_context, time_flush_texcoord_pipeline_entries);
 
-  /* NB: attributes 0 and 1 are position and color */
+  /* NB: attributes 0 and 1 are position and color, followed by the
+   * corner positions when drawing with instancing */
+  n_base_attributes = state->instanced ? 4 : 2;
 
-  for (i = 2; i < state->attributes->len; i++)
+  for (i = n_base_attributes; i < state->attributes->len; i++)
     cogl_object_unref (g_array_index (state->attributes, CoglAttribute *, i));
 
-  g_array_set_size (state->attributes, batch_start->n_layers + 2);
+  g_array_set_size (state->attributes,
+                    batch_start->n_layers + n_base_attributes);
 
   create_attrib_state.current = 0;
   create_attrib_state.flush_state = state;
@@ -549,6 +797,66 @@ compare_entry_layer_numbers (CoglJournalEntry *entry0, CoglJournalEntry *entry1)
     return FALSE;
 }
 
+static CoglAttributeBuffer *
+get_unit_quad_buffer (CoglContext *ctx)
+{
+  /* The corners are in triangle strip order with the same winding as
+   * the indexed quads */
+  static const float unit_quad[] = {
+    0.0f, 0.0f,
+    0.0f, 1.0f,
+    1.0f, 0.0f,
+    1.0f, 1.0f
+  };
+
+  if (ctx->journal_unit_quad_buffer == NULL)
+    ctx->journal_unit_quad_buffer =
+      cogl_attribute_buffer_new (ctx, sizeof (unit_quad), unit_quad);
+
+  return ctx->journal_unit_quad_buffer;
+}
+
+static void
+setup_instance_attributes (CoglJournalFlushState *state)
+{
+  CoglAttribute **attributes;
+
+  g_array_set_size (state->attributes, 4);
+  attributes = (CoglAttribute **) state->attributes->data;
+
+  attributes[0] = cogl_attribute_new (get_unit_quad_buffer (state->ctx),
+                                      "cogl_position_in",
+                                      sizeof (float) * 2,
+                                      0,
+                                      2,
+                                      COGL_ATTRIBUTE_TYPE_FLOAT);
+
+  attributes[1] = cogl_attribute_new (state->attribute_buffer,
+                                      "cogl_color_in",
+                                      state->stride,
+                                      state->array_offset +
+                                      INSTANCE_POS_STRIDE * 4,
+                                      4,
+                                      COGL_ATTRIBUTE_TYPE_UNSIGNED_BYTE);
+  _cogl_attribute_set_instance_divisor (attributes[1], 1);
+
+  attributes[2] = cogl_attribute_new (state->attribute_buffer,
+                                      "_cogl_instance_pos0",
+                                      state->stride,
+                                      state->array_offset,
+                                      3,
+                                      COGL_ATTRIBUTE_TYPE_FLOAT);
+  _cogl_attribute_set_instance_divisor (attributes[2], 1);
+
+  attributes[3] = cogl_attribute_new (state->attribute_buffer,
+                                      "_cogl_instance_pos1",
+                                      state->stride,
+                                      state->array_offset + 3 * 4,
+                                      2,
+                                      COGL_ATTRIBUTE_TYPE_FLOAT);
+  _cogl_attribute_set_instance_divisor (attributes[3], 1);
+}
+
 /* At this point we know the stride has changed from the previous batch
  * of journal entries */
 static void
@@ -584,33 +892,43 @@ _cogl_journal_flush_vbo_offsets_and_entries (CoglJournalEntry *batch_start,
    * (though n_layers may be padded; see definition of
    *  GET_JOURNAL_VB_STRIDE_FOR_N_LAYERS for details)
    */
-  stride = GET_JOURNAL_VB_STRIDE_FOR_N_LAYERS (batch_start->n_layers);
+  if (state->instanced)
+    stride = GET_JOURNAL_INSTANCE_STRIDE_FOR_N_LAYERS (batch_start->n_layers);
+  else
+    stride = GET_JOURNAL_VB_STRIDE_FOR_N_LAYERS (batch_start->n_layers);
   stride *= sizeof (float);
   state->stride = stride;
 
   for (i = 0; i < state->attributes->len; i++)
     cogl_object_unref (g_array_index (state->attributes, CoglAttribute *, i));
 
-  g_array_set_size (state->attributes, 2);
-
-  attribute_entry = &g_array_index (state->attributes, CoglAttribute *, 0);
-  *attribute_entry = cogl_attribute_new (state->attribute_buffer,
-                                         "cogl_position_in",
-                                         stride,
-                                         state->array_offset,
-                                         N_POS_COMPONENTS,
-                                         COGL_ATTRIBUTE_TYPE_FLOAT);
-
-  attribute_entry = &g_array_index (state->attributes, CoglAttribute *, 1);
-  *attribute_entry =
-    cogl_attribute_new (state->attribute_buffer,
-                        "cogl_color_in",
-                        stride,
-                        state->array_offset + (POS_STRIDE * 4),
-                        4,
-                        COGL_ATTRIBUTE_TYPE_UNSIGNED_BYTE);
-
-  state->indices = cogl_get_rectangle_indices (ctx, batch_len);
+  if (state->instanced)
+    {
+      setup_instance_attributes (state);
+    }
+  else
+    {
+      g_array_set_size (state->attributes, 2);
+
+      attribute_entry = &g_array_index (state->attributes, CoglAttribute *, 0);
+      *attribute_entry = cogl_attribute_new (state->attribute_buffer,
+                                             "cogl_position_in",
+                                             stride,
+                                             state->array_offset,
+                                             N_POS_COMPONENTS,
+                                             COGL_ATTRIBUTE_TYPE_FLOAT);
+
+      attribute_entry = &g_array_index (state->attributes, CoglAttribute *, 1);
+      *attribute_entry =
+        cogl_attribute_new (state->attribute_buffer,
+                            "cogl_color_in",
+                            stride,
+                            state->array_offset + (POS_STRIDE * 4),
+                            4,
+                            COGL_ATTRIBUTE_TYPE_UNSIGNED_BYTE);
+
+      state->indices = cogl_get_rectangle_indices (ctx, batch_len);
+    }
 
   /* We only create new Attributes when the stride within the
    * AttributeBuffer changes. (due to a change in the number of pipeline
@@ -621,7 +939,8 @@ _cogl_journal_flush_vbo_offsets_and_entries (CoglJournalEntry *batch_start,
   state->current_vertex = 0;
 
   if (G_UNLIKELY (COGL_DEBUG_ENABLED (COGL_DEBUG_JOURNAL)) &&
-      cogl_has_feature (ctx, COGL_FEATURE_ID_MAP_BUFFER_FOR_READ))
+      cogl_has_feature (ctx, COGL_FEATURE_ID_MAP_BUFFER_FOR_READ) &&
+      !state->instanced)
     {
       uint8_t *verts;
 
@@ -647,7 +966,10 @@ _cogl_journal_flush_vbo_offsets_and_entries (CoglJournalEntry *batch_start,
                   data);
 
   /* progress forward through the VBO containing all our vertices */
-  state->array_offset += (stride * 4 * batch_len);
+  if (state->instanced)
+    state->array_offset += (stride * batch_len);
+  else
+    state->array_offset += (stride * 4 * batch_len);
   if (G_UNLIKELY (COGL_DEBUG_ENABLED (COGL_DEBUG_JOURNAL)))
     g_print ("new vbo offset = %lu\n", (unsigned long)state->array_offset);
 
@@ -1110,32 +1432,187 @@ compare_entry_viewports (CoglJournalEntry *entry0, CoglJournalEntry *entry1)
   return memcmp (entry0->viewport, entry1->viewport, sizeof (float) * 4) == 0;
 }
 
-/* Gets a new vertex array from the pool. A reference is taken on the
-   array so it can be treated as if it was just newly allocated */
+static void
+entry_to_screen_polygon (CoglFramebuffer *framebuffer,
+                         const CoglJournalEntry *entry,
+                         float *vertices,
+                         float *poly);
+
+/* Checks whether two entries would end up in the same batch if they
+   were next to each other, going through the same criteria as the
+   flush callbacks. The cheap checks are done first */
+static gboolean
+compare_entries_for_reorder (CoglJournalEntry *entry0,
+                             CoglJournalEntry *entry1)
+{
+  return (compare_entry_clip_stacks (entry0, entry1) &&
+          compare_entry_dither_states (entry0, entry1) &&
+          compare_entry_strides (entry0, entry1) &&
+          compare_entry_viewports (entry0, entry1) &&
+          (SW_TRANSFORM || compare_entry_modelviews (entry0, entry1)) &&
+          compare_entry_layer_numbers (entry0, entry1) &&
+          compare_entry_pipelines (entry0, entry1));
+}
+
+static void
+get_entry_screen_bounds (CoglJournal      *journal,
+                         CoglJournalEntry *entry,
+                         ClipBounds       *bounds)
+{
+  float *vertices = &g_array_index (journal->vertices, float,
+                                    entry->array_offset + 1);
+  float poly[16];
+  int i;
+
+  entry_to_screen_polygon (journal->framebuffer, entry, vertices, poly);
+
+  bounds->x_1 = bounds->x_2 = poly[0];
+  bounds->y_1 = bounds->y_2 = poly[1];
+
+  for (i = 1; i < 4; i++)
+    {
+      bounds->x_1 = MIN (bounds->x_1, poly[i * 4]);
+      bounds->y_1 = MIN (bounds->y_1, poly[i * 4 + 1]);
+      bounds->x_2 = MAX (bounds->x_2, poly[i * 4]);
+      bounds->y_2 = MAX (bounds->y_2, poly[i * 4 + 1]);
+    }
+}
+
+static gboolean
+screen_bounds_overlap (const ClipBounds *bounds0,
+                       const ClipBounds *bounds1)
+{
+  /* Rectangles that only touch are considered overlapping too so that
+     pixels along a shared edge keep being blended in order */
+  return (bounds0->x_1 <= bounds1->x_2 && bounds1->x_1 <= bounds0->x_2 &&
+          bounds0->y_1 <= bounds1->y_2 && bounds1->y_1 <= bounds0->y_2);
+}
+
+/* Entries only need to be drawn in the order they were logged where
+ * they overlap on screen. This moves each entry back to just after
+ * the closest previous entry that it can be batched with, as long as
+ * it doesn't overlap any of the entries it is moved past. That way
+ * interleaved draws such as icons and text end up in a few batches
+ * instead of alternating between pipelines */
+static void
+reorder_entries (CoglJournal *journal)
+{
+  CoglJournalEntry *entries = (CoglJournalEntry *) journal->entries->data;
+  int n_entries = journal->entries->len;
+  ClipBounds *bounds;
+  int n_runs = 1;
+  int i;
+
+  if (n_entries < 3)
+    return;
+
+  /* Entries can only be merged into an earlier batch if there are at
+     least three runs of entries, e.g. A B A, so don't bother computing
+     the screen bounds otherwise */
+  for (i = 1; i < n_entries && n_runs < 3; i++)
+    {
+      if (!compare_entries_for_reorder (&entries[i - 1], &entries[i]))
+        n_runs++;
+    }
+
+  if (n_runs < 3)
+    return;
+
+  g_array_set_size (journal->reorder_bounds, n_entries);
+  bounds = (ClipBounds *) journal->reorder_bounds->data;
+
+  for (i = 0; i < n_entries; i++)
+    get_entry_screen_bounds (journal, &entries[i], &bounds[i]);
+
+  for (i = 2; i < n_entries; i++)
+    {
+      int first = MAX (0, i - COGL_JOURNAL_REORDER_WINDOW);
+      int target = -1;
+      int j;
+
+      if (compare_entries_for_reorder (&entries[i - 1], &entries[i]))
+        continue;
+
+      for (j = i - 1; j >= first; j--)
+        {
+          if (j < i - 1 && compare_entries_for_reorder (&entries[j],
+                                                        &entries[i]))
+            {
+              target = j + 1;
+              break;
+            }
+
+          if (screen_bounds_overlap (&bounds[j], &bounds[i]))
+            break;
+        }
+
+      if (target >= 0)
+        {
+          CoglJournalEntry entry = entries[i];
+          ClipBounds entry_bounds = bounds[i];
+
+          memmove (&entries[target + 1], &entries[target],
+                   sizeof (CoglJournalEntry) * (i - target));
+          memmove (&bounds[target + 1], &bounds[target],
+                   sizeof (ClipBounds) * (i - target));
+
+          entries[target] = entry;
+          bounds[target] = entry_bounds;
+        }
+    }
+}
+
+/* Reserves n_bytes in the context's streaming vertex buffer. It is
+   shared by the journals of all framebuffers so that only one buffer
+   is kept around regardless of how many offscreen framebuffers get
+   drawn to. A reference is taken on the buffer so it can be treated
+   as if it was just newly allocated. The offset of the reserved range
+   is returned in offset_out and the hints to map it with in
+   hints_out */
 static CoglAttributeBuffer *
-create_attribute_buffer (CoglJournal *journal,
-                         size_t n_bytes)
+reserve_attribute_buffer (CoglJournal       *journal,
+                          size_t             n_bytes,
+                          size_t            *offset_out,
+                          CoglBufferMapHint *hints_out)
 {
   CoglContext *ctx = cogl_framebuffer_get_context (journal->framebuffer);
-  CoglAttributeBuffer *vbo;
-
-  vbo = journal->vbo_pool[journal->next_vbo_in_pool];
+  CoglAttributeBuffer *vbo = ctx->journal_vbo;
 
-  if (vbo == NULL)
+  if (vbo == NULL || cogl_buffer_get_size (COGL_BUFFER (vbo)) < n_bytes)
+    {
+      size_t size = COGL_JOURNAL_VBO_MIN_SIZE;
+
+      /* If the buffer is too small then we'll just recreate it. Leave
+         room for a few more flushes of the same size before wrapping */
+      while (size < n_bytes * 4)
+        size *= 2;
+
+      if (vbo)
+        cogl_object_unref (vbo);
+      vbo = cogl_attribute_buffer_new_with_size (ctx, size);
+      cogl_buffer_set_update_hint (COGL_BUFFER (vbo),
+                                   COGL_BUFFER_UPDATE_HINT_STREAM);
+      ctx->journal_vbo = vbo;
+
+      ctx->journal_vbo_offset = 0;
+      *hints_out = COGL_BUFFER_MAP_HINT_DISCARD;
+    }
+  else if (ctx->journal_vbo_offset + n_bytes >
+           cogl_buffer_get_size (COGL_BUFFER (vbo)))
     {
-      vbo = cogl_attribute_buffer_new_with_size (ctx, n_bytes);
-      journal->vbo_pool[journal->next_vbo_in_pool] = vbo;
+      /* Wrap around, orphaning the storage that the GPU may still be
+         reading from */
+      ctx->journal_vbo_offset = 0;
+      *hints_out = COGL_BUFFER_MAP_HINT_DISCARD;
     }
-  else if (cogl_buffer_get_size (COGL_BUFFER (vbo)) < n_bytes)
+  else
     {
-      /* If the buffer is too small then we'll just recreate it */
-      cogl_object_unref (vbo);
-      vbo = cogl_attribute_buffer_new_with_size (ctx, n_bytes);
-      journal->vbo_pool[journal->next_vbo_in_pool] = vbo;
+      *hints_out = (COGL_BUFFER_MAP_HINT_DISCARD_RANGE |
+                    COGL_BUFFER_MAP_HINT_UNSYNCHRONIZED);
     }
 
-  journal->next_vbo_in_pool = ((journal->next_vbo_in_pool + 1) %
-                               COGL_JOURNAL_VBO_POOL_SIZE);
+  *offset_out = ctx->journal_vbo_offset;
+  ctx->journal_vbo_offset += n_bytes;
 
   return cogl_object_ref (vbo);
 }
@@ -1145,10 +1622,12 @@ upload_vertices (CoglJournal *journal,
                  const CoglJournalEntry *entries,
                  int n_entries,
                  size_t needed_vbo_len,
-                 GArray *vertices)
+                 GArray *vertices,
+                 size_t *offset_out)
 {
   CoglAttributeBuffer *attribute_buffer;
   CoglBuffer *buffer;
+  CoglBufferMapHint hints;
   const float *vin;
   float *vout;
   int entry_num;
@@ -1158,15 +1637,16 @@ upload_vertices (CoglJournal *journal,
 
   g_assert (needed_vbo_len);
 
-  attribute_buffer = create_attribute_buffer (journal, needed_vbo_len * 4);
+  attribute_buffer = reserve_attribute_buffer (journal,
+                                               needed_vbo_len * 4,
+                                               offset_out,
+                                               &hints);
   buffer = COGL_BUFFER (attribute_buffer);
-  cogl_buffer_set_update_hint (buffer, COGL_BUFFER_UPDATE_HINT_DYNAMIC);
 
   vout = _cogl_buffer_map_range_for_fill_or_fallback (buffer,
-                                                      0, /* offset */
-                                                      needed_vbo_len * 4);
-  vin = &g_array_index (vertices, float, 0);
-
+                                                      *offset_out,
+                                                      needed_vbo_len * 4,
+                                                      hints);
   /* Expand the number of vertices from 2 to 4 while uploading */
   for (entry_num = 0; entry_num < n_entries; entry_num++)
     {
@@ -1175,6 +1655,10 @@ upload_vertices (CoglJournal *journal,
       size_t array_stride =
         GET_JOURNAL_ARRAY_STRIDE_FOR_N_LAYERS (entry->n_layers);
 
+      /* The entries may have been reordered so the logged vertices
+         aren't necessarily in the same order */
+      vin = &g_array_index (vertices, float, entry->array_offset);
+
       /* Copy the color to all four of the vertices */
       for (i = 0; i < 4; i++)
         memcpy (vout + vb_stride * i + POS_STRIDE, vin, 4);
@@ -1231,7 +1715,6 @@ upload_vertices (CoglJournal *journal,
           tout[vb_stride * 3 + 1 + i * 2] = tin[i * 2 + 1];
         }
 
-      vin += array_stride * 2;
       vout += vb_stride * 4;
     }
 
@@ -1240,6 +1723,210 @@ upload_vertices (CoglJournal *journal,
   return attribute_buffer;
 }
 
+/* Writes one instance record per entry instead of four vertices. The
+ * entries have already been checked by can_instance_entries() */
+static CoglAttributeBuffer *
+upload_instances (CoglJournal *journal,
+                  const CoglJournalEntry *entries,
+                  int n_entries,
+                  size_t needed_len,
+                  GArray *vertices,
+                  size_t *offset_out)
+{
+  CoglAttributeBuffer *attribute_buffer;
+  CoglBuffer *buffer;
+  CoglBufferMapHint hints;
+  float *vout;
+  int entry_num;
+  int i;
+  CoglMatrixEntry *last_modelview_entry = NULL;
+  graphene_matrix_t modelview;
+
+  g_assert (needed_len);
+
+  attribute_buffer = reserve_attribute_buffer (journal,
+                                               needed_len * 4,
+                                               offset_out,
+                                               &hints);
+  buffer = COGL_BUFFER (attribute_buffer);
+
+  vout = _cogl_buffer_map_range_for_fill_or_fallback (buffer,
+                                                      *offset_out,
+                                                      needed_len * 4,
+                                                      hints);
+
+  for (entry_num = 0; entry_num < n_entries; entry_num++)
+    {
+      const CoglJournalEntry *entry = entries + entry_num;
+      size_t instance_stride =
+        GET_JOURNAL_INSTANCE_STRIDE_FOR_N_LAYERS (entry->n_layers);
+      size_t array_stride =
+        GET_JOURNAL_ARRAY_STRIDE_FOR_N_LAYERS (entry->n_layers);
+      const float *vin = &g_array_index (vertices, float, entry->array_offset);
+      const float *tin;
+      float *tout;
+      float v[4];
+      float corners[6];
+
+      memcpy (vout + INSTANCE_POS_STRIDE, vin, 4);
+      vin++;
+
+      v[0] = vin[0];
+      v[1] = vin[1];
+      v[2] = vin[array_stride];
+      v[3] = vin[array_stride + 1];
+
+      if (entry->modelview_entry != last_modelview_entry)
+        {
+          cogl_matrix_entry_get (entry->modelview_entry, &modelview);
+          last_modelview_entry = entry->modelview_entry;
+        }
+      cogl_graphene_matrix_transform_points (&modelview,
+                                             2, /* n_components */
+                                             sizeof (float) * 2, /* stride_in */
+                                             v, /* points_in */
+                                             sizeof (float) * 3, /* stride_out */
+                                             corners, /* points_out */
+                                             2 /* n_points */);
+
+      /* The z of the second corner is the same as the first because
+       * the transform keeps the quad parallel to the screen */
+      vout[0] = corners[0];
+      vout[1] = corners[1];
+      vout[2] = corners[2];
+      vout[3] = corners[3];
+      vout[4] = corners[4];
+
+      tin = vin + 2;
+      tout = vout + INSTANCE_POS_STRIDE + COLOR_STRIDE;
+      for (i = 0; i < entry->n_layers; i++)
+        {
+          tout[i * 4] = tin[i * 2];
+          tout[i * 4 + 1] = tin[i * 2 + 1];
+          tout[i * 4 + 2] = tin[array_stride + i * 2];
+          tout[i * 4 + 3] = tin[array_stride + i * 2 + 1];
+        }
+
+      vout += instance_stride;
+    }
+
+  _cogl_buffer_unmap_for_fill_or_fallback (buffer);
+
+  return attribute_buffer;
+}
+
+typedef struct
+{
+  int n_layers;
+  gboolean consecutive;
+} CheckLayerIndicesState;
+
+static gboolean
+check_layer_index_cb (CoglPipeline *pipeline,
+                      int layer_index,
+                      void *user_data)
+{
+  CheckLayerIndicesState *state = user_data;
+
+  if (layer_index != state->n_layers++)
+    {
+      state->consecutive = FALSE;
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+static gboolean
+pipeline_can_be_instanced (CoglPipeline *pipeline)
+{
+  CheckLayerIndicesState state;
+
+  /* The instanced pipeline replaces the vertex transform and the
+   * texture coordinates so anything else touching them would break */
+  if (cogl_pipeline_get_user_program (pipeline) ||
+      _cogl_pipeline_has_vertex_snippets (pipeline))
+    return FALSE;
+
+  if (cogl_pipeline_get_n_layers (pipeline) > COGL_JOURNAL_MAX_INSTANCED_LAYERS)
+    return FALSE;
+
+  /* The texture coordinate snippets are shared between pipelines
+   * which only works if the layers are numbered from 0 */
+  state.n_layers = 0;
+  state.consecutive = TRUE;
+  cogl_pipeline_foreach_layer (pipeline, check_layer_index_cb, &state);
+
+  return state.consecutive;
+}
+
+static gboolean
+modelview_can_be_instanced (CoglMatrixEntry *modelview_entry)
+{
+  graphene_matrix_t modelview;
+
+  cogl_matrix_entry_get (modelview_entry, &modelview);
+
+  /* The quad is only fully described by two of its corners if x
+   * doesn't depend on y, y doesn't depend on x and z depends on
+   * neither of them */
+  return (graphene_matrix_get_value (&modelview, 1, 0) == 0.0f &&
+          graphene_matrix_get_value (&modelview, 0, 1) == 0.0f &&
+          graphene_matrix_get_value (&modelview, 0, 2) == 0.0f &&
+          graphene_matrix_get_value (&modelview, 1, 2) == 0.0f);
+}
+
+/* Decides whether the whole journal can be drawn with instancing. On
+ * success the number of 32bit words needed for the instance records
+ * is returned in n_words_out */
+static gboolean
+can_instance_entries (CoglJournal *journal,
+                      size_t *n_words_out)
+{
+  CoglContext *ctx = cogl_framebuffer_get_context (journal->framebuffer);
+  CoglPipeline *last_pipeline = NULL;
+  CoglMatrixEntry *last_modelview_entry = NULL;
+  size_t n_words = 0;
+  int i;
+
+  if (!_cogl_has_private_feature (ctx, COGL_PRIVATE_FEATURE_INSTANCED_ARRAYS))
+    return FALSE;
+
+  if (journal->entries->len < COGL_JOURNAL_INSTANCING_THRESHOLD)
+    return FALSE;
+
+  if (G_UNLIKELY (COGL_DEBUG_ENABLED (COGL_DEBUG_DISABLE_SOFTWARE_TRANSFORM) ||
+                  COGL_DEBUG_ENABLED (COGL_DEBUG_RECTANGLES) ||
+                  COGL_DEBUG_ENABLED (COGL_DEBUG_WIREFRAME)))
+    return FALSE;
+
+  for (i = 0; i < journal->entries->len; i++)
+    {
+      CoglJournalEntry *entry =
+        &g_array_index (journal->entries, CoglJournalEntry, i);
+
+      if (entry->pipeline != last_pipeline)
+        {
+          if (!pipeline_can_be_instanced (entry->pipeline))
+            return FALSE;
+          last_pipeline = entry->pipeline;
+        }
+
+      if (entry->modelview_entry != last_modelview_entry)
+        {
+          if (!modelview_can_be_instanced (entry->modelview_entry))
+            return FALSE;
+          last_modelview_entry = entry->modelview_entry;
+        }
+
+      n_words += GET_JOURNAL_INSTANCE_STRIDE_FOR_N_LAYERS (entry->n_layers);
+    }
+
+  *n_words_out = n_words;
+
+  return TRUE;
+}
+
 void
 _cogl_journal_discard (CoglJournal *journal)
 {
@@ -1353,6 +2040,7 @@ _cogl_journal_flush (CoglJournal *journal)
   CoglFramebuffer *framebuffer;
   CoglContext *ctx;
   CoglJournalFlushState state;
+  size_t instance_words = 0;
   int i;
   COGL_STATIC_TIMER (flush_timer,
                      "Mainloop", /* parent */
@@ -1421,15 +2109,30 @@ _cogl_journal_flush (CoglJournal *journal)
                       &state); /* data */
     }
 
+  /* Reorder after the clip stack pass because software clipping can
+     remove the clip from entries, which lets more of them batch */
+  if (G_UNLIKELY (COGL_DEBUG_ENABLED (COGL_DEBUG_JOURNAL_REORDER)))
+    reorder_entries (journal);
+
   /* We upload the vertices after the clip stack pass in case it
      modifies the entries */
-  state.attribute_buffer =
-    upload_vertices (journal,
-                     &g_array_index (journal->entries, CoglJournalEntry, 0),
-                     journal->entries->len,
-                     journal->needed_vbo_len,
-                     journal->vertices);
-  state.array_offset = 0;
+  state.instanced = can_instance_entries (journal, &instance_words);
+  if (state.instanced)
+    state.attribute_buffer =
+      upload_instances (journal,
+                        &g_array_index (journal->entries, CoglJournalEntry, 0),
+                        journal->entries->len,
+                        instance_words,
+                        journal->vertices,
+                        &state.array_offset);
+  else
+    state.attribute_buffer =
+      upload_vertices (journal,
+                       &g_array_index (journal->entries, CoglJournalEntry, 0),
+                       journal->entries->len,
+                       journal->needed_vbo_len,
+                       journal->vertices,
+                       &state.array_offset);
 
   /* batch_and_call() batches a list of journal entries according to some
    * given criteria and calls a callback once for each determined batch.
@@ -32,6 +32,7 @@
 
 #include <gio/gio.h>
 
+#include "cogl/cogl-atlas-texture-private.h"
 #include "cogl/cogl-util.h"
 #include "cogl/cogl-onscreen-private.h"
 #include "cogl/cogl-frame-info-private.h"
@@ -359,6 +360,11 @@ cogl_onscreen_swap_buffers_with_damage (CoglOnscreen *onscreen,
     }
 
   priv->frame_counter++;
+
+  /* The frame has been flushed so this is a good time to shrink
+     atlases that have become mostly empty */
+  _cogl_atlas_texture_compact_atlases (
+    cogl_framebuffer_get_context (framebuffer));
 }
 
 void
@@ -419,6 +425,11 @@ cogl_onscreen_swap_region (CoglOnscreen *onscreen,
     }
 
   priv->frame_counter++;
+
+  /* The frame has been flushed so this is a good time to shrink
+     atlases that have become mostly empty */
+  _cogl_atlas_texture_compact_atlases (
+    cogl_framebuffer_get_context (framebuffer));
 }
 
 int
@@ -65,6 +65,7 @@ const CoglPipelineProgend *_cogl_pipeline_progend;
 #include "cogl/driver/gl/cogl-pipeline-fragend-glsl-private.h"
 #include "cogl/driver/gl/cogl-pipeline-vertend-glsl-private.h"
 #include "cogl/driver/gl/cogl-pipeline-progend-glsl-private.h"
+#include "cogl/driver/gl/cogl-pipeline-opengl-private.h"
 
 COGL_OBJECT_DEFINE (Pipeline, pipeline);
 COGL_GTYPE_DEFINE_CLASS (Pipeline, pipeline);
@@ -2821,3 +2822,16 @@ cogl_pipeline_get_uniform_location (CoglPipeline *pipeline,
 
   return ctx->n_uniform_names++;
 }
+
+gboolean
+cogl_pipeline_precompile (CoglPipeline *pipeline)
+{
+  _COGL_GET_CONTEXT (ctx, TRUE);
+
+  g_return_val_if_fail (cogl_is_pipeline (pipeline), TRUE);
+
+  if (!_cogl_has_private_feature (ctx, COGL_PRIVATE_FEATURE_ANY_GL))
+    return TRUE;
+
+  return _cogl_pipeline_gl_precompile (ctx, pipeline);
+}
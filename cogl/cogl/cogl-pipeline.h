@@ -162,4 +162,23 @@ COGL_EXPORT int
 cogl_pipeline_get_uniform_location (CoglPipeline *pipeline,
                                     const char *uniform_name);
 
+/**
+ * cogl_pipeline_precompile:
+ * @pipeline: A #CoglPipeline object
+ *
+ * Starts generating and compiling the GPU program needed to draw with
+ * @pipeline without drawing anything. When the driver supports
+ * compiling shaders in the background this doesn't block, and the
+ * function can be called again later to check whether the program is
+ * ready. Drawing with a pipeline whose program isn't ready yet stalls
+ * until it has finished compiling, so callers that can cope with not
+ * drawing for a frame, or with drawing something simpler instead, can
+ * use this to avoid the stall.
+ *
+ * Return value: %TRUE if drawing with @pipeline won't wait for the
+ *   program to be compiled, %FALSE otherwise
+ */
+COGL_EXPORT gboolean
+cogl_pipeline_precompile (CoglPipeline *pipeline);
+
 G_END_DECLS
@@ -335,6 +335,34 @@ cogl_trace_describe (CoglTraceHead *head,
   head->description = g_strdup (description);
 }
 
+void
+cogl_trace_mark (const char *name,
+                 const char *description,
+                 int64_t     begin_time_ns,
+                 int64_t     duration_ns)
+{
+  CoglTraceContext *trace_context;
+  CoglTraceThreadContext *trace_thread_context;
+
+  trace_thread_context = g_private_get (&cogl_trace_thread_data);
+  trace_context = trace_thread_context->trace_context;
+
+  g_mutex_lock (&cogl_trace_mutex);
+  if (!sysprof_capture_writer_add_mark (trace_context->writer,
+                                        begin_time_ns,
+                                        trace_thread_context->cpu_id,
+                                        trace_thread_context->pid,
+                                        duration_ns,
+                                        trace_thread_context->group,
+                                        name,
+                                        description))
+    {
+      if (errno == EPIPE)
+        cogl_set_tracing_disabled_on_thread (g_main_context_get_thread_default ());
+    }
+  g_mutex_unlock (&cogl_trace_mutex);
+}
+
 #else
 
 #include <string.h>
@@ -89,6 +89,12 @@ COGL_EXPORT void
 cogl_trace_describe (CoglTraceHead *head,
                      const char    *description);
 
+COGL_EXPORT void
+cogl_trace_mark (const char *name,
+                 const char *description,
+                 int64_t     begin_time_ns,
+                 int64_t     duration_ns);
+
 static inline void
 cogl_auto_trace_end_helper (CoglTraceHead **head)
 {
@@ -125,6 +131,10 @@ cogl_is_tracing_enabled (void)
   if (cogl_is_tracing_enabled ()) \
     cogl_trace_describe (&CoglTrace##Name, description);
 
+#define COGL_TRACE_MARK(name, description, begin_time_ns, duration_ns) \
+  if (cogl_is_tracing_enabled ()) \
+    cogl_trace_mark (name, description, begin_time_ns, duration_ns);
+
 #define COGL_TRACE_SCOPED_ANCHOR(Name) \
   CoglTraceHead G_GNUC_UNUSED CoglTrace##Name = { 0 }; \
   __attribute__((cleanup (cogl_auto_trace_end_helper))) \
@@ -145,6 +155,7 @@ cogl_is_tracing_enabled (void)
 #define COGL_TRACE_END(Name) (void) 0
 #define COGL_TRACE_BEGIN_SCOPED(Name, name) (void) 0
 #define COGL_TRACE_DESCRIBE(Name, description) (void) 0
+#define COGL_TRACE_MARK(name, description, begin_time_ns, duration_ns) (void) 0
 #define COGL_TRACE_ANCHOR(Name) (void) 0
 #define COGL_TRACE_BEGIN_ANCHORED(Name, name) (void) 0
 
@@ -336,6 +336,28 @@ cogl_gl_framebuffer_draw_attributes (CoglFramebufferDriver  *driver,
       glDrawArrays ((GLenum)mode, first_vertex, n_vertices));
 }
 
+static void
+cogl_gl_framebuffer_draw_instanced_attributes (CoglFramebufferDriver  *driver,
+                                               CoglPipeline           *pipeline,
+                                               CoglVerticesMode        mode,
+                                               int                     first_vertex,
+                                               int                     n_vertices,
+                                               int                     n_instances,
+                                               CoglAttribute         **attributes,
+                                               int                     n_attributes,
+                                               CoglDrawFlags           flags)
+{
+  CoglFramebuffer *framebuffer =
+    cogl_framebuffer_driver_get_framebuffer (driver);
+
+  _cogl_flush_attributes_state (framebuffer, pipeline, flags,
+                                attributes, n_attributes);
+
+  GE (cogl_framebuffer_get_context (framebuffer),
+      glDrawArraysInstanced ((GLenum)mode, first_vertex, n_vertices,
+                             n_instances));
+}
+
 static size_t
 sizeof_index_type (CoglIndicesType type)
 {
@@ -689,6 +711,8 @@ cogl_gl_framebuffer_class_init (CoglGlFramebufferClass *klass)
   driver_class->draw_attributes = cogl_gl_framebuffer_draw_attributes;
   driver_class->draw_indexed_attributes =
     cogl_gl_framebuffer_draw_indexed_attributes;
+  driver_class->draw_instanced_attributes =
+    cogl_gl_framebuffer_draw_instanced_attributes;
   driver_class->read_pixels_into_bitmap =
     cogl_gl_framebuffer_read_pixels_into_bitmap;
 }
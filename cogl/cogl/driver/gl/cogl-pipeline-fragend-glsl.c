@@ -1051,17 +1051,16 @@ _cogl_pipeline_fragend_glsl_end (CoglPipeline *pipeline,
                                                      source_strings, lengths);
 
       GE( ctx, glCompileShader (shader) );
-      GE( ctx, glGetShaderiv (shader, GL_COMPILE_STATUS, &compile_status) );
 
-      if (!compile_status)
+      /* Querying the compile status would wait for the compilation to
+       * finish; with parallel compilation, errors are reported when
+       * linking instead. */
+      if (!_cogl_has_private_feature (ctx,
+                                      COGL_PRIVATE_FEATURE_PARALLEL_SHADER_COMPILE))
         {
-          GLint len = 0;
-          char *shader_log;
-
-          GE( ctx, glGetShaderiv (shader, GL_INFO_LOG_LENGTH, &len) );
-          shader_log = g_alloca (len);
-          GE( ctx, glGetShaderInfoLog (shader, len, &len, shader_log) );
-          g_warning ("Shader compilation failed:\n%s", shader_log);
+          GE( ctx, glGetShaderiv (shader, GL_COMPILE_STATUS, &compile_status) );
+          if (!compile_status)
+            _cogl_glsl_shader_log_compile_error (ctx, shader);
         }
 
       shader_state->header = NULL;
@@ -145,6 +145,14 @@ _cogl_pipeline_flush_gl_state (CoglContext *context,
                                gboolean skip_gl_state,
                                gboolean unknown_color_alpha);
 
+gboolean
+_cogl_pipeline_gl_precompile (CoglContext  *context,
+                              CoglPipeline *pipeline);
+
+void
+_cogl_glsl_shader_log_compile_error (CoglContext *ctx,
+                                     GLuint       shader_gl_handle);
+
 void
 _cogl_glsl_shader_set_source_with_boilerplate (CoglContext *ctx,
                                                GLuint shader_gl_handle,
@@ -846,6 +846,105 @@ fragend_add_layer_cb (CoglPipelineLayer *layer,
   return TRUE;
 }
 
+static gboolean
+generate_shaders (CoglPipeline    *pipeline,
+                  CoglFramebuffer *framebuffer,
+                  int              n_layers,
+                  unsigned long    pipelines_difference,
+                  unsigned long   *layer_differences)
+{
+  const CoglPipelineVertend *vertend;
+  const CoglPipelineFragend *fragend;
+  CoglPipelineAddLayerState state;
+
+  vertend = _cogl_pipeline_vertend;
+
+  vertend->start (pipeline,
+                  n_layers,
+                  pipelines_difference);
+
+  state.framebuffer = framebuffer;
+  state.vertend = vertend;
+  state.pipeline = pipeline;
+  state.layer_differences = layer_differences;
+  state.error_adding_layer = FALSE;
+  state.added_layer = FALSE;
+
+  _cogl_pipeline_foreach_layer_internal (pipeline,
+                                         vertend_add_layer_cb,
+                                         &state);
+
+  if (G_UNLIKELY (state.error_adding_layer))
+    return FALSE;
+
+  if (G_UNLIKELY (!vertend->end (pipeline, pipelines_difference)))
+    return FALSE;
+
+  /* Now prepare the fragment processing state (fragend)
+   *
+   * NB: We can't combine the setup of the vertend and fragend
+   * since the backends that do code generation share
+   * ctx->codegen_source_buffer as a scratch buffer.
+   */
+
+  fragend = _cogl_pipeline_fragend;
+  state.fragend = fragend;
+
+  fragend->start (pipeline,
+                  n_layers,
+                  pipelines_difference);
+
+  _cogl_pipeline_foreach_layer_internal (pipeline,
+                                         fragend_add_layer_cb,
+                                         &state);
+
+  if (G_UNLIKELY (state.error_adding_layer))
+    return FALSE;
+
+  if (G_UNLIKELY (!fragend->end (pipeline, pipelines_difference)))
+    return FALSE;
+
+  return TRUE;
+}
+
+/*
+ * _cogl_pipeline_gl_precompile:
+ *
+ * Generates and starts compiling the program for @pipeline without
+ * flushing any GL state, so that it can be done ahead of the first draw.
+ * Returns %FALSE if the driver is still compiling the program in the
+ * background, in which case drawing with @pipeline would block.
+ */
+gboolean
+_cogl_pipeline_gl_precompile (CoglContext  *ctx,
+                              CoglPipeline *pipeline)
+{
+  const CoglPipelineProgend *progend = _cogl_pipeline_progend;
+  unsigned long *layer_differences = NULL;
+  int n_layers;
+  int i;
+
+  n_layers = cogl_pipeline_get_n_layers (pipeline);
+  if (n_layers)
+    {
+      layer_differences = g_alloca (sizeof (unsigned long) * n_layers);
+      for (i = 0; i < n_layers; i++)
+        layer_differences[i] = COGL_PIPELINE_LAYER_STATE_ALL;
+    }
+
+  /* If the program can't be generated now it will be when flushing, and
+   * there is nothing to wait for here */
+  if (G_UNLIKELY (!progend->start (pipeline)) ||
+      G_UNLIKELY (!generate_shaders (pipeline,
+                                     NULL,
+                                     n_layers,
+                                     COGL_PIPELINE_STATE_ALL,
+                                     layer_differences)))
+    return TRUE;
+
+  return _cogl_pipeline_progend_glsl_precompile (pipeline);
+}
+
 /*
  * _cogl_pipeline_flush_gl_state:
  *
@@ -1024,60 +1123,16 @@ _cogl_pipeline_flush_gl_state (CoglContext *ctx,
 
   do
     {
-      const CoglPipelineVertend *vertend;
-      const CoglPipelineFragend *fragend;
-      CoglPipelineAddLayerState state;
-
       progend = _cogl_pipeline_progend;
 
       if (G_UNLIKELY (!progend->start (pipeline)))
         continue;
 
-      vertend = _cogl_pipeline_vertend;
-
-      vertend->start (pipeline,
-                      n_layers,
-                      pipelines_difference);
-
-      state.framebuffer = framebuffer;
-      state.vertend = vertend;
-      state.pipeline = pipeline;
-      state.layer_differences = layer_differences;
-      state.error_adding_layer = FALSE;
-      state.added_layer = FALSE;
-
-      _cogl_pipeline_foreach_layer_internal (pipeline,
-                                             vertend_add_layer_cb,
-                                             &state);
-
-      if (G_UNLIKELY (state.error_adding_layer))
-        continue;
-
-      if (G_UNLIKELY (!vertend->end (pipeline, pipelines_difference)))
-        continue;
-
-      /* Now prepare the fragment processing state (fragend)
-       *
-       * NB: We can't combine the setup of the vertend and fragend
-       * since the backends that do code generation share
-       * ctx->codegen_source_buffer as a scratch buffer.
-       */
-
-      fragend = _cogl_pipeline_fragend;
-      state.fragend = fragend;
-
-      fragend->start (pipeline,
-                      n_layers,
-                      pipelines_difference);
-
-      _cogl_pipeline_foreach_layer_internal (pipeline,
-                                             fragend_add_layer_cb,
-                                             &state);
-
-      if (G_UNLIKELY (state.error_adding_layer))
-        continue;
-
-      if (G_UNLIKELY (!fragend->end (pipeline, pipelines_difference)))
+      if (G_UNLIKELY (!generate_shaders (pipeline,
+                                         framebuffer,
+                                         n_layers,
+                                         pipelines_difference,
+                                         layer_differences)))
         continue;
 
       if (progend->end)
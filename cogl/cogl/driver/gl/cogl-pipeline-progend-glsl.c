@@ -51,6 +51,7 @@
 #include "cogl/driver/gl/cogl-pipeline-fragend-glsl-private.h"
 #include "cogl/driver/gl/cogl-pipeline-vertend-glsl-private.h"
 #include "cogl/driver/gl/cogl-pipeline-progend-glsl-private.h"
+#include "cogl/driver/gl/cogl-program-binary-cache-private.h"
 #include "deprecated/cogl-program-private.h"
 
 /* These are used to generalise updating some uniforms that are
@@ -105,6 +106,15 @@ typedef struct
 
   GLuint program;
 
+  /* Set while the driver is still linking the program in the
+     background. The link status has to be checked before using it */
+  gboolean link_pending;
+  /* Set when the program has been (re)created but the uniform and
+     attribute locations haven't been queried yet */
+  gboolean program_changed;
+  /* Key to store the program in the binary cache once it is linked */
+  char *binary_key;
+
   unsigned long dirty_builtin_uniforms;
   GLint builtin_uniform_locations[G_N_ELEMENTS (builtin_uniforms)];
 
@@ -274,6 +284,7 @@ destroy_program_state (void *user_data,
         GE( ctx, glDeleteProgram (program_state->program) );
 
       g_free (program_state->unit_state);
+      g_free (program_state->binary_key);
 
       if (program_state->uniform_locations)
         g_array_free (program_state->uniform_locations, TRUE);
@@ -312,15 +323,12 @@ dirty_program_state (CoglPipeline *pipeline)
                              NULL);
 }
 
-static void
-link_program (GLint gl_program)
+static gboolean
+check_link_status (CoglContext *ctx,
+                   GLint        gl_program)
 {
   GLint link_status;
 
-  _COGL_GET_CONTEXT (ctx, NO_RETVAL);
-
-  GE( ctx, glLinkProgram (gl_program) );
-
   GE( ctx, glGetProgramiv (gl_program, GL_LINK_STATUS, &link_status) );
 
   if (!link_status)
@@ -341,6 +349,8 @@ link_program (GLint gl_program)
 
       g_free (log);
     }
+
+  return link_status;
 }
 
 typedef struct
@@ -709,18 +719,16 @@ _cogl_shader_compile_real (CoglHandle handle,
     }
 }
 
-static void
-_cogl_pipeline_progend_glsl_end (CoglPipeline *pipeline,
-                                 unsigned long pipelines_difference)
+static CoglPipelineProgramState *
+ensure_program (CoglPipeline *pipeline)
 {
   CoglPipelineProgramState *program_state;
-  GLuint gl_program;
-  gboolean program_changed = FALSE;
-  UpdateUniformsState state;
   CoglProgram *user_program;
   CoglPipelineCacheEntry *cache_entry = NULL;
 
-  _COGL_GET_CONTEXT (ctx, NO_RETVAL);
+  _COGL_GET_CONTEXT (ctx, NULL);
+
+  user_program = cogl_pipeline_get_user_program (pipeline);
 
   program_state = get_program_state (pipeline);
 
@@ -787,8 +795,11 @@ _cogl_pipeline_progend_glsl_end (CoglPipeline *pipeline,
 
   if (program_state->program == 0)
     {
+      GLuint backend_shaders[2];
+      int n_backend_shaders = 0;
       GLuint backend_shader;
       GSList *l;
+      int i;
 
       GE_RET( program_state->program, ctx, glCreateProgram () );
 
@@ -808,24 +819,153 @@ _cogl_pipeline_progend_glsl_end (CoglPipeline *pipeline,
           program_state->user_program_age = user_program->age;
         }
 
-      /* Attach any shaders from the GLSL backends */
       if ((backend_shader = _cogl_pipeline_fragend_glsl_get_shader (pipeline)))
-        GE( ctx, glAttachShader (program_state->program, backend_shader) );
+        backend_shaders[n_backend_shaders++] = backend_shader;
       if ((backend_shader = _cogl_pipeline_vertend_glsl_get_shader (pipeline)))
-        GE( ctx, glAttachShader (program_state->program, backend_shader) );
+        backend_shaders[n_backend_shaders++] = backend_shader;
+
+      /* Programs only made of backend generated shaders can be loaded
+       * from the on-disk binary cache instead of being linked */
+      if (!user_program &&
+          _cogl_has_private_feature (ctx, COGL_PRIVATE_FEATURE_PROGRAM_BINARY) &&
+          G_LIKELY (!(COGL_DEBUG_ENABLED (COGL_DEBUG_DISABLE_PROGRAM_CACHES))))
+        program_state->binary_key =
+          _cogl_program_binary_cache_get_key (ctx,
+                                              backend_shaders,
+                                              n_backend_shaders);
+
+      if (program_state->binary_key &&
+          _cogl_program_binary_cache_load (ctx,
+                                           program_state->program,
+                                           program_state->binary_key))
+        {
+          g_clear_pointer (&program_state->binary_key, g_free);
+        }
+      else
+        {
+          /* Attach any shaders from the GLSL backends */
+          for (i = 0; i < n_backend_shaders; i++)
+            GE( ctx, glAttachShader (program_state->program,
+                                     backend_shaders[i]) );
+
+          /* XXX: OpenGL as a special case requires the vertex position to
+           * be bound to generic attribute 0 so for simplicity we
+           * unconditionally bind the cogl_position_in attribute here...
+           */
+          GE( ctx, glBindAttribLocation (program_state->program,
+                                         0, "cogl_position_in"));
+
+          /* Some drivers only keep what is needed to return the binary
+           * when asked to before linking */
+          if (program_state->binary_key && ctx->glProgramParameteri)
+            GE( ctx, glProgramParameteri (program_state->program,
+                                          GL_PROGRAM_BINARY_RETRIEVABLE_HINT,
+                                          GL_TRUE) );
+
+          /* With parallel shader compilation the link happens on a
+           * driver thread so the status is only queried once it is
+           * needed, see finish_link() */
+          GE( ctx, glLinkProgram (program_state->program) );
+          program_state->link_pending = TRUE;
+        }
 
-      /* XXX: OpenGL as a special case requires the vertex position to
-       * be bound to generic attribute 0 so for simplicity we
-       * unconditionally bind the cogl_position_in attribute here...
-       */
-      GE( ctx, glBindAttribLocation (program_state->program,
-                                     0, "cogl_position_in"));
+      program_state->program_changed = TRUE;
+    }
+
+  return program_state;
+}
+
+static gboolean
+program_link_is_complete (CoglContext              *ctx,
+                          CoglPipelineProgramState *program_state)
+{
+  GLint completion_status;
+
+  if (!program_state->link_pending)
+    return TRUE;
+
+  if (!_cogl_has_private_feature (ctx,
+                                  COGL_PRIVATE_FEATURE_PARALLEL_SHADER_COMPILE))
+    return TRUE;
+
+  GE( ctx, glGetProgramiv (program_state->program,
+                           GL_COMPLETION_STATUS_KHR,
+                           &completion_status) );
+
+  return completion_status;
+}
 
-      link_program (program_state->program);
+static void
+finish_link (CoglContext              *ctx,
+             CoglPipeline             *pipeline,
+             CoglPipelineProgramState *program_state)
+{
+  GLuint shader;
+
+  if (!program_state->link_pending)
+    return;
+
+  program_state->link_pending = FALSE;
 
-      program_changed = TRUE;
+  if (check_link_status (ctx, program_state->program))
+    {
+      if (program_state->binary_key)
+        _cogl_program_binary_cache_store (ctx,
+                                          program_state->program,
+                                          program_state->binary_key);
+    }
+  else if (_cogl_has_private_feature (ctx,
+                                      COGL_PRIVATE_FEATURE_PARALLEL_SHADER_COMPILE))
+    {
+      /* The compile status of the generated shaders isn't checked
+       * when they are compiled in the background so report any errors
+       * now that we know something went wrong */
+      if ((shader = _cogl_pipeline_fragend_glsl_get_shader (pipeline)))
+        _cogl_glsl_shader_log_compile_error (ctx, shader);
+      if ((shader = _cogl_pipeline_vertend_glsl_get_shader (pipeline)))
+        _cogl_glsl_shader_log_compile_error (ctx, shader);
     }
 
+  g_clear_pointer (&program_state->binary_key, g_free);
+}
+
+gboolean
+_cogl_pipeline_progend_glsl_precompile (CoglPipeline *pipeline)
+{
+  CoglPipelineProgramState *program_state;
+
+  _COGL_GET_CONTEXT (ctx, TRUE);
+
+  program_state = ensure_program (pipeline);
+
+  if (!program_link_is_complete (ctx, program_state))
+    return FALSE;
+
+  finish_link (ctx, pipeline, program_state);
+
+  return TRUE;
+}
+
+static void
+_cogl_pipeline_progend_glsl_end (CoglPipeline *pipeline,
+                                 unsigned long pipelines_difference)
+{
+  CoglPipelineProgramState *program_state;
+  GLuint gl_program;
+  gboolean program_changed;
+  UpdateUniformsState state;
+  CoglProgram *user_program;
+
+  _COGL_GET_CONTEXT (ctx, NO_RETVAL);
+
+  program_state = ensure_program (pipeline);
+  finish_link (ctx, pipeline, program_state);
+
+  program_changed = program_state->program_changed;
+  program_state->program_changed = FALSE;
+
+  user_program = cogl_pipeline_get_user_program (pipeline);
+
   gl_program = program_state->program;
 
   if (ctx->current_gl_program != gl_program)
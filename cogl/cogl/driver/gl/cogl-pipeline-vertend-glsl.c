@@ -166,6 +166,22 @@ add_layer_fragment_boilerplate_cb (CoglPipelineLayer *layer,
   return TRUE;
 }
 
+void
+_cogl_glsl_shader_log_compile_error (CoglContext *ctx,
+                                     GLuint       shader_gl_handle)
+{
+  GLint len = 0;
+  char *shader_log;
+
+  GE( ctx, glGetShaderiv (shader_gl_handle, GL_INFO_LOG_LENGTH, &len) );
+  if (len <= 0)
+    return;
+
+  shader_log = g_alloca (len);
+  GE( ctx, glGetShaderInfoLog (shader_gl_handle, len, &len, shader_log) );
+  g_warning ("Shader compilation failed:\n%s", shader_log);
+}
+
 void
 _cogl_glsl_shader_set_source_with_boilerplate (CoglContext *ctx,
                                                GLuint shader_gl_handle,
@@ -178,8 +194,8 @@ _cogl_glsl_shader_set_source_with_boilerplate (CoglContext *ctx,
   const char *vertex_boilerplate;
   const char *fragment_boilerplate;
 
-  const char **strings = g_alloca (sizeof (char *) * (count_in + 4));
-  GLint *lengths = g_alloca (sizeof (GLint) * (count_in + 4));
+  const char **strings = g_alloca (sizeof (char *) * (count_in + 5));
+  GLint *lengths = g_alloca (sizeof (GLint) * (count_in + 5));
   char *version_string;
   int count = 0;
 
@@ -201,6 +217,18 @@ _cogl_glsl_shader_set_source_with_boilerplate (CoglContext *ctx,
       lengths[count++] = sizeof (image_external_extension) - 1;
     }
 
+  /* GLSL ES 1.00 only has the derivative functions with an extension
+   * so enable it to let fragment snippets use them */
+  if (shader_gl_type == GL_FRAGMENT_SHADER &&
+      ctx->driver == COGL_DRIVER_GLES2 &&
+      _cogl_has_private_feature (ctx, COGL_PRIVATE_FEATURE_SHADER_DERIVATIVES))
+    {
+      static const char derivatives_extension[] =
+        "#extension GL_OES_standard_derivatives : enable\n";
+      strings[count] = derivatives_extension;
+      lengths[count++] = sizeof (derivatives_extension) - 1;
+    }
+
   if (shader_gl_type == GL_VERTEX_SHADER)
     {
       strings[count] = vertex_boilerplate;
@@ -670,17 +698,16 @@ _cogl_pipeline_vertend_glsl_end (CoglPipeline *pipeline,
                                                      source_strings, lengths);
 
       GE( ctx, glCompileShader (shader) );
-      GE( ctx, glGetShaderiv (shader, GL_COMPILE_STATUS, &compile_status) );
 
-      if (!compile_status)
+      /* Querying the compile status would wait for the compilation to
+       * finish; with parallel compilation, errors are reported when
+       * linking instead. */
+      if (!_cogl_has_private_feature (ctx,
+                                      COGL_PRIVATE_FEATURE_PARALLEL_SHADER_COMPILE))
         {
-          GLint len = 0;
-          char *shader_log;
-
-          GE( ctx, glGetShaderiv (shader, GL_INFO_LOG_LENGTH, &len) );
-          shader_log = g_alloca (len);
-          GE( ctx, glGetShaderInfoLog (shader, len, &len, shader_log) );
-          g_warning ("Shader compilation failed:\n%s", shader_log);
+          GE( ctx, glGetShaderiv (shader, GL_COMPILE_STATUS, &compile_status) );
+          if (!compile_status)
+            _cogl_glsl_shader_log_compile_error (ctx, shader);
         }
 
       shader_state->header = NULL;
@@ -0,0 +1,491 @@
+/*
+ * Copyright (C) 2026 agent
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/*
+ * Persistent cache of linked GLSL programs.
+ *
+ * Linking the programs generated by the GLSL backends from source is one of
+ * the most expensive things happening when a pipeline is first used, and it
+ * happens again in every session. When the driver supports program binaries,
+ * the linked program is retrieved with glGetProgramBinary() and written to
+ * the user cache directory, keyed on the source of the attached shaders and
+ * on the driver identification strings. The next time a program with the
+ * same sources is needed, it is loaded with glProgramBinary() instead of
+ * being linked.
+ *
+ * The cache is cleared when the driver changes, and the least recently
+ * used binaries are evicted once it grows above
+ * PROGRAM_BINARY_CACHE_MAX_SIZE. As many programs are stored in a short
+ * time at startup, evicting is done at most once every
+ * PROGRAM_BINARY_CACHE_TRIM_INTERVAL_S seconds, after a binary was stored.
+ */
+
+#include "cogl-config.h"
+
+#include <errno.h>
+#include <gio/gio.h>
+#include <glib/gstdio.h>
+#include <string.h>
+
+#include "cogl/cogl-context-private.h"
+#include "cogl/driver/gl/cogl-program-binary-cache-private.h"
+#include "cogl/driver/gl/cogl-util-gl-private.h"
+
+/* Bump when the key or the file format changes */
+#define PROGRAM_BINARY_CACHE_VERSION 1
+
+/* Total size above which the least recently used binaries are evicted */
+#define PROGRAM_BINARY_CACHE_MAX_SIZE (32 * 1024 * 1024)
+
+/* Minimum time between two scans of the cache directory for eviction */
+#define PROGRAM_BINARY_CACHE_TRIM_INTERVAL_S 10
+
+static const char program_binary_magic[8] = "COGLPBIN";
+
+typedef struct
+{
+  char magic[8];
+  uint32_t format;
+  uint32_t length;
+} ProgramBinaryHeader;
+
+typedef struct
+{
+  char *path;
+  gint64 mtime;
+  goffset size;
+} ProgramBinaryEntry;
+
+static guint trim_cache_timeout_id;
+static gboolean trim_cache_running;
+
+static char *
+get_driver_id (CoglContext *ctx)
+{
+  return g_strdup_printf ("%d\n%s\n%s\n%s\n",
+                          PROGRAM_BINARY_CACHE_VERSION,
+                          (const char *) ctx->glGetString (GL_VENDOR),
+                          (const char *) ctx->glGetString (GL_RENDERER),
+                          (const char *) ctx->glGetString (GL_VERSION));
+}
+
+static void
+remove_binaries (const char *cache_dir)
+{
+  g_autoptr (GDir) dir = NULL;
+  const char *name;
+
+  dir = g_dir_open (cache_dir, 0, NULL);
+  if (!dir)
+    return;
+
+  while ((name = g_dir_read_name (dir)))
+    {
+      g_autofree char *path = NULL;
+
+      if (!g_str_has_suffix (name, ".bin"))
+        continue;
+
+      path = g_build_filename (cache_dir, name, NULL);
+      g_unlink (path);
+    }
+}
+
+static void
+ensure_driver_id (CoglContext *ctx,
+                  const char  *cache_dir)
+{
+  g_autofree char *driver_id = NULL;
+  g_autofree char *stored_driver_id = NULL;
+  g_autofree char *path = NULL;
+
+  driver_id = get_driver_id (ctx);
+  path = g_build_filename (cache_dir, "driver", NULL);
+
+  if (g_file_get_contents (path, &stored_driver_id, NULL, NULL) &&
+      g_strcmp0 (driver_id, stored_driver_id) == 0)
+    return;
+
+  /* The binaries of a different driver or renderer will never be loaded
+   * again, so don't let them take up space until they are evicted */
+  g_debug ("Driver changed, clearing program binary cache");
+  remove_binaries (cache_dir);
+  g_file_set_contents (path, driver_id, -1, NULL);
+}
+
+static const char *
+get_cache_dir (CoglContext *ctx)
+{
+  static char *cache_dir = NULL;
+  static gboolean initialized = FALSE;
+
+  if (!initialized)
+    {
+      g_autofree char *path = NULL;
+
+      initialized = TRUE;
+
+      path = g_build_filename (g_get_user_cache_dir (),
+                               "cogl",
+                               "program-binaries",
+                               NULL);
+      if (g_mkdir_with_parents (path, 0700) == 0)
+        {
+          ensure_driver_id (ctx, path);
+          cache_dir = g_steal_pointer (&path);
+        }
+      else
+        {
+          g_debug ("Not caching program binaries, failed to create %s: %s",
+                   path, g_strerror (errno));
+        }
+    }
+
+  return cache_dir;
+}
+
+static char *
+get_binary_path (CoglContext *ctx,
+                 const char  *key)
+{
+  const char *cache_dir = get_cache_dir (ctx);
+  g_autofree char *filename = NULL;
+
+  if (!cache_dir)
+    return NULL;
+
+  filename = g_strdup_printf ("%s.bin", key);
+  return g_build_filename (cache_dir, filename, NULL);
+}
+
+static void
+program_binary_entry_free (ProgramBinaryEntry *entry)
+{
+  g_free (entry->path);
+  g_free (entry);
+}
+
+static int
+compare_entry_age (gconstpointer a,
+                   gconstpointer b)
+{
+  const ProgramBinaryEntry *entry_a = *(const ProgramBinaryEntry **) a;
+  const ProgramBinaryEntry *entry_b = *(const ProgramBinaryEntry **) b;
+
+  if (entry_a->mtime < entry_b->mtime)
+    return -1;
+  else if (entry_a->mtime > entry_b->mtime)
+    return 1;
+  else
+    return 0;
+}
+
+static void
+trim_cache_dir (const char *cache_dir)
+{
+  g_autoptr (GPtrArray) entries = NULL;
+  g_autoptr (GDir) dir = NULL;
+  goffset total_size = 0;
+  const char *name;
+  unsigned int i;
+
+  dir = g_dir_open (cache_dir, 0, NULL);
+  if (!dir)
+    return;
+
+  entries = g_ptr_array_new_with_free_func (
+    (GDestroyNotify) program_binary_entry_free);
+
+  while ((name = g_dir_read_name (dir)))
+    {
+      ProgramBinaryEntry *entry;
+      GStatBuf stat_buf;
+      g_autofree char *path = NULL;
+
+      if (!g_str_has_suffix (name, ".bin"))
+        continue;
+
+      path = g_build_filename (cache_dir, name, NULL);
+      if (g_stat (path, &stat_buf) != 0)
+        continue;
+
+      entry = g_new0 (ProgramBinaryEntry, 1);
+      entry->path = g_steal_pointer (&path);
+      entry->mtime = stat_buf.st_mtime;
+      entry->size = stat_buf.st_size;
+      g_ptr_array_add (entries, entry);
+
+      total_size += entry->size;
+    }
+
+  if (total_size <= PROGRAM_BINARY_CACHE_MAX_SIZE)
+    return;
+
+  /* Loaded binaries get their modification time refreshed, so the oldest
+   * ones are the least recently used */
+  g_ptr_array_sort (entries, compare_entry_age);
+
+  for (i = 0;
+       i < entries->len && total_size > PROGRAM_BINARY_CACHE_MAX_SIZE;
+       i++)
+    {
+      ProgramBinaryEntry *entry = g_ptr_array_index (entries, i);
+
+      if (g_unlink (entry->path) == 0)
+        total_size -= entry->size;
+    }
+}
+
+static void
+trim_cache_thread (GTask        *task,
+                   gpointer      source_object,
+                   gpointer      task_data,
+                   GCancellable *cancellable)
+{
+  const char *cache_dir = task_data;
+
+  trim_cache_dir (cache_dir);
+  g_task_return_boolean (task, TRUE);
+}
+
+static void
+on_cache_trimmed (GObject      *source_object,
+                  GAsyncResult *result,
+                  gpointer      user_data)
+{
+  trim_cache_running = FALSE;
+}
+
+static gboolean
+trim_cache_timeout (gpointer user_data)
+{
+  const char *cache_dir = user_data;
+  g_autoptr (GTask) task = NULL;
+
+  /* Still scanning the directory since the last timeout; check again
+   * later rather than having two threads evict the same files */
+  if (trim_cache_running)
+    return G_SOURCE_CONTINUE;
+
+  trim_cache_timeout_id = 0;
+  trim_cache_running = TRUE;
+
+  task = g_task_new (NULL, NULL, on_cache_trimmed, NULL);
+  g_task_set_source_tag (task, trim_cache_timeout);
+  g_task_set_task_data (task, g_strdup (cache_dir), g_free);
+  g_task_run_in_thread (task, trim_cache_thread);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+trim_cache (const char *cache_dir)
+{
+  if (trim_cache_timeout_id)
+    return;
+
+  trim_cache_timeout_id =
+    g_timeout_add_seconds (PROGRAM_BINARY_CACHE_TRIM_INTERVAL_S,
+                           trim_cache_timeout,
+                           (gpointer) cache_dir);
+  g_source_set_name_by_id (trim_cache_timeout_id,
+                           "[cogl] Program binary cache trimming");
+}
+
+static void
+checksum_add_string (GChecksum  *checksum,
+                     const char *string)
+{
+  if (string)
+    g_checksum_update (checksum, (const guchar *) string, strlen (string));
+
+  /* Separator so that adjacent strings can't be confused */
+  g_checksum_update (checksum, (const guchar *) "", 1);
+}
+
+char *
+_cogl_program_binary_cache_get_key (CoglContext  *ctx,
+                                    const GLuint *gl_shaders,
+                                    int           n_shaders)
+{
+  g_autoptr (GChecksum) checksum = NULL;
+  g_autofree char *version = NULL;
+  int i;
+
+  checksum = g_checksum_new (G_CHECKSUM_SHA256);
+
+  version = g_strdup_printf ("%d", PROGRAM_BINARY_CACHE_VERSION);
+  checksum_add_string (checksum, version);
+
+  checksum_add_string (checksum, (const char *) ctx->glGetString (GL_VENDOR));
+  checksum_add_string (checksum, (const char *) ctx->glGetString (GL_RENDERER));
+  checksum_add_string (checksum, (const char *) ctx->glGetString (GL_VERSION));
+
+  for (i = 0; i < n_shaders; i++)
+    {
+      g_autofree char *source = NULL;
+      GLint source_length = 0;
+      GLsizei length = 0;
+
+      GE (ctx, glGetShaderiv (gl_shaders[i],
+                              GL_SHADER_SOURCE_LENGTH,
+                              &source_length));
+      if (source_length <= 0)
+        return NULL;
+
+      source = g_malloc (source_length);
+      GE (ctx, glGetShaderSource (gl_shaders[i], source_length,
+                                  &length, source));
+      g_checksum_update (checksum, (const guchar *) source, length);
+      g_checksum_update (checksum, (const guchar *) "", 1);
+    }
+
+  return g_strdup (g_checksum_get_string (checksum));
+}
+
+gboolean
+_cogl_program_binary_cache_load (CoglContext *ctx,
+                                 GLuint       gl_program,
+                                 const char  *key)
+{
+  g_autofree char *path = NULL;
+  g_autofree char *contents = NULL;
+  ProgramBinaryHeader header;
+  GLint link_status = GL_FALSE;
+  gsize length;
+
+  path = get_binary_path (ctx, key);
+  if (!path)
+    return FALSE;
+
+  if (!g_file_get_contents (path, &contents, &length, NULL))
+    return FALSE;
+
+  if (length < sizeof (header))
+    goto invalid;
+
+  memcpy (&header, contents, sizeof (header));
+  if (memcmp (header.magic, program_binary_magic, sizeof (header.magic)) != 0 ||
+      header.length != length - sizeof (header))
+    goto invalid;
+
+  GE (ctx, glProgramBinary (gl_program,
+                            header.format,
+                            contents + sizeof (header),
+                            header.length));
+  GE (ctx, glGetProgramiv (gl_program, GL_LINK_STATUS, &link_status));
+
+  if (link_status)
+    {
+      /* Refresh the modification time to mark the binary as recently
+       * used for trim_cache() */
+      g_utime (path, NULL);
+      return TRUE;
+    }
+
+invalid:
+  /* The driver rejected the binary, e.g. because it was updated without
+   * changing its version string, or the file is corrupt. Drop it so that
+   * it gets replaced by a freshly linked program. */
+  g_debug ("Discarding stale program binary %s", path);
+  g_unlink (path);
+
+  return FALSE;
+}
+
+static void
+on_binary_stored (GObject      *source_object,
+                  GAsyncResult *result,
+                  gpointer      user_data)
+{
+  const char *cache_dir = user_data;
+  g_autoptr (GError) error = NULL;
+
+  if (!g_file_replace_contents_finish (G_FILE (source_object), result,
+                                       NULL, &error))
+    {
+      g_debug ("Failed to store program binary: %s", error->message);
+      return;
+    }
+
+  trim_cache (cache_dir);
+}
+
+void
+_cogl_program_binary_cache_store (CoglContext *ctx,
+                                  GLuint       gl_program,
+                                  const char  *key)
+{
+  g_autofree char *path = NULL;
+  g_autoptr (GFile) file = NULL;
+  g_autoptr (GBytes) bytes = NULL;
+  ProgramBinaryHeader header;
+  GLint binary_length = 0;
+  GLsizei length = 0;
+  GLenum format = 0;
+  char *contents;
+
+  path = get_binary_path (ctx, key);
+  if (!path)
+    return;
+
+  GE (ctx, glGetProgramiv (gl_program, GL_PROGRAM_BINARY_LENGTH,
+                           &binary_length));
+  if (binary_length <= 0)
+    return;
+
+  contents = g_malloc (sizeof (header) + binary_length);
+  GE (ctx, glGetProgramBinary (gl_program,
+                               binary_length,
+                               &length,
+                               &format,
+                               contents + sizeof (header)));
+  if (length <= 0)
+    {
+      g_free (contents);
+      return;
+    }
+
+  memcpy (header.magic, program_binary_magic, sizeof (header.magic));
+  header.format = format;
+  header.length = length;
+  memcpy (contents, &header, sizeof (header));
+
+  bytes = g_bytes_new_take (contents, sizeof (header) + length);
+
+  /* Written asynchronously to not block painting on disk I/O; the
+   * replacement is atomic, so concurrent readers never see partial
+   * files. */
+  file = g_file_new_for_path (path);
+  g_file_replace_contents_bytes_async (file,
+                                       bytes,
+                                       NULL,
+                                       FALSE,
+                                       G_FILE_CREATE_PRIVATE,
+                                       NULL,
+                                       on_binary_stored,
+                                       (gpointer) get_cache_dir (ctx));
+}
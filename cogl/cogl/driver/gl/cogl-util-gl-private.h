@@ -226,6 +226,21 @@ cogl_gl_get_gpu_time_ns (CoglContext *context);
 #ifndef GL_PACK_REVERSE_ROW_ORDER_ANGLE
 #define GL_PACK_REVERSE_ROW_ORDER_ANGLE 0x93A4
 #endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+#ifndef GL_SHADER_SOURCE_LENGTH
+#define GL_SHADER_SOURCE_LENGTH 0x8B88
+#endif
 #ifndef GL_BACK_LEFT
 #define GL_BACK_LEFT				0x0402
 #endif
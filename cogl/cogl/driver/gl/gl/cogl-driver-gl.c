@@ -598,6 +598,33 @@ _cogl_driver_update_features (CoglContext *ctx,
   if (ctx->glGenQueries && ctx->glQueryCounter && ctx->glGetInteger64v)
     COGL_FLAGS_SET (ctx->features, COGL_FEATURE_ID_TIMESTAMP_QUERY, TRUE);
 
+  if (ctx->glGetProgramBinary && ctx->glProgramBinary)
+    {
+      GLint n_binary_formats = 0;
+
+      GE (ctx, glGetIntegerv (GL_NUM_PROGRAM_BINARY_FORMATS,
+                              &n_binary_formats));
+      if (n_binary_formats > 0)
+        COGL_FLAGS_SET (private_features,
+                        COGL_PRIVATE_FEATURE_PROGRAM_BINARY, TRUE);
+    }
+
+  if (ctx->glMaxShaderCompilerThreads)
+    {
+      /* Let the driver pick the number of compiler threads */
+      GE (ctx, glMaxShaderCompilerThreads (0xffffffff));
+      COGL_FLAGS_SET (private_features,
+                      COGL_PRIVATE_FEATURE_PARALLEL_SHADER_COMPILE, TRUE);
+    }
+
+  if (ctx->glVertexAttribDivisor && ctx->glDrawArraysInstanced)
+    COGL_FLAGS_SET (private_features,
+                    COGL_PRIVATE_FEATURE_INSTANCED_ARRAYS, TRUE);
+
+  /* fwidth() and friends are part of GLSL 1.20 */
+  COGL_FLAGS_SET (private_features,
+                  COGL_PRIVATE_FEATURE_SHADER_DERIVATIVES, TRUE);
+
   /* Cache features */
   for (i = 0; i < G_N_ELEMENTS (private_features); i++)
     ctx->private_features[i] |= private_features[i];
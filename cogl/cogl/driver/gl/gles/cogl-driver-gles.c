@@ -475,9 +475,36 @@ _cogl_driver_update_features (CoglContext *context,
                       COGL_PRIVATE_FEATURE_TEXTURE_LOD_BIAS, TRUE);
     }
 
+  if (_cogl_check_extension ("GL_OES_standard_derivatives", gl_extensions))
+    COGL_FLAGS_SET (private_features,
+                    COGL_PRIVATE_FEATURE_SHADER_DERIVATIVES, TRUE);
+
   if (context->glGenQueries && context->glQueryCounter && context->glGetInteger64v)
     COGL_FLAGS_SET (context->features, COGL_FEATURE_ID_TIMESTAMP_QUERY, TRUE);
 
+  if (context->glGetProgramBinary && context->glProgramBinary)
+    {
+      GLint n_binary_formats = 0;
+
+      GE (context, glGetIntegerv (GL_NUM_PROGRAM_BINARY_FORMATS,
+                                  &n_binary_formats));
+      if (n_binary_formats > 0)
+        COGL_FLAGS_SET (private_features,
+                        COGL_PRIVATE_FEATURE_PROGRAM_BINARY, TRUE);
+    }
+
+  if (context->glMaxShaderCompilerThreads)
+    {
+      /* Let the driver pick the number of compiler threads */
+      GE (context, glMaxShaderCompilerThreads (0xffffffff));
+      COGL_FLAGS_SET (private_features,
+                      COGL_PRIVATE_FEATURE_PARALLEL_SHADER_COMPILE, TRUE);
+    }
+
+  if (context->glVertexAttribDivisor && context->glDrawArraysInstanced)
+    COGL_FLAGS_SET (private_features,
+                    COGL_PRIVATE_FEATURE_INSTANCED_ARRAYS, TRUE);
+
   if (!g_strcmp0 ((char *) context->glGetString (GL_RENDERER), "Mali-400 MP"))
     {
       COGL_FLAGS_SET (private_features,
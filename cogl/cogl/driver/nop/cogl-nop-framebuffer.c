@@ -95,6 +95,19 @@ cogl_nop_framebuffer_draw_indexed_attributes (CoglFramebufferDriver *driver,
 {
 }
 
+static void
+cogl_nop_framebuffer_draw_instanced_attributes (CoglFramebufferDriver *driver,
+                                                CoglPipeline          *pipeline,
+                                                CoglVerticesMode       mode,
+                                                int                    first_vertex,
+                                                int                    n_vertices,
+                                                int                    n_instances,
+                                                CoglAttribute        **attributes,
+                                                int                    n_attributes,
+                                                CoglDrawFlags          flags)
+{
+}
+
 static gboolean
 cogl_nop_framebuffer_read_pixels_into_bitmap (CoglFramebufferDriver  *framebuffer,
                                               int                     x,
@@ -125,6 +138,8 @@ cogl_nop_framebuffer_class_init (CoglNopFramebufferClass *klass)
   driver_class->draw_attributes = cogl_nop_framebuffer_draw_attributes;
   driver_class->draw_indexed_attributes =
     cogl_nop_framebuffer_draw_indexed_attributes;
+  driver_class->draw_instanced_attributes =
+    cogl_nop_framebuffer_draw_instanced_attributes;
   driver_class->read_pixels_into_bitmap =
     cogl_nop_framebuffer_read_pixels_into_bitmap;
 }
@@ -279,3 +279,53 @@ COGL_EXT_FUNCTION (void, glGenQueries,
 COGL_EXT_FUNCTION (void, glDeleteQueries,
                    (GLsizei n, const GLuint *ids))
 COGL_EXT_END ()
+
+COGL_EXT_BEGIN (get_program_binary, 4, 1,
+                COGL_EXT_IN_GLES3,
+                "ARB:\0OES\0",
+                "get_program_binary\0")
+COGL_EXT_FUNCTION (void, glGetProgramBinary,
+                   (GLuint program,
+                    GLsizei bufSize,
+                    GLsizei *length,
+                    GLenum *binaryFormat,
+                    void *binary))
+COGL_EXT_FUNCTION (void, glProgramBinary,
+                   (GLuint program,
+                    GLenum binaryFormat,
+                    const void *binary,
+                    GLsizei length))
+COGL_EXT_END ()
+
+/* Not part of GL_OES_get_program_binary, so kept separate to not
+ * disable program binaries on GLES 2 drivers lacking it */
+COGL_EXT_BEGIN (program_parameteri, 4, 1,
+                COGL_EXT_IN_GLES3,
+                "ARB:\0",
+                "get_program_binary\0")
+COGL_EXT_FUNCTION (void, glProgramParameteri,
+                   (GLuint program,
+                    GLenum pname,
+                    GLint value))
+COGL_EXT_END ()
+
+COGL_EXT_BEGIN (parallel_shader_compile, 255, 255,
+                0,
+                "KHR\0ARB\0",
+                "parallel_shader_compile\0")
+COGL_EXT_FUNCTION (void, glMaxShaderCompilerThreads,
+                   (GLuint count))
+COGL_EXT_END ()
+
+COGL_EXT_BEGIN (instanced_arrays, 3, 3,
+                COGL_EXT_IN_GLES3,
+                "\0",
+                "\0")
+COGL_EXT_FUNCTION (void, glVertexAttribDivisor,
+                   (GLuint index, GLuint divisor))
+COGL_EXT_FUNCTION (void, glDrawArraysInstanced,
+                   (GLenum mode,
+                    GLint first,
+                    GLsizei count,
+                    GLsizei instancecount))
+COGL_EXT_END ()
@@ -158,6 +158,17 @@ COGL_WINSYS_FEATURE_FUNCTION (EGLBoolean, eglDestroySync,
 COGL_WINSYS_FEATURE_END ()
 #endif
 
+#ifdef EGL_ANDROID_native_fence_sync
+COGL_WINSYS_FEATURE_BEGIN (native_fence_sync,
+                           "ANDROID\0",
+                           "native_fence_sync\0",
+                           COGL_EGL_WINSYS_FEATURE_NATIVE_FENCE_SYNC)
+COGL_WINSYS_FEATURE_FUNCTION (EGLint, eglDupNativeFenceFDANDROID,
+                              (EGLDisplay dpy,
+                               EGLSyncKHR sync))
+COGL_WINSYS_FEATURE_END ()
+#endif
+
 COGL_WINSYS_FEATURE_BEGIN (surfaceless_context,
                            "KHR\0",
                            "surfaceless_context\0",
@@ -101,6 +101,7 @@ typedef enum _CoglEGLWinsysFeature
   COGL_EGL_WINSYS_FEATURE_FENCE_SYNC                    =1L<<5,
   COGL_EGL_WINSYS_FEATURE_SURFACELESS_CONTEXT           =1L<<6,
   COGL_EGL_WINSYS_FEATURE_CONTEXT_PRIORITY              =1L<<7,
+  COGL_EGL_WINSYS_FEATURE_NATIVE_FENCE_SYNC             =1L<<8,
 } CoglEGLWinsysFeature;
 
 typedef struct _CoglRendererEGL
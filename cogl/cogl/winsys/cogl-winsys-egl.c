@@ -616,6 +616,38 @@ _cogl_winsys_fence_destroy (CoglContext *context, void *fence)
 }
 #endif
 
+#ifdef EGL_ANDROID_native_fence_sync
+static int
+_cogl_winsys_context_get_latest_sync_fd (CoglContext *context)
+{
+  CoglRendererEGL *renderer = context->display->renderer->winsys;
+  EGLSyncKHR sync;
+  int fd;
+
+  if (!(renderer->private_features &
+        COGL_EGL_WINSYS_FEATURE_NATIVE_FENCE_SYNC) ||
+      !renderer->pf_eglCreateSync)
+    return -1;
+
+  sync = renderer->pf_eglCreateSync (renderer->edpy,
+                                     EGL_SYNC_NATIVE_FENCE_ANDROID,
+                                     NULL);
+  if (sync == EGL_NO_SYNC_KHR)
+    return -1;
+
+  /* The fence only gets a file descriptor once it has been flushed */
+  context->glFlush ();
+
+  fd = renderer->pf_eglDupNativeFenceFDANDROID (renderer->edpy, sync);
+  renderer->pf_eglDestroySync (renderer->edpy, sync);
+
+  if (fd == EGL_NO_NATIVE_FENCE_FD_ANDROID)
+    return -1;
+
+  return fd;
+}
+#endif
+
 static CoglWinsysVtable _cogl_winsys_vtable =
   {
     .constraints = COGL_RENDERER_CONSTRAINT_USES_EGL,
@@ -636,6 +668,9 @@ static CoglWinsysVtable _cogl_winsys_vtable =
     .fence_add = _cogl_winsys_fence_add,
     .fence_is_complete = _cogl_winsys_fence_is_complete,
     .fence_destroy = _cogl_winsys_fence_destroy,
+#endif
+#ifdef EGL_ANDROID_native_fence_sync
+    .context_get_latest_sync_fd = _cogl_winsys_context_get_latest_sync_fd,
 #endif
   };
 
@@ -211,5 +211,7 @@ gboolean meta_backend_is_hw_cursors_inhibited (MetaBackend *backend);
 void meta_backend_update_from_event (MetaBackend  *backend,
                                      ClutterEvent *event);
 
+gboolean meta_backend_dispatch_pending_events (MetaBackend *backend);
+
 char * meta_backend_get_vendor_name (MetaBackend *backend,
                                      const char  *pnp_id);
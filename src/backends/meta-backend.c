@@ -1111,6 +1111,24 @@ dispatch_clutter_event (MetaBackend *backend)
   return FALSE;
 }
 
+/*
+ * Dispatches all events queued so far, without going through the main loop.
+ * Events from the input thread are queued while the main thread is busy,
+ * e.g. updating the stage, and would otherwise wait until it is done.
+ *
+ * Returns whether any event was dispatched.
+ */
+gboolean
+meta_backend_dispatch_pending_events (MetaBackend *backend)
+{
+  gboolean dispatched = FALSE;
+
+  while (dispatch_clutter_event (backend))
+    dispatched = TRUE;
+
+  return dispatched;
+}
+
 /* Mutter is responsible for pulling events off the X queue, so Clutter
  * doesn't need (and shouldn't) run its normal event source which polls
  * the X fd, but we do have to deal with dispatching events that accumulate
@@ -1244,11 +1262,7 @@ meta_backend_initable_init (GInitable     *initable,
 
   meta_backend_post_init (backend);
 
-  while (TRUE)
-    {
-      if (!dispatch_clutter_event (backend))
-        break;
-    }
+  meta_backend_dispatch_pending_events (backend);
   _clutter_stage_process_queued_events (CLUTTER_STAGE (priv->stage));
 
   priv->in_init = FALSE;
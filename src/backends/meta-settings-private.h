@@ -35,6 +35,8 @@ typedef enum _MetaExperimentalFeature
   META_EXPERIMENTAL_FEATURE_RT_SCHEDULER = (1 << 2),
   META_EXPERIMENTAL_FEATURE_AUTOCLOSE_XWAYLAND = (1 << 3),
   META_EXPERIMENTAL_FEATURE_VARIABLE_REFRESH_RATE = (1 << 4),
+  META_EXPERIMENTAL_FEATURE_SHM_UDMABUF = (1 << 5),
+  META_EXPERIMENTAL_FEATURE_EARLY_INPUT_DELIVERY = (1 << 6),
 } MetaExperimentalFeature;
 
 typedef enum _MetaXwaylandExtension
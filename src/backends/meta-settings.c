@@ -300,6 +300,10 @@ experimental_features_handler (GVariant *features_variant,
         feature = META_EXPERIMENTAL_FEATURE_AUTOCLOSE_XWAYLAND;
       else if (g_str_equal (feature_str, "variable-refresh-rate"))
         feature = META_EXPERIMENTAL_FEATURE_VARIABLE_REFRESH_RATE;
+      else if (g_str_equal (feature_str, "shm-udmabuf"))
+        feature = META_EXPERIMENTAL_FEATURE_SHM_UDMABUF;
+      else if (g_str_equal (feature_str, "early-input-delivery"))
+        feature = META_EXPERIMENTAL_FEATURE_EARLY_INPUT_DELIVERY;
 
       if (feature)
         g_message ("Enabling experimental feature '%s'", feature_str);
@@ -40,6 +40,11 @@
 
 #define MAX_STACK_RECTS 256
 
+/* Regions with more rectangles than this end up being clipped using the
+ * stencil buffer and make FB_DAMAGE_CLIPS and swap region handling more
+ * expensive; grow them slightly rather than passing them on fragmented. */
+#define MAX_FB_CLIP_RECTANGLES 16
+
 typedef struct _MetaStageImplPrivate
 {
   MetaBackend *backend;
@@ -562,6 +567,7 @@ meta_stage_impl_redraw_view_primary (MetaStageImpl    *stage_impl,
                                                       -view_rect.x,
                                                       -view_rect.y,
                                                       fb_scale);
+      clutter_util_region_coalesce (&fb_clip_region, MAX_FB_CLIP_RECTANGLES);
 
       if (G_UNLIKELY (paint_debug_flags & CLUTTER_DEBUG_PAINT_DAMAGE_REGION))
         {
@@ -624,6 +630,8 @@ meta_stage_impl_redraw_view_primary (MetaStageImpl    *stage_impl,
                 clutter_damage_history_lookup (damage_history, age);
               cairo_region_union (fb_clip_region, old_damage);
             }
+          clutter_util_region_coalesce (&fb_clip_region,
+                                        MAX_FB_CLIP_RECTANGLES);
 
           meta_topic (META_DEBUG_BACKEND,
                       "Reusing back buffer(age=%d) - repairing region: num rects: %d",
@@ -118,24 +118,15 @@ update_scanout_candidate (MetaCompositorViewNative *view_native,
 }
 
 static gboolean
-find_scanout_candidate (MetaCompositorView  *compositor_view,
-                        MetaCompositor      *compositor,
-                        MetaCrtc           **crtc_out,
-                        CoglOnscreen       **onscreen_out,
-                        MetaWaylandSurface **surface_out)
+find_scanout_target (MetaCompositorView  *compositor_view,
+                     MetaCompositor      *compositor,
+                     MetaCrtc           **crtc_out,
+                     CoglOnscreen       **onscreen_out)
 {
   ClutterStageView *stage_view;
   MetaRendererView *renderer_view;
   MetaCrtc *crtc;
   CoglFramebuffer *framebuffer;
-  MetaWindowActor *window_actor;
-  MetaWindow *window;
-  MetaRectangle view_rect;
-  ClutterActorBox actor_box;
-  MetaSurfaceActor *surface_actor;
-  MetaSurfaceActorWayland *surface_actor_wayland;
-  MetaWaylandSurface *surface;
-  int geometry_scale;
 
   if (meta_compositor_is_unredirect_inhibited (compositor))
     {
@@ -170,6 +161,30 @@ find_scanout_candidate (MetaCompositorView  *compositor_view,
       return FALSE;
     }
 
+  *crtc_out = crtc;
+  *onscreen_out = COGL_ONSCREEN (framebuffer);
+
+  return TRUE;
+}
+
+static gboolean
+find_scanout_candidate (MetaCompositorView  *compositor_view,
+                        MetaWaylandSurface **surface_out)
+{
+  ClutterStageView *stage_view;
+  MetaRendererView *renderer_view;
+  MetaWindowActor *window_actor;
+  MetaWindow *window;
+  MetaRectangle view_rect;
+  ClutterActorBox actor_box;
+  MetaSurfaceActor *surface_actor;
+  MetaSurfaceActorWayland *surface_actor_wayland;
+  MetaWaylandSurface *surface;
+  int geometry_scale;
+
+  stage_view = meta_compositor_view_get_stage_view (compositor_view);
+  renderer_view = META_RENDERER_VIEW (stage_view);
+
   window_actor = meta_compositor_view_get_top_window_actor (compositor_view);
   if (!window_actor)
     {
@@ -263,13 +278,47 @@ find_scanout_candidate (MetaCompositorView  *compositor_view,
       return FALSE;
     }
 
-  *crtc_out = crtc;
-  *onscreen_out = COGL_ONSCREEN (framebuffer);
   *surface_out = surface;
 
   return TRUE;
 }
 
+/*
+ * The surface of a fullscreen window which isn't a direct scanout candidate
+ * yet, e.g. while it is still being animated, but likely will be soon. It
+ * gets scanout feedback already, so its client can allocate suitable buffers
+ * in advance.
+ */
+static MetaWaylandSurface *
+find_likely_scanout_candidate (MetaCompositorView *compositor_view)
+{
+  ClutterStageView *stage_view;
+  MetaWindowActor *window_actor;
+  MetaWindow *window;
+  MetaRectangle view_layout;
+  MetaSurfaceActor *surface_actor;
+
+  window_actor = meta_compositor_view_get_top_window_actor (compositor_view);
+  if (!window_actor)
+    return NULL;
+
+  window = meta_window_actor_get_meta_window (window_actor);
+  if (!window || !meta_window_is_fullscreen (window))
+    return NULL;
+
+  stage_view = meta_compositor_view_get_stage_view (compositor_view);
+  clutter_stage_view_get_layout (stage_view, &view_layout);
+
+  if (!meta_window_frame_contains_rect (window, &view_layout))
+    return NULL;
+
+  surface_actor = meta_window_actor_get_scanout_candidate (window_actor);
+  if (!surface_actor)
+    return NULL;
+
+  return meta_surface_actor_wayland_get_surface (META_SURFACE_ACTOR_WAYLAND (surface_actor));
+}
+
 static void
 try_assign_next_scanout (MetaCompositorView *compositor_view,
                          CoglOnscreen       *onscreen,
@@ -300,19 +349,23 @@ meta_compositor_view_native_maybe_assign_scanout (MetaCompositorViewNative *view
   MetaCrtc *crtc = NULL;
   CoglOnscreen *onscreen = NULL;
   MetaWaylandSurface *surface = NULL;
-  gboolean candidate_found;
 
-  candidate_found = find_scanout_candidate (compositor_view,
-                                            compositor,
-                                            &crtc,
-                                            &onscreen,
-                                            &surface);
-  if (candidate_found)
+  if (!find_scanout_target (compositor_view, compositor, &crtc, &onscreen))
+    {
+      update_scanout_candidate (view_native, NULL, NULL);
+      return;
+    }
+
+  if (find_scanout_candidate (compositor_view, &surface))
     {
       try_assign_next_scanout (compositor_view,
                                onscreen,
                                surface);
     }
+  else
+    {
+      surface = find_likely_scanout_candidate (compositor_view);
+    }
 
   update_scanout_candidate (view_native, surface, crtc);
 }
@@ -163,6 +163,48 @@ meta_surface_actor_wayland_is_view_primary (MetaSurfaceActor *actor,
   return current_primary_view == stage_view;
 }
 
+#define MOSTLY_OBSCURED_FRAME_DIVISOR 4
+#define HIDDEN_FRAME_CALLBACK_INTERVAL_US G_USEC_PER_SEC
+
+/*
+ * Returns the minimum interval between frame callbacks of the surface on
+ * its primary view, or 0 if they are not throttled. Surfaces of which only a
+ * sliver is visible get a fraction of the refresh rate, and surfaces not
+ * visible on any view (@stage_view being %NULL) get 1 Hz.
+ */
+int64_t
+meta_surface_actor_wayland_get_frame_callback_interval_us (MetaSurfaceActor *actor,
+                                                           ClutterStageView *stage_view)
+{
+  MetaWindowActor *window_actor;
+  float unobscured_fraction = 1.f;
+  float refresh_rate;
+
+  if (!stage_view)
+    return HIDDEN_FRAME_CALLBACK_INTERVAL_US;
+
+  /* Clones and screen casts show the surface beyond what is visible here */
+  window_actor = meta_window_actor_from_actor (CLUTTER_ACTOR (actor));
+  if (clutter_actor_has_mapped_clones (CLUTTER_ACTOR (actor)) ||
+      (window_actor && meta_window_actor_is_streaming (window_actor)))
+    return 0;
+
+  if (meta_surface_actor_is_obscured_on_stage_view (actor,
+                                                    stage_view,
+                                                    &unobscured_fraction))
+    return HIDDEN_FRAME_CALLBACK_INTERVAL_US;
+
+  if (unobscured_fraction >= UNOBSCURED_THRESHOLD)
+    return 0;
+
+  refresh_rate = clutter_stage_view_get_refresh_rate (stage_view);
+  if (refresh_rate <= 0.f)
+    return 0;
+
+  return (int64_t) (MOSTLY_OBSCURED_FRAME_DIVISOR * G_USEC_PER_SEC /
+                    refresh_rate);
+}
+
 static void
 meta_surface_actor_wayland_apply_transform (ClutterActor      *actor,
                                             graphene_matrix_t *matrix)
@@ -46,4 +46,7 @@ void meta_surface_actor_wayland_surface_destroyed (MetaSurfaceActorWayland *self
 gboolean meta_surface_actor_wayland_is_view_primary (MetaSurfaceActor *actor,
                                                      ClutterStageView *stage_view);
 
+int64_t meta_surface_actor_wayland_get_frame_callback_interval_us (MetaSurfaceActor *actor,
+                                                                   ClutterStageView *stage_view);
+
 G_END_DECLS
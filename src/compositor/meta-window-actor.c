@@ -535,6 +535,8 @@ meta_window_actor_constructed (GObject *object)
   /* Hang our compositor window state off the MetaWindow for fast retrieval */
   meta_window_set_compositor_private (window, object);
 
+  clutter_actor_set_gpu_timing_label (CLUTTER_ACTOR (self), window->desc);
+
   init_surface_actor (self);
 
   meta_window_actor_update_opacity (self);
@@ -26,6 +26,7 @@
 #include <gio/gunixfdlist.h>
 
 #include "cogl/cogl.h"
+#include "meta/util.h"
 
 #define META_SYSPROF_PROFILER_DBUS_PATH "/org/gnome/Sysprof3/Profiler"
 
@@ -44,11 +45,24 @@ struct _MetaProfiler
 
   gboolean persistent;
   gboolean running;
+  gboolean gpu_timings;
+  gboolean wayland_protocol;
 
   GMutex mutex;
   GList *threads;
 };
 
+enum
+{
+  PROP_0,
+
+  PROP_WAYLAND_PROTOCOL,
+
+  N_PROPS
+};
+
+static GParamSpec *obj_props[N_PROPS];
+
 static void
 meta_sysprof_capturer_init_iface (MetaDBusSysprof3ProfilerIface *iface);
 
@@ -137,6 +151,19 @@ handle_start (MetaDBusSysprof3Profiler *dbus_profiler,
 
   cogl_set_tracing_enabled_on_thread (main_context, group_name);
 
+  /* Per actor GPU timings need a timestamp query pair around each measured
+   * actor, so they are only collected when explicitly asked for. */
+  if (g_variant_lookup (options, "gpu-timings", "b", &profiler->gpu_timings) &&
+      profiler->gpu_timings)
+    meta_add_clutter_debug_flags (0, CLUTTER_DEBUG_PAINT_GPU_TIMINGS, 0);
+
+  /* Same for marks for each handled Wayland request. */
+  if (g_variant_lookup (options, "wayland-protocol", "b",
+                        &profiler->wayland_protocol) &&
+      profiler->wayland_protocol)
+    g_object_notify_by_pspec (G_OBJECT (profiler),
+                              obj_props[PROP_WAYLAND_PROTOCOL]);
+
   g_mutex_lock (&profiler->mutex);
   for (l = profiler->threads; l; l = l->next)
     {
@@ -184,6 +211,19 @@ handle_stop (MetaDBusSysprof3Profiler *dbus_profiler,
       return TRUE;
     }
 
+  if (profiler->gpu_timings)
+    {
+      meta_remove_clutter_debug_flags (0, CLUTTER_DEBUG_PAINT_GPU_TIMINGS, 0);
+      profiler->gpu_timings = FALSE;
+    }
+
+  if (profiler->wayland_protocol)
+    {
+      profiler->wayland_protocol = FALSE;
+      g_object_notify_by_pspec (G_OBJECT (profiler),
+                                obj_props[PROP_WAYLAND_PROTOCOL]);
+    }
+
   cogl_set_tracing_disabled_on_thread (g_main_context_default ());
 
   g_mutex_lock (&profiler->mutex);
@@ -264,12 +304,40 @@ meta_profiler_finalize (GObject *object)
   G_OBJECT_CLASS (meta_profiler_parent_class)->finalize (object);
 }
 
+static void
+meta_profiler_get_property (GObject    *object,
+                            guint       prop_id,
+                            GValue     *value,
+                            GParamSpec *pspec)
+{
+  MetaProfiler *profiler = META_PROFILER (object);
+
+  switch (prop_id)
+    {
+    case PROP_WAYLAND_PROTOCOL:
+      g_value_set_boolean (value, profiler->wayland_protocol);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+    }
+}
+
 static void
 meta_profiler_class_init (MetaProfilerClass *klass)
 {
   GObjectClass *object_class = G_OBJECT_CLASS (klass);
 
+  object_class->get_property = meta_profiler_get_property;
   object_class->finalize = meta_profiler_finalize;
+
+  obj_props[PROP_WAYLAND_PROTOCOL] =
+    g_param_spec_boolean ("wayland-protocol", NULL, NULL,
+                          FALSE,
+                          G_PARAM_READABLE |
+                          G_PARAM_EXPLICIT_NOTIFY |
+                          G_PARAM_STATIC_STRINGS);
+  g_object_class_install_properties (object_class, N_PROPS, obj_props);
 }
 
 static void
@@ -316,6 +384,12 @@ meta_profiler_new (const char *trace_file)
   return profiler;
 }
 
+gboolean
+meta_profiler_is_tracing_wayland_protocol (MetaProfiler *profiler)
+{
+  return profiler->wayland_protocol;
+}
+
 void
 meta_profiler_register_thread (MetaProfiler *profiler,
                                GMainContext *main_context,
@@ -35,6 +35,8 @@ G_DECLARE_FINAL_TYPE (MetaProfiler,
 
 MetaProfiler * meta_profiler_new (const char *trace_file);
 
+gboolean meta_profiler_is_tracing_wayland_protocol (MetaProfiler *profiler);
+
 void meta_profiler_register_thread (MetaProfiler *profiler,
                                     GMainContext *main_context,
                                     const char   *name);
@@ -481,6 +481,209 @@ frame_clock_schedule_update_now (void)
   g_source_unref (source);
 }
 
+typedef enum _UpdateAtTestCase
+{
+  UPDATE_AT_TEST_CASE_TARGET,
+  UPDATE_AT_TEST_CASE_FAR_TARGET,
+  UPDATE_AT_TEST_CASE_REGULAR_UPDATE,
+} UpdateAtTestCase;
+
+typedef struct _UpdateAtFrameClockTest
+{
+  FrameClockTest base;
+  UpdateAtTestCase test_case;
+  int64_t request_time_us;
+  int64_t requested_presentation_time_us;
+} UpdateAtFrameClockTest;
+
+static ClutterFrameResult
+update_at_frame_clock_frame (ClutterFrameClock *frame_clock,
+                             ClutterFrame      *frame,
+                             gpointer           user_data)
+{
+  UpdateAtFrameClockTest *test = user_data;
+  int64_t target_presentation_time_us;
+
+  test->base.fake_hw_clock->has_pending_present = TRUE;
+
+  /* The first frame gives a presentation time to align to */
+  if (!test->requested_presentation_time_us)
+    {
+      int n_cycles;
+
+      if (test->test_case == UPDATE_AT_TEST_CASE_FAR_TARGET)
+        n_cycles = 100;
+      else
+        n_cycles = 3;
+
+      test->request_time_us = g_get_monotonic_time ();
+      test->requested_presentation_time_us =
+        test->request_time_us + n_cycles * refresh_interval_us;
+      clutter_frame_clock_schedule_update_at (frame_clock,
+                                              test->requested_presentation_time_us);
+      return CLUTTER_FRAME_RESULT_PENDING_PRESENTED;
+    }
+
+  g_assert_true (clutter_frame_get_target_presentation_time (frame,
+                                                             &target_presentation_time_us));
+
+  switch (test->test_case)
+    {
+    case UPDATE_AT_TEST_CASE_TARGET:
+      g_assert_cmpint (target_presentation_time_us, >=,
+                       test->requested_presentation_time_us);
+      g_assert_cmpint (target_presentation_time_us, <,
+                       test->requested_presentation_time_us + refresh_interval_us);
+      g_assert_cmpint (g_get_monotonic_time (), >,
+                       test->requested_presentation_time_us - 2 * refresh_interval_us);
+      break;
+    case UPDATE_AT_TEST_CASE_FAR_TARGET:
+      /* Far away targets only hold back the frame clock for a few cycles */
+      g_assert_cmpint (target_presentation_time_us, <,
+                       test->request_time_us + 5 * refresh_interval_us);
+      break;
+    case UPDATE_AT_TEST_CASE_REGULAR_UPDATE:
+      /* A regular update scheduled in the meantime isn't held back */
+      g_assert_cmpint (target_presentation_time_us, <,
+                       test->requested_presentation_time_us);
+      break;
+    }
+
+  g_main_loop_quit (test->base.main_loop);
+
+  return CLUTTER_FRAME_RESULT_PENDING_PRESENTED;
+}
+
+static const ClutterFrameListenerIface update_at_frame_listener_iface = {
+  .frame = update_at_frame_clock_frame,
+};
+
+static gboolean
+update_at_hw_callback (gpointer user_data)
+{
+  UpdateAtFrameClockTest *test = user_data;
+
+  if (test->test_case == UPDATE_AT_TEST_CASE_REGULAR_UPDATE)
+    clutter_frame_clock_schedule_update (test->base.fake_hw_clock->frame_clock);
+
+  return G_SOURCE_CONTINUE;
+}
+
+static void
+run_schedule_update_at_test (UpdateAtTestCase test_case)
+{
+  UpdateAtFrameClockTest test = { 0 };
+  ClutterFrameClock *frame_clock;
+  GSource *source;
+  FakeHwClock *fake_hw_clock;
+
+  test.test_case = test_case;
+  test.base.main_loop = g_main_loop_new (NULL, FALSE);
+  frame_clock = clutter_frame_clock_new (refresh_rate,
+                                         0,
+                                         &update_at_frame_listener_iface,
+                                         &test);
+
+  fake_hw_clock = fake_hw_clock_new (frame_clock, update_at_hw_callback, &test);
+  source = &fake_hw_clock->source;
+  g_source_attach (source, NULL);
+
+  test.base.fake_hw_clock = fake_hw_clock;
+
+  clutter_frame_clock_schedule_update (frame_clock);
+  g_main_loop_run (test.base.main_loop);
+
+  g_main_loop_unref (test.base.main_loop);
+
+  clutter_frame_clock_destroy (frame_clock);
+  g_source_destroy (source);
+  g_source_unref (source);
+}
+
+static void
+frame_clock_schedule_update_at (void)
+{
+  run_schedule_update_at_test (UPDATE_AT_TEST_CASE_TARGET);
+}
+
+static void
+frame_clock_schedule_update_at_far_target (void)
+{
+  run_schedule_update_at_test (UPDATE_AT_TEST_CASE_FAR_TARGET);
+}
+
+static void
+frame_clock_schedule_update_at_regular_update (void)
+{
+  run_schedule_update_at_test (UPDATE_AT_TEST_CASE_REGULAR_UPDATE);
+}
+
+static ClutterFrameResult
+next_update_time_frame_clock_frame (ClutterFrameClock *frame_clock,
+                                    ClutterFrame      *frame,
+                                    gpointer           user_data)
+{
+  FrameClockTest *test = user_data;
+  int64_t target_presentation_time_us;
+  int64_t next_update_time_us;
+
+  test->fake_hw_clock->has_pending_present = TRUE;
+
+  /* Nothing to predict from before the first presentation */
+  if (!clutter_frame_get_target_presentation_time (frame,
+                                                   &target_presentation_time_us))
+    {
+      g_assert_false (clutter_frame_clock_get_next_update_time (frame_clock,
+                                                                &next_update_time_us));
+      clutter_frame_clock_schedule_update (frame_clock);
+      return CLUTTER_FRAME_RESULT_PENDING_PRESENTED;
+    }
+
+  g_assert_true (clutter_frame_clock_get_next_update_time (frame_clock,
+                                                           &next_update_time_us));
+  g_assert_cmpint (next_update_time_us, >, g_get_monotonic_time ());
+  g_assert_cmpint (next_update_time_us, <=,
+                   target_presentation_time_us + refresh_interval_us);
+
+  g_main_loop_quit (test->main_loop);
+
+  return CLUTTER_FRAME_RESULT_PENDING_PRESENTED;
+}
+
+static const ClutterFrameListenerIface next_update_time_frame_listener_iface = {
+  .frame = next_update_time_frame_clock_frame,
+};
+
+static void
+frame_clock_next_update_time (void)
+{
+  FrameClockTest test;
+  ClutterFrameClock *frame_clock;
+  GSource *source;
+  FakeHwClock *fake_hw_clock;
+
+  test.main_loop = g_main_loop_new (NULL, FALSE);
+  frame_clock = clutter_frame_clock_new (refresh_rate,
+                                         0,
+                                         &next_update_time_frame_listener_iface,
+                                         &test);
+
+  fake_hw_clock = fake_hw_clock_new (frame_clock, NULL, NULL);
+  source = &fake_hw_clock->source;
+  g_source_attach (source, NULL);
+
+  test.fake_hw_clock = fake_hw_clock;
+
+  clutter_frame_clock_schedule_update (frame_clock);
+  g_main_loop_run (test.main_loop);
+
+  g_main_loop_unref (test.main_loop);
+
+  clutter_frame_clock_destroy (frame_clock);
+  g_source_destroy (source);
+  g_source_unref (source);
+}
+
 static void
 before_frame_frame_clock_before_frame (ClutterFrameClock *frame_clock,
                                        ClutterFrame      *frame,
@@ -831,6 +1034,10 @@ CLUTTER_TEST_SUITE (
   CLUTTER_TEST_UNIT ("/frame-clock/delayed-damage", frame_clock_delayed_damage)
   CLUTTER_TEST_UNIT ("/frame-clock/no-damage", frame_clock_no_damage)
   CLUTTER_TEST_UNIT ("/frame-clock/schedule-update-now", frame_clock_schedule_update_now)
+  CLUTTER_TEST_UNIT ("/frame-clock/schedule-update-at", frame_clock_schedule_update_at)
+  CLUTTER_TEST_UNIT ("/frame-clock/schedule-update-at-far-target", frame_clock_schedule_update_at_far_target)
+  CLUTTER_TEST_UNIT ("/frame-clock/schedule-update-at-regular-update", frame_clock_schedule_update_at_regular_update)
+  CLUTTER_TEST_UNIT ("/frame-clock/next-update-time", frame_clock_next_update_time)
   CLUTTER_TEST_UNIT ("/frame-clock/before-frame", frame_clock_before_frame)
   CLUTTER_TEST_UNIT ("/frame-clock/inhibit", frame_clock_inhibit)
   CLUTTER_TEST_UNIT ("/frame-clock/reschedule-on-idle", frame_clock_reschedule_on_idle)
@@ -0,0 +1,104 @@
+#include <clutter/clutter.h>
+
+#include "clutter/clutter-mutter.h"
+
+#include "tests/clutter-test-utils.h"
+
+static gboolean
+region_contains_region (const cairo_region_t *region,
+                        const cairo_region_t *other)
+{
+  cairo_region_t *difference;
+  gboolean contains;
+
+  difference = cairo_region_copy (other);
+  cairo_region_subtract (difference, region);
+  contains = cairo_region_is_empty (difference);
+  cairo_region_destroy (difference);
+
+  return contains;
+}
+
+static void
+region_coalesce_noop (void)
+{
+  cairo_rectangle_int_t rects[] = {
+    { .x = 0, .y = 0, .width = 10, .height = 10 },
+    { .x = 100, .y = 100, .width = 10, .height = 10 },
+  };
+  cairo_region_t *region;
+  cairo_region_t *original;
+
+  region = cairo_region_create_rectangles (rects, G_N_ELEMENTS (rects));
+  original = region;
+
+  g_assert_false (clutter_util_region_coalesce (&region, 4));
+  g_assert_true (region == original);
+  g_assert_cmpint (cairo_region_num_rectangles (region), ==, 2);
+
+  cairo_region_destroy (region);
+}
+
+static void
+region_coalesce_cheap_merge (void)
+{
+  cairo_rectangle_int_t rects[] = {
+    { .x = 0, .y = 0, .width = 100, .height = 10 },
+    { .x = 0, .y = 10, .width = 99, .height = 10 },
+  };
+  cairo_rectangle_int_t extents;
+  cairo_region_t *region;
+
+  region = cairo_region_create_rectangles (rects, G_N_ELEMENTS (rects));
+  g_assert_cmpint (cairo_region_num_rectangles (region), ==, 2);
+
+  g_assert_true (clutter_util_region_coalesce (&region, 4));
+  g_assert_cmpint (cairo_region_num_rectangles (region), ==, 1);
+
+  cairo_region_get_extents (region, &extents);
+  g_assert_cmpint (extents.x, ==, 0);
+  g_assert_cmpint (extents.y, ==, 0);
+  g_assert_cmpint (extents.width, ==, 100);
+  g_assert_cmpint (extents.height, ==, 20);
+
+  cairo_region_destroy (region);
+}
+
+static void
+region_coalesce_limit (void)
+{
+  cairo_region_t *original;
+  cairo_region_t *region;
+  int x, y;
+
+  region = cairo_region_create ();
+  for (y = 0; y < 10; y++)
+    {
+      for (x = 0; x < 10; x++)
+        {
+          cairo_rectangle_int_t rect = {
+            .x = x * 20 + y,
+            .y = y * 20,
+            .width = 5,
+            .height = 5,
+          };
+
+          cairo_region_union_rectangle (region, &rect);
+        }
+    }
+  original = cairo_region_copy (region);
+  g_assert_cmpint (cairo_region_num_rectangles (region), ==, 100);
+
+  g_assert_true (clutter_util_region_coalesce (&region, 8));
+  g_assert_cmpint (cairo_region_num_rectangles (region), <=, 8);
+  g_assert_true (region_contains_region (region, original));
+
+  cairo_region_destroy (original);
+  cairo_region_destroy (region);
+}
+
+CLUTTER_TEST_SUITE (
+  CLUTTER_TEST_UNIT ("/region-coalesce/noop", region_coalesce_noop)
+  CLUTTER_TEST_UNIT ("/region-coalesce/cheap-merge", region_coalesce_cheap_merge)
+  CLUTTER_TEST_UNIT ("/region-coalesce/limit", region_coalesce_limit)
+)
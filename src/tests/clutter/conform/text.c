@@ -1,5 +1,6 @@
 #include <glib.h>
 #include <clutter/clutter.h>
+#include <cogl-pango/cogl-pango.h>
 #include <string.h>
 
 #include "tests/clutter-test-utils.h"
@@ -546,6 +547,92 @@ text_idempotent_use_markup (void)
   clutter_actor_destroy (CLUTTER_ACTOR (text));
 }
 
+static void
+on_presented (ClutterStage     *stage,
+              ClutterStageView *view,
+              ClutterFrameInfo *frame_info,
+              gboolean         *was_presented)
+{
+  *was_presented = TRUE;
+}
+
+static void
+on_glyphs_ready (PangoRenderer *renderer,
+                 gboolean      *glyphs_ready)
+{
+  *glyphs_ready = TRUE;
+}
+
+static void
+wait_for_presented (ClutterActor *stage)
+{
+  gboolean was_presented = FALSE;
+  gulong presented_id;
+
+  presented_id = g_signal_connect (stage, "presented",
+                                   G_CALLBACK (on_presented),
+                                   &was_presented);
+  clutter_actor_queue_redraw (stage);
+  while (!was_presented)
+    g_main_context_iteration (NULL, FALSE);
+  g_signal_handler_disconnect (stage, presented_id);
+}
+
+static void
+text_async_glyphs (void)
+{
+  CoglPangoFontMap *font_map = COGL_PANGO_FONT_MAP (clutter_get_font_map ());
+  PangoRenderer *renderer = cogl_pango_font_map_get_renderer (font_map);
+  gboolean was_async;
+  ClutterActor *stage;
+  ClutterActor *text;
+  ClutterActor *other_text;
+  PangoLayout *layout;
+  gboolean glyphs_ready = FALSE;
+  gulong glyphs_ready_id;
+
+  was_async = cogl_pango_font_map_get_use_async_rasterization (font_map);
+  cogl_pango_font_map_set_use_async_rasterization (font_map, TRUE);
+  cogl_pango_font_map_clear_glyph_cache (font_map);
+
+  glyphs_ready_id = g_signal_connect (renderer, "glyphs-ready",
+                                      G_CALLBACK (on_glyphs_ready),
+                                      &glyphs_ready);
+
+  stage = clutter_test_get_stage ();
+  text = clutter_text_new_with_text ("Sans 24", "Async glyphs");
+  clutter_actor_add_child (stage, text);
+  clutter_actor_show (stage);
+
+  /* None of the glyphs are cached, so they are left out of the first
+   * frame and rasterized in the background */
+  wait_for_presented (stage);
+  layout = clutter_text_get_layout (CLUTTER_TEXT (text));
+  g_assert_true (cogl_pango_layout_has_pending_glyphs (layout));
+
+  while (!glyphs_ready)
+    g_main_context_iteration (NULL, TRUE);
+
+  /* The text is drawn again with all of its glyphs */
+  wait_for_presented (stage);
+  layout = clutter_text_get_layout (CLUTTER_TEXT (text));
+  g_assert_false (cogl_pango_layout_has_pending_glyphs (layout));
+
+  /* And the glyphs stay in the cache for any other text using them */
+  glyphs_ready = FALSE;
+  other_text = clutter_text_new_with_text ("Sans 24", "glyphs Async");
+  clutter_actor_add_child (stage, other_text);
+  wait_for_presented (stage);
+  layout = clutter_text_get_layout (CLUTTER_TEXT (other_text));
+  g_assert_false (cogl_pango_layout_has_pending_glyphs (layout));
+  g_assert_false (glyphs_ready);
+
+  g_signal_handler_disconnect (renderer, glyphs_ready_id);
+  clutter_actor_destroy (other_text);
+  clutter_actor_destroy (text);
+  cogl_pango_font_map_set_use_async_rasterization (font_map, was_async);
+}
+
 CLUTTER_TEST_SUITE (
   CLUTTER_TEST_UNIT ("/text/utf8-validation", text_utf8_validation)
   CLUTTER_TEST_UNIT ("/text/set-empty", text_set_empty)
@@ -560,4 +647,5 @@ CLUTTER_TEST_SUITE (
   CLUTTER_TEST_UNIT ("/text/cursor", text_cursor)
   CLUTTER_TEST_UNIT ("/text/event", text_event)
   CLUTTER_TEST_UNIT ("/text/idempotent-use-markup", text_idempotent_use_markup)
+  CLUTTER_TEST_UNIT ("/text/async-glyphs", text_async_glyphs)
 )
@@ -0,0 +1,176 @@
+#include "cogl-config.h"
+
+#include <glib.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cogl/cogl-bitmap-simd-private.h"
+
+/* Measures the throughput of the bitmap conversion kernels with each
+ * implementation supported by the CPU. The default size is that of a
+ * 1080p screenshot. */
+
+#define DEFAULT_WIDTH 1920
+#define DEFAULT_HEIGHT 1080
+#define DEFAULT_ITERATIONS 50
+
+typedef enum
+{
+  KERNEL_PREMULT_ALPHA_LAST,
+  KERNEL_PREMULT_ALPHA_FIRST,
+  KERNEL_UNPREMULT_ALPHA_LAST,
+  KERNEL_UNPREMULT_ALPHA_FIRST,
+  KERNEL_SWAP_RGBA_BGRA,
+  KERNEL_XRGB_TO_ARGB,
+  KERNEL_UNPACK_XRGB_2101010,
+  KERNEL_UNPACK_ABGR_2101010,
+
+  N_KERNELS
+} Kernel;
+
+static const char *kernel_names[] = {
+  "premult (alpha last)",
+  "premult (alpha first)",
+  "unpremult (alpha last)",
+  "unpremult (alpha first)",
+  "RGBA8888 <-> BGRA8888",
+  "XRGB8888 -> ARGB8888",
+  "XRGB2101010 -> RGBA8888",
+  "ABGR2101010 -> RGBA8888",
+};
+
+static const CoglBitmapShuffle swap_rgba_bgra = { { 2, 1, 0, 3 } };
+static const CoglBitmapShuffle xrgb_to_argb = { { -1, 1, 2, 3 } };
+static const CoglBitmapUnpack10 xrgb_2101010 = { 20, 10, 0, -1 };
+static const CoglBitmapUnpack10 abgr_2101010 = { 0, 10, 20, 30 };
+
+static void
+fill_premultiplied (uint8_t  *data,
+                    int       n_pixels,
+                    gboolean  alpha_first)
+{
+  int alpha_index = alpha_first ? 0 : 3;
+  int i, j;
+
+  for (i = 0; i < n_pixels; i++)
+    {
+      uint8_t alpha = g_random_int_range (0, 256);
+
+      for (j = 0; j < 4; j++)
+        {
+          if (j == alpha_index)
+            data[i * 4 + j] = alpha;
+          else
+            data[i * 4 + j] = alpha ? g_random_int_range (0, alpha + 1) : 0;
+        }
+    }
+}
+
+static void
+run_kernel (const CoglBitmapSimdFuncs *funcs,
+            Kernel                     kernel,
+            const uint8_t             *src,
+            uint8_t                   *dst,
+            int                        width,
+            int                        height)
+{
+  int y;
+
+  for (y = 0; y < height; y++)
+    {
+      const uint8_t *src_row = src + y * width * 4;
+      uint8_t *dst_row = dst + y * width * 4;
+
+      switch (kernel)
+        {
+        case KERNEL_PREMULT_ALPHA_LAST:
+          funcs->premult_alpha_last (dst_row, width);
+          break;
+        case KERNEL_PREMULT_ALPHA_FIRST:
+          funcs->premult_alpha_first (dst_row, width);
+          break;
+        case KERNEL_UNPREMULT_ALPHA_LAST:
+          funcs->unpremult_alpha_last (dst_row, width);
+          break;
+        case KERNEL_UNPREMULT_ALPHA_FIRST:
+          funcs->unpremult_alpha_first (dst_row, width);
+          break;
+        case KERNEL_SWAP_RGBA_BGRA:
+          funcs->shuffle_8888 (src_row, dst_row, width, &swap_rgba_bgra);
+          break;
+        case KERNEL_XRGB_TO_ARGB:
+          funcs->shuffle_8888 (src_row, dst_row, width, &xrgb_to_argb);
+          break;
+        case KERNEL_UNPACK_XRGB_2101010:
+          funcs->unpack_10_to_8 (src_row, dst_row, width, &xrgb_2101010);
+          break;
+        case KERNEL_UNPACK_ABGR_2101010:
+          funcs->unpack_10_to_8 (src_row, dst_row, width, &abgr_2101010);
+          break;
+        case N_KERNELS:
+          g_assert_not_reached ();
+        }
+    }
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  int width = DEFAULT_WIDTH;
+  int height = DEFAULT_HEIGHT;
+  int iterations = DEFAULT_ITERATIONS;
+  size_t size;
+  g_autofree uint8_t *src = NULL;
+  g_autofree uint8_t *dst = NULL;
+  Kernel kernel;
+
+  if (argc > 1)
+    iterations = MAX (atoi (argv[1]), 1);
+
+  size = (size_t) width * height * 4;
+  src = g_malloc (size);
+  dst = g_malloc (size);
+  g_print ("%d x %d pixels, %d iterations\n", width, height, iterations);
+
+  for (kernel = 0; kernel < N_KERNELS; kernel++)
+    {
+      CoglBitmapSimdLevel level;
+
+      g_print ("\n%s\n", kernel_names[kernel]);
+
+      fill_premultiplied (src, width * height,
+                          (kernel == KERNEL_PREMULT_ALPHA_FIRST ||
+                           kernel == KERNEL_UNPREMULT_ALPHA_FIRST));
+
+      for (level = 0; level < COGL_BITMAP_SIMD_N_LEVELS; level++)
+        {
+          const CoglBitmapSimdFuncs *funcs;
+          int64_t elapsed = 0;
+          int i;
+
+          funcs = _cogl_bitmap_simd_get_funcs_for_level (level);
+          if (!funcs)
+            continue;
+
+          for (i = 0; i < iterations; i++)
+            {
+              int64_t start;
+
+              /* The in place kernels modify their input so start
+               * from the same data each time */
+              memcpy (dst, src, size);
+
+              start = g_get_monotonic_time ();
+              run_kernel (funcs, kernel, src, dst, width, height);
+              elapsed += g_get_monotonic_time () - start;
+            }
+
+          g_print ("  %-6s %8.1f Mpixels/s\n",
+                   funcs->name,
+                   ((double) width * height * iterations) / MAX (elapsed, 1));
+        }
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,197 @@
+#include "cogl-config.h"
+
+#include <string.h>
+
+#include "cogl/cogl-bitmap-simd-private.h"
+#include "tests/cogl-test-utils.h"
+
+/* Odd so that the tails which aren't vectorized get checked too */
+#define N_PIXELS 259
+
+static const CoglBitmapUnpack10 unpack_10_layouts[] = {
+  { 22, 12, 2, 0 },
+  { 2, 12, 22, 0 },
+  { 20, 10, 0, -1 },
+  { 20, 10, 0, 30 },
+  { 0, 10, 20, -1 },
+  { 0, 10, 20, 30 },
+};
+
+static void
+fill_random (uint8_t *data,
+             int      n_bytes)
+{
+  int i;
+
+  for (i = 0; i < n_bytes; i++)
+    data[i] = g_test_rand_int_range (0, 256);
+}
+
+/* Fills the pixels with valid premultiplied colors. Every alpha
+ * value gets used with every color value over the 256 rows */
+static void
+fill_premultiplied (uint8_t  *data,
+                    int       row,
+                    gboolean  alpha_first)
+{
+  int alpha_index = alpha_first ? 0 : 3;
+  int x, i;
+
+  for (x = 0; x < N_PIXELS; x++)
+    {
+      uint8_t *p = data + x * 4;
+
+      p[alpha_index] = row;
+      for (i = 0; i < 4; i++)
+        {
+          if (i != alpha_index)
+            p[i] = row ? (x + i * 37) % (row + 1) : 0;
+        }
+    }
+}
+
+static void
+check_premult (const CoglBitmapSimdFuncs *portable,
+               const CoglBitmapSimdFuncs *funcs)
+{
+  uint8_t expected[N_PIXELS * 4];
+  uint8_t result[N_PIXELS * 4];
+  int row;
+
+  for (row = 0; row < 256; row++)
+    {
+      fill_premultiplied (expected, row, FALSE);
+      memcpy (result, expected, sizeof (result));
+      portable->unpremult_alpha_last (expected, N_PIXELS);
+      funcs->unpremult_alpha_last (result, N_PIXELS);
+      g_assert_cmpmem (expected, sizeof (expected), result, sizeof (result));
+
+      portable->premult_alpha_last (expected, N_PIXELS);
+      funcs->premult_alpha_last (result, N_PIXELS);
+      g_assert_cmpmem (expected, sizeof (expected), result, sizeof (result));
+
+      fill_premultiplied (expected, row, TRUE);
+      memcpy (result, expected, sizeof (result));
+      portable->unpremult_alpha_first (expected, N_PIXELS);
+      funcs->unpremult_alpha_first (result, N_PIXELS);
+      g_assert_cmpmem (expected, sizeof (expected), result, sizeof (result));
+
+      portable->premult_alpha_first (expected, N_PIXELS);
+      funcs->premult_alpha_first (result, N_PIXELS);
+      g_assert_cmpmem (expected, sizeof (expected), result, sizeof (result));
+    }
+
+  /* Colors bigger than the alpha aren't valid premultiplied data but
+   * they should still give the same results */
+  fill_random (expected, sizeof (expected));
+  memcpy (result, expected, sizeof (result));
+  portable->unpremult_alpha_last (expected, N_PIXELS);
+  funcs->unpremult_alpha_last (result, N_PIXELS);
+  g_assert_cmpmem (expected, sizeof (expected), result, sizeof (result));
+
+  fill_random (expected, sizeof (expected));
+  memcpy (result, expected, sizeof (result));
+  portable->unpremult_alpha_first (expected, N_PIXELS);
+  funcs->unpremult_alpha_first (result, N_PIXELS);
+  g_assert_cmpmem (expected, sizeof (expected), result, sizeof (result));
+}
+
+static void
+check_shuffle (const CoglBitmapSimdFuncs *portable,
+               const CoglBitmapSimdFuncs *funcs)
+{
+  uint8_t src[N_PIXELS * 4];
+  uint8_t expected[N_PIXELS * 4];
+  uint8_t result[N_PIXELS * 4];
+  int i, j;
+
+  fill_random (src, sizeof (src));
+
+  for (i = 0; i < 5 * 5 * 5 * 5; i++)
+    {
+      CoglBitmapShuffle shuffle;
+      int n = i;
+
+      for (j = 0; j < 4; j++)
+        {
+          shuffle.shuffle[j] = n % 5 - 1;
+          n /= 5;
+        }
+
+      portable->shuffle_8888 (src, expected, N_PIXELS, &shuffle);
+      funcs->shuffle_8888 (src, result, N_PIXELS, &shuffle);
+      g_assert_cmpmem (expected, sizeof (expected), result, sizeof (result));
+
+      /* In place */
+      memcpy (result, src, sizeof (result));
+      funcs->shuffle_8888 (result, result, N_PIXELS, &shuffle);
+      g_assert_cmpmem (expected, sizeof (expected), result, sizeof (result));
+    }
+}
+
+static void
+check_unpack_10 (const CoglBitmapSimdFuncs *portable,
+                 const CoglBitmapSimdFuncs *funcs)
+{
+  uint32_t src[1024];
+  uint8_t expected[1024 * 4];
+  uint8_t result[1024 * 4];
+  int i;
+
+  /* Every 10-bit value in every channel */
+  for (i = 0; i < 1024; i++)
+    src[i] = (i << 22) | (i << 12) | (i << 2) | (i & 3);
+
+  for (i = 0; i < G_N_ELEMENTS (unpack_10_layouts); i++)
+    {
+      portable->unpack_10_to_8 ((const uint8_t *) src, expected, 1024,
+                                &unpack_10_layouts[i]);
+      funcs->unpack_10_to_8 ((const uint8_t *) src, result, 1024,
+                             &unpack_10_layouts[i]);
+      g_assert_cmpmem (expected, sizeof (expected), result, sizeof (result));
+    }
+
+  for (i = 0; i < 1024; i++)
+    src[i] = (i << 20) | (i << 10) | i | ((uint32_t) i << 30);
+
+  for (i = 0; i < G_N_ELEMENTS (unpack_10_layouts); i++)
+    {
+      portable->unpack_10_to_8 ((const uint8_t *) src, expected, N_PIXELS,
+                                &unpack_10_layouts[i]);
+      funcs->unpack_10_to_8 ((const uint8_t *) src, result, N_PIXELS,
+                             &unpack_10_layouts[i]);
+      g_assert_cmpmem (expected, N_PIXELS * 4, result, N_PIXELS * 4);
+    }
+}
+
+static void
+test_bitmap_simd (void)
+{
+  const CoglBitmapSimdFuncs *portable;
+  CoglBitmapSimdLevel level;
+
+  portable = _cogl_bitmap_simd_get_funcs_for_level (COGL_BITMAP_SIMD_NONE);
+  g_assert_nonnull (portable);
+  g_assert_nonnull (_cogl_bitmap_simd_get_funcs ());
+
+  for (level = COGL_BITMAP_SIMD_NONE + 1;
+       level < COGL_BITMAP_SIMD_N_LEVELS;
+       level++)
+    {
+      const CoglBitmapSimdFuncs *funcs;
+
+      funcs = _cogl_bitmap_simd_get_funcs_for_level (level);
+      if (!funcs)
+        continue;
+
+      g_test_message ("Checking %s", funcs->name);
+
+      check_premult (portable, funcs);
+      check_shuffle (portable, funcs);
+      check_unpack_10 (portable, funcs);
+    }
+}
+
+COGL_TEST_SUITE_MINIMAL (
+  g_test_add_func ("/bitmap/simd", test_bitmap_simd);
+)
@@ -0,0 +1,159 @@
+#include "cogl-config.h"
+
+#include <string.h>
+
+#include "cogl-pango/cogl-pango-distance-field-private.h"
+#include "cogl-pango/cogl-pango-glyph-cache.h"
+#include "tests/cogl-test-utils.h"
+
+#define SIZE 40
+/* Padding at the end of each row to check that the strides are used */
+#define COVERAGE_STRIDE (SIZE + 3)
+#define OUT_STRIDE (SIZE + 5)
+#define SQUARE_START 12
+#define SQUARE_END 28
+
+static uint8_t
+get_value (const uint8_t *distance_field,
+           int            along,
+           int            across,
+           gboolean       vertical)
+{
+  if (vertical)
+    return distance_field[along * OUT_STRIDE + across];
+  else
+    return distance_field[across * OUT_STRIDE + along];
+}
+
+static void
+check_edge (const uint8_t *distance_field,
+            gboolean       vertical)
+{
+  int middle = SIZE / 2;
+  int i;
+
+  /* The pixels on both sides of the outline are one pixel center away
+   * from the other side, which is 1 / (2 * spread) of the range */
+  g_assert_cmpint (get_value (distance_field, SQUARE_START, middle, vertical),
+                   ==, 149);
+  g_assert_cmpint (get_value (distance_field, SQUARE_START - 1, middle,
+                              vertical),
+                   ==, 106);
+
+  /* The values saturate at the spread */
+  g_assert_cmpint (get_value (distance_field,
+                              SQUARE_START + COGL_PANGO_SDF_SPREAD - 1,
+                              middle, vertical),
+                   ==, 255);
+  g_assert_cmpint (get_value (distance_field,
+                              SQUARE_START - COGL_PANGO_SDF_SPREAD,
+                              middle, vertical),
+                   ==, 0);
+
+  for (i = 0; i < SQUARE_START - COGL_PANGO_SDF_SPREAD; i++)
+    g_assert_cmpint (get_value (distance_field, i, middle, vertical), ==, 0);
+  for (i = SQUARE_START + COGL_PANGO_SDF_SPREAD - 1; i <= middle; i++)
+    g_assert_cmpint (get_value (distance_field, i, middle, vertical), ==, 255);
+
+  /* In between, the values rise towards the inside */
+  for (i = SQUARE_START - COGL_PANGO_SDF_SPREAD;
+       i < SQUARE_START + COGL_PANGO_SDF_SPREAD - 1;
+       i++)
+    {
+      g_assert_cmpint (get_value (distance_field, i, middle, vertical),
+                       <,
+                       get_value (distance_field, i + 1, middle, vertical));
+    }
+
+  /* And it's the same on the other side of the square */
+  for (i = 0; i < SIZE / 2; i++)
+    {
+      g_assert_cmpint (get_value (distance_field, i, middle, vertical),
+                       ==,
+                       get_value (distance_field, SIZE - 1 - i, middle,
+                                  vertical));
+    }
+}
+
+static void
+test_pango_distance_field (void)
+{
+  uint8_t coverage[SIZE * COVERAGE_STRIDE];
+  uint8_t distance_field[SIZE * OUT_STRIDE];
+  int x, y;
+
+  memset (coverage, 0x42, sizeof (coverage));
+  for (y = 0; y < SIZE; y++)
+    {
+      for (x = 0; x < SIZE; x++)
+        {
+          gboolean inside = (x >= SQUARE_START && x < SQUARE_END &&
+                             y >= SQUARE_START && y < SQUARE_END);
+
+          coverage[y * COVERAGE_STRIDE + x] = inside ? 255 : 0;
+        }
+    }
+
+  memset (distance_field, 0x42, sizeof (distance_field));
+  _cogl_pango_compute_distance_field (coverage, COVERAGE_STRIDE,
+                                      SIZE, SIZE,
+                                      distance_field, OUT_STRIDE);
+
+  for (y = 0; y < SIZE; y++)
+    {
+      for (x = SIZE; x < OUT_STRIDE; x++)
+        g_assert_cmpint (distance_field[y * OUT_STRIDE + x], ==, 0x42);
+    }
+
+  check_edge (distance_field, FALSE);
+  check_edge (distance_field, TRUE);
+
+  /* A corner pixel is further away from the square than an edge one */
+  g_assert_cmpint (distance_field[(SQUARE_START - 1) * OUT_STRIDE +
+                                  SQUARE_START - 1],
+                   <,
+                   distance_field[(SIZE / 2) * OUT_STRIDE + SQUARE_START - 1]);
+}
+
+static void
+test_pango_distance_field_partial_coverage (void)
+{
+  uint8_t coverage[SIZE * SIZE];
+  uint8_t distance_field[SIZE * SIZE];
+  int x, y;
+
+  /* The half covered column is right on the outline */
+  for (y = 0; y < SIZE; y++)
+    {
+      for (x = 0; x < SIZE; x++)
+        {
+          if (x < SIZE / 2)
+            coverage[y * SIZE + x] = 255;
+          else if (x == SIZE / 2)
+            coverage[y * SIZE + x] = 128;
+          else
+            coverage[y * SIZE + x] = 0;
+        }
+    }
+
+  _cogl_pango_compute_distance_field (coverage, SIZE,
+                                      SIZE, SIZE,
+                                      distance_field, SIZE);
+
+  for (y = 0; y < SIZE; y++)
+    {
+      const uint8_t *row = distance_field + y * SIZE;
+
+      g_assert_cmpint (row[SIZE / 2], ==, 128);
+      g_assert_cmpint (row[SIZE / 2 - 1], >, 128);
+      g_assert_cmpint (row[SIZE / 2 + 1], <, 128);
+      g_assert_cmpint (row[SIZE / 2 - COGL_PANGO_SDF_SPREAD], ==, 255);
+      g_assert_cmpint (row[SIZE / 2 + COGL_PANGO_SDF_SPREAD], ==, 0);
+    }
+}
+
+COGL_TEST_SUITE_MINIMAL (
+  g_test_add_func ("/pango/distance-field", test_pango_distance_field);
+  g_test_add_func ("/pango/distance-field/partial-coverage",
+                   test_pango_distance_field_partial_coverage);
+)
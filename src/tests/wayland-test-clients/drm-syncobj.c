@@ -0,0 +1,432 @@
+/*
+ * Copyright (C) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <drm_fourcc.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <gbm.h>
+#include <glib.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <wayland-client.h>
+#include <xf86drm.h>
+
+#include "wayland-test-client-utils.h"
+
+#include "linux-dmabuf-unstable-v1-client-protocol.h"
+#include "linux-drm-syncobj-v1-client-protocol.h"
+
+typedef struct _Timeline
+{
+  struct wp_linux_drm_syncobj_timeline_v1 *timeline;
+  uint32_t drm_syncobj;
+} Timeline;
+
+static WaylandDisplay *display;
+static struct wl_registry *registry;
+static struct zwp_linux_dmabuf_v1 *dmabuf;
+static struct wp_linux_drm_syncobj_manager_v1 *syncobj_manager;
+
+static int drm_fd = -1;
+static struct gbm_device *gbm_device;
+
+static void
+handle_registry_global (void               *user_data,
+                        struct wl_registry *registry,
+                        uint32_t            id,
+                        const char         *interface,
+                        uint32_t            version)
+{
+  if (strcmp (interface, "zwp_linux_dmabuf_v1") == 0)
+    {
+      dmabuf = wl_registry_bind (registry, id,
+                                 &zwp_linux_dmabuf_v1_interface, 3);
+    }
+  else if (strcmp (interface, "wp_linux_drm_syncobj_manager_v1") == 0)
+    {
+      syncobj_manager =
+        wl_registry_bind (registry, id,
+                          &wp_linux_drm_syncobj_manager_v1_interface, 1);
+    }
+}
+
+static void
+handle_registry_global_remove (void               *user_data,
+                               struct wl_registry *registry,
+                               uint32_t            name)
+{
+}
+
+static const struct wl_registry_listener registry_listener = {
+  handle_registry_global,
+  handle_registry_global_remove
+};
+
+static void
+connect_to_display (void)
+{
+  g_assert_null (display);
+
+  display = wayland_display_new (WAYLAND_DISPLAY_CAPABILITY_TEST_DRIVER);
+  g_assert_nonnull (display);
+
+  registry = wl_display_get_registry (display->display);
+  wl_registry_add_listener (registry, &registry_listener, NULL);
+  wl_display_roundtrip (display->display);
+
+  g_assert_nonnull (dmabuf);
+  g_assert_nonnull (syncobj_manager);
+}
+
+static void
+clean_up_display (void)
+{
+  g_clear_pointer (&syncobj_manager, wp_linux_drm_syncobj_manager_v1_destroy);
+  g_clear_pointer (&dmabuf, zwp_linux_dmabuf_v1_destroy);
+  g_clear_pointer (&registry, wl_registry_destroy);
+  g_clear_object (&display);
+}
+
+static Timeline *
+create_timeline (void)
+{
+  Timeline *timeline;
+  int fd;
+
+  timeline = g_new0 (Timeline, 1);
+
+  g_assert_cmpint (drmSyncobjCreate (drm_fd, 0, &timeline->drm_syncobj),
+                   ==, 0);
+  g_assert_cmpint (drmSyncobjHandleToFD (drm_fd, timeline->drm_syncobj, &fd),
+                   ==, 0);
+
+  timeline->timeline =
+    wp_linux_drm_syncobj_manager_v1_import_timeline (syncobj_manager, fd);
+  close (fd);
+
+  return timeline;
+}
+
+static void
+timeline_free (Timeline *timeline)
+{
+  g_clear_pointer (&timeline->timeline, wp_linux_drm_syncobj_timeline_v1_destroy);
+  drmSyncobjDestroy (drm_fd, timeline->drm_syncobj);
+  g_free (timeline);
+}
+
+static void
+timeline_signal (Timeline *timeline,
+                 uint64_t  point)
+{
+  g_assert_cmpint (drmSyncobjTimelineSignal (drm_fd,
+                                             &timeline->drm_syncobj,
+                                             &point, 1),
+                   ==, 0);
+}
+
+static gboolean
+timeline_wait (Timeline *timeline,
+               uint64_t  point,
+               int64_t   timeout_ns)
+{
+  int64_t deadline_ns = 0;
+
+  if (timeout_ns > 0)
+    deadline_ns = g_get_monotonic_time () * 1000 + timeout_ns;
+
+  return drmSyncobjTimelineWait (drm_fd, &timeline->drm_syncobj, &point, 1,
+                                 deadline_ns,
+                                 DRM_SYNCOBJ_WAIT_FLAGS_WAIT_FOR_SUBMIT,
+                                 NULL) == 0;
+}
+
+static struct wl_buffer *
+create_dma_buf_buffer (struct gbm_bo **out_bo)
+{
+  struct zwp_linux_buffer_params_v1 *params;
+  struct wl_buffer *buffer;
+  struct gbm_bo *bo;
+  int fd;
+
+  bo = gbm_bo_create (gbm_device, 16, 16, DRM_FORMAT_XRGB8888,
+                      GBM_BO_USE_RENDERING | GBM_BO_USE_LINEAR);
+  g_assert_nonnull (bo);
+
+  fd = gbm_bo_get_fd (bo);
+  g_assert_cmpint (fd, >=, 0);
+
+  params = zwp_linux_dmabuf_v1_create_params (dmabuf);
+  zwp_linux_buffer_params_v1_add (params, fd, 0,
+                                  gbm_bo_get_offset (bo, 0),
+                                  gbm_bo_get_stride (bo),
+                                  DRM_FORMAT_MOD_INVALID >> 32,
+                                  DRM_FORMAT_MOD_INVALID & 0xffffffff);
+  buffer = zwp_linux_buffer_params_v1_create_immed (params, 16, 16,
+                                                    DRM_FORMAT_XRGB8888, 0);
+  zwp_linux_buffer_params_v1_destroy (params);
+  close (fd);
+
+  g_assert_nonnull (buffer);
+
+  *out_bo = bo;
+  return buffer;
+}
+
+static void
+assert_protocol_error (uint32_t expected_code)
+{
+  const struct wl_interface *interface = NULL;
+  uint32_t code;
+
+  g_assert_cmpint (wl_display_roundtrip (display->display), ==, -1);
+
+  code = wl_display_get_protocol_error (display->display, &interface, NULL);
+  g_assert (interface == &wp_linux_drm_syncobj_surface_v1_interface);
+  g_assert_cmpuint (code, ==, expected_code);
+}
+
+static void
+test_no_buffer (void)
+{
+  struct wl_surface *surface;
+  struct wp_linux_drm_syncobj_surface_v1 *syncobj_surface;
+  Timeline *timeline;
+
+  connect_to_display ();
+
+  surface = wl_compositor_create_surface (display->compositor);
+  syncobj_surface =
+    wp_linux_drm_syncobj_manager_v1_get_surface (syncobj_manager, surface);
+  timeline = create_timeline ();
+
+  wp_linux_drm_syncobj_surface_v1_set_acquire_point (syncobj_surface,
+                                                     timeline->timeline,
+                                                     0, 1);
+  wp_linux_drm_syncobj_surface_v1_set_release_point (syncobj_surface,
+                                                     timeline->timeline,
+                                                     0, 2);
+  wl_surface_commit (surface);
+
+  assert_protocol_error (WP_LINUX_DRM_SYNCOBJ_SURFACE_V1_ERROR_NO_BUFFER);
+
+  timeline_free (timeline);
+  clean_up_display ();
+}
+
+static void
+test_unsupported_buffer (void)
+{
+  struct wl_surface *surface;
+  struct wp_linux_drm_syncobj_surface_v1 *syncobj_surface;
+  struct wl_buffer *buffer;
+  Timeline *timeline;
+  void *data;
+  int size;
+
+  connect_to_display ();
+
+  surface = wl_compositor_create_surface (display->compositor);
+  syncobj_surface =
+    wp_linux_drm_syncobj_manager_v1_get_surface (syncobj_manager, surface);
+  timeline = create_timeline ();
+
+  g_assert_true (create_shm_buffer (display, 16, 16, &buffer, &data, &size));
+
+  wl_surface_attach (surface, buffer, 0, 0);
+  wp_linux_drm_syncobj_surface_v1_set_acquire_point (syncobj_surface,
+                                                     timeline->timeline,
+                                                     0, 1);
+  wp_linux_drm_syncobj_surface_v1_set_release_point (syncobj_surface,
+                                                     timeline->timeline,
+                                                     0, 2);
+  wl_surface_commit (surface);
+
+  assert_protocol_error (WP_LINUX_DRM_SYNCOBJ_SURFACE_V1_ERROR_UNSUPPORTED_BUFFER);
+
+  munmap (data, size);
+  timeline_free (timeline);
+  clean_up_display ();
+}
+
+static void
+test_missing_point (gboolean set_acquire_point)
+{
+  struct wl_surface *surface;
+  struct wp_linux_drm_syncobj_surface_v1 *syncobj_surface;
+  struct wl_buffer *buffer;
+  struct gbm_bo *bo;
+  Timeline *timeline;
+
+  connect_to_display ();
+
+  surface = wl_compositor_create_surface (display->compositor);
+  syncobj_surface =
+    wp_linux_drm_syncobj_manager_v1_get_surface (syncobj_manager, surface);
+  timeline = create_timeline ();
+  buffer = create_dma_buf_buffer (&bo);
+
+  wl_surface_attach (surface, buffer, 0, 0);
+  if (set_acquire_point)
+    {
+      wp_linux_drm_syncobj_surface_v1_set_acquire_point (syncobj_surface,
+                                                         timeline->timeline,
+                                                         0, 1);
+    }
+  else
+    {
+      wp_linux_drm_syncobj_surface_v1_set_release_point (syncobj_surface,
+                                                         timeline->timeline,
+                                                         0, 2);
+    }
+  wl_surface_commit (surface);
+
+  if (set_acquire_point)
+    assert_protocol_error (WP_LINUX_DRM_SYNCOBJ_SURFACE_V1_ERROR_NO_RELEASE_POINT);
+  else
+    assert_protocol_error (WP_LINUX_DRM_SYNCOBJ_SURFACE_V1_ERROR_NO_ACQUIRE_POINT);
+
+  gbm_bo_destroy (bo);
+  timeline_free (timeline);
+  clean_up_display ();
+}
+
+static void
+test_conflicting_points (void)
+{
+  struct wl_surface *surface;
+  struct wp_linux_drm_syncobj_surface_v1 *syncobj_surface;
+  struct wl_buffer *buffer;
+  struct gbm_bo *bo;
+  Timeline *timeline;
+
+  connect_to_display ();
+
+  surface = wl_compositor_create_surface (display->compositor);
+  syncobj_surface =
+    wp_linux_drm_syncobj_manager_v1_get_surface (syncobj_manager, surface);
+  timeline = create_timeline ();
+  buffer = create_dma_buf_buffer (&bo);
+
+  wl_surface_attach (surface, buffer, 0, 0);
+  wp_linux_drm_syncobj_surface_v1_set_acquire_point (syncobj_surface,
+                                                     timeline->timeline,
+                                                     0, 2);
+  wp_linux_drm_syncobj_surface_v1_set_release_point (syncobj_surface,
+                                                     timeline->timeline,
+                                                     0, 2);
+  wl_surface_commit (surface);
+
+  assert_protocol_error (WP_LINUX_DRM_SYNCOBJ_SURFACE_V1_ERROR_CONFLICTING_POINTS);
+
+  gbm_bo_destroy (bo);
+  timeline_free (timeline);
+  clean_up_display ();
+}
+
+static void
+test_acquire_point_not_superseded (void)
+{
+  struct wl_surface *surface;
+  struct wp_linux_drm_syncobj_surface_v1 *syncobj_surface;
+  struct wl_buffer *buffer1;
+  struct wl_buffer *buffer2;
+  struct gbm_bo *bo1;
+  struct gbm_bo *bo2;
+  Timeline *timeline;
+
+  connect_to_display ();
+
+  surface = wl_compositor_create_surface (display->compositor);
+  syncobj_surface =
+    wp_linux_drm_syncobj_manager_v1_get_surface (syncobj_manager, surface);
+  timeline = create_timeline ();
+  buffer1 = create_dma_buf_buffer (&bo1);
+  buffer2 = create_dma_buf_buffer (&bo2);
+
+  /* The first commit waits for an acquire point which isn't signalled yet */
+  wl_surface_attach (surface, buffer1, 0, 0);
+  wp_linux_drm_syncobj_surface_v1_set_acquire_point (syncobj_surface,
+                                                     timeline->timeline,
+                                                     0, 1);
+  wp_linux_drm_syncobj_surface_v1_set_release_point (syncobj_surface,
+                                                     timeline->timeline,
+                                                     0, 2);
+  wl_surface_commit (surface);
+
+  /* The second one is ready right away, but must not skip the first one */
+  timeline_signal (timeline, 3);
+  wl_surface_attach (surface, buffer2, 0, 0);
+  wp_linux_drm_syncobj_surface_v1_set_acquire_point (syncobj_surface,
+                                                     timeline->timeline,
+                                                     0, 3);
+  wp_linux_drm_syncobj_surface_v1_set_release_point (syncobj_surface,
+                                                     timeline->timeline,
+                                                     0, 4);
+  wl_surface_commit (surface);
+  g_assert_cmpint (wl_display_roundtrip (display->display), !=, -1);
+
+  g_assert_false (timeline_wait (timeline, 2, 0));
+
+  timeline_signal (timeline, 1);
+  g_assert_true (timeline_wait (timeline, 2, 5 * G_NSEC_PER_SEC));
+
+  wl_buffer_destroy (buffer2);
+  wl_buffer_destroy (buffer1);
+  gbm_bo_destroy (bo2);
+  gbm_bo_destroy (bo1);
+  wp_linux_drm_syncobj_surface_v1_destroy (syncobj_surface);
+  wl_surface_destroy (surface);
+  timeline_free (timeline);
+  clean_up_display ();
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  const char *render_node_path;
+
+  connect_to_display ();
+  render_node_path = lookup_property_value (display, "render-node-path");
+  g_assert_nonnull (render_node_path);
+
+  drm_fd = open (render_node_path, O_RDWR | O_CLOEXEC);
+  if (drm_fd < 0)
+    {
+      g_error ("Failed to open drm render node %s: %s",
+               render_node_path, g_strerror (errno));
+    }
+  clean_up_display ();
+
+  gbm_device = gbm_create_device (drm_fd);
+  g_assert_nonnull (gbm_device);
+
+  test_no_buffer ();
+  test_unsupported_buffer ();
+  test_missing_point (TRUE);
+  test_missing_point (FALSE);
+  test_conflicting_points ();
+  test_acquire_point_not_superseded ();
+
+  gbm_device_destroy (gbm_device);
+  close (drm_fd);
+
+  return EXIT_SUCCESS;
+}
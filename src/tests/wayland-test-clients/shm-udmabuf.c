@@ -0,0 +1,193 @@
+/*
+ * Copyright (C) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <fcntl.h>
+#include <glib.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <wayland-client.h>
+
+#include "wayland-test-client-utils.h"
+
+#define BUFFER_WIDTH 64
+#define BUFFER_HEIGHT 64
+
+static WaylandDisplay *display;
+static struct wl_surface *surface;
+static struct xdg_surface *xdg_surface;
+static struct xdg_toplevel *xdg_toplevel;
+
+static struct wl_callback *frame_callback;
+static gboolean waiting_for_configure;
+
+static void
+handle_buffer_release (void             *data,
+                       struct wl_buffer *buffer)
+{
+  wl_buffer_destroy (buffer);
+}
+
+static const struct wl_buffer_listener buffer_listener = {
+  handle_buffer_release
+};
+
+static struct wl_buffer *
+create_sealed_shm_buffer (uint32_t color)
+{
+  struct wl_shm_pool *pool;
+  struct wl_buffer *buffer;
+  int stride = BUFFER_WIDTH * 4;
+  long page_size = sysconf (_SC_PAGESIZE);
+  int size;
+  uint32_t *pixels;
+  int fd;
+  int i;
+
+  /* udmabuf maps whole pages, which must all be part of the pool */
+  size = ((stride * BUFFER_HEIGHT + page_size - 1) / page_size) * page_size;
+
+  fd = memfd_create ("shm-udmabuf-test", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+  g_assert_cmpint (fd, >=, 0);
+  g_assert_cmpint (ftruncate (fd, size), ==, 0);
+  g_assert_cmpint (fcntl (fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_SEAL),
+                   ==, 0);
+
+  pixels = mmap (NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  g_assert (pixels != MAP_FAILED);
+  for (i = 0; i < BUFFER_WIDTH * BUFFER_HEIGHT; i++)
+    pixels[i] = color;
+  munmap (pixels, size);
+
+  pool = wl_shm_create_pool (display->shm, fd, size);
+  buffer = wl_shm_pool_create_buffer (pool, 0,
+                                      BUFFER_WIDTH, BUFFER_HEIGHT,
+                                      stride,
+                                      WL_SHM_FORMAT_ARGB8888);
+  wl_buffer_add_listener (buffer, &buffer_listener, NULL);
+  wl_shm_pool_destroy (pool);
+  close (fd);
+
+  return buffer;
+}
+
+static void
+handle_xdg_toplevel_configure (void                *data,
+                               struct xdg_toplevel *xdg_toplevel,
+                               int32_t              width,
+                               int32_t              height,
+                               struct wl_array     *state)
+{
+}
+
+static void
+handle_xdg_toplevel_close (void                *data,
+                           struct xdg_toplevel *xdg_toplevel)
+{
+  g_assert_not_reached ();
+}
+
+static const struct xdg_toplevel_listener xdg_toplevel_listener = {
+  handle_xdg_toplevel_configure,
+  handle_xdg_toplevel_close,
+};
+
+static void
+handle_xdg_surface_configure (void               *data,
+                              struct xdg_surface *xdg_surface,
+                              uint32_t            serial)
+{
+  /* Only acknowledge, so that the buffer attached by the test is the only
+   * one committed */
+  xdg_surface_ack_configure (xdg_surface, serial);
+  waiting_for_configure = FALSE;
+}
+
+static const struct xdg_surface_listener xdg_surface_listener = {
+  handle_xdg_surface_configure,
+};
+
+static void
+handle_frame_callback (void               *data,
+                       struct wl_callback *callback,
+                       uint32_t            time)
+{
+  wl_callback_destroy (callback);
+  frame_callback = NULL;
+}
+
+static const struct wl_callback_listener frame_listener = {
+  handle_frame_callback,
+};
+
+static void
+commit_and_wait_for_frame (void)
+{
+  frame_callback = wl_surface_frame (surface);
+  wl_callback_add_listener (frame_callback, &frame_listener, NULL);
+  wl_surface_commit (surface);
+
+  while (frame_callback)
+    {
+      if (wl_display_dispatch (display->display) == -1)
+        g_error ("Failed to dispatch Wayland display");
+    }
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  display = wayland_display_new (WAYLAND_DISPLAY_CAPABILITY_TEST_DRIVER);
+
+  surface = wl_compositor_create_surface (display->compositor);
+  xdg_surface = xdg_wm_base_get_xdg_surface (display->xdg_wm_base, surface);
+  xdg_surface_add_listener (xdg_surface, &xdg_surface_listener, NULL);
+  xdg_toplevel = xdg_surface_get_toplevel (xdg_surface);
+  xdg_toplevel_add_listener (xdg_toplevel, &xdg_toplevel_listener, NULL);
+  xdg_toplevel_set_title (xdg_toplevel, "shm-udmabuf");
+
+  waiting_for_configure = TRUE;
+  wl_surface_commit (surface);
+
+  while (waiting_for_configure)
+    {
+      if (wl_display_dispatch (display->display) == -1)
+        g_error ("Failed to dispatch Wayland display");
+    }
+
+  /* A pool created from a memfd that can't shrink can be imported */
+  wl_surface_attach (surface, create_sealed_shm_buffer (0xff00ff00), 0, 0);
+  commit_and_wait_for_frame ();
+  test_driver_sync_point (display->test_driver, 0, surface);
+
+  /* Any other pool is copied from as usual */
+  draw_surface (display, surface, BUFFER_WIDTH, BUFFER_HEIGHT, 0xffff0000);
+  wl_surface_damage_buffer (surface, 0, 0, BUFFER_WIDTH, BUFFER_HEIGHT);
+  commit_and_wait_for_frame ();
+  test_driver_sync_point (display->test_driver, 1, surface);
+
+  wl_display_roundtrip (display->display);
+
+  g_clear_pointer (&xdg_toplevel, xdg_toplevel_destroy);
+  g_clear_pointer (&xdg_surface, xdg_surface_destroy);
+  g_clear_pointer (&surface, wl_surface_destroy);
+  g_clear_object (&display);
+
+  return EXIT_SUCCESS;
+}
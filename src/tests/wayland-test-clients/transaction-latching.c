@@ -0,0 +1,274 @@
+/*
+ * Copyright (C) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <glib.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <wayland-client.h>
+
+#include "wayland-test-client-utils.h"
+
+typedef struct _TestBuffer
+{
+  struct wl_buffer *buffer;
+  gboolean released;
+} TestBuffer;
+
+static WaylandDisplay *display;
+
+static struct wl_surface *surface;
+static struct xdg_surface *xdg_surface;
+static struct xdg_toplevel *xdg_toplevel;
+
+static struct wl_surface *subsurface_surface;
+static struct wl_subsurface *subsurface;
+
+static struct wl_callback *frame_callback;
+static gboolean waiting_for_configure;
+
+static void
+handle_buffer_release (void             *data,
+                       struct wl_buffer *buffer)
+{
+  TestBuffer *test_buffer = data;
+
+  test_buffer->released = TRUE;
+}
+
+static const struct wl_buffer_listener buffer_listener = {
+  handle_buffer_release
+};
+
+/* The buffers are square, their size tells them apart on the server side */
+static TestBuffer *
+test_buffer_new (int      size,
+                 uint32_t color)
+{
+  TestBuffer *test_buffer;
+  struct wl_shm_pool *pool;
+  int stride = size * 4;
+  int length = stride * size;
+  uint32_t *pixels;
+  int fd;
+  int i;
+
+  fd = create_anonymous_file (length);
+  g_assert_cmpint (fd, >=, 0);
+
+  pixels = mmap (NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  g_assert (pixels != MAP_FAILED);
+  for (i = 0; i < size * size; i++)
+    pixels[i] = color;
+  munmap (pixels, length);
+
+  test_buffer = g_new0 (TestBuffer, 1);
+
+  pool = wl_shm_create_pool (display->shm, fd, length);
+  test_buffer->buffer = wl_shm_pool_create_buffer (pool, 0,
+                                                   size, size,
+                                                   stride,
+                                                   WL_SHM_FORMAT_ARGB8888);
+  wl_buffer_add_listener (test_buffer->buffer, &buffer_listener, test_buffer);
+  wl_shm_pool_destroy (pool);
+  close (fd);
+
+  return test_buffer;
+}
+
+static void
+test_buffer_free (TestBuffer *test_buffer)
+{
+  wl_buffer_destroy (test_buffer->buffer);
+  g_free (test_buffer);
+}
+
+static void
+handle_xdg_toplevel_configure (void                *data,
+                               struct xdg_toplevel *xdg_toplevel,
+                               int32_t              width,
+                               int32_t              height,
+                               struct wl_array     *state)
+{
+}
+
+static void
+handle_xdg_toplevel_close (void                *data,
+                           struct xdg_toplevel *xdg_toplevel)
+{
+  g_assert_not_reached ();
+}
+
+static const struct xdg_toplevel_listener xdg_toplevel_listener = {
+  handle_xdg_toplevel_configure,
+  handle_xdg_toplevel_close,
+};
+
+static void
+handle_xdg_surface_configure (void               *data,
+                              struct xdg_surface *xdg_surface,
+                              uint32_t            serial)
+{
+  /* Acknowledged configures aren't content updates, so only acknowledge
+   * the initial one to not interfere with the latching being tested */
+  if (!waiting_for_configure)
+    return;
+
+  xdg_surface_ack_configure (xdg_surface, serial);
+  waiting_for_configure = FALSE;
+}
+
+static const struct xdg_surface_listener xdg_surface_listener = {
+  handle_xdg_surface_configure,
+};
+
+static void
+handle_frame_callback (void               *data,
+                       struct wl_callback *callback,
+                       uint32_t            time)
+{
+  wl_callback_destroy (callback);
+  frame_callback = NULL;
+}
+
+static const struct wl_callback_listener frame_listener = {
+  handle_frame_callback,
+};
+
+static void
+commit_and_wait_for_frame (struct wl_surface *commit_surface)
+{
+  frame_callback = wl_surface_frame (commit_surface);
+  wl_callback_add_listener (frame_callback, &frame_listener, NULL);
+  wl_surface_commit (commit_surface);
+
+  while (frame_callback)
+    {
+      if (wl_display_dispatch (display->display) == -1)
+        g_error ("Failed to dispatch Wayland display");
+    }
+}
+
+static void
+attach (struct wl_surface *attach_surface,
+        TestBuffer        *test_buffer)
+{
+  wl_surface_attach (attach_surface, test_buffer->buffer, 0, 0);
+  wl_surface_damage_buffer (attach_surface, 0, 0, G_MAXINT32, G_MAXINT32);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  g_autoptr (GPtrArray) buffers = NULL;
+  TestBuffer *superseded1;
+  TestBuffer *superseded2;
+
+  display = wayland_display_new (WAYLAND_DISPLAY_CAPABILITY_TEST_DRIVER);
+  buffers = g_ptr_array_new_with_free_func ((GDestroyNotify) test_buffer_free);
+
+  surface = wl_compositor_create_surface (display->compositor);
+  xdg_surface = xdg_wm_base_get_xdg_surface (display->xdg_wm_base, surface);
+  xdg_surface_add_listener (xdg_surface, &xdg_surface_listener, NULL);
+  xdg_toplevel = xdg_surface_get_toplevel (xdg_surface);
+  xdg_toplevel_add_listener (xdg_toplevel, &xdg_toplevel_listener, NULL);
+  xdg_toplevel_set_title (xdg_toplevel, "transaction-latching");
+
+  waiting_for_configure = TRUE;
+  wl_surface_commit (surface);
+  while (waiting_for_configure)
+    {
+      if (wl_display_dispatch (display->display) == -1)
+        g_error ("Failed to dispatch Wayland display");
+    }
+
+  g_ptr_array_add (buffers, test_buffer_new (32, 0xff0000ff));
+  attach (surface, buffers->pdata[0]);
+  commit_and_wait_for_frame (surface);
+  test_driver_sync_point (display->test_driver, 0, surface);
+
+  /* Several content updates committed in one go are applied as one, and
+   * the superseded buffers are released right away */
+  superseded1 = test_buffer_new (34, 0xff00ff00);
+  superseded2 = test_buffer_new (36, 0xffff0000);
+  g_ptr_array_add (buffers, superseded1);
+  g_ptr_array_add (buffers, superseded2);
+  g_ptr_array_add (buffers, test_buffer_new (38, 0xff00ffff));
+
+  attach (surface, superseded1);
+  wl_surface_commit (surface);
+  attach (surface, superseded2);
+  wl_surface_commit (surface);
+  attach (surface, buffers->pdata[3]);
+  commit_and_wait_for_frame (surface);
+  g_assert_true (superseded1->released);
+  g_assert_true (superseded2->released);
+  test_driver_sync_point (display->test_driver, 1, surface);
+
+  /* A synchronized subsurface content update is only applied together with
+   * the parent */
+  subsurface_surface = wl_compositor_create_surface (display->compositor);
+  subsurface = wl_subcompositor_get_subsurface (display->subcompositor,
+                                                subsurface_surface,
+                                                surface);
+  g_ptr_array_add (buffers, test_buffer_new (8, 0xffffff00));
+  attach (subsurface_surface, buffers->pdata[4]);
+  wl_surface_commit (subsurface_surface);
+  g_ptr_array_add (buffers, test_buffer_new (40, 0xff0000ff));
+  attach (surface, buffers->pdata[5]);
+  commit_and_wait_for_frame (surface);
+
+  g_ptr_array_add (buffers, test_buffer_new (10, 0xff00ff00));
+  attach (subsurface_surface, buffers->pdata[6]);
+  wl_surface_commit (subsurface_surface);
+  test_driver_sync_point (display->test_driver, 2, subsurface_surface);
+
+  g_ptr_array_add (buffers, test_buffer_new (42, 0xffff0000));
+  attach (surface, buffers->pdata[7]);
+  commit_and_wait_for_frame (surface);
+  test_driver_sync_point (display->test_driver, 3, subsurface_surface);
+
+  /* A desynchronized one on its own */
+  wl_subsurface_set_desync (subsurface);
+  g_ptr_array_add (buffers, test_buffer_new (12, 0xff00ffff));
+  attach (subsurface_surface, buffers->pdata[8]);
+  commit_and_wait_for_frame (subsurface_surface);
+  test_driver_sync_point (display->test_driver, 4, subsurface_surface);
+
+  /* Without any stage update, content updates are still applied after a
+   * while */
+  test_driver_sync_point (display->test_driver, 5, surface);
+  g_ptr_array_add (buffers, test_buffer_new (44, 0xffffff00));
+  attach (surface, buffers->pdata[9]);
+  wl_surface_commit (surface);
+  wait_for_sync_event (display, 0);
+  test_driver_sync_point (display->test_driver, 6, surface);
+
+  wl_display_roundtrip (display->display);
+
+  g_clear_pointer (&subsurface, wl_subsurface_destroy);
+  g_clear_pointer (&subsurface_surface, wl_surface_destroy);
+  g_clear_pointer (&xdg_toplevel, xdg_toplevel_destroy);
+  g_clear_pointer (&xdg_surface, xdg_surface_destroy);
+  g_clear_pointer (&surface, wl_surface_destroy);
+  g_clear_pointer (&buffers, g_ptr_array_unref);
+  g_clear_object (&display);
+
+  return EXIT_SUCCESS;
+}
@@ -29,9 +29,14 @@
 #include "tests/meta-test-utils.h"
 #include "tests/meta-wayland-test-driver.h"
 #include "tests/meta-wayland-test-utils.h"
+#include "wayland/meta-wayland-buffer.h"
 #include "wayland/meta-wayland-client-private.h"
+#include "wayland/meta-wayland-dma-buf.h"
+#include "wayland/meta-wayland-drm-syncobj.h"
 #include "wayland/meta-wayland-filter-manager.h"
+#include "wayland/meta-wayland-private.h"
 #include "wayland/meta-wayland-surface.h"
+#include "wayland/meta-wayland-udmabuf.h"
 
 #include "dummy-client-protocol.h"
 #include "dummy-server-protocol.h"
@@ -77,6 +82,329 @@ single_pixel_buffer (void)
   meta_wayland_test_client_finish (wayland_test_client);
 }
 
+static void
+assert_coalesced_shm_damage (const cairo_rectangle_int_t *damage,
+                             int                          n_damage,
+                             const cairo_rectangle_int_t *expected,
+                             int                          n_expected)
+{
+  g_autoptr (GArray) rects = NULL;
+  cairo_region_t *region;
+  int i;
+
+  region = cairo_region_create_rectangles (damage, n_damage);
+  rects = meta_wayland_buffer_coalesce_shm_damage (region);
+  cairo_region_destroy (region);
+
+  g_assert_cmpuint (rects->len, ==, n_expected);
+  for (i = 0; i < n_expected; i++)
+    {
+      cairo_rectangle_int_t *rect =
+        &g_array_index (rects, cairo_rectangle_int_t, i);
+
+      g_assert_cmpint (rect->x, ==, expected[i].x);
+      g_assert_cmpint (rect->y, ==, expected[i].y);
+      g_assert_cmpint (rect->width, ==, expected[i].width);
+      g_assert_cmpint (rect->height, ==, expected[i].height);
+    }
+}
+
+static void
+buffer_shm_damage_coalescing (void)
+{
+  /* Empty damage */
+  assert_coalesced_shm_damage (NULL, 0, NULL, 0);
+
+  /* Touching rectangles */
+  assert_coalesced_shm_damage ((cairo_rectangle_int_t[]) {
+                                 { 0, 0, 10, 10 },
+                                 { 10, 0, 10, 10 },
+                                 { 0, 10, 20, 10 },
+                               }, 3,
+                               (cairo_rectangle_int_t[]) {
+                                 { 0, 0, 20, 20 },
+                               }, 1);
+
+  /* Overlapping rectangles, split into three bands by the region */
+  assert_coalesced_shm_damage ((cairo_rectangle_int_t[]) {
+                                 { 0, 0, 20, 20 },
+                                 { 10, 10, 20, 20 },
+                               }, 2,
+                               (cairo_rectangle_int_t[]) {
+                                 { 0, 0, 30, 30 },
+                               }, 1);
+
+  /* Contained rectangle */
+  assert_coalesced_shm_damage ((cairo_rectangle_int_t[]) {
+                                 { 0, 0, 100, 100 },
+                                 { 10, 10, 10, 10 },
+                               }, 2,
+                               (cairo_rectangle_int_t[]) {
+                                 { 0, 0, 100, 100 },
+                               }, 1);
+
+  /* Uploading 64 * 64 undamaged pixels is still considered cheaper than a
+   * separate upload, one more isn't */
+  assert_coalesced_shm_damage ((cairo_rectangle_int_t[]) {
+                                 { 0, 0, 1, 1 },
+                                 { 0, 4097, 1, 1 },
+                               }, 2,
+                               (cairo_rectangle_int_t[]) {
+                                 { 0, 0, 1, 4098 },
+                               }, 1);
+  assert_coalesced_shm_damage ((cairo_rectangle_int_t[]) {
+                                 { 0, 0, 1, 1 },
+                                 { 0, 4098, 1, 1 },
+                               }, 2,
+                               (cairo_rectangle_int_t[]) {
+                                 { 0, 0, 1, 1 },
+                                 { 0, 4098, 1, 1 },
+                               }, 2);
+
+  /* Distant rectangles */
+  assert_coalesced_shm_damage ((cairo_rectangle_int_t[]) {
+                                 { 0, 0, 10, 10 },
+                                 { 200, 200, 10, 10 },
+                               }, 2,
+                               (cairo_rectangle_int_t[]) {
+                                 { 0, 0, 10, 10 },
+                                 { 200, 200, 10, 10 },
+                               }, 2);
+}
+
+static void
+drm_syncobj (void)
+{
+  MetaWaylandCompositor *compositor =
+    meta_context_get_wayland_compositor (test_context);
+  MetaWaylandDrmSyncobjManager *manager = compositor->drm_syncobj_manager;
+  MetaWaylandTestClient *wayland_test_client;
+  int i;
+
+  if (!manager)
+    {
+      g_test_skip ("Explicit sync not supported");
+      return;
+    }
+
+  meta_wayland_test_driver_set_property (
+    test_driver, "render-node-path",
+    meta_wayland_drm_syncobj_manager_get_render_node_path (manager));
+
+  wayland_test_client =
+    meta_wayland_test_client_new (test_context, "drm-syncobj");
+  for (i = 0; i < 5; i++)
+    {
+      g_test_expect_message ("libmutter", G_LOG_LEVEL_WARNING,
+                             "WL: error in client communication*");
+    }
+  meta_wayland_test_client_finish (wayland_test_client);
+  g_test_assert_expected_messages ();
+}
+
+static void
+on_shm_udmabuf_sync_point (MetaWaylandTestDriver *test_driver,
+                           unsigned int           sequence,
+                           struct wl_resource    *surface_resource,
+                           struct wl_client      *wl_client,
+                           MetaWaylandUdmabuf    *udmabuf)
+{
+  MetaWaylandSurface *surface = wl_resource_get_user_data (surface_resource);
+  MetaWaylandBuffer *buffer = surface->buffer;
+  g_autoptr (MetaWaylandDmaBufBuffer) dma_buf = NULL;
+
+  g_assert_nonnull (buffer);
+  g_assert_nonnull (wl_shm_buffer_get (buffer->resource));
+
+  /* Imported or not, a wl_shm buffer must never be mistaken for a client
+   * dma-buf, e.g. for explicit sync or direct scanout */
+  g_assert_null (meta_wayland_dma_buf_from_buffer (buffer));
+
+  dma_buf = meta_wayland_udmabuf_import_shm_buffer (udmabuf, buffer);
+
+  switch (sequence)
+    {
+    case 0:
+      /* Sealed memfd pool. Whether the dma-buf can be sampled from depends
+       * on the renderer, otherwise the buffer is copied from */
+      g_assert_nonnull (dma_buf);
+      if (buffer->type == META_WAYLAND_BUFFER_TYPE_DMA_BUF)
+        g_assert_true (buffer->dma_buf.is_udmabuf);
+      else
+        g_assert_cmpint (buffer->type, ==, META_WAYLAND_BUFFER_TYPE_SHM);
+      break;
+    case 1:
+      /* Regular pool, falls back to copying */
+      g_assert_null (dma_buf);
+      g_assert_cmpint (buffer->type, ==, META_WAYLAND_BUFFER_TYPE_SHM);
+      g_assert_false (buffer->dma_buf.is_udmabuf);
+      break;
+    default:
+      g_assert_not_reached ();
+    }
+}
+
+static void
+buffer_shm_udmabuf (void)
+{
+  MetaWaylandCompositor *compositor =
+    meta_context_get_wayland_compositor (test_context);
+  MetaWaylandUdmabuf *udmabuf;
+  MetaWaylandTestClient *wayland_test_client;
+  g_autoptr (GError) error = NULL;
+  gulong sync_point_id;
+
+  /* The experimental feature isn't enabled in tests */
+  g_assert_null (compositor->udmabuf);
+  udmabuf = meta_wayland_udmabuf_new (compositor, &error);
+  if (!udmabuf)
+    {
+      g_test_skip (error->message);
+      return;
+    }
+  compositor->udmabuf = udmabuf;
+
+  sync_point_id =
+    g_signal_connect (test_driver, "sync-point",
+                      G_CALLBACK (on_shm_udmabuf_sync_point),
+                      udmabuf);
+
+  wayland_test_client =
+    meta_wayland_test_client_new (test_context, "shm-udmabuf");
+  meta_wayland_test_client_finish (wayland_test_client);
+
+  g_signal_handler_disconnect (test_driver, sync_point_id);
+  g_clear_pointer (&compositor->udmabuf, meta_wayland_udmabuf_free);
+}
+
+typedef struct _TransactionLatchingData
+{
+  MetaWaylandSurface *surface;
+  MetaWaylandSurface *subsurface;
+  int n_applied;
+  gboolean frame_clocks_inhibited;
+} TransactionLatchingData;
+
+static int
+get_buffer_size (MetaWaylandSurface *surface)
+{
+  struct wl_shm_buffer *shm_buffer;
+
+  g_assert_nonnull (surface->buffer);
+  shm_buffer = wl_shm_buffer_get (surface->buffer->resource);
+  g_assert_nonnull (shm_buffer);
+  g_assert_cmpint (wl_shm_buffer_get_width (shm_buffer), ==,
+                   wl_shm_buffer_get_height (shm_buffer));
+
+  return wl_shm_buffer_get_width (shm_buffer);
+}
+
+static void
+set_frame_clocks_inhibited (gboolean inhibited)
+{
+  MetaBackend *backend = meta_context_get_backend (test_context);
+  ClutterActor *stage = meta_backend_get_stage (backend);
+  GList *l;
+
+  for (l = clutter_stage_peek_stage_views (CLUTTER_STAGE (stage)); l; l = l->next)
+    {
+      ClutterFrameClock *frame_clock =
+        clutter_stage_view_get_frame_clock (l->data);
+
+      if (inhibited)
+        clutter_frame_clock_inhibit (frame_clock);
+      else
+        clutter_frame_clock_uninhibit (frame_clock);
+    }
+}
+
+static void
+on_transaction_latching_state_applied (MetaWaylandSurface      *surface,
+                                       TransactionLatchingData *data)
+{
+  data->n_applied++;
+
+  if (data->frame_clocks_inhibited)
+    {
+      set_frame_clocks_inhibited (FALSE);
+      data->frame_clocks_inhibited = FALSE;
+      meta_wayland_test_driver_emit_sync_event (test_driver, 0);
+    }
+}
+
+static void
+on_transaction_latching_sync_point (MetaWaylandTestDriver   *test_driver,
+                                    unsigned int             sequence,
+                                    struct wl_resource      *surface_resource,
+                                    struct wl_client        *wl_client,
+                                    TransactionLatchingData *data)
+{
+  MetaWaylandSurface *surface = wl_resource_get_user_data (surface_resource);
+
+  switch (sequence)
+    {
+    case 0:
+      data->surface = surface;
+      g_signal_connect (surface, "pre-state-applied",
+                        G_CALLBACK (on_transaction_latching_state_applied),
+                        data);
+      g_assert_cmpint (get_buffer_size (surface), ==, 32);
+      break;
+    case 1:
+      /* The three content updates were applied as one */
+      g_assert_cmpint (data->n_applied, ==, 1);
+      g_assert_cmpint (get_buffer_size (surface), ==, 38);
+      break;
+    case 2:
+      /* The synchronized subsurface state is still cached */
+      data->subsurface = surface;
+      g_assert_cmpint (get_buffer_size (data->subsurface), ==, 8);
+      g_assert_cmpint (get_buffer_size (data->surface), ==, 40);
+      break;
+    case 3:
+      g_assert_cmpint (get_buffer_size (data->subsurface), ==, 10);
+      g_assert_cmpint (get_buffer_size (data->surface), ==, 42);
+      break;
+    case 4:
+      g_assert_cmpint (get_buffer_size (data->subsurface), ==, 12);
+      g_assert_cmpint (get_buffer_size (data->surface), ==, 42);
+      break;
+    case 5:
+      /* Nothing will latch the next content update but the timeout */
+      set_frame_clocks_inhibited (TRUE);
+      data->frame_clocks_inhibited = TRUE;
+      break;
+    case 6:
+      g_assert_false (data->frame_clocks_inhibited);
+      g_assert_cmpint (get_buffer_size (data->surface), ==, 44);
+      g_signal_handlers_disconnect_by_func (data->surface,
+                                            on_transaction_latching_state_applied,
+                                            data);
+      break;
+    default:
+      g_assert_not_reached ();
+    }
+}
+
+static void
+transaction_latching (void)
+{
+  TransactionLatchingData data = {};
+  MetaWaylandTestClient *wayland_test_client;
+  gulong sync_point_id;
+
+  sync_point_id =
+    g_signal_connect (test_driver, "sync-point",
+                      G_CALLBACK (on_transaction_latching_sync_point),
+                      &data);
+
+  wayland_test_client =
+    meta_wayland_test_client_new (test_context, "transaction-latching");
+  meta_wayland_test_client_finish (wayland_test_client);
+
+  g_signal_handler_disconnect (test_driver, sync_point_id);
+}
+
 static void
 subsurface_reparenting (void)
 {
@@ -864,6 +1192,14 @@ init_tests (void)
                    buffer_transform);
   g_test_add_func ("/wayland/buffer/single_pixel_buffer",
                    single_pixel_buffer);
+  g_test_add_func ("/wayland/buffer/shm-damage-coalescing",
+                   buffer_shm_damage_coalescing);
+  g_test_add_func ("/wayland/buffer/drm-syncobj",
+                   drm_syncobj);
+  g_test_add_func ("/wayland/buffer/shm-udmabuf",
+                   buffer_shm_udmabuf);
+  g_test_add_func ("/wayland/transaction/latching",
+                   transaction_latching);
   g_test_add_func ("/wayland/subsurface/remap-toplevel",
                    subsurface_remap_toplevel);
   g_test_add_func ("/wayland/subsurface/reparent",
@@ -51,13 +51,17 @@
 #include "wayland/meta-wayland-buffer.h"
 
 #include <drm_fourcc.h>
+#include <string.h>
+#include <unistd.h>
 
 #include "backends/meta-backend-private.h"
 #include "clutter/clutter.h"
 #include "cogl/cogl-egl.h"
 #include "meta/util.h"
 #include "wayland/meta-wayland-dma-buf.h"
+#include "wayland/meta-wayland-drm-syncobj.h"
 #include "wayland/meta-wayland-private.h"
+#include "wayland/meta-wayland-udmabuf.h"
 
 #ifdef HAVE_NATIVE_BACKEND
 #include "backends/native/meta-drm-buffer-gbm.h"
@@ -130,6 +134,34 @@ meta_wayland_buffer_is_realized (MetaWaylandBuffer *buffer)
   return buffer->type != META_WAYLAND_BUFFER_TYPE_UNKNOWN;
 }
 
+static gboolean
+try_realize_shm_udmabuf (MetaWaylandBuffer *buffer)
+{
+  MetaWaylandUdmabuf *udmabuf = buffer->compositor->udmabuf;
+  g_autoptr (GError) error = NULL;
+
+  if (!udmabuf)
+    return FALSE;
+
+  buffer->dma_buf.dma_buf =
+    meta_wayland_udmabuf_import_shm_buffer (udmabuf, buffer);
+  if (!buffer->dma_buf.dma_buf)
+    return FALSE;
+
+  if (!meta_wayland_dma_buf_realize_texture (buffer, &error))
+    {
+      meta_topic (META_DEBUG_WAYLAND,
+                  "Falling back to copying wl_buffer@%u: %s",
+                  wl_resource_get_id (buffer->resource), error->message);
+      g_clear_object (&buffer->dma_buf.dma_buf);
+      return FALSE;
+    }
+
+  buffer->dma_buf.is_udmabuf = TRUE;
+
+  return TRUE;
+}
+
 gboolean
 meta_wayland_buffer_realize (MetaWaylandBuffer *buffer)
 {
@@ -141,7 +173,10 @@ meta_wayland_buffer_realize (MetaWaylandBuffer *buffer)
 
   if (wl_shm_buffer_get (buffer->resource) != NULL)
     {
-      buffer->type = META_WAYLAND_BUFFER_TYPE_SHM;
+      if (try_realize_shm_udmabuf (buffer))
+        buffer->type = META_WAYLAND_BUFFER_TYPE_DMA_BUF;
+      else
+        buffer->type = META_WAYLAND_BUFFER_TYPE_SHM;
       return TRUE;
     }
 
@@ -660,6 +695,31 @@ meta_wayland_buffer_inc_use_count (MetaWaylandBuffer *buffer)
   buffer->use_count++;
 }
 
+static void
+signal_release_points (MetaWaylandBuffer *buffer)
+{
+  MetaContext *context =
+    meta_wayland_compositor_get_context (buffer->compositor);
+  MetaBackend *backend = meta_context_get_backend (context);
+  ClutterBackend *clutter_backend = meta_backend_get_clutter_backend (backend);
+  CoglContext *cogl_context =
+    clutter_backend_get_cogl_context (clutter_backend);
+  int sync_fd;
+  unsigned int i;
+
+  /* Any rendering still sampling from the buffer has been submitted by now,
+   * so the latest fence covers all of it */
+  sync_fd = cogl_context_get_latest_sync_fd (cogl_context);
+
+  for (i = 0; i < buffer->release_points->len; i++)
+    meta_wayland_sync_point_signal (buffer->release_points->pdata[i], sync_fd);
+
+  g_ptr_array_set_size (buffer->release_points, 0);
+
+  if (sync_fd >= 0)
+    close (sync_fd);
+}
+
 void
 meta_wayland_buffer_dec_use_count (MetaWaylandBuffer *buffer)
 {
@@ -667,16 +727,386 @@ meta_wayland_buffer_dec_use_count (MetaWaylandBuffer *buffer)
 
   buffer->use_count--;
 
-  if (buffer->use_count == 0 && buffer->resource)
+  if (buffer->use_count > 0)
+    return;
+
+  if (buffer->release_points && buffer->release_points->len > 0)
+    signal_release_points (buffer);
+
+  if (buffer->resource)
     wl_buffer_send_release (buffer->resource);
 }
 
+/**
+ * meta_wayland_buffer_add_release_point:
+ * @buffer: A #MetaWaylandBuffer
+ * @sync_point: (transfer full): An explicit sync release point
+ *
+ * Adds a release point to signal once the buffer isn't used anymore, i.e.
+ * when its use count drops to 0.
+ */
+void
+meta_wayland_buffer_add_release_point (MetaWaylandBuffer    *buffer,
+                                       MetaWaylandSyncPoint *sync_point)
+{
+  g_return_if_fail (buffer->use_count > 0);
+
+  if (!buffer->release_points)
+    {
+      buffer->release_points =
+        g_ptr_array_new_with_free_func ((GDestroyNotify) meta_wayland_sync_point_free);
+    }
+
+  g_ptr_array_add (buffer->release_points, sync_point);
+}
+
 gboolean
 meta_wayland_buffer_is_y_inverted (MetaWaylandBuffer *buffer)
 {
   return buffer->is_y_inverted;
 }
 
+/*
+ * Uploading a rectangle has a fixed cost on top of the cost of copying its
+ * pixels. Damage rectangles are merged as long as the pixels needlessly
+ * uploaded that way cost less than the uploads saved.
+ */
+#define SHM_UPLOAD_OVERHEAD_PIXELS (64 * 64)
+
+/* Uploads of at least this size are staged in a pixel buffer filled by
+ * multiple threads */
+#define SHM_STAGING_MIN_BYTES (1024 * 1024)
+#define SHM_STAGING_BYTES_PER_JOB (256 * 1024)
+#define SHM_STAGING_MAX_WORKERS 3
+
+typedef struct _ShmCopyJob
+{
+  const uint8_t *src;
+  uint8_t *dst;
+  int src_stride;
+  int dst_stride;
+  int row_size;
+  int n_rows;
+} ShmCopyJob;
+
+typedef struct _ShmCopy
+{
+  struct wl_shm_buffer *shm_buffer;
+  GArray *jobs;
+  int next_job;
+
+  GMutex mutex;
+  GCond cond;
+  int n_running_workers;
+} ShmCopy;
+
+static int64_t
+rectangle_area (const cairo_rectangle_int_t *rect)
+{
+  return (int64_t) rect->width * rect->height;
+}
+
+/*
+ * The rectangles of a cairo region are sorted in horizontal bands from top
+ * to bottom, so merging each into the previous one if cheap enough first
+ * joins spans of the same rows and then consecutive rows.
+ */
+GArray *
+meta_wayland_buffer_coalesce_shm_damage (cairo_region_t *region)
+{
+  GArray *rects;
+  cairo_rectangle_int_t current;
+  int64_t current_damaged_area = 0;
+  int i, n_rectangles;
+
+  n_rectangles = cairo_region_num_rectangles (region);
+  rects = g_array_sized_new (FALSE, FALSE, sizeof (cairo_rectangle_int_t),
+                             n_rectangles);
+
+  for (i = 0; i < n_rectangles; i++)
+    {
+      cairo_rectangle_int_t rect;
+      cairo_rectangle_int_t merged;
+      int x2, y2;
+
+      cairo_region_get_rectangle (region, i, &rect);
+
+      if (i == 0)
+        {
+          current = rect;
+          current_damaged_area = rectangle_area (&rect);
+          continue;
+        }
+
+      x2 = MAX (current.x + current.width, rect.x + rect.width);
+      y2 = MAX (current.y + current.height, rect.y + rect.height);
+      merged.x = MIN (current.x, rect.x);
+      merged.y = MIN (current.y, rect.y);
+      merged.width = x2 - merged.x;
+      merged.height = y2 - merged.y;
+
+      if (rectangle_area (&merged) -
+          (current_damaged_area + rectangle_area (&rect)) <=
+          SHM_UPLOAD_OVERHEAD_PIXELS)
+        {
+          current = merged;
+          current_damaged_area += rectangle_area (&rect);
+        }
+      else
+        {
+          g_array_append_val (rects, current);
+          current = rect;
+          current_damaged_area = rectangle_area (&rect);
+        }
+    }
+
+  if (n_rectangles > 0)
+    g_array_append_val (rects, current);
+
+  return rects;
+}
+
+static void
+run_shm_copy_jobs (ShmCopy *copy)
+{
+  while (TRUE)
+    {
+      int job_index = g_atomic_int_add (&copy->next_job, 1);
+      ShmCopyJob *job;
+      int row;
+
+      if (job_index >= (int) copy->jobs->len)
+        break;
+
+      job = &g_array_index (copy->jobs, ShmCopyJob, job_index);
+      for (row = 0; row < job->n_rows; row++)
+        {
+          memcpy (job->dst + row * job->dst_stride,
+                  job->src + row * job->src_stride,
+                  job->row_size);
+        }
+    }
+}
+
+static void
+shm_copy_worker_func (gpointer data,
+                      gpointer user_data)
+{
+  ShmCopy *copy = data;
+
+  /* The SIGBUS handling of wl_shm is per thread */
+  wl_shm_buffer_begin_access (copy->shm_buffer);
+  run_shm_copy_jobs (copy);
+  wl_shm_buffer_end_access (copy->shm_buffer);
+
+  g_mutex_lock (&copy->mutex);
+  copy->n_running_workers--;
+  g_cond_signal (&copy->cond);
+  g_mutex_unlock (&copy->mutex);
+}
+
+static int
+get_n_shm_copy_workers (void)
+{
+  static int n_workers = -1;
+
+  if (n_workers < 0)
+    {
+      n_workers = CLAMP ((int) g_get_num_processors () - 1,
+                         0, SHM_STAGING_MAX_WORKERS);
+    }
+
+  return n_workers;
+}
+
+static GThreadPool *
+ensure_shm_copy_thread_pool (MetaWaylandCompositor *compositor)
+{
+  if (!compositor->shm_copy_thread_pool)
+    {
+      compositor->shm_copy_thread_pool =
+        g_thread_pool_new (shm_copy_worker_func,
+                           NULL,
+                           get_n_shm_copy_workers (),
+                           FALSE,
+                           NULL);
+    }
+
+  return compositor->shm_copy_thread_pool;
+}
+
+/*
+ * Copies the damaged rectangles packed after each other into the mapped
+ * staging buffer, split into jobs which are run by the calling thread and
+ * the worker threads.
+ */
+static void
+copy_shm_damage (MetaWaylandCompositor *compositor,
+                 struct wl_shm_buffer  *shm_buffer,
+                 GArray                *rects,
+                 int                    bpp,
+                 uint8_t               *staging_data)
+{
+  const uint8_t *data = wl_shm_buffer_get_data (shm_buffer);
+  int32_t stride = wl_shm_buffer_get_stride (shm_buffer);
+  ShmCopy copy = { 0 };
+  size_t offset = 0;
+  int n_workers;
+  int i;
+
+  copy.shm_buffer = shm_buffer;
+  copy.jobs = g_array_new (FALSE, FALSE, sizeof (ShmCopyJob));
+
+  for (i = 0; i < rects->len; i++)
+    {
+      cairo_rectangle_int_t *rect =
+        &g_array_index (rects, cairo_rectangle_int_t, i);
+      int row_size = rect->width * bpp;
+      int rows_per_job = MAX (SHM_STAGING_BYTES_PER_JOB / row_size, 1);
+      int row;
+
+      for (row = 0; row < rect->height; row += rows_per_job)
+        {
+          ShmCopyJob job;
+
+          job.src = data + (rect->y + row) * stride + rect->x * bpp;
+          job.dst = staging_data + offset + (size_t) row * row_size;
+          job.src_stride = stride;
+          job.dst_stride = row_size;
+          job.row_size = row_size;
+          job.n_rows = MIN (rows_per_job, rect->height - row);
+          g_array_append_val (copy.jobs, job);
+        }
+
+      offset += (size_t) row_size * rect->height;
+    }
+
+  n_workers = MIN (get_n_shm_copy_workers (), (int) copy.jobs->len - 1);
+  if (n_workers > 0)
+    {
+      GThreadPool *thread_pool = ensure_shm_copy_thread_pool (compositor);
+
+      g_mutex_init (&copy.mutex);
+      g_cond_init (&copy.cond);
+      copy.n_running_workers = n_workers;
+
+      for (i = 0; i < n_workers; i++)
+        g_thread_pool_push (thread_pool, &copy, NULL);
+    }
+
+  run_shm_copy_jobs (&copy);
+
+  if (n_workers > 0)
+    {
+      g_mutex_lock (&copy.mutex);
+      while (copy.n_running_workers > 0)
+        g_cond_wait (&copy.cond, &copy.mutex);
+      g_mutex_unlock (&copy.mutex);
+
+      g_cond_clear (&copy.cond);
+      g_mutex_clear (&copy.mutex);
+    }
+
+  g_array_free (copy.jobs, TRUE);
+}
+
+static CoglPixelBuffer *
+ensure_shm_staging_buffer (MetaWaylandBuffer *buffer,
+                           size_t             size)
+{
+  MetaWaylandCompositor *compositor = buffer->compositor;
+  MetaContext *context = meta_wayland_compositor_get_context (compositor);
+  MetaBackend *backend = meta_context_get_backend (context);
+  ClutterBackend *clutter_backend = meta_backend_get_clutter_backend (backend);
+  CoglContext *cogl_context =
+    clutter_backend_get_cogl_context (clutter_backend);
+
+  if (!cogl_has_feature (cogl_context, COGL_FEATURE_ID_MAP_BUFFER_FOR_WRITE))
+    return NULL;
+
+  if (compositor->shm_staging_buffer &&
+      cogl_buffer_get_size (COGL_BUFFER (compositor->shm_staging_buffer)) < size)
+    g_clear_pointer (&compositor->shm_staging_buffer, cogl_object_unref);
+
+  if (!compositor->shm_staging_buffer)
+    {
+      compositor->shm_staging_buffer =
+        cogl_pixel_buffer_new (cogl_context, size, NULL);
+      cogl_buffer_set_update_hint (COGL_BUFFER (compositor->shm_staging_buffer),
+                                   COGL_BUFFER_UPDATE_HINT_STREAM);
+    }
+
+  return compositor->shm_staging_buffer;
+}
+
+static gboolean
+upload_shm_damage_staged (MetaWaylandBuffer    *buffer,
+                          struct wl_shm_buffer *shm_buffer,
+                          CoglTexture          *cogl_texture,
+                          CoglPixelFormat       format,
+                          GArray               *rects,
+                          size_t                size,
+                          GError              **error)
+{
+  CoglPixelBuffer *staging_buffer;
+  uint8_t *staging_data;
+  size_t offset = 0;
+  int bpp;
+  int i;
+
+  staging_buffer = ensure_shm_staging_buffer (buffer, size);
+  if (!staging_buffer)
+    return FALSE;
+
+  /* Discarding lets the driver hand out fresh storage instead of waiting
+   * for the previous uploads from the buffer to finish */
+  staging_data = cogl_buffer_map_range (COGL_BUFFER (staging_buffer),
+                                        0, size,
+                                        COGL_BUFFER_ACCESS_WRITE,
+                                        COGL_BUFFER_MAP_HINT_DISCARD,
+                                        NULL);
+  if (!staging_data)
+    return FALSE;
+
+  bpp = cogl_pixel_format_get_bytes_per_pixel (format, 0);
+  copy_shm_damage (buffer->compositor, shm_buffer, rects, bpp, staging_data);
+
+  cogl_buffer_unmap (COGL_BUFFER (staging_buffer));
+
+  for (i = 0; i < rects->len; i++)
+    {
+      cairo_rectangle_int_t *rect =
+        &g_array_index (rects, cairo_rectangle_int_t, i);
+      int row_size = rect->width * bpp;
+      CoglBitmap *bitmap;
+      gboolean uploaded;
+
+      bitmap = cogl_bitmap_new_from_buffer (COGL_BUFFER (staging_buffer),
+                                            format,
+                                            rect->width, rect->height,
+                                            row_size,
+                                            offset);
+      uploaded = cogl_texture_set_region_from_bitmap (cogl_texture,
+                                                      0, 0,
+                                                      rect->x, rect->y,
+                                                      rect->width,
+                                                      rect->height,
+                                                      bitmap);
+      cogl_object_unref (bitmap);
+
+      if (!uploaded)
+        {
+          g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+                       "Failed to upload staged damage");
+          return FALSE;
+        }
+
+      offset += (size_t) row_size * rect->height;
+    }
+
+  return TRUE;
+}
+
 static gboolean
 process_shm_buffer_damage (MetaWaylandBuffer *buffer,
                            MetaMultiTexture  *texture,
@@ -684,37 +1114,61 @@ process_shm_buffer_damage (MetaWaylandBuffer *buffer,
                            GError           **error)
 {
   struct wl_shm_buffer *shm_buffer;
-  int i, n_rectangles;
   gboolean set_texture_failed = FALSE;
   CoglPixelFormat format;
   CoglTexture *cogl_texture;
-
-  n_rectangles = cairo_region_num_rectangles (region);
+  g_autoptr (GArray) rects = NULL;
+  size_t size = 0;
+  int bpp;
+  int i;
 
   shm_buffer = wl_shm_buffer_get (buffer->resource);
 
   shm_buffer_get_cogl_pixel_format (buffer, shm_buffer, &format);
   g_return_val_if_fail (cogl_pixel_format_get_n_planes (format) == 1, FALSE);
   cogl_texture = meta_multi_texture_get_plane (texture, 0);
+  bpp = cogl_pixel_format_get_bytes_per_pixel (format, 0);
+
+  rects = meta_wayland_buffer_coalesce_shm_damage (region);
+  for (i = 0; i < rects->len; i++)
+    {
+      cairo_rectangle_int_t *rect =
+        &g_array_index (rects, cairo_rectangle_int_t, i);
+
+      size += (size_t) rectangle_area (rect) * bpp;
+    }
 
   wl_shm_buffer_begin_access (shm_buffer);
 
-  for (i = 0; i < n_rectangles; i++)
+  /* Only 32 bit formats are uploaded without conversion everywhere, which
+   * would otherwise have to read back from the staging buffer */
+  if (size >= SHM_STAGING_MIN_BYTES && bpp == 4 &&
+      upload_shm_damage_staged (buffer, shm_buffer, cogl_texture, format,
+                                rects, size, error))
+    {
+      wl_shm_buffer_end_access (shm_buffer);
+      return TRUE;
+    }
+
+  if (error && *error)
+    {
+      wl_shm_buffer_end_access (shm_buffer);
+      return FALSE;
+    }
+
+  for (i = 0; i < rects->len; i++)
     {
       const uint8_t *data = wl_shm_buffer_get_data (shm_buffer);
       int32_t stride = wl_shm_buffer_get_stride (shm_buffer);
-      cairo_rectangle_int_t rect;
-      int bpp;
-
-      bpp = cogl_pixel_format_get_bytes_per_pixel (format, 0);
-      cairo_region_get_rectangle (region, i, &rect);
+      cairo_rectangle_int_t *rect =
+        &g_array_index (rects, cairo_rectangle_int_t, i);
 
       if (!_cogl_texture_set_region (cogl_texture,
-                                     rect.width, rect.height,
+                                     rect->width, rect->height,
                                      format,
                                      stride,
-                                     data + rect.x * bpp + rect.y * stride,
-                                     rect.x, rect.y,
+                                     data + rect->x * bpp + rect->y * stride,
+                                     rect->x, rect->y,
                                      0,
                                      error))
         {
@@ -849,6 +1303,15 @@ meta_wayland_buffer_try_acquire_scanout (MetaWaylandBuffer *buffer,
       {
         MetaWaylandDmaBufBuffer *dma_buf;
 
+        /* udmabufs are backed by pages of system memory that display
+         * controllers generally can't scan out from */
+        if (buffer->dma_buf.is_udmabuf)
+          {
+            meta_topic (META_DEBUG_RENDER,
+                        "Shared memory buffer not scanout compatible");
+            return NULL;
+          }
+
         dma_buf = meta_wayland_dma_buf_from_buffer (buffer);
         if (!dma_buf)
           return NULL;
@@ -875,6 +1338,8 @@ meta_wayland_buffer_finalize (GObject *object)
 
   g_warn_if_fail (buffer->use_count == 0);
 
+  g_clear_pointer (&buffer->release_points, g_ptr_array_unref);
+
   clear_tainted_scanout_onscreens (buffer);
   g_clear_pointer (&buffer->tainted_scanout_onscreens, g_hash_table_unref);
 
@@ -28,6 +28,7 @@
 #include <wayland-server.h>
 
 #include "cogl/cogl.h"
+#include "core/util-private.h"
 #include "meta/meta-multi-texture.h"
 #include "wayland/meta-wayland-types.h"
 #include "wayland/meta-wayland-egl-stream.h"
@@ -74,6 +75,8 @@ struct _MetaWaylandBuffer
   struct {
     MetaWaylandDmaBufBuffer *dma_buf;
     MetaMultiTexture *texture;
+    /* wl_shm buffer imported as a dma-buf using udmabuf */
+    gboolean is_udmabuf;
   } dma_buf;
 
   struct {
@@ -82,6 +85,9 @@ struct _MetaWaylandBuffer
   } single_pixel;
 
   GHashTable *tainted_scanout_onscreens;
+
+  /* Explicit sync release points to signal when the use count drops to 0 */
+  GPtrArray *release_points;
 };
 
 #define META_TYPE_WAYLAND_BUFFER (meta_wayland_buffer_get_type ())
@@ -99,6 +105,8 @@ gboolean                meta_wayland_buffer_attach              (MetaWaylandBuff
 CoglSnippet *           meta_wayland_buffer_create_snippet      (MetaWaylandBuffer     *buffer);
 void                    meta_wayland_buffer_inc_use_count       (MetaWaylandBuffer     *buffer);
 void                    meta_wayland_buffer_dec_use_count       (MetaWaylandBuffer     *buffer);
+void                    meta_wayland_buffer_add_release_point   (MetaWaylandBuffer     *buffer,
+                                                                 MetaWaylandSyncPoint  *sync_point);
 gboolean                meta_wayland_buffer_is_y_inverted       (MetaWaylandBuffer     *buffer);
 void                    meta_wayland_buffer_process_damage      (MetaWaylandBuffer     *buffer,
                                                                  MetaMultiTexture      *texture,
@@ -107,3 +115,6 @@ CoglScanout *           meta_wayland_buffer_try_acquire_scanout (MetaWaylandBuff
                                                                  CoglOnscreen          *onscreen);
 
 void meta_wayland_init_shm (MetaWaylandCompositor *compositor);
+
+META_EXPORT_TEST
+GArray * meta_wayland_buffer_coalesce_shm_damage (cairo_region_t *region);
@@ -111,6 +111,11 @@ typedef struct _MetaWaylandDmaBufSurfaceFeedback
   MetaWaylandDmaBufFeedback *feedback;
   GList *resources;
   gulong scanout_candidate_changed_id;
+  gulong scanout_failed_id;
+
+  /* Format of the last buffer feedback was re-sent for after failed scanout */
+  uint32_t scanout_failed_drm_format;
+  uint64_t scanout_failed_drm_modifier;
 } MetaWaylandDmaBufSurfaceFeedback;
 
 struct _MetaWaylandDmaBufManager
@@ -332,7 +337,7 @@ meta_wayland_dma_buf_feedback_copy (MetaWaylandDmaBufFeedback *feedback)
   return new_feedback;
 }
 
-static gboolean
+gboolean
 meta_wayland_dma_buf_realize_texture (MetaWaylandBuffer  *buffer,
                                       GError            **error)
 {
@@ -812,7 +817,8 @@ meta_wayland_dma_buf_fds_for_wayland_buffer (MetaWaylandBuffer *buffer)
  * request of linux_dmabuf_unstable_v1.
  *
  * Returns: (transfer none): The corresponding #MetaWaylandDmaBufBuffer (or
- * %NULL if it wasn't a dma_buf-based wayland buffer)
+ * %NULL if it wasn't a dma_buf-based wayland buffer, which includes wl_shm
+ * buffers imported using udmabuf)
  */
 MetaWaylandDmaBufBuffer *
 meta_wayland_dma_buf_from_buffer (MetaWaylandBuffer *buffer)
@@ -820,6 +826,9 @@ meta_wayland_dma_buf_from_buffer (MetaWaylandBuffer *buffer)
   if (!buffer->resource)
     return NULL;
 
+  if (buffer->dma_buf.is_udmabuf)
+    return NULL;
+
   if (wl_resource_instance_of (buffer->resource, &wl_buffer_interface,
                                &dma_buf_buffer_impl))
     return wl_resource_get_user_data (buffer->resource);
@@ -1113,6 +1122,46 @@ dma_buf_handle_destroy (struct wl_client   *client,
   wl_resource_destroy (resource);
 }
 
+/**
+ * meta_wayland_dma_buf_buffer_new_linear:
+ * @dma_buf_manager: a #MetaWaylandDmaBufManager
+ * @fd: (transfer full): the dma-buf file descriptor
+ * @width: the width of the buffer
+ * @height: the height of the buffer
+ * @drm_format: the DRM fourcc of the buffer
+ * @offset: the offset of the first pixel within @fd
+ * @stride: the stride of the buffer
+ *
+ * Wraps a single plane, linear dma-buf that was not created through the
+ * linux-dmabuf protocol, e.g. one exported from a wl_shm pool.
+ *
+ * Returns: (transfer full): A new #MetaWaylandDmaBufBuffer
+ */
+MetaWaylandDmaBufBuffer *
+meta_wayland_dma_buf_buffer_new_linear (MetaWaylandDmaBufManager *dma_buf_manager,
+                                        int                       fd,
+                                        int                       width,
+                                        int                       height,
+                                        uint32_t                  drm_format,
+                                        uint32_t                  offset,
+                                        uint32_t                  stride)
+{
+  MetaWaylandDmaBufBuffer *dma_buf;
+
+  dma_buf = g_object_new (META_TYPE_WAYLAND_DMA_BUF_BUFFER, NULL);
+  dma_buf->manager = dma_buf_manager;
+  dma_buf->width = width;
+  dma_buf->height = height;
+  dma_buf->drm_format = drm_format;
+  dma_buf->drm_modifier = DRM_FORMAT_MOD_LINEAR;
+  dma_buf->is_y_inverted = TRUE;
+  dma_buf->fds[0] = fd;
+  dma_buf->offsets[0] = offset;
+  dma_buf->strides[0] = stride;
+
+  return dma_buf;
+}
+
 static void
 dma_buf_handle_create_buffer_params (struct wl_client   *client,
                                      struct wl_resource *dma_buf_resource,
@@ -1305,6 +1354,28 @@ ensure_scanout_tranche (MetaWaylandDmaBufSurfaceFeedback *surface_feedback,
   meta_wayland_dma_buf_feedback_add_tranche (feedback, tranche);
 }
 
+static gboolean
+crtc_supports_dma_buf (MetaWaylandDmaBufManager *dma_buf_manager,
+                       MetaCrtcKms              *crtc_kms,
+                       MetaWaylandDmaBufBuffer  *dma_buf)
+{
+  MetaContext *context =
+    meta_wayland_compositor_get_context (dma_buf_manager->compositor);
+  MetaBackend *backend = meta_context_get_backend (context);
+
+  if (should_send_modifiers (backend))
+    {
+      return crtc_supports_modifier (crtc_kms,
+                                     dma_buf->drm_format,
+                                     dma_buf->drm_modifier);
+    }
+  else
+    {
+      return (dma_buf->drm_modifier == DRM_FORMAT_MOD_INVALID &&
+              meta_crtc_kms_supports_format (crtc_kms, dma_buf->drm_format));
+    }
+}
+
 static void
 clear_scanout_tranche (MetaWaylandDmaBufSurfaceFeedback *surface_feedback)
 {
@@ -1345,6 +1416,65 @@ on_scanout_candidate_changed (MetaWaylandSurface               *surface,
 
   update_surface_feedback_tranches (surface_feedback);
 
+  surface_feedback->scanout_failed_drm_format = 0;
+  surface_feedback->scanout_failed_drm_modifier = 0;
+
+  for (l = surface_feedback->resources; l; l = l->next)
+    {
+      struct wl_resource *resource = l->data;
+
+      meta_wayland_dma_buf_feedback_send (surface_feedback->feedback,
+                                          surface_feedback->dma_buf_manager,
+                                          resource);
+    }
+}
+
+/*
+ * Clients that didn't pick a format and modifier from the scanout tranche,
+ * e.g. because they allocated their buffers before it was advertised, get
+ * the feedback once more as a hint to reallocate.
+ */
+static void
+on_scanout_failed (MetaWaylandSurface               *surface,
+                   MetaWaylandDmaBufSurfaceFeedback *surface_feedback)
+{
+#ifdef HAVE_NATIVE_BACKEND
+  MetaCrtc *crtc;
+  MetaWaylandBuffer *buffer;
+  MetaWaylandDmaBufBuffer *dma_buf;
+  GList *l;
+
+  crtc = meta_wayland_surface_get_scanout_candidate (surface);
+  if (!crtc || !META_IS_CRTC_KMS (crtc))
+    return;
+
+  buffer = meta_wayland_surface_get_buffer (surface);
+  if (!buffer || !buffer->resource ||
+      !wl_resource_instance_of (buffer->resource, &wl_buffer_interface,
+                                &dma_buf_buffer_impl))
+    return;
+
+  dma_buf = wl_resource_get_user_data (buffer->resource);
+
+  if (crtc_supports_dma_buf (surface_feedback->dma_buf_manager,
+                             META_CRTC_KMS (crtc),
+                             dma_buf))
+    return;
+
+  if (surface_feedback->scanout_failed_drm_format == dma_buf->drm_format &&
+      surface_feedback->scanout_failed_drm_modifier == dma_buf->drm_modifier)
+    return;
+
+  surface_feedback->scanout_failed_drm_format = dma_buf->drm_format;
+  surface_feedback->scanout_failed_drm_modifier = dma_buf->drm_modifier;
+
+  meta_topic (META_DEBUG_WAYLAND,
+              "Re-sending dma-buf feedback for surface %u, buffer format "
+              "0x%x modifier 0x%" G_GINT64_MODIFIER "x can't be scanned out",
+              wl_resource_get_id (surface->resource),
+              dma_buf->drm_format,
+              dma_buf->drm_modifier);
+
   for (l = surface_feedback->resources; l; l = l->next)
     {
       struct wl_resource *resource = l->data;
@@ -1353,6 +1483,7 @@ on_scanout_candidate_changed (MetaWaylandSurface               *surface,
                                           surface_feedback->dma_buf_manager,
                                           resource);
     }
+#endif /* HAVE_NATIVE_BACKEND */
 }
 
 static void
@@ -1391,6 +1522,10 @@ ensure_surface_feedback (MetaWaylandDmaBufManager *dma_buf_manager,
     g_signal_connect (surface, "notify::scanout-candidate",
                       G_CALLBACK (on_scanout_candidate_changed),
                       surface_feedback);
+  surface_feedback->scanout_failed_id =
+    g_signal_connect (surface, "scanout-failed",
+                      G_CALLBACK (on_scanout_failed),
+                      surface_feedback);
 
   g_object_set_qdata_full (G_OBJECT (surface),
                            quark_dma_buf_surface_feedback,
@@ -1415,6 +1550,8 @@ surface_feedback_destructor (struct wl_resource *resource)
     {
       g_clear_signal_handler (&surface_feedback->scanout_candidate_changed_id,
                               surface_feedback->surface);
+      g_clear_signal_handler (&surface_feedback->scanout_failed_id,
+                              surface_feedback->surface);
       g_object_set_qdata (G_OBJECT (surface_feedback->surface),
                           quark_dma_buf_surface_feedback, NULL);
     }
@@ -30,6 +30,7 @@
 #include <glib-object.h>
 
 #include "cogl/cogl.h"
+#include "core/util-private.h"
 #include "meta/meta-multi-texture.h"
 #include "wayland/meta-wayland-types.h"
 
@@ -46,6 +47,19 @@ typedef struct _MetaWaylandDmaBufBuffer MetaWaylandDmaBufBuffer;
 MetaWaylandDmaBufManager * meta_wayland_dma_buf_manager_new (MetaWaylandCompositor  *compositor,
                                                              GError                **error);
 
+MetaWaylandDmaBufBuffer *
+meta_wayland_dma_buf_buffer_new_linear (MetaWaylandDmaBufManager *dma_buf_manager,
+                                        int                       fd,
+                                        int                       width,
+                                        int                       height,
+                                        uint32_t                  drm_format,
+                                        uint32_t                  offset,
+                                        uint32_t                  stride);
+
+gboolean
+meta_wayland_dma_buf_realize_texture (MetaWaylandBuffer  *buffer,
+                                      GError            **error);
+
 gboolean
 meta_wayland_dma_buf_buffer_attach (MetaWaylandBuffer  *buffer,
                                     MetaMultiTexture  **texture,
@@ -54,6 +68,7 @@ meta_wayland_dma_buf_buffer_attach (MetaWaylandBuffer  *buffer,
 MetaWaylandDmaBufBuffer *
 meta_wayland_dma_buf_fds_for_wayland_buffer (MetaWaylandBuffer *buffer);
 
+META_EXPORT_TEST
 MetaWaylandDmaBufBuffer *
 meta_wayland_dma_buf_from_buffer (MetaWaylandBuffer *buffer);
 
@@ -0,0 +1,731 @@
+/*
+ * Copyright (C) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * MetaWaylandDrmSyncobj
+ *
+ * Implements the linux-drm-syncobj-v1 explicit synchronization protocol
+ *
+ * Clients using explicit synchronization pass a DRM timeline syncobj point
+ * which is signalled once the content of an attached buffer is ready
+ * (acquire point), and one which the compositor signals once it is done
+ * accessing the buffer (release point). This replaces the implicit
+ * synchronization via the dma-buf fences.
+ */
+
+#include "config.h"
+
+#include "wayland/meta-wayland-drm-syncobj.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <glib-unix.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <xf86drm.h>
+
+#include "backends/meta-backend-private.h"
+#include "backends/meta-egl-ext.h"
+#include "backends/meta-egl.h"
+#include "cogl/cogl-egl.h"
+#include "cogl/cogl.h"
+#include "meta/meta-backend.h"
+#include "wayland/meta-wayland-buffer.h"
+#include "wayland/meta-wayland-private.h"
+#include "wayland/meta-wayland-surface.h"
+#include "wayland/meta-wayland-versions.h"
+
+#include "linux-drm-syncobj-v1-server-protocol.h"
+
+struct _MetaWaylandDrmSyncobjManager
+{
+  GObject parent;
+
+  MetaWaylandCompositor *compositor;
+  struct wl_global *global;
+  char *render_node_path;
+  int drm_fd;
+};
+
+struct _MetaWaylandSyncobjTimeline
+{
+  GObject parent;
+
+  MetaWaylandDrmSyncobjManager *manager;
+  uint32_t drm_syncobj;
+};
+
+typedef struct _MetaWaylandSyncPointSource
+{
+  GSource base;
+
+  MetaWaylandDmaBufSourceDispatch dispatch;
+  MetaWaylandBuffer *buffer;
+  gpointer user_data;
+
+  int event_fd;
+} MetaWaylandSyncPointSource;
+
+G_DEFINE_TYPE (MetaWaylandDrmSyncobjManager, meta_wayland_drm_syncobj_manager,
+               G_TYPE_OBJECT)
+
+G_DEFINE_TYPE (MetaWaylandSyncobjTimeline, meta_wayland_syncobj_timeline,
+               G_TYPE_OBJECT)
+
+static MetaWaylandSyncobjTimeline *
+meta_wayland_syncobj_timeline_new (MetaWaylandDrmSyncobjManager *manager,
+                                   uint32_t                      drm_syncobj)
+{
+  MetaWaylandSyncobjTimeline *timeline;
+
+  timeline = g_object_new (META_TYPE_WAYLAND_SYNCOBJ_TIMELINE, NULL);
+  timeline->manager = g_object_ref (manager);
+  timeline->drm_syncobj = drm_syncobj;
+
+  return timeline;
+}
+
+static void
+meta_wayland_syncobj_timeline_finalize (GObject *object)
+{
+  MetaWaylandSyncobjTimeline *timeline = META_WAYLAND_SYNCOBJ_TIMELINE (object);
+
+  drmSyncobjDestroy (timeline->manager->drm_fd, timeline->drm_syncobj);
+  g_clear_object (&timeline->manager);
+
+  G_OBJECT_CLASS (meta_wayland_syncobj_timeline_parent_class)->finalize (object);
+}
+
+static void
+meta_wayland_syncobj_timeline_class_init (MetaWaylandSyncobjTimelineClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = meta_wayland_syncobj_timeline_finalize;
+}
+
+static void
+meta_wayland_syncobj_timeline_init (MetaWaylandSyncobjTimeline *timeline)
+{
+}
+
+static MetaWaylandSyncPoint *
+meta_wayland_sync_point_new (MetaWaylandSyncobjTimeline *timeline,
+                             uint32_t                    point_hi,
+                             uint32_t                    point_lo)
+{
+  MetaWaylandSyncPoint *sync_point;
+
+  sync_point = g_new0 (MetaWaylandSyncPoint, 1);
+  sync_point->timeline = g_object_ref (timeline);
+  sync_point->sync_point = (uint64_t) point_hi << 32 | point_lo;
+
+  return sync_point;
+}
+
+void
+meta_wayland_sync_point_free (MetaWaylandSyncPoint *sync_point)
+{
+  g_clear_object (&sync_point->timeline);
+  g_free (sync_point);
+}
+
+/**
+ * meta_wayland_sync_point_signal:
+ * @sync_point: A #MetaWaylandSyncPoint
+ * @sync_fd: A sync file descriptor, or -1
+ *
+ * Makes the sync point signalled once the fence of @sync_fd is, or right away
+ * if @sync_fd is -1. The caller keeps the ownership of @sync_fd.
+ */
+void
+meta_wayland_sync_point_signal (MetaWaylandSyncPoint *sync_point,
+                                int                   sync_fd)
+{
+  MetaWaylandSyncobjTimeline *timeline = sync_point->timeline;
+  int drm_fd = timeline->manager->drm_fd;
+
+  if (sync_fd >= 0)
+    {
+      uint32_t tmp_syncobj;
+
+      if (drmSyncobjCreate (drm_fd, 0, &tmp_syncobj) == 0)
+        {
+          int ret;
+
+          ret = drmSyncobjImportSyncFile (drm_fd, tmp_syncobj, sync_fd);
+          if (ret == 0)
+            {
+              ret = drmSyncobjTransfer (drm_fd,
+                                        timeline->drm_syncobj,
+                                        sync_point->sync_point,
+                                        tmp_syncobj, 0, 0);
+            }
+
+          drmSyncobjDestroy (drm_fd, tmp_syncobj);
+
+          if (ret == 0)
+            return;
+        }
+
+      g_warning ("Failed to attach fence to release point: %s",
+                 g_strerror (errno));
+    }
+
+  if (drmSyncobjTimelineSignal (drm_fd, &timeline->drm_syncobj,
+                                &sync_point->sync_point, 1) != 0)
+    g_warning ("Failed to signal release point: %s", g_strerror (errno));
+}
+
+static gboolean
+meta_wayland_sync_point_source_dispatch (GSource     *base,
+                                         GSourceFunc  callback,
+                                         gpointer     user_data)
+{
+  MetaWaylandSyncPointSource *source = (MetaWaylandSyncPointSource *) base;
+  uint64_t value;
+
+  if (read (source->event_fd, &value, sizeof (value)) < 0 &&
+      errno == EAGAIN)
+    return G_SOURCE_CONTINUE;
+
+  source->dispatch (source->buffer, source->user_data);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+meta_wayland_sync_point_source_finalize (GSource *base)
+{
+  MetaWaylandSyncPointSource *source = (MetaWaylandSyncPointSource *) base;
+
+  g_clear_fd (&source->event_fd, NULL);
+  g_clear_object (&source->buffer);
+}
+
+static GSourceFuncs meta_wayland_sync_point_source_funcs = {
+  .dispatch = meta_wayland_sync_point_source_dispatch,
+  .finalize = meta_wayland_sync_point_source_finalize
+};
+
+/**
+ * meta_wayland_sync_point_create_source:
+ * @sync_point: A #MetaWaylandSyncPoint
+ * @buffer: The #MetaWaylandBuffer the sync point is for
+ * @dispatch: Callback
+ * @user_data: User data for the callback
+ *
+ * Creates a GSource which will call the specified dispatch callback when the
+ * sync point has been signalled.
+ *
+ * Returns: The new GSource (or %NULL if the sync point was signalled already)
+ */
+GSource *
+meta_wayland_sync_point_create_source (MetaWaylandSyncPoint            *sync_point,
+                                       MetaWaylandBuffer               *buffer,
+                                       MetaWaylandDmaBufSourceDispatch  dispatch,
+                                       gpointer                         user_data)
+{
+  MetaWaylandSyncobjTimeline *timeline = sync_point->timeline;
+  int drm_fd = timeline->manager->drm_fd;
+  MetaWaylandSyncPointSource *source;
+  int event_fd;
+
+  if (drmSyncobjTimelineWait (drm_fd, &timeline->drm_syncobj,
+                              &sync_point->sync_point, 1, 0,
+                              DRM_SYNCOBJ_WAIT_FLAGS_WAIT_FOR_SUBMIT,
+                              NULL) == 0)
+    return NULL;
+
+  event_fd = eventfd (0, EFD_CLOEXEC | EFD_NONBLOCK);
+  if (event_fd < 0)
+    {
+      g_warning ("Failed to create eventfd: %s", g_strerror (errno));
+      return NULL;
+    }
+
+  if (drmSyncobjEventfd (drm_fd, timeline->drm_syncobj,
+                         sync_point->sync_point, event_fd, 0) != 0)
+    {
+      g_warning ("Failed to wait for acquire point: %s", g_strerror (errno));
+      close (event_fd);
+      return NULL;
+    }
+
+  source =
+    (MetaWaylandSyncPointSource *) g_source_new (&meta_wayland_sync_point_source_funcs,
+                                                 sizeof (*source));
+  source->buffer = g_object_ref (buffer);
+  source->dispatch = dispatch;
+  source->user_data = user_data;
+  source->event_fd = event_fd;
+  g_source_add_unix_fd (&source->base, event_fd, G_IO_IN);
+
+  return &source->base;
+}
+
+/**
+ * meta_wayland_surface_explicit_sync_validate:
+ * @surface: A #MetaWaylandSurface
+ * @state: The pending state about to be committed
+ *
+ * Checks that the pending state fulfills the requirements of the
+ * explicit synchronization protocol, and posts a protocol error if not.
+ *
+ * Returns: %FALSE if a protocol error was posted
+ */
+gboolean
+meta_wayland_surface_explicit_sync_validate (MetaWaylandSurface      *surface,
+                                             MetaWaylandSurfaceState *state)
+{
+  struct wl_resource *resource = surface->drm_syncobj.resource;
+  MetaWaylandSyncPoint *acquire = state->drm_syncobj.acquire;
+  MetaWaylandSyncPoint *release = state->drm_syncobj.release;
+
+  if (!resource)
+    return TRUE;
+
+  if (!state->buffer)
+    {
+      if (acquire || release)
+        {
+          wl_resource_post_error (resource,
+                                  WP_LINUX_DRM_SYNCOBJ_SURFACE_V1_ERROR_NO_BUFFER,
+                                  "Explicit sync points set without a buffer");
+          return FALSE;
+        }
+
+      return TRUE;
+    }
+
+  /* Shared memory buffers might be imported as dma-bufs internally, but
+   * they still aren't dma-bufs as far as the client is concerned */
+  if ((state->buffer->resource &&
+       wl_shm_buffer_get (state->buffer->resource)) ||
+      !meta_wayland_dma_buf_from_buffer (state->buffer))
+    {
+      wl_resource_post_error (resource,
+                              WP_LINUX_DRM_SYNCOBJ_SURFACE_V1_ERROR_UNSUPPORTED_BUFFER,
+                              "Explicit sync is only supported for dma-buf buffers");
+      return FALSE;
+    }
+
+  if (!acquire)
+    {
+      wl_resource_post_error (resource,
+                              WP_LINUX_DRM_SYNCOBJ_SURFACE_V1_ERROR_NO_ACQUIRE_POINT,
+                              "Buffer committed without an acquire point");
+      return FALSE;
+    }
+
+  if (!release)
+    {
+      wl_resource_post_error (resource,
+                              WP_LINUX_DRM_SYNCOBJ_SURFACE_V1_ERROR_NO_RELEASE_POINT,
+                              "Buffer committed without a release point");
+      return FALSE;
+    }
+
+  if (acquire->timeline == release->timeline &&
+      acquire->sync_point >= release->sync_point)
+    {
+      wl_resource_post_error (resource,
+                              WP_LINUX_DRM_SYNCOBJ_SURFACE_V1_ERROR_CONFLICTING_POINTS,
+                              "Release point not after the acquire point");
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+static void
+drm_syncobj_timeline_destroy (struct wl_client   *client,
+                              struct wl_resource *resource)
+{
+  wl_resource_destroy (resource);
+}
+
+static void
+drm_syncobj_timeline_destructor (struct wl_resource *resource)
+{
+  MetaWaylandSyncobjTimeline *timeline = wl_resource_get_user_data (resource);
+
+  g_object_unref (timeline);
+}
+
+static const struct wp_linux_drm_syncobj_timeline_v1_interface drm_syncobj_timeline_implementation = {
+  drm_syncobj_timeline_destroy,
+};
+
+static void
+drm_syncobj_surface_destroy (struct wl_client   *client,
+                             struct wl_resource *resource)
+{
+  wl_resource_destroy (resource);
+}
+
+static void
+drm_syncobj_surface_destructor (struct wl_resource *resource)
+{
+  MetaWaylandSurface *surface = wl_resource_get_user_data (resource);
+  MetaWaylandSurfaceState *pending;
+
+  if (!surface)
+    return;
+
+  /* Points set since the last commit may be discarded */
+  pending = surface->pending_state;
+  g_clear_pointer (&pending->drm_syncobj.acquire, meta_wayland_sync_point_free);
+  g_clear_pointer (&pending->drm_syncobj.release, meta_wayland_sync_point_free);
+
+  g_clear_signal_handler (&surface->drm_syncobj.destroy_handler_id, surface);
+  surface->drm_syncobj.resource = NULL;
+}
+
+static void
+on_surface_destroyed (MetaWaylandSurface *surface)
+{
+  wl_resource_set_user_data (surface->drm_syncobj.resource, NULL);
+  surface->drm_syncobj.resource = NULL;
+}
+
+static void
+set_sync_point (struct wl_resource    *resource,
+                struct wl_resource    *timeline_resource,
+                uint32_t               point_hi,
+                uint32_t               point_lo,
+                MetaWaylandSyncPoint **sync_point)
+{
+  MetaWaylandSyncobjTimeline *timeline =
+    wl_resource_get_user_data (timeline_resource);
+
+  g_clear_pointer (sync_point, meta_wayland_sync_point_free);
+  *sync_point = meta_wayland_sync_point_new (timeline, point_hi, point_lo);
+}
+
+static void
+drm_syncobj_surface_set_acquire_point (struct wl_client   *client,
+                                       struct wl_resource *resource,
+                                       struct wl_resource *timeline_resource,
+                                       uint32_t            point_hi,
+                                       uint32_t            point_lo)
+{
+  MetaWaylandSurface *surface = wl_resource_get_user_data (resource);
+
+  if (!surface)
+    {
+      wl_resource_post_error (resource,
+                              WP_LINUX_DRM_SYNCOBJ_SURFACE_V1_ERROR_NO_SURFACE,
+                              "Surface has been destroyed");
+      return;
+    }
+
+  set_sync_point (resource, timeline_resource, point_hi, point_lo,
+                  &surface->pending_state->drm_syncobj.acquire);
+}
+
+static void
+drm_syncobj_surface_set_release_point (struct wl_client   *client,
+                                       struct wl_resource *resource,
+                                       struct wl_resource *timeline_resource,
+                                       uint32_t            point_hi,
+                                       uint32_t            point_lo)
+{
+  MetaWaylandSurface *surface = wl_resource_get_user_data (resource);
+
+  if (!surface)
+    {
+      wl_resource_post_error (resource,
+                              WP_LINUX_DRM_SYNCOBJ_SURFACE_V1_ERROR_NO_SURFACE,
+                              "Surface has been destroyed");
+      return;
+    }
+
+  set_sync_point (resource, timeline_resource, point_hi, point_lo,
+                  &surface->pending_state->drm_syncobj.release);
+}
+
+static const struct wp_linux_drm_syncobj_surface_v1_interface drm_syncobj_surface_implementation = {
+  drm_syncobj_surface_destroy,
+  drm_syncobj_surface_set_acquire_point,
+  drm_syncobj_surface_set_release_point,
+};
+
+static void
+drm_syncobj_manager_destroy (struct wl_client   *client,
+                             struct wl_resource *resource)
+{
+  wl_resource_destroy (resource);
+}
+
+static void
+drm_syncobj_manager_get_surface (struct wl_client   *client,
+                                 struct wl_resource *resource,
+                                 uint32_t            id,
+                                 struct wl_resource *surface_resource)
+{
+  MetaWaylandSurface *surface = wl_resource_get_user_data (surface_resource);
+  struct wl_resource *syncobj_surface_resource;
+
+  if (surface->drm_syncobj.resource)
+    {
+      wl_resource_post_error (resource,
+                              WP_LINUX_DRM_SYNCOBJ_MANAGER_V1_ERROR_SURFACE_EXISTS,
+                              "Surface already has an explicit sync object");
+      return;
+    }
+
+  syncobj_surface_resource =
+    wl_resource_create (client,
+                        &wp_linux_drm_syncobj_surface_v1_interface,
+                        wl_resource_get_version (resource),
+                        id);
+  wl_resource_set_implementation (syncobj_surface_resource,
+                                  &drm_syncobj_surface_implementation,
+                                  surface,
+                                  drm_syncobj_surface_destructor);
+
+  surface->drm_syncobj.resource = syncobj_surface_resource;
+  surface->drm_syncobj.destroy_handler_id =
+    g_signal_connect (surface,
+                      "destroy",
+                      G_CALLBACK (on_surface_destroyed),
+                      NULL);
+}
+
+static void
+drm_syncobj_manager_import_timeline (struct wl_client   *client,
+                                     struct wl_resource *resource,
+                                     uint32_t            id,
+                                     int32_t             fd)
+{
+  MetaWaylandDrmSyncobjManager *manager = wl_resource_get_user_data (resource);
+  MetaWaylandSyncobjTimeline *timeline;
+  struct wl_resource *timeline_resource;
+  uint32_t drm_syncobj;
+  int ret;
+
+  ret = drmSyncobjFDToHandle (manager->drm_fd, fd, &drm_syncobj);
+  close (fd);
+
+  if (ret != 0)
+    {
+      wl_resource_post_error (resource,
+                              WP_LINUX_DRM_SYNCOBJ_MANAGER_V1_ERROR_INVALID_TIMELINE,
+                              "Failed to import DRM syncobj: %s",
+                              g_strerror (errno));
+      return;
+    }
+
+  timeline = meta_wayland_syncobj_timeline_new (manager, drm_syncobj);
+
+  timeline_resource =
+    wl_resource_create (client,
+                        &wp_linux_drm_syncobj_timeline_v1_interface,
+                        wl_resource_get_version (resource),
+                        id);
+  wl_resource_set_implementation (timeline_resource,
+                                  &drm_syncobj_timeline_implementation,
+                                  timeline,
+                                  drm_syncobj_timeline_destructor);
+}
+
+static const struct wp_linux_drm_syncobj_manager_v1_interface drm_syncobj_manager_implementation = {
+  drm_syncobj_manager_destroy,
+  drm_syncobj_manager_get_surface,
+  drm_syncobj_manager_import_timeline,
+};
+
+static void
+drm_syncobj_manager_bind (struct wl_client *client,
+                          void             *user_data,
+                          uint32_t          version,
+                          uint32_t          id)
+{
+  MetaWaylandDrmSyncobjManager *manager = user_data;
+  struct wl_resource *resource;
+
+  resource = wl_resource_create (client,
+                                 &wp_linux_drm_syncobj_manager_v1_interface,
+                                 version, id);
+  wl_resource_set_implementation (resource,
+                                  &drm_syncobj_manager_implementation,
+                                  manager, NULL);
+}
+
+static int
+open_render_node (MetaBackend  *backend,
+                  char        **out_path,
+                  GError      **error)
+{
+  MetaEgl *egl = meta_backend_get_egl (backend);
+  ClutterBackend *clutter_backend = meta_backend_get_clutter_backend (backend);
+  CoglContext *cogl_context = clutter_backend_get_cogl_context (clutter_backend);
+  EGLDisplay egl_display = cogl_egl_context_get_egl_display (cogl_context);
+  EGLDeviceEXT egl_device;
+  EGLAttrib attrib;
+  const char *render_node;
+  int fd;
+
+  if (!meta_egl_query_display_attrib (egl, egl_display,
+                                      EGL_DEVICE_EXT, &attrib,
+                                      error))
+    return -1;
+
+  egl_device = (EGLDeviceEXT) attrib;
+
+  if (!meta_egl_egl_device_has_extensions (egl, egl_device, NULL,
+                                           "EGL_EXT_device_drm_render_node",
+                                           NULL))
+    {
+      g_set_error (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+                   "Missing 'EGL_EXT_device_drm_render_node'");
+      return -1;
+    }
+
+  render_node = meta_egl_query_device_string (egl, egl_device,
+                                              EGL_DRM_RENDER_NODE_FILE_EXT,
+                                              error);
+  if (!render_node)
+    return -1;
+
+  fd = open (render_node, O_RDWR | O_CLOEXEC);
+  if (fd < 0)
+    {
+      g_set_error (error, G_IO_ERROR, g_io_error_from_errno (errno),
+                   "Failed to open '%s': %s",
+                   render_node, g_strerror (errno));
+      return -1;
+    }
+
+  *out_path = g_strdup (render_node);
+  return fd;
+}
+
+/**
+ * meta_wayland_drm_syncobj_manager_new:
+ * @compositor: A #MetaWaylandCompositor
+ * @error: Return location for a #GError
+ *
+ * Creates the global for the linux-drm-syncobj-v1 protocol if the GPU driver,
+ * the kernel and the renderer support everything needed for it.
+ *
+ * Returns: (transfer full): A new #MetaWaylandDrmSyncobjManager, or %NULL
+ */
+MetaWaylandDrmSyncobjManager *
+meta_wayland_drm_syncobj_manager_new (MetaWaylandCompositor  *compositor,
+                                      GError                **error)
+{
+  MetaContext *context = meta_wayland_compositor_get_context (compositor);
+  MetaBackend *backend = meta_context_get_backend (context);
+  ClutterBackend *clutter_backend = meta_backend_get_clutter_backend (backend);
+  CoglContext *cogl_context = clutter_backend_get_cogl_context (clutter_backend);
+  g_autoptr (MetaWaylandDrmSyncobjManager) manager = NULL;
+  uint64_t timeline_cap = 0;
+  g_autofree char *render_node_path = NULL;
+  int sync_fd;
+  int drm_fd;
+
+  drm_fd = open_render_node (backend, &render_node_path, error);
+  if (drm_fd < 0)
+    return NULL;
+
+  manager = g_object_new (META_TYPE_WAYLAND_DRM_SYNCOBJ_MANAGER, NULL);
+  manager->compositor = compositor;
+  manager->render_node_path = g_steal_pointer (&render_node_path);
+  manager->drm_fd = drm_fd;
+
+  if (drmGetCap (drm_fd, DRM_CAP_SYNCOBJ_TIMELINE, &timeline_cap) != 0 ||
+      !timeline_cap)
+    {
+      g_set_error (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+                   "Timeline syncobjs not supported by the DRM driver");
+      return NULL;
+    }
+
+  /* Waiting via an eventfd needs Linux 6.6. With a valid eventfd but no
+   * syncobj, it fails with ENOENT if supported */
+  sync_fd = eventfd (0, EFD_CLOEXEC);
+  if (sync_fd >= 0 &&
+      drmSyncobjEventfd (drm_fd, 0, 0, sync_fd, 0) != 0 &&
+      errno != ENOENT)
+    {
+      close (sync_fd);
+      g_set_error (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+                   "Waiting for syncobjs via eventfd not supported");
+      return NULL;
+    }
+  g_clear_fd (&sync_fd, NULL);
+
+  /* Release points are signalled with the fence of the rendering done
+   * until a buffer isn't used anymore */
+  sync_fd = cogl_context_get_latest_sync_fd (cogl_context);
+  if (sync_fd < 0)
+    {
+      g_set_error (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+                   "Native fence sync not supported by the renderer");
+      return NULL;
+    }
+  close (sync_fd);
+
+  manager->global = wl_global_create (compositor->wayland_display,
+                                      &wp_linux_drm_syncobj_manager_v1_interface,
+                                      META_WP_LINUX_DRM_SYNCOBJ_V1_VERSION,
+                                      manager,
+                                      drm_syncobj_manager_bind);
+  if (!manager->global)
+    {
+      g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+                   "Failed to create wp_linux_drm_syncobj_manager_v1 global");
+      return NULL;
+    }
+
+  return g_steal_pointer (&manager);
+}
+
+const char *
+meta_wayland_drm_syncobj_manager_get_render_node_path (MetaWaylandDrmSyncobjManager *manager)
+{
+  return manager->render_node_path;
+}
+
+static void
+meta_wayland_drm_syncobj_manager_finalize (GObject *object)
+{
+  MetaWaylandDrmSyncobjManager *manager =
+    META_WAYLAND_DRM_SYNCOBJ_MANAGER (object);
+
+  g_clear_pointer (&manager->global, wl_global_destroy);
+  g_clear_pointer (&manager->render_node_path, g_free);
+  g_clear_fd (&manager->drm_fd, NULL);
+
+  G_OBJECT_CLASS (meta_wayland_drm_syncobj_manager_parent_class)->finalize (object);
+}
+
+static void
+meta_wayland_drm_syncobj_manager_class_init (MetaWaylandDrmSyncobjManagerClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = meta_wayland_drm_syncobj_manager_finalize;
+}
+
+static void
+meta_wayland_drm_syncobj_manager_init (MetaWaylandDrmSyncobjManager *manager)
+{
+  manager->drm_fd = -1;
+}
@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <glib.h>
+#include <glib-object.h>
+
+#include "core/util-private.h"
+#include "wayland/meta-wayland-dma-buf.h"
+#include "wayland/meta-wayland-types.h"
+
+#define META_TYPE_WAYLAND_DRM_SYNCOBJ_MANAGER (meta_wayland_drm_syncobj_manager_get_type ())
+G_DECLARE_FINAL_TYPE (MetaWaylandDrmSyncobjManager,
+                      meta_wayland_drm_syncobj_manager,
+                      META, WAYLAND_DRM_SYNCOBJ_MANAGER, GObject)
+
+#define META_TYPE_WAYLAND_SYNCOBJ_TIMELINE (meta_wayland_syncobj_timeline_get_type ())
+G_DECLARE_FINAL_TYPE (MetaWaylandSyncobjTimeline,
+                      meta_wayland_syncobj_timeline,
+                      META, WAYLAND_SYNCOBJ_TIMELINE, GObject)
+
+struct _MetaWaylandSyncPoint
+{
+  MetaWaylandSyncobjTimeline *timeline;
+  uint64_t sync_point;
+};
+
+MetaWaylandDrmSyncobjManager * meta_wayland_drm_syncobj_manager_new (MetaWaylandCompositor  *compositor,
+                                                                     GError                **error);
+
+META_EXPORT_TEST
+const char * meta_wayland_drm_syncobj_manager_get_render_node_path (MetaWaylandDrmSyncobjManager *manager);
+
+void meta_wayland_sync_point_free (MetaWaylandSyncPoint *sync_point);
+
+void meta_wayland_sync_point_signal (MetaWaylandSyncPoint *sync_point,
+                                     int                   sync_fd);
+
+GSource * meta_wayland_sync_point_create_source (MetaWaylandSyncPoint            *sync_point,
+                                                 MetaWaylandBuffer               *buffer,
+                                                 MetaWaylandDmaBufSourceDispatch  dispatch,
+                                                 gpointer                         user_data);
+
+gboolean meta_wayland_surface_explicit_sync_validate (MetaWaylandSurface      *surface,
+                                                      MetaWaylandSurfaceState *state);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (MetaWaylandSyncPoint, meta_wayland_sync_point_free)
@@ -34,6 +34,7 @@ typedef struct _MetaWaylandPresentationFeedback
   struct wl_resource *resource;
 
   MetaWaylandSurface *surface;
+  int64_t commit_time_us;
 } MetaWaylandPresentationFeedback;
 
 typedef struct _MetaWaylandPresentationTime
@@ -61,6 +62,15 @@ void meta_wayland_presentation_feedback_present (MetaWaylandPresentationFeedback
 struct wl_list * meta_wayland_presentation_time_ensure_feedbacks (MetaWaylandPresentationTime *presentation_time,
                                                                   ClutterStageView            *stage_view);
 
+void meta_wayland_presentation_time_surface_committed (MetaWaylandSurface      *surface,
+                                                       MetaWaylandSurfaceState *state);
+
+void meta_wayland_presentation_time_frame_callbacks_emitted (MetaWaylandSurface *surface,
+                                                             int64_t             time_us,
+                                                             int64_t             refresh_interval_us);
+
+int64_t meta_wayland_presentation_time_get_render_duration (MetaWaylandSurface *surface);
+
 void meta_wayland_presentation_time_cursor_painted (MetaWaylandPresentationTime *presentation_time,
                                                     ClutterStageView            *stage_view,
                                                     MetaWaylandCursorSurface    *cursor_surface);
@@ -24,6 +24,7 @@
 
 #include <glib.h>
 
+#include "cogl/cogl.h"
 #include "compositor/meta-surface-actor-wayland.h"
 #include "wayland/meta-wayland-cursor-surface.h"
 #include "wayland/meta-wayland-presentation-time-private.h"
@@ -34,6 +35,12 @@
 
 #include "presentation-time-server-protocol.h"
 
+/*
+ * Render duration samples longer than this many refresh cycles of the view
+ * the frame callbacks were emitted for are ignored.
+ */
+#define MAX_RENDER_DURATION_REFRESH_CYCLES 2
+
 static void
 wp_presentation_feedback_destructor (struct wl_resource *resource)
 {
@@ -252,10 +259,63 @@ meta_wayland_init_presentation_time (MetaWaylandCompositor *compositor)
 void
 meta_wayland_presentation_feedback_discard (MetaWaylandPresentationFeedback *feedback)
 {
+  if (feedback->surface)
+    feedback->surface->presentation_time.stats.n_discarded++;
+
   wp_presentation_feedback_send_discarded (feedback->resource);
   wl_resource_destroy (feedback->resource);
 }
 
+static void
+update_presentation_stats (MetaWaylandPresentationFeedback *feedback,
+                           int64_t                          presentation_time_us)
+{
+  MetaWaylandSurface *surface = feedback->surface;
+  int64_t latency_us;
+
+  surface->presentation_time.stats.n_presented++;
+
+  if (!feedback->commit_time_us || !presentation_time_us)
+    return;
+
+  latency_us = presentation_time_us - feedback->commit_time_us;
+
+  surface->presentation_time.stats.last_latency_us = latency_us;
+  surface->presentation_time.stats.max_latency_us =
+    MAX (surface->presentation_time.stats.max_latency_us, latency_us);
+
+  if (!surface->presentation_time.stats.average_latency_us)
+    surface->presentation_time.stats.average_latency_us = latency_us;
+  else
+    surface->presentation_time.stats.average_latency_us +=
+      (latency_us - surface->presentation_time.stats.average_latency_us) / 8;
+
+  meta_topic (META_DEBUG_WAYLAND,
+              "Surface %u presented %" G_GINT64_FORMAT " µs after commit "
+              "(average %" G_GINT64_FORMAT " µs, max %" G_GINT64_FORMAT " µs, "
+              "%" G_GUINT64_FORMAT " presented, %" G_GUINT64_FORMAT " discarded)",
+              wl_resource_get_id (surface->resource),
+              latency_us,
+              surface->presentation_time.stats.average_latency_us,
+              surface->presentation_time.stats.max_latency_us,
+              surface->presentation_time.stats.n_presented,
+              surface->presentation_time.stats.n_discarded);
+
+#ifdef COGL_HAS_TRACING
+  if (G_UNLIKELY (cogl_is_tracing_enabled ()))
+    {
+      g_autofree char *description = NULL;
+
+      description = g_strdup_printf ("surface %u",
+                                     wl_resource_get_id (surface->resource));
+      COGL_TRACE_MARK ("WaylandSurface (commit to presentation)",
+                       description,
+                       us2ns (feedback->commit_time_us),
+                       us2ns (latency_us));
+    }
+#endif
+}
+
 static void
 maybe_update_presentation_sequence (MetaWaylandSurface *surface,
                                     ClutterFrameInfo   *frame_info,
@@ -342,6 +402,7 @@ meta_wayland_presentation_feedback_present (MetaWaylandPresentationFeedback *fee
   refresh_interval_ns = (uint32_t) (0.5 + s2ns (1) / frame_info->refresh_rate);
 
   maybe_update_presentation_sequence (surface, frame_info, output);
+  update_presentation_stats (feedback, time_us);
 
   seq_hi = surface->presentation_time.sequence >> 32;
   seq_lo = surface->presentation_time.sequence;
@@ -398,6 +459,69 @@ meta_wayland_presentation_time_ensure_feedbacks (MetaWaylandPresentationTime *pr
   return g_hash_table_lookup (presentation_time->feedbacks, stage_view);
 }
 
+void
+meta_wayland_presentation_time_surface_committed (MetaWaylandSurface      *surface,
+                                                  MetaWaylandSurfaceState *state)
+{
+  MetaWaylandPresentationFeedback *feedback;
+  int64_t now_us;
+
+  now_us = g_get_monotonic_time ();
+
+  wl_list_for_each (feedback, &state->presentation_feedback_list, link)
+    {
+      if (!feedback->commit_time_us)
+        feedback->commit_time_us = now_us;
+    }
+
+  if (state->newly_attached && surface->presentation_time.frame_callback_time_us)
+    {
+      int64_t render_duration_us = surface->presentation_time.render_duration_us;
+      int64_t duration_us;
+
+      duration_us = now_us - surface->presentation_time.frame_callback_time_us;
+      surface->presentation_time.frame_callback_time_us = 0;
+
+      /* A client taking longer than a couple of refresh cycles wasn't
+       * rendering continuously, e.g. it was idle in between, so it says
+       * nothing about how long it needs for a frame. */
+      if (duration_us > MAX_RENDER_DURATION_REFRESH_CYCLES *
+                        surface->presentation_time.frame_callback_refresh_interval_us)
+        return;
+
+      /* Follow slower frames right away, and faster ones gradually. */
+      surface->presentation_time.render_duration_us =
+        MAX (duration_us, render_duration_us - render_duration_us / 8);
+    }
+}
+
+void
+meta_wayland_presentation_time_frame_callbacks_emitted (MetaWaylandSurface *surface,
+                                                        int64_t             time_us,
+                                                        int64_t             refresh_interval_us)
+{
+  /* Only frame callbacks paced by a stage view are measured */
+  if (!refresh_interval_us)
+    {
+      surface->presentation_time.frame_callback_time_us = 0;
+      return;
+    }
+
+  surface->presentation_time.frame_callback_time_us = time_us;
+  surface->presentation_time.frame_callback_refresh_interval_us =
+    refresh_interval_us;
+}
+
+/*
+ * Returns how long the client usually takes from a frame callback to
+ * committing new content, or 0 if that isn't known yet.
+ */
+int64_t
+meta_wayland_presentation_time_get_render_duration (MetaWaylandSurface *surface)
+{
+  return surface->presentation_time.render_duration_us;
+}
+
 void
 meta_wayland_presentation_time_cursor_painted (MetaWaylandPresentationTime *presentation_time,
                                                ClutterStageView            *stage_view,
@@ -105,12 +105,35 @@ struct _MetaWaylandCompositor
 
   MetaWaylandPresentationTime presentation_time;
   MetaWaylandDmaBufManager *dma_buf_manager;
+  MetaWaylandDrmSyncobjManager *drm_syncobj_manager;
+  MetaWaylandUdmabuf *udmabuf;
+
+  /* Staging buffer for uploading large wl_shm buffer damage, and the
+   * threads filling it */
+  CoglPixelBuffer *shm_staging_buffer;
+  GThreadPool *shm_copy_thread_pool;
 
   /*
    * Queue of transactions which have been committed but not applied yet, in the
    * order they were committed.
    */
   GQueue committed_transactions;
+
+  /*
+   * Ready transactions which only update surface content are applied right
+   * before the stage is updated, so that the ones superseded in the mean
+   * time can be skipped.
+   */
+  gboolean transactions_latching;
+  guint transaction_latch_timeout_id;
+
+  /*
+   * The stage view and frame transactions are being latched for, if any, and
+   * the time the frame is expected to be presented at.
+   */
+  ClutterStageView *latch_view;
+  int64_t latch_frame_count;
+  int64_t latch_presentation_time_us;
 };
 
 gboolean meta_wayland_compositor_is_egl_display_bound (MetaWaylandCompositor *compositor);
@@ -0,0 +1,523 @@
+/*
+ * Copyright (C) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * The protocol tracer accounts the requests each Wayland client sends, and
+ * the CPU time spent handling them. It hooks into libwayland as a protocol
+ * logger, which is called right before a request is dispatched to its
+ * handler. A request is considered handled when the next one is logged, or
+ * when the Wayland event source is done dispatching.
+ *
+ * Tracing is opt-in: it can be started by setting
+ * MUTTER_DEBUG_TRACE_WAYLAND_PROTOCOL, or by starting a Sysprof capture
+ * with the "wayland-protocol" option, in which case each handled request
+ * also ends up as a mark in the capture.
+ *
+ * The D-Bus interface to query and control the tracer exposes what every
+ * client is doing, so like the environment variable it's meant for debugging
+ * only, and is only exported when the environment variable is set.
+ */
+
+#include "config.h"
+
+#include "wayland/meta-wayland-protocol-tracer.h"
+
+#include <time.h>
+#include <wayland-server.h>
+
+#include "cogl/cogl.h"
+#include "core/meta-context-private.h"
+#include "wayland/meta-wayland-private.h"
+
+#define META_WAYLAND_PROTOCOL_TRACER_DBUS_SERVICE "org.gnome.Mutter.WaylandProtocolTracer"
+#define META_WAYLAND_PROTOCOL_TRACER_DBUS_PATH "/org/gnome/Mutter/WaylandProtocolTracer"
+
+typedef struct _RequestStats
+{
+  const char *interface_name;
+  const char *request_name;
+
+  uint64_t count;
+  int64_t cpu_time_ns;
+} RequestStats;
+
+typedef struct _ClientStats
+{
+  MetaWaylandProtocolTracer *tracer;
+
+  struct wl_client *client;
+  struct wl_listener client_destroy_listener;
+
+  pid_t pid;
+  char *command;
+
+  /* const struct wl_message * -> RequestStats */
+  GHashTable *requests;
+} ClientStats;
+
+struct _MetaWaylandProtocolTracer
+{
+  MetaDBusWaylandProtocolTracerSkeleton parent;
+
+  MetaWaylandCompositor *compositor;
+
+  guint dbus_name_id;
+
+  gboolean started;
+  gboolean profiling;
+  struct wl_protocol_logger *logger;
+
+  /* struct wl_client * -> ClientStats */
+  GHashTable *clients;
+
+  struct {
+    ClientStats *client_stats;
+    RequestStats *request_stats;
+    int64_t begin_time_ns;
+    int64_t begin_cpu_time_ns;
+  } current;
+};
+
+static void meta_wayland_protocol_tracer_init_iface (MetaDBusWaylandProtocolTracerIface *iface);
+
+G_DEFINE_TYPE_WITH_CODE (MetaWaylandProtocolTracer, meta_wayland_protocol_tracer,
+                         META_DBUS_TYPE_WAYLAND_PROTOCOL_TRACER_SKELETON,
+                         G_IMPLEMENT_INTERFACE (META_DBUS_TYPE_WAYLAND_PROTOCOL_TRACER,
+                                                meta_wayland_protocol_tracer_init_iface))
+
+static int64_t
+get_clock_time_ns (clockid_t clock_id)
+{
+  struct timespec ts;
+
+  clock_gettime (clock_id, &ts);
+
+  return (int64_t) ts.tv_sec * G_GINT64_CONSTANT (1000000000) + ts.tv_nsec;
+}
+
+static char *
+get_client_command (pid_t pid)
+{
+  g_autofree char *path = NULL;
+  g_autofree char *contents = NULL;
+
+  if (pid <= 0)
+    return g_strdup ("");
+
+  path = g_strdup_printf ("/proc/%d/comm", pid);
+  if (!g_file_get_contents (path, &contents, NULL, NULL))
+    return g_strdup ("");
+
+  return g_strdup (g_strchomp (contents));
+}
+
+static void
+client_stats_free (ClientStats *client_stats)
+{
+  wl_list_remove (&client_stats->client_destroy_listener.link);
+  g_hash_table_unref (client_stats->requests);
+  g_free (client_stats->command);
+  g_free (client_stats);
+}
+
+static void
+on_client_destroyed (struct wl_listener *listener,
+                     void               *data)
+{
+  ClientStats *client_stats = wl_container_of (listener,
+                                               client_stats,
+                                               client_destroy_listener);
+  MetaWaylandProtocolTracer *tracer = client_stats->tracer;
+
+  if (tracer->current.client_stats == client_stats)
+    {
+      tracer->current.client_stats = NULL;
+      tracer->current.request_stats = NULL;
+    }
+
+  g_hash_table_remove (tracer->clients, client_stats->client);
+}
+
+static ClientStats *
+ensure_client_stats (MetaWaylandProtocolTracer *tracer,
+                     struct wl_client          *client)
+{
+  ClientStats *client_stats;
+
+  client_stats = g_hash_table_lookup (tracer->clients, client);
+  if (client_stats)
+    return client_stats;
+
+  client_stats = g_new0 (ClientStats, 1);
+  client_stats->tracer = tracer;
+  client_stats->client = client;
+  wl_client_get_credentials (client, &client_stats->pid, NULL, NULL);
+  client_stats->command = get_client_command (client_stats->pid);
+  client_stats->requests = g_hash_table_new_full (NULL, NULL, NULL, g_free);
+
+  client_stats->client_destroy_listener.notify = on_client_destroyed;
+  wl_client_add_destroy_listener (client,
+                                  &client_stats->client_destroy_listener);
+
+  g_hash_table_insert (tracer->clients, client, client_stats);
+
+  return client_stats;
+}
+
+static RequestStats *
+ensure_request_stats (ClientStats             *client_stats,
+                      struct wl_resource      *resource,
+                      const struct wl_message *message)
+{
+  RequestStats *request_stats;
+
+  request_stats = g_hash_table_lookup (client_stats->requests, message);
+  if (request_stats)
+    return request_stats;
+
+  request_stats = g_new0 (RequestStats, 1);
+  request_stats->interface_name = wl_resource_get_class (resource);
+  request_stats->request_name = message->name;
+  g_hash_table_insert (client_stats->requests, (gpointer) message,
+                       request_stats);
+
+  return request_stats;
+}
+
+static void
+end_current_request (MetaWaylandProtocolTracer *tracer)
+{
+  RequestStats *request_stats = tracer->current.request_stats;
+
+  if (!request_stats)
+    return;
+
+  request_stats->cpu_time_ns +=
+    get_clock_time_ns (CLOCK_THREAD_CPUTIME_ID) -
+    tracer->current.begin_cpu_time_ns;
+
+#ifdef COGL_HAS_TRACING
+  if (tracer->profiling && G_UNLIKELY (cogl_is_tracing_enabled ()))
+    {
+      ClientStats *client_stats = tracer->current.client_stats;
+      g_autofree char *description = NULL;
+      int64_t duration_ns;
+
+      description = g_strdup_printf ("%s.%s (%s[%d])",
+                                     request_stats->interface_name,
+                                     request_stats->request_name,
+                                     client_stats->command,
+                                     client_stats->pid);
+      duration_ns = (get_clock_time_ns (CLOCK_MONOTONIC) -
+                     tracer->current.begin_time_ns);
+      COGL_TRACE_MARK ("Wayland (request)",
+                       description,
+                       tracer->current.begin_time_ns,
+                       duration_ns);
+    }
+#endif
+
+  tracer->current.client_stats = NULL;
+  tracer->current.request_stats = NULL;
+}
+
+static void
+protocol_logger_func (void                                    *user_data,
+                      enum wl_protocol_logger_type             type,
+                      const struct wl_protocol_logger_message *message)
+{
+  MetaWaylandProtocolTracer *tracer = user_data;
+  struct wl_client *client;
+  ClientStats *client_stats;
+  RequestStats *request_stats;
+
+  if (type != WL_PROTOCOL_LOGGER_REQUEST)
+    return;
+
+  end_current_request (tracer);
+
+  client = wl_resource_get_client (message->resource);
+  client_stats = ensure_client_stats (tracer, client);
+  request_stats = ensure_request_stats (client_stats,
+                                        message->resource,
+                                        message->message);
+  request_stats->count++;
+
+  tracer->current.client_stats = client_stats;
+  tracer->current.request_stats = request_stats;
+  if (tracer->profiling)
+    tracer->current.begin_time_ns = get_clock_time_ns (CLOCK_MONOTONIC);
+  tracer->current.begin_cpu_time_ns =
+    get_clock_time_ns (CLOCK_THREAD_CPUTIME_ID);
+}
+
+static void
+update_logger (MetaWaylandProtocolTracer *tracer)
+{
+  MetaDBusWaylandProtocolTracer *dbus_tracer =
+    META_DBUS_WAYLAND_PROTOCOL_TRACER (tracer);
+  gboolean running = tracer->started || tracer->profiling;
+
+  if (running && !tracer->logger)
+    {
+      tracer->logger =
+        wl_display_add_protocol_logger (tracer->compositor->wayland_display,
+                                        protocol_logger_func,
+                                        tracer);
+    }
+  else if (!running && tracer->logger)
+    {
+      end_current_request (tracer);
+      g_clear_pointer (&tracer->logger, wl_protocol_logger_destroy);
+    }
+
+  meta_dbus_wayland_protocol_tracer_set_running (dbus_tracer, running);
+}
+
+static gboolean
+handle_start (MetaDBusWaylandProtocolTracer *dbus_tracer,
+              GDBusMethodInvocation         *invocation)
+{
+  MetaWaylandProtocolTracer *tracer =
+    META_WAYLAND_PROTOCOL_TRACER (dbus_tracer);
+
+  tracer->started = TRUE;
+  update_logger (tracer);
+
+  meta_dbus_wayland_protocol_tracer_complete_start (dbus_tracer, invocation);
+  return G_DBUS_METHOD_INVOCATION_HANDLED;
+}
+
+static gboolean
+handle_stop (MetaDBusWaylandProtocolTracer *dbus_tracer,
+             GDBusMethodInvocation         *invocation)
+{
+  MetaWaylandProtocolTracer *tracer =
+    META_WAYLAND_PROTOCOL_TRACER (dbus_tracer);
+
+  if (!tracer->started)
+    {
+      g_dbus_method_invocation_return_error (invocation,
+                                             G_DBUS_ERROR,
+                                             G_DBUS_ERROR_FAILED,
+                                             "Tracer not started");
+      return G_DBUS_METHOD_INVOCATION_HANDLED;
+    }
+
+  tracer->started = FALSE;
+  update_logger (tracer);
+
+  meta_dbus_wayland_protocol_tracer_complete_stop (dbus_tracer, invocation);
+  return G_DBUS_METHOD_INVOCATION_HANDLED;
+}
+
+static gboolean
+handle_reset (MetaDBusWaylandProtocolTracer *dbus_tracer,
+              GDBusMethodInvocation         *invocation)
+{
+  MetaWaylandProtocolTracer *tracer =
+    META_WAYLAND_PROTOCOL_TRACER (dbus_tracer);
+
+  tracer->current.client_stats = NULL;
+  tracer->current.request_stats = NULL;
+  g_hash_table_remove_all (tracer->clients);
+
+  meta_dbus_wayland_protocol_tracer_complete_reset (dbus_tracer, invocation);
+  return G_DBUS_METHOD_INVOCATION_HANDLED;
+}
+
+static gboolean
+handle_get_statistics (MetaDBusWaylandProtocolTracer *dbus_tracer,
+                       GDBusMethodInvocation         *invocation)
+{
+  MetaWaylandProtocolTracer *tracer =
+    META_WAYLAND_PROTOCOL_TRACER (dbus_tracer);
+  GVariantBuilder clients_builder;
+  GHashTableIter client_iter;
+  ClientStats *client_stats;
+
+  g_variant_builder_init (&clients_builder, G_VARIANT_TYPE ("a(usa(sstt))"));
+
+  g_hash_table_iter_init (&client_iter, tracer->clients);
+  while (g_hash_table_iter_next (&client_iter, NULL, (gpointer *) &client_stats))
+    {
+      GVariantBuilder requests_builder;
+      GHashTableIter request_iter;
+      RequestStats *request_stats;
+
+      g_variant_builder_init (&requests_builder, G_VARIANT_TYPE ("a(sstt)"));
+
+      g_hash_table_iter_init (&request_iter, client_stats->requests);
+      while (g_hash_table_iter_next (&request_iter, NULL,
+                                     (gpointer *) &request_stats))
+        {
+          g_variant_builder_add (&requests_builder, "(sstt)",
+                                 request_stats->interface_name,
+                                 request_stats->request_name,
+                                 request_stats->count,
+                                 request_stats->cpu_time_ns / 1000);
+        }
+
+      g_variant_builder_add (&clients_builder, "(usa(sstt))",
+                             (uint32_t) client_stats->pid,
+                             client_stats->command,
+                             &requests_builder);
+    }
+
+  meta_dbus_wayland_protocol_tracer_complete_get_statistics (
+    dbus_tracer, invocation, g_variant_builder_end (&clients_builder));
+  return G_DBUS_METHOD_INVOCATION_HANDLED;
+}
+
+static void
+meta_wayland_protocol_tracer_init_iface (MetaDBusWaylandProtocolTracerIface *iface)
+{
+  iface->handle_start = handle_start;
+  iface->handle_stop = handle_stop;
+  iface->handle_reset = handle_reset;
+  iface->handle_get_statistics = handle_get_statistics;
+}
+
+static void
+on_bus_acquired (GDBusConnection *connection,
+                 const char      *name,
+                 gpointer         user_data)
+{
+  MetaWaylandProtocolTracer *tracer = user_data;
+  GDBusInterfaceSkeleton *interface_skeleton =
+    G_DBUS_INTERFACE_SKELETON (tracer);
+  g_autoptr (GError) error = NULL;
+
+  if (!g_dbus_interface_skeleton_export (interface_skeleton,
+                                         connection,
+                                         META_WAYLAND_PROTOCOL_TRACER_DBUS_PATH,
+                                         &error))
+    {
+      g_warning ("Failed to export Wayland protocol tracer object: %s",
+                 error->message);
+    }
+}
+
+static void
+on_name_acquired (GDBusConnection *connection,
+                  const char      *name,
+                  gpointer         user_data)
+{
+  g_info ("Acquired name %s", name);
+}
+
+static void
+on_name_lost (GDBusConnection *connection,
+              const char      *name,
+              gpointer         user_data)
+{
+  g_warning ("Lost or failed to acquire name %s", name);
+}
+
+#ifdef HAVE_PROFILER
+static void
+on_profiler_wayland_protocol_changed (MetaProfiler              *profiler,
+                                      GParamSpec                *pspec,
+                                      MetaWaylandProtocolTracer *tracer)
+{
+  tracer->profiling = meta_profiler_is_tracing_wayland_protocol (profiler);
+  update_logger (tracer);
+}
+#endif
+
+static void
+meta_wayland_protocol_tracer_finalize (GObject *object)
+{
+  MetaWaylandProtocolTracer *tracer = META_WAYLAND_PROTOCOL_TRACER (object);
+
+  g_clear_pointer (&tracer->logger, wl_protocol_logger_destroy);
+  g_clear_pointer (&tracer->clients, g_hash_table_unref);
+  g_clear_handle_id (&tracer->dbus_name_id, g_bus_unown_name);
+
+  G_OBJECT_CLASS (meta_wayland_protocol_tracer_parent_class)->finalize (object);
+}
+
+static void
+meta_wayland_protocol_tracer_class_init (MetaWaylandProtocolTracerClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = meta_wayland_protocol_tracer_finalize;
+}
+
+static void
+meta_wayland_protocol_tracer_init (MetaWaylandProtocolTracer *tracer)
+{
+  tracer->clients =
+    g_hash_table_new_full (NULL, NULL,
+                           NULL, (GDestroyNotify) client_stats_free);
+}
+
+MetaWaylandProtocolTracer *
+meta_wayland_protocol_tracer_new (MetaWaylandCompositor *compositor)
+{
+  MetaWaylandProtocolTracer *tracer;
+  gboolean debug_enabled;
+#ifdef HAVE_PROFILER
+  MetaProfiler *profiler;
+#endif
+
+  tracer = g_object_new (META_TYPE_WAYLAND_PROTOCOL_TRACER, NULL);
+  tracer->compositor = compositor;
+
+  tracer->started = !!g_getenv ("MUTTER_DEBUG_TRACE_WAYLAND_PROTOCOL");
+  debug_enabled = tracer->started;
+
+#ifdef HAVE_PROFILER
+  profiler = meta_context_get_profiler (compositor->context);
+  if (profiler)
+    {
+      tracer->profiling = meta_profiler_is_tracing_wayland_protocol (profiler);
+      g_signal_connect_object (profiler, "notify::wayland-protocol",
+                               G_CALLBACK (on_profiler_wayland_protocol_changed),
+                               tracer,
+                               0);
+    }
+#endif
+
+  update_logger (tracer);
+
+  if (debug_enabled)
+    {
+      tracer->dbus_name_id =
+        g_bus_own_name (G_BUS_TYPE_SESSION,
+                        META_WAYLAND_PROTOCOL_TRACER_DBUS_SERVICE,
+                        G_BUS_NAME_OWNER_FLAGS_NONE,
+                        on_bus_acquired,
+                        on_name_acquired,
+                        on_name_lost,
+                        tracer,
+                        NULL);
+    }
+
+  return tracer;
+}
+
+/*
+ * Called once the Wayland event source is done dispatching, so that time
+ * spent outside of it isn't accounted to the last handled request.
+ */
+void
+meta_wayland_protocol_tracer_end_dispatch (MetaWaylandProtocolTracer *tracer)
+{
+  end_current_request (tracer);
+}
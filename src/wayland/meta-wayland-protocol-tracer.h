@@ -0,0 +1,33 @@
+/*
+ * Copyright (C) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <glib-object.h>
+
+#include "wayland/meta-wayland-types.h"
+
+#include "meta-dbus-wayland-protocol-tracer.h"
+
+#define META_TYPE_WAYLAND_PROTOCOL_TRACER (meta_wayland_protocol_tracer_get_type ())
+G_DECLARE_FINAL_TYPE (MetaWaylandProtocolTracer, meta_wayland_protocol_tracer,
+                      META, WAYLAND_PROTOCOL_TRACER,
+                      MetaDBusWaylandProtocolTracerSkeleton)
+
+MetaWaylandProtocolTracer * meta_wayland_protocol_tracer_new (MetaWaylandCompositor *compositor);
+
+void meta_wayland_protocol_tracer_end_dispatch (MetaWaylandProtocolTracer *tracer);
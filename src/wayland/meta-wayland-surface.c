@@ -39,6 +39,8 @@
 #include "wayland/meta-wayland-actor-surface.h"
 #include "wayland/meta-wayland-buffer.h"
 #include "wayland/meta-wayland-data-device.h"
+#include "wayland/meta-wayland-drm-syncobj.h"
+#include "wayland/meta-wayland-fifo.h"
 #include "wayland/meta-wayland-fractional-scale.h"
 #include "wayland/meta-wayland-gtk-shell.h"
 #include "wayland/meta-wayland-keyboard.h"
@@ -109,6 +111,7 @@ enum
   SURFACE_SHORTCUTS_RESTORED,
   SURFACE_GEOMETRY_CHANGED,
   SURFACE_PRE_STATE_APPLIED,
+  SURFACE_SCANOUT_FAILED,
   N_SURFACE_SIGNALS
 };
 
@@ -421,6 +424,15 @@ meta_wayland_surface_state_set_default (MetaWaylandSurfaceState *state)
   wl_list_init (&state->presentation_feedback_list);
 
   state->xdg_popup_reposition_token = 0;
+
+  state->drm_syncobj.acquire = NULL;
+  state->drm_syncobj.release = NULL;
+
+  state->fifo.set_barrier = FALSE;
+  state->fifo.wait_barrier = FALSE;
+
+  state->commit_timing.has_target_time = FALSE;
+  state->commit_timing.target_time_us = 0;
 }
 
 static void
@@ -448,6 +460,9 @@ meta_wayland_surface_state_clear (MetaWaylandSurfaceState *state)
   g_clear_pointer (&state->opaque_region, cairo_region_destroy);
   g_clear_pointer (&state->xdg_positioner, g_free);
 
+  g_clear_pointer (&state->drm_syncobj.acquire, meta_wayland_sync_point_free);
+  g_clear_pointer (&state->drm_syncobj.release, meta_wayland_sync_point_free);
+
   if (state->buffer_destroy_handler_id)
     {
       g_clear_signal_handler (&state->buffer_destroy_handler_id, state->buffer);
@@ -492,6 +507,11 @@ meta_wayland_surface_state_merge_into (MetaWaylandSurfaceState *from,
 
       g_clear_object (&to->texture);
       to->texture = g_steal_pointer (&from->texture);
+
+      g_clear_pointer (&to->drm_syncobj.acquire, meta_wayland_sync_point_free);
+      to->drm_syncobj.acquire = g_steal_pointer (&from->drm_syncobj.acquire);
+      g_clear_pointer (&to->drm_syncobj.release, meta_wayland_sync_point_free);
+      to->drm_syncobj.release = g_steal_pointer (&from->drm_syncobj.release);
     }
 
   to->dx += from->dx;
@@ -605,6 +625,19 @@ meta_wayland_surface_state_merge_into (MetaWaylandSurfaceState *from,
       to->xdg_positioner = g_steal_pointer (&from->xdg_positioner);
       to->xdg_popup_reposition_token = from->xdg_popup_reposition_token;
     }
+
+  to->fifo.set_barrier |= from->fifo.set_barrier;
+  to->fifo.wait_barrier |= from->fifo.wait_barrier;
+
+  if (from->commit_timing.has_target_time)
+    {
+      to->commit_timing.target_time_us =
+        to->commit_timing.has_target_time ?
+        MAX (to->commit_timing.target_time_us,
+             from->commit_timing.target_time_us) :
+        from->commit_timing.target_time_us;
+      to->commit_timing.has_target_time = TRUE;
+    }
 }
 
 static void
@@ -737,7 +770,8 @@ meta_wayland_surface_apply_state (MetaWaylandSurface      *surface,
       /* If the newly attached buffer is going to be accessed directly without
        * making a copy, such as an EGL buffer, mark it as in-use don't release
        * it until is replaced by a subsequent wl_surface.commit or when the
-       * wl_surface is destroyed.
+       * wl_surface is destroyed. This includes wl_shm buffers imported using
+       * udmabuf, as their memory is sampled from directly.
        */
       surface->buffer_held =
         (state->buffer &&
@@ -878,6 +912,9 @@ meta_wayland_surface_apply_state (MetaWaylandSurface      *surface,
   if (state->newly_attached && surface->buffer_held)
     g_clear_object (&state->buffer);
 
+  if (state->fifo.set_barrier)
+    meta_wayland_surface_set_fifo_barrier (surface);
+
   g_signal_emit (state,
                  surface_state_signals[SURFACE_STATE_SIGNAL_APPLIED],
                  0);
@@ -928,6 +965,11 @@ meta_wayland_surface_commit (MetaWaylandSurface *surface)
   COGL_TRACE_BEGIN_SCOPED (MetaWaylandSurfaceCommit,
                            "WaylandSurface (commit)");
 
+  if (!meta_wayland_surface_explicit_sync_validate (surface, pending))
+    return;
+
+  meta_wayland_presentation_time_surface_committed (surface, pending);
+
   if (buffer)
     {
       g_autoptr (GError) error = NULL;
@@ -955,6 +997,13 @@ meta_wayland_surface_commit (MetaWaylandSurface *surface)
 
       g_object_ref (buffer);
       meta_wayland_buffer_inc_use_count (buffer);
+
+      /* The release point gets signalled once this use of the buffer ended */
+      if (pending->drm_syncobj.release)
+        {
+          meta_wayland_buffer_add_release_point (buffer,
+                                                 g_steal_pointer (&pending->drm_syncobj.release));
+        }
     }
   else if (pending->newly_attached)
     {
@@ -1457,6 +1506,7 @@ meta_wayland_surface_finalize (GObject *object)
 
   g_clear_object (&surface->scanout_candidate);
   g_clear_object (&surface->role);
+  g_clear_weak_pointer (&surface->fifo.barrier_view);
 
   if (surface->unassigned.buffer)
     {
@@ -1851,6 +1901,13 @@ meta_wayland_surface_class_init (MetaWaylandSurfaceClass *klass)
                   0, NULL, NULL,
                   g_cclosure_marshal_VOID__VOID,
                   G_TYPE_NONE, 0);
+  surface_signals[SURFACE_SCANOUT_FAILED] =
+    g_signal_new ("scanout-failed",
+                  G_TYPE_FROM_CLASS (object_class),
+                  G_SIGNAL_RUN_LAST,
+                  0, NULL, NULL,
+                  g_cclosure_marshal_VOID__VOID,
+                  G_TYPE_NONE, 0);
 }
 
 static void
@@ -2122,6 +2179,37 @@ meta_wayland_surface_get_actor (MetaWaylandSurface *surface)
   return meta_wayland_actor_surface_get_actor (META_WAYLAND_ACTOR_SURFACE (surface->role));
 }
 
+/*
+ * Returns until when frame callbacks of the surface are held back because
+ * little or nothing of it is visible on @stage_view, its primary view, or on
+ * any view if %NULL. Returns 0 if they can be emitted now.
+ */
+int64_t
+meta_wayland_surface_get_frame_callback_throttle_time (MetaWaylandSurface *surface,
+                                                       ClutterStageView   *stage_view,
+                                                       int64_t             now_us)
+{
+  MetaSurfaceActor *actor;
+  int64_t interval_us;
+  int64_t throttle_time_us;
+
+  actor = meta_wayland_surface_get_actor (surface);
+  if (!actor)
+    return 0;
+
+  interval_us =
+    meta_surface_actor_wayland_get_frame_callback_interval_us (actor,
+                                                               stage_view);
+  if (!interval_us)
+    return 0;
+
+  /* Frames don't arrive exactly on time, so allow some early ones */
+  throttle_time_us = surface->last_frame_callback_time_us +
+                     interval_us - interval_us / 8;
+
+  return throttle_time_us > now_us ? throttle_time_us : 0;
+}
+
 void
 meta_wayland_surface_notify_geometry_changed (MetaWaylandSurface *surface)
 {
@@ -2224,7 +2312,10 @@ meta_wayland_surface_try_acquire_scanout (MetaWaylandSurface *surface,
   scanout = meta_wayland_buffer_try_acquire_scanout (surface->buffer,
                                                      onscreen);
   if (!scanout)
-    return NULL;
+    {
+      g_signal_emit (surface, surface_signals[SURFACE_SCANOUT_FAILED], 0);
+      return NULL;
+    }
 
   buffer = g_object_ref (surface->buffer);
   meta_wayland_buffer_inc_use_count (buffer);
@@ -136,6 +136,24 @@ struct _MetaWaylandSurfaceState
   /* xdg_popup */
   MetaWaylandXdgPositioner *xdg_positioner;
   uint32_t xdg_popup_reposition_token;
+
+  /* linux-drm-syncobj */
+  struct {
+    MetaWaylandSyncPoint *acquire;
+    MetaWaylandSyncPoint *release;
+  } drm_syncobj;
+
+  /* fifo */
+  struct {
+    gboolean set_barrier;
+    gboolean wait_barrier;
+  } fifo;
+
+  /* commit-timing */
+  struct {
+    gboolean has_target_time;
+    int64_t target_time_us;
+  } commit_timing;
 };
 
 struct _MetaWaylandDragDestFuncs
@@ -242,9 +260,35 @@ struct _MetaWaylandSurface
     double scale;
   } fractional_scale;
 
+  /* wp_linux_drm_syncobj_surface_v1 */
+  struct {
+    struct wl_resource *resource;
+    gulong destroy_handler_id;
+  } drm_syncobj;
+
+  /* wp_fifo_v1 */
+  struct {
+    struct wl_resource *resource;
+    gulong destroy_handler_id;
+
+    /* Set while the last content update with a barrier is being shown */
+    gboolean barrier;
+    ClutterStageView *barrier_view;
+    int64_t barrier_frame_count;
+  } fifo;
+
+  /* wp_commit_timer_v1 */
+  struct {
+    struct wl_resource *resource;
+    gulong destroy_handler_id;
+  } commit_timer;
+
   /* table of seats for which shortcuts are inhibited */
   GHashTable *shortcut_inhibited_seats;
 
+  /* When frame callbacks were last emitted, for throttling hidden surfaces */
+  int64_t last_frame_callback_time_us;
+
   /* presentation-time */
   struct {
     struct wl_list feedback_list;
@@ -259,6 +303,24 @@ struct _MetaWaylandSurface
      * delta to update our own 64-bit sequence.
      */
     uint64_t sequence;
+
+    /* Commit to presentation latency of content updates with feedback */
+    struct {
+      uint64_t n_presented;
+      uint64_t n_discarded;
+      int64_t last_latency_us;
+      int64_t average_latency_us;
+      int64_t max_latency_us;
+    } stats;
+
+    /*
+     * When frame callbacks were last emitted and the refresh interval of the
+     * stage view they were emitted for, and a decaying maximum of how long
+     * the client took to commit new content in response.
+     */
+    int64_t frame_callback_time_us;
+    int64_t frame_callback_refresh_interval_us;
+    int64_t render_duration_us;
   } presentation_time;
 
   /* dma-buf feedback */
@@ -379,6 +441,10 @@ MetaMultiTexture *  meta_wayland_surface_get_texture (MetaWaylandSurface *surfac
 META_EXPORT_TEST
 MetaSurfaceActor *  meta_wayland_surface_get_actor (MetaWaylandSurface *surface);
 
+int64_t             meta_wayland_surface_get_frame_callback_throttle_time (MetaWaylandSurface *surface,
+                                                                           ClutterStageView   *stage_view,
+                                                                           int64_t             now_us);
+
 void                meta_wayland_surface_notify_geometry_changed (MetaWaylandSurface *surface);
 
 void                meta_wayland_surface_notify_subsurface_state_changed (MetaWaylandSurface *surface);
@@ -25,12 +25,30 @@
 
 #include <glib-unix.h>
 
+#include "compositor/meta-surface-actor-wayland.h"
+#include "meta/meta-backend.h"
 #include "wayland/meta-wayland.h"
 #include "wayland/meta-wayland-buffer.h"
 #include "wayland/meta-wayland-dma-buf.h"
+#include "wayland/meta-wayland-drm-syncobj.h"
+#include "wayland/meta-wayland-fifo.h"
+#include "wayland/meta-wayland-private.h"
 
 #define META_WAYLAND_TRANSACTION_NONE ((void *)(uintptr_t) G_MAXSIZE)
 
+/*
+ * Ready content updates are latched when the stage is about to be updated. This
+ * is the fallback for when that doesn't happen, e.g. because all frame clocks
+ * are inhibited.
+ */
+#define META_WAYLAND_TRANSACTION_LATCH_TIMEOUT_MS 100
+
+/*
+ * Predicted presentation times aren't exact, so content updates with a target
+ * presentation time this close after the predicted one are latched as well.
+ */
+#define META_WAYLAND_TRANSACTION_TARGET_TIME_SLACK_US 1000
+
 struct _MetaWaylandTransaction
 {
   GList node;
@@ -248,13 +266,400 @@ has_dependencies (MetaWaylandTransaction *transaction)
   return FALSE;
 }
 
+static gboolean
+state_has_applied_handlers (MetaWaylandSurfaceState *state)
+{
+  static guint applied_signal_id;
+
+  if (!applied_signal_id)
+    {
+      applied_signal_id = g_signal_lookup ("applied",
+                                           META_TYPE_WAYLAND_SURFACE_STATE);
+    }
+
+  return g_signal_has_handler_pending (state, applied_signal_id, 0, TRUE);
+}
+
+static gboolean
+state_has_timing_constraints (MetaWaylandSurfaceState *state)
+{
+  return (state->fifo.set_barrier ||
+          state->fifo.wait_barrier ||
+          state->commit_timing.has_target_time);
+}
+
+static gboolean
+is_buffer_pending (MetaWaylandTransaction *transaction,
+                   MetaWaylandBuffer      *buffer)
+{
+  return (transaction->buf_sources &&
+          g_hash_table_contains (transaction->buf_sources, buffer));
+}
+
+/*
+ * Returns the next committed transaction if it has entries for exactly the
+ * same surfaces, doesn't wait for any buffers and replaces all buffers the
+ * given transaction is still waiting for. Applying both in one go then has
+ * the same result, except that the older content is never shown.
+ */
+static MetaWaylandTransaction *
+find_superseding_transaction (MetaWaylandTransaction *transaction)
+{
+  MetaWaylandTransaction *next = NULL;
+  GHashTableIter iter;
+  MetaWaylandSurface *surface;
+  MetaWaylandTransactionEntry *entry;
+
+  g_hash_table_iter_init (&iter, transaction->entries);
+  while (g_hash_table_iter_next (&iter,
+                                 (gpointer *) &surface, (gpointer *) &entry))
+    {
+      if (!entry->next_transaction)
+        return NULL;
+
+      if (next && entry->next_transaction != next)
+        return NULL;
+
+      next = entry->next_transaction;
+    }
+
+  if (!next ||
+      g_hash_table_size (next->entries) !=
+      g_hash_table_size (transaction->entries))
+    return NULL;
+
+  if (next->buf_sources && g_hash_table_size (next->buf_sources) > 0)
+    return NULL;
+
+  g_hash_table_iter_init (&iter, transaction->entries);
+  while (g_hash_table_iter_next (&iter,
+                                 (gpointer *) &surface, (gpointer *) &entry))
+    {
+      MetaWaylandTransactionEntry *next_entry;
+
+      next_entry = meta_wayland_transaction_get_entry (next, surface);
+
+      /* Merging loses track of which state handlers were connected to */
+      if ((entry->state && state_has_applied_handlers (entry->state)) ||
+          (next_entry->state && state_has_applied_handlers (next_entry->state)))
+        return NULL;
+
+      /* Content updates with timing constraints all need to be shown */
+      if ((entry->state && state_has_timing_constraints (entry->state)) ||
+          (next_entry->state && state_has_timing_constraints (next_entry->state)))
+        return NULL;
+
+      if (entry->state && entry->state->buffer &&
+          is_buffer_pending (transaction, entry->state->buffer))
+        {
+          if (!(next_entry->state && next_entry->state->newly_attached))
+            return NULL;
+
+          /* The release point would be signalled before the acquire point */
+          if (entry->state->drm_syncobj.acquire)
+            return NULL;
+        }
+    }
+
+  return next;
+}
+
+/*
+ * Merges following transactions which supersede this one into it. The
+ * buffers which are replaced that way are released right away.
+ */
+static void
+meta_wayland_transaction_collapse (MetaWaylandTransaction *transaction)
+{
+  MetaWaylandTransaction *next;
+
+  while ((next = find_superseding_transaction (transaction)))
+    {
+      GHashTableIter iter;
+      MetaWaylandSurface *surface;
+      MetaWaylandTransactionEntry *entry;
+
+      g_hash_table_iter_init (&iter, transaction->entries);
+      while (g_hash_table_iter_next (&iter,
+                                     (gpointer *) &surface,
+                                     (gpointer *) &entry))
+        {
+          MetaWaylandTransactionEntry *next_entry;
+
+          next_entry = meta_wayland_transaction_get_entry (next, surface);
+          entry->next_transaction = next_entry->next_transaction;
+
+          if (surface->transaction.last_committed == next)
+            surface->transaction.last_committed = transaction;
+        }
+
+      /* All buffers still waited for are replaced */
+      if (transaction->buf_sources)
+        g_hash_table_remove_all (transaction->buf_sources);
+
+      meta_wayland_transaction_merge_into (next, transaction);
+    }
+}
+
+/*
+ * Whether the transaction only replaces the content of surfaces which already
+ * have some. Other changes, e.g. mapping, unmapping or configure
+ * acknowledgements, are still applied as soon as possible.
+ */
+static gboolean
+is_content_update (MetaWaylandTransaction *transaction)
+{
+  GHashTableIter iter;
+  MetaWaylandSurface *surface;
+  MetaWaylandTransactionEntry *entry;
+
+  g_hash_table_iter_init (&iter, transaction->entries);
+  while (g_hash_table_iter_next (&iter,
+                                 (gpointer *) &surface, (gpointer *) &entry))
+    {
+      MetaWaylandSurfaceState *state = entry->state;
+
+      if (entry->has_sub_pos || !state)
+        return FALSE;
+
+      if (!state->newly_attached || !state->buffer || !surface->buffer)
+        return FALSE;
+
+      if (state->has_new_geometry ||
+          state->has_acked_configure_serial ||
+          state->has_new_min_size ||
+          state->has_new_max_size ||
+          state->subsurface_placement_ops ||
+          state->xdg_positioner)
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+/*
+ * Whether the transaction waits for a fifo barrier or a target presentation
+ * time, which can only be checked when latching.
+ */
+static gboolean
+has_timing_constraints (MetaWaylandTransaction *transaction)
+{
+  GHashTableIter iter;
+  MetaWaylandTransactionEntry *entry;
+
+  g_hash_table_iter_init (&iter, transaction->entries);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &entry))
+    {
+      MetaWaylandSurfaceState *state = entry->state;
+
+      if (state &&
+          (state->fifo.wait_barrier || state->commit_timing.has_target_time))
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
+static int64_t
+get_target_time (MetaWaylandTransaction *transaction)
+{
+  GHashTableIter iter;
+  MetaWaylandTransactionEntry *entry;
+  int64_t target_time_us = 0;
+
+  g_hash_table_iter_init (&iter, transaction->entries);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &entry))
+    {
+      MetaWaylandSurfaceState *state = entry->state;
+
+      if (state && state->commit_timing.has_target_time)
+        target_time_us = MAX (target_time_us,
+                              state->commit_timing.target_time_us);
+    }
+
+  return target_time_us;
+}
+
+static gboolean
+is_primary_on_other_view (MetaWaylandSurface *surface,
+                          ClutterStageView   *stage_view)
+{
+  MetaSurfaceActor *actor = meta_wayland_surface_get_actor (surface);
+  GList *l;
+
+  if (!actor)
+    return FALSE;
+
+  for (l = clutter_actor_peek_stage_views (CLUTTER_ACTOR (actor)); l; l = l->next)
+    {
+      ClutterStageView *view = l->data;
+
+      if (view != stage_view &&
+          meta_surface_actor_wayland_is_view_primary (actor, view))
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
+/*
+ * Target presentation times are checked against the frame being latched for,
+ * unless the surface is shown on another view, which will latch it with its
+ * own frame.
+ */
+static gboolean
+is_target_time_reached (MetaWaylandCompositor *compositor,
+                        MetaWaylandSurface    *surface,
+                        int64_t                target_time_us)
+{
+  if (compositor->latch_view &&
+      is_primary_on_other_view (surface, compositor->latch_view))
+    return FALSE;
+
+  return (compositor->latch_presentation_time_us +
+          META_WAYLAND_TRANSACTION_TARGET_TIME_SLACK_US >= target_time_us);
+}
+
+static gboolean
+is_ready_for_latch (MetaWaylandTransaction *transaction)
+{
+  MetaWaylandCompositor *compositor = transaction->compositor;
+  GHashTableIter iter;
+  MetaWaylandSurface *surface;
+  MetaWaylandTransactionEntry *entry;
+
+  g_hash_table_iter_init (&iter, transaction->entries);
+  while (g_hash_table_iter_next (&iter,
+                                 (gpointer *) &surface, (gpointer *) &entry))
+    {
+      MetaWaylandSurfaceState *state = entry->state;
+
+      if (!state)
+        continue;
+
+      if (state->fifo.wait_barrier &&
+          meta_wayland_surface_is_fifo_barrier_set (surface))
+        return FALSE;
+
+      if (state->commit_timing.has_target_time &&
+          !is_target_time_reached (compositor, surface,
+                                   state->commit_timing.target_time_us))
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+static gboolean
+latch_timeout_cb (gpointer user_data);
+
+/*
+ * Asks the frame clocks of the views the surfaces are shown on for an update
+ * in time for the transaction, or the whole stage if there are none.
+ */
+static void
+meta_wayland_transaction_schedule_latch (MetaWaylandTransaction *transaction)
+{
+  MetaWaylandCompositor *compositor = transaction->compositor;
+  MetaContext *context = meta_wayland_compositor_get_context (compositor);
+  MetaBackend *backend = meta_context_get_backend (context);
+  int64_t presentation_time_us;
+  gboolean scheduled = FALSE;
+  GHashTableIter iter;
+  MetaWaylandSurface *surface;
+
+  presentation_time_us = MAX (get_target_time (transaction) -
+                              META_WAYLAND_TRANSACTION_TARGET_TIME_SLACK_US,
+                              g_get_monotonic_time ());
+
+  g_hash_table_iter_init (&iter, transaction->entries);
+  while (g_hash_table_iter_next (&iter, (gpointer *) &surface, NULL))
+    {
+      MetaSurfaceActor *actor = meta_wayland_surface_get_actor (surface);
+      GList *l;
+
+      if (!actor)
+        continue;
+
+      for (l = clutter_actor_peek_stage_views (CLUTTER_ACTOR (actor));
+           l;
+           l = l->next)
+        {
+          ClutterStageView *view = l->data;
+
+          if (!meta_surface_actor_wayland_is_view_primary (actor, view))
+            continue;
+
+          clutter_frame_clock_schedule_update_at (clutter_stage_view_get_frame_clock (view),
+                                                  presentation_time_us);
+          scheduled = TRUE;
+        }
+    }
+
+  if (!scheduled)
+    clutter_stage_schedule_update (CLUTTER_STAGE (meta_backend_get_stage (backend)));
+
+  if (compositor->transaction_latch_timeout_id)
+    return;
+
+  if (compositor->transactions_latching)
+    {
+      int64_t target_time_us;
+      int64_t timeout_ms;
+
+      /* Held back by its timing constraints, which the frame clocks were
+       * asked to take care of. Without them, it's only latched once its
+       * target time passed, and fifo barriers are cleared on their own. */
+      target_time_us = get_target_time (transaction);
+      if (!target_time_us)
+        return;
+
+      timeout_ms = (target_time_us - g_get_monotonic_time ()) / 1000 +
+                   META_WAYLAND_TRANSACTION_LATCH_TIMEOUT_MS;
+      compositor->transaction_latch_timeout_id =
+        g_timeout_add (CLAMP (timeout_ms,
+                              META_WAYLAND_TRANSACTION_LATCH_TIMEOUT_MS,
+                              G_MAXINT),
+                       latch_timeout_cb, compositor);
+    }
+  else
+    {
+      compositor->transaction_latch_timeout_id =
+        g_timeout_add (META_WAYLAND_TRANSACTION_LATCH_TIMEOUT_MS,
+                       latch_timeout_cb, compositor);
+    }
+
+  g_source_set_name_by_id (compositor->transaction_latch_timeout_id,
+                           "[mutter] Wayland transaction latch");
+}
+
 static void
 meta_wayland_transaction_maybe_apply_one (MetaWaylandTransaction  *transaction,
                                           MetaWaylandTransaction **first_candidate)
 {
+  MetaWaylandCompositor *compositor = transaction->compositor;
+
+  if (compositor->transactions_latching)
+    meta_wayland_transaction_collapse (transaction);
+
   if (has_dependencies (transaction))
     return;
 
+  if (compositor->transactions_latching)
+    {
+      if (!is_ready_for_latch (transaction))
+        {
+          meta_wayland_transaction_schedule_latch (transaction);
+          return;
+        }
+    }
+  else if (is_content_update (transaction) ||
+           has_timing_constraints (transaction))
+    {
+      meta_wayland_transaction_schedule_latch (transaction);
+      return;
+    }
+
   meta_wayland_transaction_apply (transaction, first_candidate);
 }
 
@@ -276,6 +681,78 @@ meta_wayland_transaction_maybe_apply (MetaWaylandTransaction *transaction)
     }
 }
 
+static void
+meta_wayland_transaction_latch (MetaWaylandCompositor *compositor,
+                                ClutterStageView      *stage_view,
+                                ClutterFrame          *frame)
+{
+  GQueue *committed_queue;
+  GList *l;
+
+  g_clear_handle_id (&compositor->transaction_latch_timeout_id,
+                     g_source_remove);
+
+  committed_queue =
+    meta_wayland_compositor_get_committed_transactions (compositor);
+
+  compositor->transactions_latching = TRUE;
+  compositor->latch_view = stage_view;
+  compositor->latch_frame_count = frame ? clutter_frame_get_count (frame) : 0;
+  if (!frame ||
+      !clutter_frame_get_target_presentation_time (frame,
+                                                   &compositor->latch_presentation_time_us))
+    compositor->latch_presentation_time_us = g_get_monotonic_time ();
+
+  l = committed_queue->head;
+  while (l)
+    {
+      MetaWaylandTransaction *transaction = l->data;
+
+      meta_wayland_transaction_collapse (transaction);
+
+      if (has_dependencies (transaction))
+        {
+          l = l->next;
+          continue;
+        }
+
+      if (!is_ready_for_latch (transaction))
+        {
+          meta_wayland_transaction_schedule_latch (transaction);
+          l = l->next;
+          continue;
+        }
+
+      meta_wayland_transaction_maybe_apply (transaction);
+
+      /* Applying can free any number of transactions */
+      l = committed_queue->head;
+    }
+
+  compositor->latch_view = NULL;
+  compositor->transactions_latching = FALSE;
+}
+
+static gboolean
+latch_timeout_cb (gpointer user_data)
+{
+  MetaWaylandCompositor *compositor = user_data;
+
+  compositor->transaction_latch_timeout_id = 0;
+  meta_wayland_transaction_latch (compositor, NULL, NULL);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+on_before_update (ClutterStage          *stage,
+                  ClutterStageView      *stage_view,
+                  ClutterFrame          *frame,
+                  MetaWaylandCompositor *compositor)
+{
+  meta_wayland_transaction_latch (compositor, stage_view, frame);
+}
+
 static void
 meta_wayland_transaction_dma_buf_dispatch (MetaWaylandBuffer *buffer,
                                            gpointer           user_data)
@@ -290,18 +767,34 @@ meta_wayland_transaction_dma_buf_dispatch (MetaWaylandBuffer *buffer,
 }
 
 static gboolean
-meta_wayland_transaction_add_dma_buf_source (MetaWaylandTransaction *transaction,
-                                             MetaWaylandBuffer      *buffer)
+meta_wayland_transaction_add_dma_buf_source (MetaWaylandTransaction  *transaction,
+                                             MetaWaylandSurfaceState *state)
 {
+  MetaWaylandBuffer *buffer = state->buffer;
   GSource *source;
 
   if (transaction->buf_sources &&
       g_hash_table_contains (transaction->buf_sources, buffer))
     return FALSE;
 
-  source = meta_wayland_dma_buf_create_source (buffer,
+  /* With explicit sync, only the acquire point needs to be waited for,
+   * not the implicit fences */
+  if (state->drm_syncobj.acquire)
+    {
+      source =
+        meta_wayland_sync_point_create_source (state->drm_syncobj.acquire,
+                                               buffer,
                                                meta_wayland_transaction_dma_buf_dispatch,
                                                transaction);
+    }
+  else
+    {
+      source =
+        meta_wayland_dma_buf_create_source (buffer,
+                                            meta_wayland_transaction_dma_buf_dispatch,
+                                            transaction);
+    }
+
   if (!source)
     return FALSE;
 
@@ -335,10 +828,9 @@ meta_wayland_transaction_commit (MetaWaylandTransaction *transaction)
     {
       if (entry && entry->state)
         {
-          MetaWaylandBuffer *buffer = entry->state->buffer;
-
-          if (buffer &&
-              meta_wayland_transaction_add_dma_buf_source (transaction, buffer))
+          if (entry->state->buffer &&
+              meta_wayland_transaction_add_dma_buf_source (transaction,
+                                                           entry->state))
             maybe_apply = FALSE;
         }
     }
@@ -592,9 +1084,16 @@ meta_wayland_transaction_free (MetaWaylandTransaction *transaction)
 void
 meta_wayland_transaction_finalize (MetaWaylandCompositor *compositor)
 {
+  MetaContext *context = meta_wayland_compositor_get_context (compositor);
+  MetaBackend *backend = meta_context_get_backend (context);
+  ClutterActor *stage = meta_backend_get_stage (backend);
   GQueue *transactions;
   GList *node;
 
+  g_signal_handlers_disconnect_by_func (stage, on_before_update, compositor);
+  g_clear_handle_id (&compositor->transaction_latch_timeout_id,
+                     g_source_remove);
+
   transactions = meta_wayland_compositor_get_committed_transactions (compositor);
 
   while ((node = g_queue_pop_head_link (transactions)))
@@ -610,8 +1109,14 @@ meta_wayland_transaction_finalize (MetaWaylandCompositor *compositor)
 void
 meta_wayland_transaction_init (MetaWaylandCompositor *compositor)
 {
+  MetaContext *context = meta_wayland_compositor_get_context (compositor);
+  MetaBackend *backend = meta_context_get_backend (context);
+  ClutterActor *stage = meta_backend_get_stage (backend);
   GQueue *transactions;
 
   transactions = meta_wayland_compositor_get_committed_transactions (compositor);
   g_queue_init (transactions);
+
+  g_signal_connect (stage, "before-update",
+                    G_CALLBACK (on_before_update), compositor);
 }
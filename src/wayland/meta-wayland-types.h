@@ -66,6 +66,11 @@ typedef struct _MetaWaylandActivation MetaWaylandActivation;
 
 typedef struct _MetaWaylandDmaBufManager MetaWaylandDmaBufManager;
 
+typedef struct _MetaWaylandDrmSyncobjManager MetaWaylandDrmSyncobjManager;
+typedef struct _MetaWaylandSyncPoint MetaWaylandSyncPoint;
+
+typedef struct _MetaWaylandUdmabuf MetaWaylandUdmabuf;
+
 typedef struct _MetaWaylandXdgPositioner MetaWaylandXdgPositioner;
 
 typedef struct _MetaXWaylandManager MetaXWaylandManager;
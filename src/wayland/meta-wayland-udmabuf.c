@@ -0,0 +1,426 @@
+/*
+ * Copyright (C) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * wl_shm buffers whose pool is a sealed memfd can be turned into dma-bufs
+ * by the udmabuf driver, and then be imported like any other dma-buf
+ * instead of being copied into a texture on every commit.
+ *
+ * libwayland doesn't give access to the file descriptor of a wl_shm pool,
+ * so the wl_shm requests are observed using a protocol logger, keeping a
+ * duplicate of each suitable pool file descriptor and the offset of each
+ * buffer created from it.
+ */
+
+#include "config.h"
+
+#include "wayland/meta-wayland-udmabuf.h"
+
+#include <drm_fourcc.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <glib/gstdio.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <wayland-server.h>
+
+#ifdef HAVE_LINUX_UDMABUF
+#include <linux/udmabuf.h>
+#endif
+
+#include "meta/util.h"
+#include "wayland/meta-wayland-buffer.h"
+#include "wayland/meta-wayland-private.h"
+
+typedef struct _MetaWaylandShmPool
+{
+  int fd;
+} MetaWaylandShmPool;
+
+typedef struct _MetaWaylandShmBufferInfo
+{
+  MetaWaylandShmPool *pool;
+  int32_t offset;
+} MetaWaylandShmBufferInfo;
+
+typedef struct _MetaWaylandUdmabufClient
+{
+  MetaWaylandUdmabuf *udmabuf;
+  struct wl_client *wayland_client;
+  struct wl_listener destroy_listener;
+
+  /* wl_shm_pool id -> MetaWaylandShmPool */
+  GHashTable *pools;
+  /* wl_buffer id -> MetaWaylandShmBufferInfo */
+  GHashTable *buffers;
+} MetaWaylandUdmabufClient;
+
+struct _MetaWaylandUdmabuf
+{
+  MetaWaylandCompositor *compositor;
+
+  int fd;
+  struct wl_protocol_logger *protocol_logger;
+
+  /* struct wl_client -> MetaWaylandUdmabufClient */
+  GHashTable *clients;
+};
+
+static MetaWaylandUdmabufClient *
+lookup_udmabuf_client (MetaWaylandUdmabuf *udmabuf,
+                       struct wl_resource *resource)
+{
+  return g_hash_table_lookup (udmabuf->clients,
+                              wl_resource_get_client (resource));
+}
+
+#ifdef HAVE_LINUX_UDMABUF
+static void
+shm_pool_clear (MetaWaylandShmPool *pool)
+{
+  g_clear_fd (&pool->fd, NULL);
+}
+
+static void
+shm_pool_unref (MetaWaylandShmPool *pool)
+{
+  g_rc_box_release_full (pool, (GDestroyNotify) shm_pool_clear);
+}
+
+static void
+shm_buffer_info_free (MetaWaylandShmBufferInfo *info)
+{
+  shm_pool_unref (info->pool);
+  g_free (info);
+}
+
+static void
+udmabuf_client_free (MetaWaylandUdmabufClient *client)
+{
+  wl_list_remove (&client->destroy_listener.link);
+  g_hash_table_unref (client->buffers);
+  g_hash_table_unref (client->pools);
+  g_free (client);
+}
+
+static void
+udmabuf_client_destroyed (struct wl_listener *listener,
+                          void               *data)
+{
+  MetaWaylandUdmabufClient *client = wl_container_of (listener, client,
+                                                      destroy_listener);
+
+  g_hash_table_remove (client->udmabuf->clients, client->wayland_client);
+}
+
+static MetaWaylandUdmabufClient *
+ensure_udmabuf_client (MetaWaylandUdmabuf *udmabuf,
+                       struct wl_client   *wayland_client)
+{
+  MetaWaylandUdmabufClient *client;
+
+  client = g_hash_table_lookup (udmabuf->clients, wayland_client);
+  if (client)
+    return client;
+
+  client = g_new0 (MetaWaylandUdmabufClient, 1);
+  client->udmabuf = udmabuf;
+  client->wayland_client = wayland_client;
+  client->pools = g_hash_table_new_full (NULL, NULL, NULL,
+                                         (GDestroyNotify) shm_pool_unref);
+  client->buffers = g_hash_table_new_full (NULL, NULL, NULL,
+                                           (GDestroyNotify) shm_buffer_info_free);
+  client->destroy_listener.notify = udmabuf_client_destroyed;
+  wl_client_add_destroy_listener (wayland_client, &client->destroy_listener);
+
+  g_hash_table_insert (udmabuf->clients, wayland_client, client);
+
+  return client;
+}
+
+static void
+handle_shm_create_pool (MetaWaylandUdmabuf                      *udmabuf,
+                        const struct wl_protocol_logger_message *message)
+{
+  MetaWaylandUdmabufClient *client;
+  MetaWaylandShmPool *pool;
+  uint32_t pool_id = message->arguments[0].n;
+  int fd = message->arguments[1].h;
+  int seals;
+  int pool_fd;
+
+  /* udmabuf only accepts memfds that can't shrink, and that can still be
+   * written to */
+  seals = fcntl (fd, F_GET_SEALS);
+  if (seals < 0 || !(seals & F_SEAL_SHRINK) || (seals & F_SEAL_WRITE))
+    return;
+
+  pool_fd = fcntl (fd, F_DUPFD_CLOEXEC, 0);
+  if (pool_fd < 0)
+    return;
+
+  pool = g_rc_box_new0 (MetaWaylandShmPool);
+  pool->fd = pool_fd;
+
+  client = ensure_udmabuf_client (udmabuf,
+                                  wl_resource_get_client (message->resource));
+  g_hash_table_replace (client->pools, GUINT_TO_POINTER (pool_id), pool);
+}
+
+static void
+handle_shm_pool_create_buffer (MetaWaylandUdmabuf                      *udmabuf,
+                               const struct wl_protocol_logger_message *message)
+{
+  MetaWaylandUdmabufClient *client;
+  MetaWaylandShmPool *pool;
+  MetaWaylandShmBufferInfo *info;
+  uint32_t buffer_id = message->arguments[0].n;
+
+  client = lookup_udmabuf_client (udmabuf, message->resource);
+  if (!client)
+    return;
+
+  pool = g_hash_table_lookup (client->pools,
+                              GUINT_TO_POINTER (wl_resource_get_id (message->resource)));
+  if (!pool)
+    return;
+
+  info = g_new0 (MetaWaylandShmBufferInfo, 1);
+  info->pool = g_rc_box_acquire (pool);
+  info->offset = message->arguments[1].i;
+
+  g_hash_table_replace (client->buffers, GUINT_TO_POINTER (buffer_id), info);
+}
+
+static void
+handle_destroy (MetaWaylandUdmabuf                      *udmabuf,
+                const struct wl_protocol_logger_message *message,
+                gboolean                                 is_pool)
+{
+  MetaWaylandUdmabufClient *client;
+  uint32_t id;
+
+  client = lookup_udmabuf_client (udmabuf, message->resource);
+  if (!client)
+    return;
+
+  id = wl_resource_get_id (message->resource);
+  if (is_pool)
+    g_hash_table_remove (client->pools, GUINT_TO_POINTER (id));
+  else
+    g_hash_table_remove (client->buffers, GUINT_TO_POINTER (id));
+}
+
+static void
+protocol_logger_func (void                                    *user_data,
+                      enum wl_protocol_logger_type             type,
+                      const struct wl_protocol_logger_message *message)
+{
+  MetaWaylandUdmabuf *udmabuf = user_data;
+  const char *interface_name;
+  const char *request_name;
+
+  if (type != WL_PROTOCOL_LOGGER_REQUEST)
+    return;
+
+  interface_name = wl_resource_get_class (message->resource);
+  request_name = message->message->name;
+
+  if (g_str_equal (interface_name, "wl_shm"))
+    {
+      if (g_str_equal (request_name, "create_pool"))
+        handle_shm_create_pool (udmabuf, message);
+    }
+  else if (g_str_equal (interface_name, "wl_shm_pool"))
+    {
+      if (g_str_equal (request_name, "create_buffer"))
+        handle_shm_pool_create_buffer (udmabuf, message);
+      else if (g_str_equal (request_name, "destroy"))
+        handle_destroy (udmabuf, message, TRUE);
+    }
+  else if (g_str_equal (interface_name, "wl_buffer"))
+    {
+      if (g_str_equal (request_name, "destroy"))
+        handle_destroy (udmabuf, message, FALSE);
+    }
+}
+#endif /* HAVE_LINUX_UDMABUF */
+
+static uint32_t
+drm_format_from_shm_format (uint32_t shm_format)
+{
+  switch (shm_format)
+    {
+    case WL_SHM_FORMAT_ARGB8888:
+      return DRM_FORMAT_ARGB8888;
+    case WL_SHM_FORMAT_XRGB8888:
+      return DRM_FORMAT_XRGB8888;
+    default:
+      /* All other wl_shm formats use the DRM fourcc codes */
+      return shm_format;
+    }
+}
+
+#ifdef HAVE_LINUX_UDMABUF
+static int
+create_udmabuf (MetaWaylandUdmabuf *udmabuf,
+                int                 memfd,
+                uint64_t            offset,
+                uint64_t            size)
+{
+  struct udmabuf_create create = {
+    .memfd = memfd,
+    .flags = UDMABUF_FLAGS_CLOEXEC,
+    .offset = offset,
+    .size = size,
+  };
+
+  return ioctl (udmabuf->fd, UDMABUF_CREATE, &create);
+}
+#else
+static int
+create_udmabuf (MetaWaylandUdmabuf *udmabuf G_GNUC_UNUSED,
+                int                 memfd G_GNUC_UNUSED,
+                uint64_t            offset G_GNUC_UNUSED,
+                uint64_t            size G_GNUC_UNUSED)
+{
+  errno = ENOTSUP;
+  return -1;
+}
+#endif
+
+/**
+ * meta_wayland_udmabuf_import_shm_buffer:
+ * @udmabuf: a #MetaWaylandUdmabuf
+ * @buffer: a wl_shm based #MetaWaylandBuffer
+ *
+ * Creates a dma-buf sharing the memory of @buffer, if its pool is
+ * suitable for it.
+ *
+ * Returns: (transfer full) (nullable): A new #MetaWaylandDmaBufBuffer
+ */
+MetaWaylandDmaBufBuffer *
+meta_wayland_udmabuf_import_shm_buffer (MetaWaylandUdmabuf *udmabuf,
+                                        MetaWaylandBuffer  *buffer)
+{
+  struct wl_resource *resource = buffer->resource;
+  MetaWaylandUdmabufClient *client;
+  MetaWaylandShmBufferInfo *info;
+  struct wl_shm_buffer *shm_buffer;
+  struct stat stat_buf;
+  int64_t page_size;
+  int64_t start, end;
+  int width, height, stride;
+  int fd;
+
+  client = lookup_udmabuf_client (udmabuf, resource);
+  if (!client)
+    return NULL;
+
+  info = g_hash_table_lookup (client->buffers,
+                              GUINT_TO_POINTER (wl_resource_get_id (resource)));
+  if (!info)
+    return NULL;
+
+  shm_buffer = wl_shm_buffer_get (resource);
+  width = wl_shm_buffer_get_width (shm_buffer);
+  height = wl_shm_buffer_get_height (shm_buffer);
+  stride = wl_shm_buffer_get_stride (shm_buffer);
+
+  /* udmabuf works on whole pages, so include the partial pages at either
+   * end and compensate with the plane offset */
+  page_size = sysconf (_SC_PAGESIZE);
+  start = info->offset - (info->offset % page_size);
+  end = (int64_t) info->offset + (int64_t) stride * height;
+  end = ((end + page_size - 1) / page_size) * page_size;
+
+  if (fstat (info->pool->fd, &stat_buf) != 0 || end > stat_buf.st_size)
+    return NULL;
+
+  fd = create_udmabuf (udmabuf, info->pool->fd, start, end - start);
+  if (fd < 0)
+    {
+      meta_topic (META_DEBUG_WAYLAND,
+                  "Failed to create udmabuf for wl_buffer@%u: %s",
+                  wl_resource_get_id (resource), g_strerror (errno));
+      return NULL;
+    }
+
+  return meta_wayland_dma_buf_buffer_new_linear (udmabuf->compositor->dma_buf_manager,
+                                                 fd,
+                                                 width,
+                                                 height,
+                                                 drm_format_from_shm_format (wl_shm_buffer_get_format (shm_buffer)),
+                                                 info->offset - start,
+                                                 stride);
+}
+
+MetaWaylandUdmabuf *
+meta_wayland_udmabuf_new (MetaWaylandCompositor  *compositor,
+                          GError                **error)
+{
+#ifdef HAVE_LINUX_UDMABUF
+  MetaWaylandUdmabuf *udmabuf;
+  int fd;
+
+  if (!compositor->dma_buf_manager)
+    {
+      g_set_error (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+                   "No dma-buf support");
+      return NULL;
+    }
+
+  fd = open ("/dev/udmabuf", O_RDWR | O_CLOEXEC);
+  if (fd < 0)
+    {
+      int errsv = errno;
+
+      g_set_error (error, G_IO_ERROR,
+                   errsv == ENOENT ? G_IO_ERROR_NOT_SUPPORTED
+                                   : g_io_error_from_errno (errsv),
+                   "Failed to open /dev/udmabuf: %s", g_strerror (errsv));
+      return NULL;
+    }
+
+  udmabuf = g_new0 (MetaWaylandUdmabuf, 1);
+  udmabuf->compositor = compositor;
+  udmabuf->fd = fd;
+  udmabuf->clients =
+    g_hash_table_new_full (NULL, NULL, NULL,
+                           (GDestroyNotify) udmabuf_client_free);
+  udmabuf->protocol_logger =
+    wl_display_add_protocol_logger (compositor->wayland_display,
+                                    protocol_logger_func,
+                                    udmabuf);
+
+  return udmabuf;
+#else
+  g_set_error (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+               "Built without udmabuf support");
+  return NULL;
+#endif
+}
+
+void
+meta_wayland_udmabuf_free (MetaWaylandUdmabuf *udmabuf)
+{
+  g_clear_pointer (&udmabuf->protocol_logger, wl_protocol_logger_destroy);
+  g_clear_pointer (&udmabuf->clients, g_hash_table_unref);
+  g_clear_fd (&udmabuf->fd, NULL);
+  g_free (udmabuf);
+}
@@ -0,0 +1,37 @@
+/*
+ * Copyright (C) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <glib.h>
+
+#include "core/util-private.h"
+#include "wayland/meta-wayland-dma-buf.h"
+#include "wayland/meta-wayland-types.h"
+
+META_EXPORT_TEST
+MetaWaylandUdmabuf * meta_wayland_udmabuf_new (MetaWaylandCompositor  *compositor,
+                                               GError                **error);
+
+META_EXPORT_TEST
+void meta_wayland_udmabuf_free (MetaWaylandUdmabuf *udmabuf);
+
+META_EXPORT_TEST
+MetaWaylandDmaBufBuffer * meta_wayland_udmabuf_import_shm_buffer (MetaWaylandUdmabuf *udmabuf,
+                                                                  MetaWaylandBuffer  *buffer);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (MetaWaylandUdmabuf, meta_wayland_udmabuf_free)
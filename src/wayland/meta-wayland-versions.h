@@ -59,3 +59,6 @@
 #define META_WP_SINGLE_PIXEL_BUFFER_V1_VERSION 1
 #define META_MUTTER_X11_INTEROP_VERSION 1
 #define META_WP_FRACTIONAL_SCALE_VERSION 1
+#define META_WP_LINUX_DRM_SYNCOBJ_V1_VERSION 1
+#define META_WP_FIFO_V1_VERSION 1
+#define META_WP_COMMIT_TIMING_V1_VERSION 1
@@ -28,6 +28,8 @@
 #include <stdlib.h>
 #include <wayland-server.h>
 
+#include "backends/meta-backend-private.h"
+#include "backends/meta-settings-private.h"
 #include "clutter/clutter.h"
 #include "cogl/cogl-egl.h"
 #include "compositor/meta-surface-actor-wayland.h"
@@ -35,9 +37,12 @@
 #include "core/meta-context-private.h"
 #include "wayland/meta-wayland-activation.h"
 #include "wayland/meta-wayland-buffer.h"
+#include "wayland/meta-wayland-commit-timing.h"
 #include "wayland/meta-wayland-data-device.h"
 #include "wayland/meta-wayland-dma-buf.h"
+#include "wayland/meta-wayland-drm-syncobj.h"
 #include "wayland/meta-wayland-egl-stream.h"
+#include "wayland/meta-wayland-fifo.h"
 #include "wayland/meta-wayland-filter-manager.h"
 #include "wayland/meta-wayland-idle-inhibit.h"
 #include "wayland/meta-wayland-inhibit-shortcuts-dialog.h"
@@ -46,11 +51,13 @@
 #include "wayland/meta-wayland-outputs.h"
 #include "wayland/meta-wayland-presentation-time-private.h"
 #include "wayland/meta-wayland-private.h"
+#include "wayland/meta-wayland-protocol-tracer.h"
 #include "wayland/meta-wayland-region.h"
 #include "wayland/meta-wayland-seat.h"
 #include "wayland/meta-wayland-subsurface.h"
 #include "wayland/meta-wayland-tablet-manager.h"
 #include "wayland/meta-wayland-transaction.h"
+#include "wayland/meta-wayland-udmabuf.h"
 #include "wayland/meta-wayland-xdg-foreign.h"
 
 #ifdef HAVE_XWAYLAND
@@ -65,6 +72,9 @@
 #include "backends/native/meta-renderer-native.h"
 #endif
 
+/* Headroom for clients which take longer than usual for a frame */
+#define FRAME_CALLBACK_LEAD_TIME_MARGIN_US 2000
+
 enum
 {
   PREPARE_SHUTDOWN,
@@ -82,6 +92,8 @@ typedef struct _MetaWaylandCompositorPrivate
 
   MetaWaylandFilterManager *filter_manager;
   GHashTable *frame_callback_sources;
+  guint hidden_frame_callbacks_timeout_id;
+  MetaWaylandProtocolTracer *protocol_tracer;
 } MetaWaylandCompositorPrivate;
 
 G_DEFINE_TYPE_WITH_PRIVATE (MetaWaylandCompositor, meta_wayland_compositor,
@@ -90,6 +102,7 @@ G_DEFINE_TYPE_WITH_PRIVATE (MetaWaylandCompositor, meta_wayland_compositor,
 typedef struct
 {
   GSource source;
+  MetaWaylandCompositor *compositor;
   struct wl_display *display;
 } WaylandEventSource;
 
@@ -121,10 +134,15 @@ wayland_event_source_dispatch (GSource    *base,
                                void       *data)
 {
   WaylandEventSource *source = (WaylandEventSource *)base;
+  MetaWaylandCompositorPrivate *priv =
+    meta_wayland_compositor_get_instance_private (source->compositor);
   struct wl_event_loop *loop = wl_display_get_event_loop (source->display);
 
   wl_event_loop_dispatch (loop, 0);
 
+  if (priv->protocol_tracer)
+    meta_wayland_protocol_tracer_end_dispatch (priv->protocol_tracer);
+
   return TRUE;
 }
 
@@ -137,8 +155,9 @@ static GSourceFuncs wayland_event_source_funcs =
 };
 
 static GSource *
-wayland_event_source_new (struct wl_display *display)
+wayland_event_source_new (MetaWaylandCompositor *compositor)
 {
+  struct wl_display *display = compositor->wayland_display;
   GSource *source;
   WaylandEventSource *wayland_source;
   struct wl_event_loop *loop = wl_display_get_event_loop (display);
@@ -147,6 +166,7 @@ wayland_event_source_new (struct wl_display *display)
                          sizeof (WaylandEventSource));
   g_source_set_name (source, "[mutter] Wayland events");
   wayland_source = (WaylandEventSource *) source;
+  wayland_source->compositor = compositor;
   wayland_source->display = display;
   g_source_add_unix_fd (&wayland_source->source,
                         wl_event_loop_get_fd (loop),
@@ -155,12 +175,47 @@ wayland_event_source_new (struct wl_display *display)
   return &wayland_source->source;
 }
 
+static GSource *
+ensure_source_for_stage_view (MetaWaylandCompositor *compositor,
+                              ClutterStageView      *stage_view);
+
+static gboolean
+is_surface_actor_on_any_view (MetaSurfaceActor *actor);
+
+static void
+ensure_hidden_frame_callbacks_timeout (MetaWaylandCompositor *compositor);
+
+static void
+emit_frame_callbacks_for_surface (MetaWaylandSurface *surface,
+                                  ClutterStageView   *stage_view,
+                                  int64_t             now_us)
+{
+  MetaWaylandActorSurface *actor_surface =
+    META_WAYLAND_ACTOR_SURFACE (surface->role);
+  int64_t refresh_interval_us = 0;
+
+  if (stage_view)
+    {
+      refresh_interval_us =
+        (int64_t) (0.5 + G_USEC_PER_SEC /
+                   clutter_stage_view_get_refresh_rate (stage_view));
+    }
+
+  meta_wayland_actor_surface_emit_frame_callbacks (actor_surface,
+                                                   now_us / 1000);
+  meta_wayland_presentation_time_frame_callbacks_emitted (surface, now_us,
+                                                          refresh_interval_us);
+  surface->last_frame_callback_time_us = now_us;
+}
+
 static void
 emit_frame_callbacks_for_stage_view (MetaWaylandCompositor *compositor,
                                      ClutterStageView      *stage_view)
 {
   GList *l;
   int64_t now_us;
+  int64_t throttle_time_us = 0;
+  gboolean has_hidden_surfaces = FALSE;
 
   now_us = g_get_monotonic_time ();
 
@@ -170,7 +225,7 @@ emit_frame_callbacks_for_stage_view (MetaWaylandCompositor *compositor,
       GList *l_cur = l;
       MetaWaylandSurface *surface = l->data;
       MetaSurfaceActor *actor;
-      MetaWaylandActorSurface *actor_surface;
+      int64_t surface_throttle_time_us;
 
       l = l->next;
 
@@ -180,17 +235,185 @@ emit_frame_callbacks_for_stage_view (MetaWaylandCompositor *compositor,
 
       if (!meta_surface_actor_wayland_is_view_primary (actor,
                                                        stage_view))
+        {
+          if (!has_hidden_surfaces)
+            has_hidden_surfaces = !is_surface_actor_on_any_view (actor);
+          continue;
+        }
+
+      surface_throttle_time_us =
+        meta_wayland_surface_get_frame_callback_throttle_time (surface,
+                                                               stage_view,
+                                                               now_us);
+      if (surface_throttle_time_us)
+        {
+          if (!throttle_time_us || surface_throttle_time_us < throttle_time_us)
+            throttle_time_us = surface_throttle_time_us;
+          continue;
+        }
+
+      emit_frame_callbacks_for_surface (surface, stage_view, now_us);
+
+      compositor->frame_callback_surfaces =
+        g_list_delete_link (compositor->frame_callback_surfaces, l_cur);
+    }
+
+  /*
+   * Come back for throttled surfaces without waiting for, or causing, a
+   * stage update, as they might be the only thing that would draw.
+   */
+  if (throttle_time_us)
+    {
+      GSource *source = ensure_source_for_stage_view (compositor, stage_view);
+      int64_t ready_time_us = g_source_get_ready_time (source);
+
+      if (ready_time_us == -1 || throttle_time_us < ready_time_us)
+        g_source_set_ready_time (source, throttle_time_us);
+    }
+
+  /* Surfaces might have been hidden since they requested frame callbacks */
+  if (has_hidden_surfaces)
+    ensure_hidden_frame_callbacks_timeout (compositor);
+}
+
+static gboolean
+is_surface_actor_on_any_view (MetaSurfaceActor *actor)
+{
+  ClutterActor *stage = clutter_actor_get_stage (CLUTTER_ACTOR (actor));
+  GList *l;
+
+  if (!stage)
+    return FALSE;
+
+  for (l = clutter_stage_peek_stage_views (CLUTTER_STAGE (stage)); l; l = l->next)
+    {
+      if (meta_surface_actor_wayland_is_view_primary (actor, l->data))
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
+/*
+ * Surfaces that aren't visible on any view never get frame callbacks from
+ * stage updates, so they get throttled ones from here instead, to not leave
+ * clients blocked on them indefinitely.
+ */
+static gboolean
+hidden_frame_callbacks_timeout_cb (gpointer user_data)
+{
+  MetaWaylandCompositor *compositor = user_data;
+  MetaWaylandCompositorPrivate *priv =
+    meta_wayland_compositor_get_instance_private (compositor);
+  GList *l;
+  int64_t now_us;
+  gboolean has_hidden_surfaces = FALSE;
+
+  now_us = g_get_monotonic_time ();
+
+  l = compositor->frame_callback_surfaces;
+  while (l)
+    {
+      GList *l_cur = l;
+      MetaWaylandSurface *surface = l->data;
+      MetaSurfaceActor *actor;
+
+      l = l->next;
+
+      actor = meta_wayland_surface_get_actor (surface);
+      if (!actor)
+        continue;
+
+      if (is_surface_actor_on_any_view (actor))
         continue;
 
-      actor_surface = META_WAYLAND_ACTOR_SURFACE (surface->role);
-      meta_wayland_actor_surface_emit_frame_callbacks (actor_surface,
-                                                       now_us / 1000);
+      if (meta_wayland_surface_get_frame_callback_throttle_time (surface,
+                                                                 NULL,
+                                                                 now_us))
+        {
+          has_hidden_surfaces = TRUE;
+          continue;
+        }
+
+      emit_frame_callbacks_for_surface (surface, NULL, now_us);
 
       compositor->frame_callback_surfaces =
         g_list_delete_link (compositor->frame_callback_surfaces, l_cur);
     }
+
+  if (!has_hidden_surfaces)
+    {
+      priv->hidden_frame_callbacks_timeout_id = 0;
+      return G_SOURCE_REMOVE;
+    }
+
+  return G_SOURCE_CONTINUE;
 }
 
+/*
+ * Only runs while surfaces that aren't visible on any view wait for frame
+ * callbacks. Visible ones get them from the updates of their stage views.
+ */
+static void
+ensure_hidden_frame_callbacks_timeout (MetaWaylandCompositor *compositor)
+{
+  MetaWaylandCompositorPrivate *priv =
+    meta_wayland_compositor_get_instance_private (compositor);
+
+  if (priv->hidden_frame_callbacks_timeout_id)
+    return;
+
+  priv->hidden_frame_callbacks_timeout_id =
+    g_timeout_add_seconds (1, hidden_frame_callbacks_timeout_cb,
+                           compositor);
+  g_source_set_name_by_id (priv->hidden_frame_callbacks_timeout_id,
+                           "[mutter] Wayland hidden surface frame callbacks");
+}
+
+#ifdef HAVE_NATIVE_BACKEND
+/*
+ * How long before an update frame callbacks need to be emitted for the
+ * clients on the stage view to have new content ready for it, going by how
+ * long they took for previous frames.
+ */
+static gboolean
+get_frame_callback_lead_time (MetaWaylandCompositor *compositor,
+                              ClutterStageView      *stage_view,
+                              int64_t               *out_lead_time_us)
+{
+  int64_t lead_time_us = 0;
+  GList *l;
+
+  for (l = compositor->frame_callback_surfaces; l; l = l->next)
+    {
+      MetaWaylandSurface *surface = l->data;
+      MetaSurfaceActor *actor;
+      int64_t render_duration_us;
+
+      actor = meta_wayland_surface_get_actor (surface);
+      if (!actor)
+        continue;
+
+      if (!meta_surface_actor_wayland_is_view_primary (actor,
+                                                       stage_view))
+        continue;
+
+      render_duration_us =
+        meta_wayland_presentation_time_get_render_duration (surface);
+      if (!render_duration_us)
+        return FALSE;
+
+      lead_time_us = MAX (lead_time_us, render_duration_us);
+    }
+
+  if (!lead_time_us)
+    return FALSE;
+
+  *out_lead_time_us = lead_time_us + FRAME_CALLBACK_LEAD_TIME_MARGIN_US;
+  return TRUE;
+}
+#endif
+
 static gboolean
 frame_callback_source_dispatch (GSource     *source,
                                 GSourceFunc  callback,
@@ -200,8 +423,8 @@ frame_callback_source_dispatch (GSource     *source,
   MetaWaylandCompositor *compositor = frame_callback_source->compositor;
   ClutterStageView *stage_view = frame_callback_source->stage_view;
 
-  emit_frame_callbacks_for_stage_view (compositor, stage_view);
   g_source_set_ready_time (source, -1);
+  emit_frame_callbacks_for_stage_view (compositor, stage_view);
 
   return G_SOURCE_CONTINUE;
 }
@@ -282,6 +505,27 @@ ensure_source_for_stage_view (MetaWaylandCompositor *compositor,
   return source;
 }
 
+/*
+ * Input events are forwarded to Wayland clients from the main thread, so
+ * events arriving while the stage is being updated normally wait for the
+ * whole frame to be done. With early input delivery, they are dispatched
+ * and flushed right after each stage view update instead, before the rest of
+ * the post-frame work.
+ */
+static void
+maybe_deliver_pending_input (MetaWaylandCompositor *compositor)
+{
+  MetaBackend *backend = meta_context_get_backend (compositor->context);
+  MetaSettings *settings = meta_backend_get_settings (backend);
+
+  if (!meta_settings_is_experimental_feature_enabled (settings,
+                                                      META_EXPERIMENTAL_FEATURE_EARLY_INPUT_DELIVERY))
+    return;
+
+  if (meta_backend_dispatch_pending_events (backend))
+    wl_display_flush_clients (compositor->wayland_display);
+}
+
 static void
 on_after_update (ClutterStage          *stage,
                  ClutterStageView      *stage_view,
@@ -294,7 +538,11 @@ on_after_update (ClutterStage          *stage,
   MetaFrameNative *frame_native;
   FrameCallbackSource *frame_callback_source;
   GSource *source;
+  int64_t target_presentation_time_us;
   int64_t min_render_time_allowed_us;
+  int64_t source_ready_time_us;
+
+  maybe_deliver_pending_input (compositor);
 
   if (!META_IS_BACKEND_NATIVE (backend))
     {
@@ -307,43 +555,55 @@ on_after_update (ClutterStage          *stage,
   source = ensure_source_for_stage_view (compositor, stage_view);
   frame_callback_source = (FrameCallbackSource *) source;
 
+  if (!clutter_frame_get_target_presentation_time (frame,
+                                                   &target_presentation_time_us))
+    target_presentation_time_us = 0;
+
+  if (g_source_get_ready_time (source) != -1 &&
+      frame_callback_source->target_presentation_time_us <
+      target_presentation_time_us)
+    emit_frame_callbacks_for_stage_view (compositor, stage_view);
+
   if (meta_frame_native_had_kms_update (frame_native) ||
       !clutter_frame_get_min_render_time_allowed (frame,
                                                   &min_render_time_allowed_us))
     {
-      g_source_set_ready_time (source, -1);
-      emit_frame_callbacks_for_stage_view (compositor, stage_view);
+      ClutterFrameClock *frame_clock =
+        clutter_stage_view_get_frame_clock (stage_view);
+      int64_t next_update_time_us;
+      int64_t lead_time_us;
+
+      /*
+       * New content can only make it into the next update, so there is no
+       * point in clients starting on it any earlier than they need to.
+       */
+      if (clutter_frame_clock_get_next_update_time (frame_clock,
+                                                    &next_update_time_us) &&
+          get_frame_callback_lead_time (compositor, stage_view, &lead_time_us))
+        source_ready_time_us = next_update_time_us - lead_time_us;
+      else
+        source_ready_time_us = 0;
     }
   else
     {
-      int64_t target_presentation_time_us;
-      int64_t source_ready_time_us;
-
-      if (!clutter_frame_get_target_presentation_time (frame,
-                                                       &target_presentation_time_us))
-        target_presentation_time_us = 0;
-
-      if (g_source_get_ready_time (source) != -1 &&
-          frame_callback_source->target_presentation_time_us <
-          target_presentation_time_us)
-        emit_frame_callbacks_for_stage_view (compositor, stage_view);
-
       source_ready_time_us = target_presentation_time_us -
                              min_render_time_allowed_us;
+    }
 
-      if (source_ready_time_us <= g_get_monotonic_time ())
-        {
-          g_source_set_ready_time (source, -1);
-          emit_frame_callbacks_for_stage_view (compositor, stage_view);
-        }
-      else
-        {
-          frame_callback_source->target_presentation_time_us =
-            target_presentation_time_us;
-          g_source_set_ready_time (source, source_ready_time_us);
-        }
+  if (source_ready_time_us <= g_get_monotonic_time ())
+    {
+      g_source_set_ready_time (source, -1);
+      emit_frame_callbacks_for_stage_view (compositor, stage_view);
+    }
+  else
+    {
+      frame_callback_source->target_presentation_time_us =
+        target_presentation_time_us;
+      g_source_set_ready_time (source, source_ready_time_us);
     }
 #else
+  maybe_deliver_pending_input (compositor);
+
   emit_frame_callbacks_for_stage_view (compositor, stage_view);
 #endif
 }
@@ -511,11 +771,17 @@ void
 meta_wayland_compositor_add_frame_callback_surface (MetaWaylandCompositor *compositor,
                                                     MetaWaylandSurface    *surface)
 {
+  MetaSurfaceActor *actor;
+
   if (g_list_find (compositor->frame_callback_surfaces, surface))
     return;
 
   compositor->frame_callback_surfaces =
     g_list_prepend (compositor->frame_callback_surfaces, surface);
+
+  actor = meta_wayland_surface_get_actor (surface);
+  if (actor && !is_surface_actor_on_any_view (actor))
+    ensure_hidden_frame_callbacks_timeout (compositor);
 }
 
 void
@@ -630,12 +896,23 @@ meta_wayland_compositor_finalize (GObject *object)
 
   meta_wayland_transaction_finalize (compositor);
 
+  g_clear_pointer (&compositor->udmabuf, meta_wayland_udmabuf_free);
+  g_clear_object (&compositor->drm_syncobj_manager);
+  g_clear_pointer (&compositor->shm_staging_buffer, cogl_object_unref);
+  if (compositor->shm_copy_thread_pool)
+    {
+      g_thread_pool_free (compositor->shm_copy_thread_pool, FALSE, TRUE);
+      compositor->shm_copy_thread_pool = NULL;
+    }
   g_clear_object (&compositor->dma_buf_manager);
 
   g_clear_pointer (&compositor->seat, meta_wayland_seat_free);
 
   g_clear_pointer (&priv->filter_manager, meta_wayland_filter_manager_free);
   g_clear_pointer (&priv->frame_callback_sources, g_hash_table_destroy);
+  g_clear_handle_id (&priv->hidden_frame_callbacks_timeout_id,
+                     g_source_remove);
+  g_clear_object (&priv->protocol_tracer);
 
   g_clear_pointer (&compositor->display_name, g_free);
   g_clear_pointer (&compositor->wayland_display, wl_display_destroy);
@@ -745,12 +1022,67 @@ init_dma_buf_support (MetaWaylandCompositor *compositor)
     }
 }
 
+static void
+init_drm_syncobj_support (MetaWaylandCompositor *compositor)
+{
+  g_autoptr (GError) error = NULL;
+
+  if (!compositor->dma_buf_manager)
+    return;
+
+  compositor->drm_syncobj_manager =
+    meta_wayland_drm_syncobj_manager_new (compositor, &error);
+  if (!compositor->drm_syncobj_manager)
+    {
+      if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED))
+        {
+          meta_topic (META_DEBUG_WAYLAND,
+                      "Wayland explicit sync protocol support not enabled: %s",
+                      error->message);
+        }
+      else
+        {
+          g_warning ("Wayland explicit sync protocol support not enabled: %s",
+                     error->message);
+        }
+    }
+}
+
+static void
+init_shm_udmabuf_support (MetaWaylandCompositor *compositor)
+{
+  MetaBackend *backend = meta_context_get_backend (compositor->context);
+  MetaSettings *settings = meta_backend_get_settings (backend);
+  g_autoptr (GError) error = NULL;
+
+  if (!meta_settings_is_experimental_feature_enabled (settings,
+                                                      META_EXPERIMENTAL_FEATURE_SHM_UDMABUF))
+    return;
+
+  compositor->udmabuf = meta_wayland_udmabuf_new (compositor, &error);
+  if (!compositor->udmabuf)
+    {
+      if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED))
+        {
+          meta_topic (META_DEBUG_WAYLAND,
+                      "Zero-copy shared memory buffers not enabled: %s",
+                      error->message);
+        }
+      else
+        {
+          g_warning ("Zero-copy shared memory buffers not enabled: %s",
+                     error->message);
+        }
+    }
+}
+
 MetaWaylandCompositor *
 meta_wayland_compositor_new (MetaContext *context)
 {
   MetaBackend *backend = meta_context_get_backend (context);
   ClutterActor *stage = meta_backend_get_stage (backend);
   MetaWaylandCompositor *compositor;
+  MetaWaylandCompositorPrivate *priv;
   GSource *wayland_event_source;
 #ifdef HAVE_XWAYLAND
   MetaX11DisplayPolicy x11_display_policy;
@@ -758,8 +1090,11 @@ meta_wayland_compositor_new (MetaContext *context)
 
   compositor = g_object_new (META_TYPE_WAYLAND_COMPOSITOR, NULL);
   compositor->context = context;
+  priv = meta_wayland_compositor_get_instance_private (compositor);
+
+  priv->protocol_tracer = meta_wayland_protocol_tracer_new (compositor);
 
-  wayland_event_source = wayland_event_source_new (compositor->wayland_display);
+  wayland_event_source = wayland_event_source_new (compositor);
 
   /* XXX: Here we are setting the wayland event source to have a
    * slightly lower priority than the X event source, because we are
@@ -799,11 +1134,15 @@ meta_wayland_compositor_new (MetaContext *context)
   meta_wayland_xdg_foreign_init (compositor);
   meta_wayland_legacy_xdg_foreign_init (compositor);
   init_dma_buf_support (compositor);
+  init_drm_syncobj_support (compositor);
+  init_shm_udmabuf_support (compositor);
   meta_wayland_init_single_pixel_buffer_manager (compositor);
   meta_wayland_keyboard_shortcuts_inhibit_init (compositor);
   meta_wayland_surface_inhibit_shortcuts_dialog_init ();
   meta_wayland_text_input_init (compositor);
   meta_wayland_init_presentation_time (compositor);
+  meta_wayland_init_fifo (compositor);
+  meta_wayland_init_commit_timing (compositor);
   meta_wayland_activation_init (compositor);
   meta_wayland_transaction_init (compositor);
   meta_wayland_idle_inhibit_init (compositor);